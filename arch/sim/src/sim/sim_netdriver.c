@@ -66,6 +66,7 @@
 
 #include <nuttx/compiler.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/mutex.h>
 #include <nuttx/wqueue.h>
 #include <nuttx/net/net.h>
 #include <nuttx/net/netdev_lowerhalf.h>
@@ -84,6 +85,31 @@
 #  define SIM_NETDEV_RECV_OFFLOAD
 #endif
 
+/* The host device has a single queue, multiple queues are emulated by
+ * steering the received packets to per-queue rings with the flow hash of
+ * the upper half.
+ */
+
+#ifndef CONFIG_SIM_NETDEV_QUEUES
+#  define CONFIG_SIM_NETDEV_QUEUES 1
+#endif
+
+#define SIM_NETDEV_RINGSIZE 8
+
+/* 1TX + 1RX is enough for sim, but the upper half needs more packets in
+ * flight to merge received segments or to queue the segments it splits,
+ * and the emulated queues hold received packets in their rings.
+ */
+
+#if CONFIG_SIM_NETDEV_QUEUES > 1
+#  define SIM_NETDEV_QUOTA \
+     MIN(CONFIG_SIM_NETDEV_QUEUES * SIM_NETDEV_RINGSIZE, NETPKT_BUFNUM / 4)
+#elif defined(CONFIG_NETDEV_GSO) || defined(CONFIG_NETDEV_GRO)
+#  define SIM_NETDEV_QUOTA MIN(CONFIG_NETDEV_PKT_BATCH, NETPKT_BUFNUM / 4)
+#else
+#  define SIM_NETDEV_QUOTA 1
+#endif
+
 /* Get index / buffer from dev pointer. */
 
 #define DEVIDX(p) ((struct sim_netdev_s *)(p) - g_sim_dev)
@@ -103,6 +129,23 @@ struct sim_netdev_s
 };
 #endif
 
+#if CONFIG_SIM_NETDEV_QUEUES > 1
+/* The received packets steered to an emulated queue */
+
+struct sim_netring_s
+{
+  netpkt_t *pkts[SIM_NETDEV_RINGSIZE];
+  uint8_t   head;                      /* Index of the oldest packet */
+  uint8_t   count;                     /* Number of packets in the ring */
+};
+
+struct sim_netqueues_s
+{
+  mutex_t lock;                        /* Serializes the host device */
+  struct sim_netring_s rings[CONFIG_SIM_NETDEV_QUEUES];
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -111,6 +154,11 @@ static int netdriver_send(struct netdev_lowerhalf_s *dev, netpkt_t *pkt);
 static netpkt_t *netdriver_recv(struct netdev_lowerhalf_s *dev);
 static int netdriver_ifup(struct netdev_lowerhalf_s *dev);
 static int netdriver_ifdown(struct netdev_lowerhalf_s *dev);
+#if CONFIG_SIM_NETDEV_QUEUES > 1
+static int netdriver_sendq(struct netdev_lowerhalf_s *dev, netpkt_t *pkt,
+                           int queue);
+static netpkt_t *netdriver_recvq(struct netdev_lowerhalf_s *dev, int queue);
+#endif
 
 /****************************************************************************
  * Private Data
@@ -121,12 +169,20 @@ static int netdriver_ifdown(struct netdev_lowerhalf_s *dev);
 static struct sim_netdev_s g_sim_dev[CONFIG_SIM_NETDEV_NUMBER];
 static const struct netdev_ops_s g_ops =
 {
-  netdriver_ifup,   /* ifup */
-  netdriver_ifdown, /* ifdown */
-  netdriver_send,   /* transmit */
-  netdriver_recv    /* receive */
+  .ifup      = netdriver_ifup,
+  .ifdown    = netdriver_ifdown,
+  .transmit  = netdriver_send,
+  .receive   = netdriver_recv,
+#if CONFIG_SIM_NETDEV_QUEUES > 1
+  .transmitq = netdriver_sendq,
+  .receiveq  = netdriver_recvq,
+#endif
 };
 
+#if CONFIG_SIM_NETDEV_QUEUES > 1
+static struct sim_netqueues_s g_sim_queues[CONFIG_SIM_NETDEV_NUMBER];
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -188,6 +244,79 @@ static netpkt_t *netdriver_recv(struct netdev_lowerhalf_s *dev)
   return pkt;
 }
 
+#if CONFIG_SIM_NETDEV_QUEUES > 1
+static int netdriver_sendq(struct netdev_lowerhalf_s *dev, netpkt_t *pkt,
+                           int queue)
+{
+  struct sim_netqueues_s *queues = &g_sim_queues[DEVIDX(dev)];
+  int ret;
+
+  nxmutex_lock(&queues->lock);
+  ret = netdriver_send(dev, pkt);
+  nxmutex_unlock(&queues->lock);
+
+  return ret;
+}
+
+static netpkt_t *netdriver_recvq(struct netdev_lowerhalf_s *dev, int queue)
+{
+  struct sim_netqueues_s *queues = &g_sim_queues[DEVIDX(dev)];
+  struct sim_netring_s *ring = &queues->rings[queue];
+  uint32_t notify = 0;
+  netpkt_t *pkt = NULL;
+  netpkt_t *rxpkt;
+  int qid;
+
+  nxmutex_lock(&queues->lock);
+
+  if (ring->count > 0)
+    {
+      pkt        = ring->pkts[ring->head];
+      ring->head = (ring->head + 1) % SIM_NETDEV_RINGSIZE;
+      ring->count--;
+    }
+
+  /* Read from the host until a packet of this queue arrives, the packets
+   * of the other queues are parked in their rings, or dropped if the ring
+   * is full like a NIC does.
+   */
+
+  while (pkt == NULL && (rxpkt = netdriver_recv(dev)) != NULL)
+    {
+      qid = netdev_lower_flowqueue(dev, rxpkt);
+      if (qid == queue)
+        {
+          pkt = rxpkt;
+        }
+      else if (queues->rings[qid].count < SIM_NETDEV_RINGSIZE)
+        {
+          struct sim_netring_s *other = &queues->rings[qid];
+
+          other->pkts[(other->head + other->count) % SIM_NETDEV_RINGSIZE] =
+            rxpkt;
+          other->count++;
+          notify |= 1u << qid;
+        }
+      else
+        {
+          netpkt_free(dev, rxpkt, NETPKT_RX);
+        }
+    }
+
+  nxmutex_unlock(&queues->lock);
+
+  for (qid = 0; notify != 0; qid++, notify >>= 1)
+    {
+      if ((notify & 1) != 0)
+        {
+          netdev_lower_rxready_queue(dev, qid);
+        }
+    }
+
+  return pkt;
+}
+#endif
+
 static int netdriver_ifup(struct netdev_lowerhalf_s *dev)
 {
 #ifdef CONFIG_NET_IPv4
@@ -251,12 +380,18 @@ int sim_netdriver_init(void)
                       netdriver_txdone_interrupt,
                       netdriver_rxready_interrupt);
 
-      /* 1TX + 1RX is enough for sim. */
-
-      dev->quota[NETPKT_TX] = 1;
-      dev->quota[NETPKT_RX] = 1;
+      dev->quota[NETPKT_TX] = SIM_NETDEV_QUOTA;
+      dev->quota[NETPKT_RX] = SIM_NETDEV_QUOTA;
       dev->ops              = &g_ops;
 
+#if CONFIG_SIM_NETDEV_QUEUES > 1
+      if (devidx >= CONFIG_SIM_WIFIDEV_NUMBER)
+        {
+          nxmutex_init(&g_sim_queues[devidx].lock);
+          dev->nqueues = CONFIG_SIM_NETDEV_QUEUES;
+        }
+#endif
+
 #if CONFIG_SIM_WIFIDEV_NUMBER != 0
       if (devidx < CONFIG_SIM_WIFIDEV_NUMBER)
         {
@@ -42,22 +42,52 @@
 
 #define MAX_OPENCNT       (255)                  /* Limit of uint8_t */
 
+#ifndef CONFIG_BCH_CACHE_NSECTORS
+#  define CONFIG_BCH_CACHE_NSECTORS 1
+#endif
+
+#ifndef CONFIG_BCH_READAHEAD
+#  define CONFIG_BCH_READAHEAD 0
+#endif
+
+/* The sector number of an empty cache slot */
+
+#define BCH_NOSECTOR      ((size_t)-1)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+/* One sector of the sector cache.  The data of slot 'n' is held at
+ * bch->cache + n * bch->sectsize.
+ */
+
+struct bchlib_slot_s
+{
+  size_t sector;           /* The sector held in the slot, or BCH_NOSECTOR */
+  uint32_t stamp;          /* The time of the last access, for LRU */
+  bool dirty;              /* true: Data has been written to the slot */
+};
+
 struct bchlib_s
 {
   FAR struct inode *inode; /* I-node of the block driver */
   uint32_t sectsize;       /* The size of one sector on the device */
   size_t nsectors;         /* Number of sectors supported by the device */
-  size_t sector;           /* The current sector in the buffer */
+  size_t lastsector;       /* The last sector read, to detect sequential
+                            * access */
   mutex_t lock;            /* For atomic accesses to this structure */
   uint8_t refs;            /* Number of references */
-  bool dirty;              /* true: Data has been written to the buffer */
   bool readonly;           /* true: Only read operations are supported */
   bool unlinked;           /* true: The driver has been unlinked */
-  FAR uint8_t *buffer;     /* One sector buffer */
+  uint32_t clock;          /* Advances on each access to the cache */
+  FAR uint8_t *cache;      /* The sector cache, allocated on first use */
+  FAR uint8_t *buffer;     /* The data of the current sector */
+
+  /* The slot of the current sector and the slots of the sector cache */
+
+  FAR struct bchlib_slot_s *current;
+  struct bchlib_slot_s slots[CONFIG_BCH_CACHE_NSECTORS];
 
 #if defined(CONFIG_BCH_ENCRYPTION)
   uint8_t key[CONFIG_BCH_ENCRYPTION_KEY_SIZE];  /* Encryption key */
@@ -83,7 +113,9 @@ EXTERN const struct file_operations g_bch_fops;
  * Public Function Prototypes
  ****************************************************************************/
 
-EXTERN int  bchlib_flushsector(FAR struct bchlib_s *bch, bool discard);
+EXTERN int  bchlib_flushcache(FAR struct bchlib_s *bch, bool discard);
+EXTERN void bchlib_invalidate(FAR struct bchlib_s *bch, size_t sector,
+                              size_t nsectors);
 EXTERN int  bchlib_readsector(FAR struct bchlib_s *bch, size_t sector);
 
 #undef EXTERN
@@ -172,7 +172,7 @@ static int bch_close(FAR struct file *filep)
 
   /* Flush any dirty pages remaining in the cache */
 
-  bchlib_flushsector(bch, false);
+  bchlib_flushcache(bch, false);
 
   /* Decrement the reference count (I don't use bchlib_decref() because I
    * want the entire close operation to be atomic wrt other driver
@@ -437,9 +437,16 @@ static int bch_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
       case BIOC_DISCARD:
         {
-          /* Invalidate the sector so next read is from the device- */
+          /* Write back and drop the cached sectors so that the next read
+           * is from the device.
+           */
+
+          ret = bchlib_flushcache(bch, true);
+          if (ret < 0)
+            {
+              break;
+            }
 
-          bch->sector = (size_t)-1;
           goto ioctl_default;
         }
 
@@ -447,7 +454,7 @@ static int bch_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
         {
           /* Flush any dirty pages remaining in the cache */
 
-          ret = bchlib_flushsector(bch, false);
+          ret = bchlib_flushcache(bch, false);
           if (ret < 0)
             {
               break;
@@ -28,7 +28,9 @@
 #include <nuttx/kmalloc.h>
 
 #include <sys/types.h>
+#include <sys/param.h>
 #include <stdbool.h>
+#include <string.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
@@ -39,6 +41,12 @@
 #  include <nuttx/crypto/crypto.h>
 #endif
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BCH_NSLOTS CONFIG_BCH_CACHE_NSECTORS
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -62,10 +70,11 @@ static void bch_xor(uint32_t *R, uint32_t *A, uint32_t *B)
  ****************************************************************************/
 
 #if defined(CONFIG_BCH_ENCRYPTION)
-static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
+static int bch_cypher(FAR struct bchlib_s *bch, FAR uint8_t *data,
+                      size_t sector, int encrypt)
 {
   int blocks = bch->sectsize / 16;
-  FAR uint32_t *buffer = (FAR uint32_t *)bch->buffer;
+  FAR uint32_t *buffer = (FAR uint32_t *)data;
   int i;
 
   for (i = 0; i < blocks; i++, buffer += 16 / sizeof(uint32_t) )
@@ -73,7 +82,7 @@ static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
       uint32_t T[4];
       uint32_t X[4] =
       {
-        bch->sector, 0, 0, i
+        sector, 0, 0, i
       };
 
       aes_cypher(X, X, 16, NULL, bch->key, CONFIG_BCH_ENCRYPTION_KEY_SIZE,
@@ -92,74 +101,375 @@ static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
 #endif
 
 /****************************************************************************
- * Public Functions
+ * Name: bch_slotdata
+ *
+ * Description:
+ *   Return the data of a cache slot
+ *
  ****************************************************************************/
 
+static inline FAR uint8_t *bch_slotdata(FAR struct bchlib_s *bch, int ndx)
+{
+  return bch->cache + (size_t)ndx * bch->sectsize;
+}
+
 /****************************************************************************
- * Name: bchlib_flushsector
+ * Name: bch_findslot
  *
  * Description:
- *   Flush the current contents of the sector buffer (if dirty)
+ *   Return the index of the slot holding a sector, or -1 if the sector is
+ *   not cached.
  *
- * Assumptions:
- *   Caller must assume mutual exclusion
+ ****************************************************************************/
+
+#if CONFIG_BCH_READAHEAD > 0
+static int bch_findslot(FAR struct bchlib_s *bch, size_t sector)
+{
+  int ndx;
+
+  for (ndx = 0; ndx < BCH_NSLOTS; ndx++)
+    {
+      if (bch->slots[ndx].sector == sector)
+        {
+          return ndx;
+        }
+    }
+
+  return -1;
+}
+#endif
+
+/****************************************************************************
+ * Name: bch_writeslots
+ *
+ * Description:
+ *   Write 'nslots' adjacent slots holding consecutive sectors to the media
+ *   with a single transfer.
  *
  ****************************************************************************/
 
-int bchlib_flushsector(FAR struct bchlib_s *bch, bool discard)
+static int bch_writeslots(FAR struct bchlib_s *bch, int first, int nslots)
 {
-  FAR struct inode *inode;
-  ssize_t ret = OK;
+  FAR struct inode *inode = bch->inode;
+  ssize_t ret;
+  int ndx;
 
-  /* Check if the sector has been modified and is out of synch with the
-   * media.
-   */
+#if defined(CONFIG_BCH_ENCRYPTION)
+  /* Encrypt data as necessary */
 
-  if (bch->dirty && bch->buffer != NULL)
+  for (ndx = first; ndx < first + nslots; ndx++)
     {
-      inode = bch->inode;
+      bch_cypher(bch, bch_slotdata(bch, ndx), bch->slots[ndx].sector,
+                 CYPHER_ENCRYPT);
+    }
+#endif
+
+  /* Write the sectors to the media */
+
+  ret = inode->u.i_bops->write(inode, bch_slotdata(bch, first),
+                               bch->slots[first].sector, nslots);
 
 #if defined(CONFIG_BCH_ENCRYPTION)
-      /* Encrypt data as necessary */
+  /* Computation overhead to save memory for extra sector buffer
+   * TODO: Add configuration switch for extra sector buffer
+   */
+
+  for (ndx = first; ndx < first + nslots; ndx++)
+    {
+      bch_cypher(bch, bch_slotdata(bch, ndx), bch->slots[ndx].sector,
+                 CYPHER_DECRYPT);
+    }
+#endif
+
+  if (ret < 0)
+    {
+      ferr("Write failed: %zd\n", ret);
+      return (int)ret;
+    }
+
+  /* The sectors are now in sync with the media */
+
+  for (ndx = first; ndx < first + nslots; ndx++)
+    {
+      bch->slots[ndx].dirty = false;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bch_readslots
+ *
+ * Description:
+ *   Read 'nslots' consecutive sectors from the media into adjacent slots
+ *   with a single transfer.
+ *
+ ****************************************************************************/
+
+static int bch_readslots(FAR struct bchlib_s *bch, int first, int nslots,
+                         size_t sector)
+{
+  FAR struct inode *inode = bch->inode;
+  ssize_t ret;
+  int ndx;
+
+  for (ndx = first; ndx < first + nslots; ndx++)
+    {
+      bch->slots[ndx].sector = BCH_NOSECTOR;
+    }
+
+  ret = inode->u.i_bops->read(inode, bch_slotdata(bch, first), sector,
+                              nslots);
+  if (ret < 0)
+    {
+      ferr("Read failed: %zd\n", ret);
+      return (int)ret;
+    }
 
-      bch_cypher(bch, CYPHER_ENCRYPT);
+  for (ndx = first; ndx < first + nslots; ndx++, sector++)
+    {
+      bch->slots[ndx].sector = sector;
+      bch->slots[ndx].stamp  = bch->clock;
+#if defined(CONFIG_BCH_ENCRYPTION)
+      bch_cypher(bch, bch_slotdata(bch, ndx), sector, CYPHER_DECRYPT);
 #endif
+    }
+
+  return OK;
+}
 
-      /* Write the sector to the media */
+/****************************************************************************
+ * Name: bch_older
+ *
+ * Description:
+ *   Return true if slot 'ndx' should be replaced before slot 'victim',
+ *   because it is empty or less recently used.
+ *
+ ****************************************************************************/
+
+static inline bool bch_older(FAR struct bchlib_s *bch, int ndx, int victim)
+{
+  return bch->slots[victim].sector != BCH_NOSECTOR &&
+         (bch->slots[ndx].sector == BCH_NOSECTOR ||
+          (int32_t)(bch->slots[ndx].stamp - bch->slots[victim].stamp) < 0);
+}
+
+/****************************************************************************
+ * Name: bch_readahead
+ *
+ * Description:
+ *   Read 'sector' and the sectors following it into the cache.  Every slot
+ *   replaced is chosen by LRU age, starting with 'victim'.  The sectors are
+ *   assigned to the chosen slots in ascending order, so that each run of
+ *   adjacent slots is read with a single transfer.
+ *
+ * Returned Value:
+ *   The index of the slot holding 'sector', or a negated errno value.
+ *
+ ****************************************************************************/
+
+#if CONFIG_BCH_READAHEAD > 0
+static int bch_readahead(FAR struct bchlib_s *bch, int victim,
+                         size_t sector)
+{
+  bool chosen[BCH_NSLOTS];
+  bool dirty;
+  size_t next = sector;
+  int nslots;
+  int first;
+  int ndx;
+  int ret;
+
+  nslots = MIN(CONFIG_BCH_READAHEAD + 1, BCH_NSLOTS);
+  if (nslots > bch->nsectors - sector)
+    {
+      nslots = bch->nsectors - sector;
+    }
+
+  /* Stop at the first sector that is cached already */
+
+  for (ndx = 1; ndx < nslots; ndx++)
+    {
+      if (bch_findslot(bch, sector + ndx) >= 0)
+        {
+          nslots = ndx;
+          break;
+        }
+    }
 
-      ret = inode->u.i_bops->write(inode, bch->buffer, bch->sector, 1);
+  /* Choose the least recently used slots */
+
+  memset(chosen, 0, sizeof(chosen));
+  chosen[victim] = true;
+  dirty = bch->slots[victim].dirty;
+
+  while (--nslots > 0)
+    {
+      victim = -1;
+      for (ndx = 0; ndx < BCH_NSLOTS; ndx++)
+        {
+          if (!chosen[ndx] && (victim < 0 || bch_older(bch, ndx, victim)))
+            {
+              victim = ndx;
+            }
+        }
+
+      chosen[victim] = true;
+      dirty |= bch->slots[victim].dirty;
+    }
+
+  /* Write back the dirty sectors before any of them is replaced.  All of
+   * them go at once, which gives the best chance to coalesce them.
+   */
+
+  if (dirty)
+    {
+      ret = bchlib_flushcache(bch, false);
       if (ret < 0)
         {
-          ferr("Write failed: %zd\n", ret);
-          return (int)ret;
+          ferr("Flush failed: %d\n", ret);
+          return ret;
+        }
+    }
+
+  /* Read each run of adjacent chosen slots.  Only a failure to read
+   * 'sector' itself is an error.
+   */
+
+  victim = -1;
+  first  = -1;
+
+  for (ndx = 0; ndx <= BCH_NSLOTS; ndx++)
+    {
+      if (ndx < BCH_NSLOTS && chosen[ndx])
+        {
+          if (first < 0)
+            {
+              first = ndx;
+            }
+
+          continue;
         }
 
-#if defined(CONFIG_BCH_ENCRYPTION)
-      /* Computation overhead to save memory for extra sector buffer
-       * TODO: Add configuration switch for extra sector buffer
-       */
+      if (first >= 0)
+        {
+          ret = bch_readslots(bch, first, ndx - first, next);
+          if (ret < 0)
+            {
+              return victim < 0 ? ret : victim;
+            }
+
+          if (victim < 0)
+            {
+              victim = first;
+            }
+
+          next += ndx - first;
+          first = -1;
+        }
+    }
 
-      bch_cypher(bch, CYPHER_DECRYPT);
+  return victim;
+}
 #endif
 
-      /* The sector is now in sync with the media */
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
 
-      bch->dirty = false;
+/****************************************************************************
+ * Name: bchlib_flushcache
+ *
+ * Description:
+ *   Write all dirty sectors of the cache to the media, coalescing adjacent
+ *   slots that hold consecutive sectors into one transfer.  If 'discard' is
+ *   true, the cache is emptied afterwards.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+int bchlib_flushcache(FAR struct bchlib_s *bch, bool discard)
+{
+  int nslots;
+  int ret;
+  int ndx;
+
+  if (bch->cache == NULL)
+    {
+      return OK;
+    }
+
+  for (ndx = 0; ndx < BCH_NSLOTS; ndx += nslots)
+    {
+      nslots = 1;
+      if (!bch->slots[ndx].dirty)
+        {
+          continue;
+        }
+
+      while (ndx + nslots < BCH_NSLOTS &&
+             bch->slots[ndx + nslots].dirty &&
+             bch->slots[ndx + nslots].sector ==
+             bch->slots[ndx].sector + nslots)
+        {
+          nslots++;
+        }
+
+      ret = bch_writeslots(bch, ndx, nslots);
+      if (ret < 0)
+        {
+          return ret;
+        }
     }
 
   if (discard)
     {
-      bch->sector = (size_t)-1;
+      bchlib_invalidate(bch, 0, bch->nsectors);
     }
 
-  return (int)ret;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bchlib_invalidate
+ *
+ * Description:
+ *   Drop the cached copies of a range of sectors, without writing them
+ *   back.  Used when the range is about to be overwritten on the media.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+void bchlib_invalidate(FAR struct bchlib_s *bch, size_t sector,
+                       size_t nsectors)
+{
+  FAR struct bchlib_slot_s *slot;
+  int ndx;
+
+  for (ndx = 0; ndx < BCH_NSLOTS; ndx++)
+    {
+      slot = &bch->slots[ndx];
+      if (slot->sector != BCH_NOSECTOR && slot->sector >= sector &&
+          slot->sector - sector < nsectors)
+        {
+          slot->sector = BCH_NOSECTOR;
+          slot->dirty  = false;
+        }
+    }
 }
 
 /****************************************************************************
  * Name: bchlib_readsector
  *
  * Description:
- *   Read the current sector contents into buffer
+ *   Make 'sector' the current sector, reading it into the least recently
+ *   used slot of the cache if it is not cached.  When the sectors are read
+ *   sequentially, the following sectors are read ahead into the next least
+ *   recently used slots.
  *
  * Assumptions:
  *   Caller must assume mutual exclusion
@@ -168,46 +478,90 @@ int bchlib_flushsector(FAR struct bchlib_s *bch, bool discard)
 
 int bchlib_readsector(FAR struct bchlib_s *bch, size_t sector)
 {
-  FAR struct inode *inode;
-  ssize_t ret = OK;
+  FAR struct bchlib_slot_s *slot;
+  int victim = 0;
+  int ret;
+  int ndx;
 
-  if (bch->buffer == NULL)
+  if (bch->cache == NULL)
     {
 #if CONFIG_BCH_BUFFER_ALIGNMENT != 0
-      bch->buffer = kmm_memalign(CONFIG_BCH_BUFFER_ALIGNMENT, bch->sectsize);
+      bch->cache = kmm_memalign(CONFIG_BCH_BUFFER_ALIGNMENT,
+                                (size_t)BCH_NSLOTS * bch->sectsize);
 #else
-      bch->buffer = kmm_malloc(bch->sectsize);
+      bch->cache = kmm_malloc((size_t)BCH_NSLOTS * bch->sectsize);
 #endif
-      if (bch->buffer == NULL)
+      if (bch->cache == NULL)
         {
-          ferr("Failed to allocate sector buffer\n");
+          ferr("Failed to allocate sector cache\n");
           return -ENOMEM;
         }
     }
 
-  if (bch->sector != sector)
+  bch->clock++;
+
+  /* Look the sector up, selecting an empty or else the least recently
+   * used slot as the victim in case it is not cached.
+   */
+
+  for (ndx = 0; ndx < BCH_NSLOTS; ndx++)
     {
-      inode = bch->inode;
+      slot = &bch->slots[ndx];
+      if (slot->sector == sector)
+        {
+          goto found;
+        }
 
-      ret = bchlib_flushsector(bch, true);
-      if (ret < 0)
+      if (bch_older(bch, ndx, victim))
         {
-          ferr("Flush failed: %zd\n", ret);
-          return (int)ret;
+          victim = ndx;
         }
+    }
+
+#if CONFIG_BCH_READAHEAD > 0
+  /* On sequential access read the following sectors too */
 
-      ret = inode->u.i_bops->read(inode, bch->buffer, sector, 1);
+  if (sector == bch->lastsector + 1)
+    {
+      ret = bch_readahead(bch, victim, sector);
       if (ret < 0)
         {
-          ferr("Read failed: %zd\n", ret);
-          return (int)ret;
+          return ret;
         }
 
-      bch->sector = sector;
-#if defined(CONFIG_BCH_ENCRYPTION)
-      bch_cypher(bch, CYPHER_DECRYPT);
+      ndx  = ret;
+      slot = &bch->slots[ndx];
+      goto found;
+    }
 #endif
+
+  /* Write back the dirty sectors before the victim is replaced.  All of
+   * them go at once, which gives the best chance to coalesce them.
+   */
+
+  if (bch->slots[victim].dirty)
+    {
+      ret = bchlib_flushcache(bch, false);
+      if (ret < 0)
+        {
+          ferr("Flush failed: %d\n", ret);
+          return ret;
+        }
     }
 
-  return (int)ret;
+  ret = bch_readslots(bch, victim, 1, sector);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ndx  = victim;
+  slot = &bch->slots[ndx];
+
+found:
+  slot->stamp     = bch->clock;
+  bch->current    = slot;
+  bch->buffer     = bch_slotdata(bch, ndx);
+  bch->lastsector = sector;
+  return OK;
 }
@@ -148,6 +148,15 @@ ssize_t bchlib_read(FAR void *handle, FAR char *buffer, off_t offset,
           nsectors = bch->nsectors - sector;
         }
 
+      /* Write back the dirty sectors first, the media must be up to date */
+
+      ret = bchlib_flushcache(bch, false);
+      if (ret < 0)
+        {
+          ferr("ERROR: Flush failed: %d\n", ret);
+          return ret;
+        }
+
       ret = bch->inode->u.i_bops->read(bch->inode, (FAR uint8_t *)buffer,
                                        sector, nsectors);
       if (ret < 0)
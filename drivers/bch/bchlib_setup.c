@@ -60,6 +60,7 @@ int bchlib_setup(FAR const char *blkdev, bool readonly, FAR void **handle)
   FAR struct bchlib_s *bch;
   struct geometry geo;
   int ret;
+  int i;
 
   DEBUGASSERT(blkdev);
 
@@ -110,8 +111,14 @@ int bchlib_setup(FAR const char *blkdev, bool readonly, FAR void **handle)
   nxmutex_init(&bch->lock);
   bch->nsectors = geo.geo_nsectors;
   bch->sectsize = geo.geo_sectorsize;
-  bch->sector   = (size_t)-1;
   bch->readonly = readonly;
+
+  bch->lastsector = BCH_NOSECTOR;
+  for (i = 0; i < CONFIG_BCH_CACHE_NSECTORS; i++)
+    {
+      bch->slots[i].sector = BCH_NOSECTOR;
+    }
+
   *handle = bch;
   return OK;
 
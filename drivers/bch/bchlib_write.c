@@ -107,7 +107,7 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
         }
 
       memcpy(&bch->buffer[sectoffset], buffer, nbytes);
-      bch->dirty = true;
+      bch->current->dirty = true;
 
       /* Adjust pointers and counts */
 
@@ -144,16 +144,7 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
 
       nbytes = len > bch->sectsize ? bch->sectsize : len;
       memcpy(bch->buffer, buffer, nbytes);
-      bch->dirty = true;
-
-      /* Write the sector back to the block device */
-
-      ret = bchlib_flushsector(bch, false);
-      if (ret < 0)
-        {
-          ferr("ERROR: Flush failed: %d\n", ret);
-          return ret;
-        }
+      bch->current->dirty = true;
 
       /* Adjust pointers and counts */
 
@@ -175,16 +166,19 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
           nsectors = bch->nsectors - sector;
         }
 
-      /* Flush the dirty sector to keep the sector sequence */
+      /* Flush the dirty sectors to keep the sector sequence, and drop the
+       * cached copies of the sectors that are about to be overwritten.
+       */
 
-      ret = bchlib_flushsector(bch, sector <= bch->sector &&
-                               bch->sector < (sector + nsectors));
+      ret = bchlib_flushcache(bch, false);
       if (ret < 0)
         {
           ferr("ERROR: Flush failed: %d\n", ret);
           return ret;
         }
 
+      bchlib_invalidate(bch, sector, nsectors);
+
       /* Write the contiguous sectors */
 
       ret = bch->inode->u.i_bops->write(bch->inode, (FAR uint8_t *)buffer,
@@ -225,7 +219,7 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
       /* Copy the head end of the sector from the user buffer */
 
       memcpy(bch->buffer, buffer, len);
-      bch->dirty = true;
+      bch->current->dirty = true;
 
       /* Adjust counts */
 
@@ -35,10 +35,12 @@
 #include <nuttx/kmalloc.h>
 #include <nuttx/kthread.h>
 #include <nuttx/mm/iob.h>
+#include <nuttx/mutex.h>
 #include <nuttx/net/can.h>
 #include <nuttx/net/net.h>
 #include <nuttx/net/netdev_lowerhalf.h>
 #include <nuttx/net/pkt.h>
+#include <nuttx/net/tcp.h>
 #include <nuttx/semaphore.h>
 #include <nuttx/spinlock.h>
 
@@ -56,22 +58,103 @@
 #  define NETDEV_WORK LPWORK
 #endif
 
-#ifdef CONFIG_NETDEV_RSS
+#if defined(CONFIG_NETDEV_MULTIQUEUE) && \
+    CONFIG_NETDEV_MAX_QUEUES > CONFIG_SMP_NCPUS
+#  define NETDEV_THREAD_COUNT CONFIG_NETDEV_MAX_QUEUES
+#elif defined(CONFIG_NETDEV_RSS) || defined(CONFIG_NETDEV_MULTIQUEUE)
 #  define NETDEV_THREAD_COUNT CONFIG_SMP_NCPUS
 #else
 #  define NETDEV_THREAD_COUNT 1
 #endif
 
+#ifndef CONFIG_NETDEV_PKT_BATCH
+#  define CONFIG_NETDEV_PKT_BATCH 16
+#endif
+
+#if defined(CONFIG_NETDEV_GSO) || defined(CONFIG_NETDEV_GRO)
+#  define NETDEV_HAVE_TCP_OFFLOAD 1
+#endif
+
+/* The lock serializing the calls into the lower half */
+
+#ifdef CONFIG_NETDEV_SPLIT_LOCK
+#  define netdev_upper_lock(upper)   nxmutex_lock(&(upper)->lock)
+#  define netdev_upper_unlock(upper) nxmutex_unlock(&(upper)->lock)
+#else
+#  define netdev_upper_lock(upper)   net_lock()
+#  define netdev_upper_unlock(upper) net_unlock()
+#endif
+
+/* Whether the lower half has several queues, and the queue of a packet of
+ * a batch.
+ */
+
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+#  define NETDEV_UPPER_MQ(upper)      ((upper)->lower->nqueues > 1)
+#  define NETDEV_UPPER_QID(batch, i)  ((batch)->qids[i])
+#else
+#  define NETDEV_UPPER_MQ(upper)      false
+#  define NETDEV_UPPER_QID(batch, i)  0
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+/* A batch of packets passed between the lower half and the network */
+
+struct netdev_upper_batch_s
+{
+  int           npkts;
+  FAR netpkt_t *pkts[CONFIG_NETDEV_PKT_BATCH];
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  uint32_t      queues;                        /* Bit set of the TX queues */
+  uint8_t       qids[CONFIG_NETDEV_PKT_BATCH]; /* TX queue of each packet */
+#endif
+};
+
+/* The TCP packet that received segments are being merged into */
+
+#ifdef CONFIG_NETDEV_GRO
+struct netdev_upper_gro_s
+{
+  FAR netpkt_t *pkt;     /* The merged packet, NULL if none */
+  uint16_t      iphl;    /* The length of its IP header */
+  uint16_t      tcphl;   /* The length of its TCP header */
+  uint16_t      sum;     /* The checksum of the merged TCP payload */
+  uint16_t      nsegs;   /* The number of segments merged */
+  uint32_t      nextseq; /* The sequence number of the next segment */
+};
+#endif
+
 /* This structure describes the state of the upper half driver */
 
 struct netdev_upperhalf_s
 {
   FAR struct netdev_lowerhalf_s *lower;
 
+  /* Serializes the receive, transmit and reclaim calls into the lower half.
+   * May be taken with the network locked, but never the other way around.
+   */
+
+#ifdef CONFIG_NETDEV_SPLIT_LOCK
+  mutex_t lock;
+#endif
+
+  /* Serializes the calls on each queue of a multi-queue lower half, taken
+   * instead of the lock above.  Several are taken in ascending order.
+   */
+
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  mutex_t qlock[CONFIG_NETDEV_MAX_QUEUES];
+#endif
+
+  /* The TX batch being collected by devif_poll(), protected by the network
+   * lock.  NULL if the packets should be sent directly.
+   */
+
+  FAR struct netdev_upper_batch_s *txbatch;
+
   /* Deferring poll work to work queue or thread */
 
 #ifdef CONFIG_NETDEV_WORK_THREAD
@@ -207,6 +290,9 @@ netdev_upper_alloc(FAR struct netdev_lowerhalf_s *dev)
   /* Allocate the upper-half data structure */
 
   FAR struct netdev_upperhalf_s *upper;
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  int i;
+#endif
 
   DEBUGASSERT(dev != NULL && dev->netdev.d_private == NULL);
 
@@ -219,246 +305,899 @@ netdev_upper_alloc(FAR struct netdev_lowerhalf_s *dev)
 
   upper->lower = dev;
   dev->netdev.d_private = upper;
+#ifdef CONFIG_NETDEV_SPLIT_LOCK
+  nxmutex_init(&upper->lock);
+#endif
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  for (i = 0; i < CONFIG_NETDEV_MAX_QUEUES; i++)
+    {
+      nxmutex_init(&upper->qlock[i]);
+    }
+#endif
 
   return upper;
 }
 
 /****************************************************************************
- * Name: netdev_upper_can_tx
+ * Name: netdev_upper_qlock/qunlock
  *
  * Description:
- *   Check if we allow tx on this device.
- *
- * Assumptions:
- *   Called with the network locked.
+ *   Lock or unlock a queue of the lower half, which is the whole device if
+ *   it has only one.
  *
  ****************************************************************************/
 
-static inline bool netdev_upper_can_tx(FAR struct netdev_upperhalf_s *upper)
+static inline void netdev_upper_qlock(FAR struct netdev_upperhalf_s *upper,
+                                      int queue)
 {
-  FAR struct netdev_lowerhalf_s *lower = upper->lower;
-  int quota = netdev_lower_quota_load(lower, NETPKT_TX);
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  if (NETDEV_UPPER_MQ(upper))
+    {
+      nxmutex_lock(&upper->qlock[queue]);
+      return;
+    }
+#endif
+
+  netdev_upper_lock(upper);
+}
 
-  if (quota <= 0 && lower->ops->reclaim)
+static inline void
+netdev_upper_qunlock(FAR struct netdev_upperhalf_s *upper, int queue)
+{
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  if (NETDEV_UPPER_MQ(upper))
     {
-      lower->ops->reclaim(lower);
-      quota = netdev_lower_quota_load(lower, NETPKT_TX);
+      nxmutex_unlock(&upper->qlock[queue]);
+      return;
     }
+#endif
 
-  return quota > 0;
+  netdev_upper_unlock(upper);
 }
 
 /****************************************************************************
- * Name: netdev_upper_txpoll
+ * Name: netdev_upper_lock_all/unlock_all
  *
  * Description:
- *   The transmitter is available, check if the network has any outgoing
- *   packets ready to send.  This is a callback from devif_poll().
- *   devif_poll() may be called:
- *
- *   1. When the preceding TX packet send is complete
- *   2. When the preceding TX packet send times out and the interface is
- *      reset
- *   3. During normal TX polling
- *
- * Input Parameters:
- *   dev - Reference to the NuttX driver state structure
- *
- * Returned Value:
- *   Negated errno value - Error number that occurs.
- *   NETDEV_TX_CONTINUE  - Driver can send more, continue the poll.
- *
- * Assumptions:
- *   Called with the network locked.
+ *   Lock or unlock the whole lower half, which takes all of its queue locks
+ *   in ascending order if it has several queues.
  *
  ****************************************************************************/
 
-static int netdev_upper_txpoll(FAR struct net_driver_s *dev)
+static void netdev_upper_lock_all(FAR struct netdev_upperhalf_s *upper)
 {
-  FAR struct netdev_upperhalf_s *upper = dev->d_private;
-  FAR struct netdev_lowerhalf_s *lower = upper->lower;
-  FAR netpkt_t                  *pkt;
-  int                            ret;
-
-  DEBUGASSERT(dev->d_len > 0);
-
-  NETDEV_TXPACKETS(dev);
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  if (NETDEV_UPPER_MQ(upper))
+    {
+      int queue;
 
-#ifdef CONFIG_NET_PKT
-  /* When packet sockets are enabled, feed the tx frame into it */
+      for (queue = 0; queue < upper->lower->nqueues; queue++)
+        {
+          nxmutex_lock(&upper->qlock[queue]);
+        }
 
-  pkt_input(dev);
+      return;
+    }
 #endif
 
-  pkt = netpkt_get(dev, NETPKT_TX);
+  netdev_upper_lock(upper);
+}
 
-  if (netpkt_getdatalen(lower, pkt) > NETDEV_PKTSIZE(dev))
+static void netdev_upper_unlock_all(FAR struct netdev_upperhalf_s *upper)
+{
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  if (NETDEV_UPPER_MQ(upper))
     {
-      nerr("ERROR: Packet too long to send!\n");
-      ret = -EMSGSIZE;
+      int queue;
+
+      for (queue = upper->lower->nqueues - 1; queue >= 0; queue--)
+        {
+          nxmutex_unlock(&upper->qlock[queue]);
+        }
+
+      return;
     }
-  else
+#endif
+
+  netdev_upper_unlock(upper);
+}
+
+/****************************************************************************
+ * Name: netdev_upper_batch_lock/batch_unlock
+ *
+ * Description:
+ *   Lock or unlock all of the queues a TX batch is sent on.  Unlocking
+ *   forgets the queues of the batch.
+ *
+ ****************************************************************************/
+
+static void netdev_upper_batch_lock(FAR struct netdev_upperhalf_s *upper,
+                                    FAR struct netdev_upper_batch_s *batch)
+{
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  if (NETDEV_UPPER_MQ(upper))
     {
-      ret = lower->ops->transmit(lower, pkt);
+      uint32_t queues;
+      int queue;
+
+      for (queue = 0, queues = batch->queues; queues != 0;
+           queue++, queues >>= 1)
+        {
+          if ((queues & 1) != 0)
+            {
+              nxmutex_lock(&upper->qlock[queue]);
+            }
+        }
+
+      return;
     }
+#endif
 
-  if (ret != OK)
+  netdev_upper_lock(upper);
+}
+
+static void netdev_upper_batch_unlock(FAR struct netdev_upperhalf_s *upper,
+                                      FAR struct netdev_upper_batch_s *batch)
+{
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  if (NETDEV_UPPER_MQ(upper))
     {
-      /* Stop polling on any error
-       * REVISIT: maybe store the pkt in upper half and retry later?
-       */
+      uint32_t queues;
+      int queue;
 
-      NETDEV_TXERRORS(dev);
-      netpkt_put(dev, pkt, NETPKT_TX);
-      return ret;
+      for (queue = 0, queues = batch->queues; queues != 0;
+           queue++, queues >>= 1)
+        {
+          if ((queues & 1) != 0)
+            {
+              nxmutex_unlock(&upper->qlock[queue]);
+            }
+        }
+
+      batch->queues = 0;
+      return;
     }
+#endif
 
-  return NETDEV_TX_CONTINUE;
+  netdev_upper_unlock(upper);
 }
 
 /****************************************************************************
- * Name: netdev_upper_tx
+ * Name: netdev_upper_reclaim
  *
  * Description:
- *   Do the actual transmission of packets, including pre-queued packets and
- *   packets from the network stack.
- *
- * Input Parameters:
- *   dev - Reference to the NuttX driver state structure
- *
- * Returned Value:
- *   Negated errno value - Error number that occurs.
- *   NETDEV_TX_CONTINUE  - Driver can send more, continue the poll.
- *
- * Assumptions:
- *   Called with the network locked.
+ *   Let the lower half reclaim the packets it has sent, on all queues.
  *
  ****************************************************************************/
 
-static int netdev_upper_tx(FAR struct net_driver_s *dev)
+static void netdev_upper_reclaim(FAR struct netdev_upperhalf_s *upper)
 {
-#if CONFIG_IOB_NCHAINS > 0
-  FAR struct netdev_upperhalf_s *upper = dev->d_private;
+  FAR struct netdev_lowerhalf_s *lower = upper->lower;
 
-  if (!IOB_QEMPTY(&upper->txq))
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  if (NETDEV_UPPER_MQ(upper))
     {
-      /* Put the packet back to the device */
+      int queue;
 
-      netdev_iob_replace(dev, iob_remove_queue(&upper->txq));
-      return netdev_upper_txpoll(dev);
+      if (lower->ops->reclaimq != NULL)
+        {
+          for (queue = 0; queue < lower->nqueues; queue++)
+            {
+              nxmutex_lock(&upper->qlock[queue]);
+              lower->ops->reclaimq(lower, queue);
+              nxmutex_unlock(&upper->qlock[queue]);
+            }
+        }
+
+      return;
     }
 #endif
 
-  /* No more TX packets in queue, poll the net stack to get more packets */
-
-  return devif_poll(dev, netdev_upper_txpoll);
+  if (lower->ops->reclaim != NULL)
+    {
+      netdev_upper_lock(upper);
+      lower->ops->reclaim(lower);
+      netdev_upper_unlock(upper);
+    }
 }
 
 /****************************************************************************
- * Name: netdev_upper_txavail_work
+ * Name: netdev_upper_can_tx
  *
  * Description:
- *   Perform an out-of-cycle tx poll on the worker thread.
- *
- * Input Parameters:
- *   upper - Reference to the upper half driver structure
+ *   Check if we allow tx on this device.
  *
  * Assumptions:
  *   Called with the network locked.
  *
  ****************************************************************************/
 
-static void netdev_upper_txavail_work(FAR struct netdev_upperhalf_s *upper)
+static inline bool netdev_upper_can_tx(FAR struct netdev_upperhalf_s *upper)
 {
-  FAR struct net_driver_s *dev = &upper->lower->netdev;
-
-  /* Ignore the notification if the interface is not yet up */
+  FAR struct netdev_lowerhalf_s *lower = upper->lower;
+  int quota = netdev_lower_quota_load(lower, NETPKT_TX);
 
-  if (IFF_IS_UP(dev->d_flags))
+  if (quota <= 0)
     {
-      DEBUGASSERT(dev->d_buf == NULL); /* Make sure: IOB only. */
-      while (netdev_upper_can_tx(upper) &&
-             netdev_upper_tx(dev) == NETDEV_TX_CONTINUE);
+      netdev_upper_reclaim(upper);
+      quota = netdev_lower_quota_load(lower, NETPKT_TX);
     }
+
+  return quota > 0;
 }
 
 /****************************************************************************
- * Name: netdev_upper_queue_tx
+ * Name: netdev_upper_xmit
  *
  * Description:
- *   Queue a TX packet to the upper half for sending later.
- *
- * Input Parameters:
- *   dev - Reference to the NuttX driver state structure
+ *   Hand a packet to the lower half, the packet is recycled on failure.
  *
  * Assumptions:
- *   Called with the network locked.
+ *   Called with the queue locked.
  *
  ****************************************************************************/
 
-#if defined(CONFIG_NET_LOOPBACK) || defined(CONFIG_NET_ETHERNET) || \
-    defined(CONFIG_DRIVERS_IEEE80211) || defined(CONFIG_NET_MBIM)
-static void netdev_upper_queue_tx(FAR struct net_driver_s *dev)
+static int netdev_upper_xmit(FAR struct netdev_upperhalf_s *upper,
+                             FAR netpkt_t *pkt, int queue)
 {
-#if CONFIG_IOB_NCHAINS > 0
-  FAR struct netdev_upperhalf_s *upper = dev->d_private;
+  FAR struct netdev_lowerhalf_s *lower = upper->lower;
   int ret;
 
-  if ((ret = iob_tryadd_queue(dev->d_iob, &upper->txq)) >= 0)
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  if (NETDEV_UPPER_MQ(upper))
     {
-      netdev_iob_clear(dev);
+      ret = lower->ops->transmitq(lower, pkt, queue);
     }
   else
+#endif
     {
-      nwarn("WARNING: Failed to queue TX packet, dropping: %d\n", ret);
+      ret = lower->ops->transmit(lower, pkt);
     }
-#else
-  /* Fall back to send the packet directly if we don't have IOB queue. */
 
-  netdev_upper_txpoll(dev);
-#endif
+  if (ret != OK)
+    {
+      NETDEV_TXERRORS(&lower->netdev);
+      netpkt_free(lower, pkt, NETPKT_TX);
+    }
+
+  return ret;
 }
-#endif
 
 /****************************************************************************
- * Name: eth_input
+ * Name: netdev_upper_txflush
  *
  * Description:
- *   Handle L2 packet input.
- *
- * Input Parameters:
- *   dev - Reference to the NuttX network driver state structure
+ *   Hand a batch of packets collected by netdev_upper_txpoll() to the lower
+ *   half.  Sending stops on the first error and the rest of the batch is
+ *   dropped.
  *
  * Assumptions:
- *   Called with the network locked.
+ *   Called with the queues of the batch locked.
  *
  ****************************************************************************/
 
-#if defined(CONFIG_NET_LOOPBACK) || defined(CONFIG_NET_ETHERNET) || \
-    defined(CONFIG_DRIVERS_IEEE80211)
-static void eth_input(FAR struct net_driver_s *dev)
+static int netdev_upper_txflush(FAR struct netdev_upperhalf_s *upper,
+                                FAR struct netdev_upper_batch_s *batch)
 {
-  FAR struct eth_hdr_s *eth_hdr = (FAR struct eth_hdr_s *)NETLLBUF;
-
-  /* Check if this is an 802.1Q VLAN tagged packet */
+  int ret = OK;
+  int i;
 
-  if (eth_hdr->type == HTONS(TPID_8021QVLAN))
+  for (i = 0; i < batch->npkts; i++)
     {
-      /* Need to remove the 4 octet VLAN Tag, by moving src and dest
-       * addresses 4 octets to the right, and then read the actual
-       * ethertype. The VLAN ID and priority fields are currently
-       * ignored.
-       */
+      if (ret == OK)
+        {
+          ret = netdev_upper_xmit(upper, batch->pkts[i],
+                                  NETDEV_UPPER_QID(batch, i));
+        }
+      else
+        {
+          NETDEV_TXERRORS(&upper->lower->netdev);
+          netpkt_free(upper->lower, batch->pkts[i], NETPKT_TX);
+        }
+    }
 
-      memmove((FAR uint8_t *)eth_hdr + 4, eth_hdr,
-              offsetof(struct eth_hdr_s, type));
-      dev->d_iob  = iob_trimhead(dev->d_iob, 4);
-      dev->d_len -= 4;
+  batch->npkts = 0;
+  return ret;
+}
 
-      eth_hdr = (FAR struct eth_hdr_s *)NETLLBUF;
-    }
+/****************************************************************************
+ * Name: netdev_upper_txqueue
+ *
+ * Description:
+ *   Queue a packet for transmission.  The packet is collected into the TX
+ *   batch if there is one, and sent directly otherwise.  A full batch is
+ *   flushed first, so that the packets reach the lower half in order.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
 
-  /* We only accept IP packets of the configured type and ARP packets */
+static int netdev_upper_txqueue(FAR struct netdev_upperhalf_s *upper,
+                                FAR netpkt_t *pkt)
+{
+  FAR struct netdev_upper_batch_s *batch = upper->txbatch;
+  int queue = 0;
+  int ret = OK;
+
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  /* Keep each flow on one queue, so that its packets stay in order */
+
+  if (NETDEV_UPPER_MQ(upper))
+    {
+      queue = netdev_lower_flowqueue(upper->lower, pkt);
+    }
+#endif
+
+  if (batch == NULL)
+    {
+      netdev_upper_qlock(upper, queue);
+      ret = netdev_upper_xmit(upper, pkt, queue);
+      netdev_upper_qunlock(upper, queue);
+      return ret;
+    }
+
+  if (batch->npkts >= CONFIG_NETDEV_PKT_BATCH)
+    {
+      netdev_upper_batch_lock(upper, batch);
+      ret = netdev_upper_txflush(upper, batch);
+      netdev_upper_batch_unlock(upper, batch);
+
+      if (ret != OK)
+        {
+          NETDEV_TXERRORS(&upper->lower->netdev);
+          netpkt_free(upper->lower, pkt, NETPKT_TX);
+          return ret;
+        }
+    }
+
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  batch->qids[batch->npkts] = queue;
+  batch->queues |= 1u << queue;
+#endif
+
+  batch->pkts[batch->npkts++] = pkt;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: netdev_upper_tcpinfo
+ *
+ * Description:
+ *   Check if a packet is a complete TCP segment in IPv4 or in IPv6 without
+ *   extension headers, whose IP and TCP headers are in the first buffer.
+ *
+ * Input Parameters:
+ *   pkt   - The packet, starting with the IP header
+ *   iphl  - Returns the length of the IP header
+ *   tcphl - Returns the length of the TCP header
+ *
+ ****************************************************************************/
+
+#ifdef NETDEV_HAVE_TCP_OFFLOAD
+static bool netdev_upper_tcpinfo(FAR netpkt_t *pkt, FAR uint16_t *iphl,
+                                 FAR uint16_t *tcphl)
+{
+  FAR uint8_t *l3 = IOB_DATA(pkt);
+  FAR struct tcp_hdr_s *tcp;
+  unsigned int len;
+
+  if (pkt->io_len == 0)
+    {
+      return false;
+    }
+
+#ifdef CONFIG_NET_IPv4
+  if ((l3[0] & IP_VERSION_MASK) == IPv4_VERSION)
+    {
+      FAR struct ipv4_hdr_s *ipv4 = (FAR struct ipv4_hdr_s *)l3;
+
+      /* Fragments are never offloaded */
+
+      if (pkt->io_len < IPv4_HDRLEN || ipv4->proto != IP_PROTO_TCP ||
+          (ipv4->vhl & IPv4_HLMASK) < (IPv4_HDRLEN >> 2) ||
+          ((((uint16_t)ipv4->ipoffset[0] << 8) | ipv4->ipoffset[1]) &
+           ~IP_FLAG_DONTFRAG) != 0)
+        {
+          return false;
+        }
+
+      *iphl = (ipv4->vhl & IPv4_HLMASK) << 2;
+      len   = ((uint16_t)ipv4->len[0] << 8) + ipv4->len[1];
+    }
+  else
+#endif
+#ifdef CONFIG_NET_IPv6
+  if ((l3[0] & IP_VERSION_MASK) == IPv6_VERSION)
+    {
+      FAR struct ipv6_hdr_s *ipv6 = (FAR struct ipv6_hdr_s *)l3;
+
+      if (pkt->io_len < IPv6_HDRLEN || ipv6->proto != IP_PROTO_TCP)
+        {
+          return false;
+        }
+
+      *iphl = IPv6_HDRLEN;
+      len   = ((uint16_t)ipv6->len[0] << 8) + ipv6->len[1] + IPv6_HDRLEN;
+    }
+  else
+#endif
+    {
+      return false;
+    }
+
+  /* Trailing padding and truncated packets are left to the network */
+
+  if (len != pkt->io_pktlen || pkt->io_len < *iphl + TCP_HDRLEN)
+    {
+      return false;
+    }
+
+  tcp    = (FAR struct tcp_hdr_s *)(l3 + *iphl);
+  *tcphl = (tcp->tcpoffset >> 4) << 2;
+
+  return *tcphl >= TCP_HDRLEN && pkt->io_len >= *iphl + *tcphl;
+}
+
+/****************************************************************************
+ * Name: netdev_upper_tcpsum
+ *
+ * Description:
+ *   Calculate the checksum of the pseudo header of a TCP packet, the
+ *   length is taken from the IP header.
+ *
+ ****************************************************************************/
+
+static uint16_t netdev_upper_tcpsum(FAR const uint8_t *l3, uint16_t iphl)
+{
+  uint16_t sum;
+
+#ifdef CONFIG_NET_IPv4
+#  ifdef CONFIG_NET_IPv6
+  if ((l3[0] & IP_VERSION_MASK) == IPv4_VERSION)
+#  endif
+    {
+      FAR const struct ipv4_hdr_s *ipv4 = (FAR const struct ipv4_hdr_s *)l3;
+
+      sum = ((uint16_t)ipv4->len[0] << 8) + ipv4->len[1] - iphl +
+            IP_PROTO_TCP;
+      return chksum(sum, (FAR const uint8_t *)ipv4->srcipaddr,
+                    2 * sizeof(in_addr_t));
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+    {
+      FAR const struct ipv6_hdr_s *ipv6 = (FAR const struct ipv6_hdr_s *)l3;
+
+      sum = ((uint16_t)ipv6->len[0] << 8) + ipv6->len[1] + IP_PROTO_TCP;
+      return chksum(sum, (FAR const uint8_t *)ipv6->srcipaddr,
+                    2 * sizeof(net_ipv6addr_t));
+    }
+#endif
+}
+#endif /* NETDEV_HAVE_TCP_OFFLOAD */
+
+/****************************************************************************
+ * Name: netdev_upper_gso
+ *
+ * Description:
+ *   Split a TCP packet larger than the MTU into segments of 'mss' bytes of
+ *   payload and queue them for transmission.  The payload is copied into
+ *   new packets, the headers of the original packet are replicated with
+ *   the length, identification, sequence number and checksums fixed up.
+ *   FIN and PSH are only kept on the last segment.
+ *
+ * Input Parameters:
+ *   upper - Reference to the upper half driver structure
+ *   pkt   - The packet to split, released on return
+ *   mss   - The payload size of the segments
+ *   iphl  - The length of the IP header
+ *   tcphl - The length of the TCP header
+ *
+ * Returned Value:
+ *   OK if all segments were queued, a negated errno value otherwise.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETDEV_GSO
+static int netdev_upper_gso(FAR struct netdev_upperhalf_s *upper,
+                            FAR netpkt_t *pkt, uint16_t mss,
+                            uint16_t iphl, uint16_t tcphl)
+{
+  FAR struct netdev_lowerhalf_s *lower = upper->lower;
+  FAR struct net_driver_s       *dev   = &lower->netdev;
+  FAR const uint8_t             *hdr   = IOB_DATA(pkt);
+  unsigned int                   llhl  = NET_LL_HDRLEN(dev);
+  unsigned int                   hl    = iphl + tcphl;
+  unsigned int                   datalen;
+  unsigned int                   offset;
+  unsigned int                   seglen;
+  FAR struct tcp_hdr_s          *tcp;
+  FAR netpkt_t                  *seg;
+  FAR uint8_t                   *l3;
+  uint16_t                       ipid = 0;
+  uint16_t                       len;
+  int                            ret  = OK;
+
+  UNUSED(ipid);
+  datalen = pkt->io_pktlen - hl;
+
+#ifdef CONFIG_NET_IPv4
+  if ((hdr[0] & IP_VERSION_MASK) == IPv4_VERSION)
+    {
+      FAR const struct ipv4_hdr_s *ipv4 =
+        (FAR const struct ipv4_hdr_s *)hdr;
+
+      ipid = ((uint16_t)ipv4->ipid[0] << 8) + ipv4->ipid[1];
+    }
+#endif
+
+  for (offset = 0; offset < datalen; offset += seglen)
+    {
+      seglen = MIN(datalen - offset, mss);
+
+      /* Build the segment with the same layout as netpkt_alloc(), the
+       * link layer header is put into the reserved space.
+       */
+
+      seg = iob_tryalloc(false);
+      if (seg == NULL)
+        {
+          ret = -ENOMEM;
+          break;
+        }
+
+      iob_reserve(seg, CONFIG_NET_LL_GUARDSIZE);
+      memcpy(IOB_DATA(seg) - llhl, hdr - llhl, llhl);
+
+      ret = iob_trycopyin(seg, hdr, hl, 0, false);
+      if (ret >= 0)
+        {
+          ret = iob_clone_partial(pkt, seglen, hl + offset, seg, hl,
+                                  false, false);
+        }
+
+      if (ret < 0)
+        {
+          iob_free_chain(seg);
+          break;
+        }
+
+      DEBUGASSERT(seg->io_len >= hl);
+
+      l3  = IOB_DATA(seg);
+      tcp = (FAR struct tcp_hdr_s *)(l3 + iphl);
+
+#ifdef CONFIG_NET_IPv4
+#  ifdef CONFIG_NET_IPv6
+      if ((l3[0] & IP_VERSION_MASK) == IPv4_VERSION)
+#  endif
+        {
+          FAR struct ipv4_hdr_s *ipv4 = (FAR struct ipv4_hdr_s *)l3;
+
+          len             = hl + seglen;
+          ipv4->len[0]    = len >> 8;
+          ipv4->len[1]    = len & 0xff;
+          ipv4->ipid[0]   = ipid >> 8;
+          ipv4->ipid[1]   = ipid & 0xff;
+          ipv4->ipchksum  = 0;
+          ipv4->ipchksum  = ~ipv4_chksum(ipv4);
+          ipid++;
+        }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+#  ifdef CONFIG_NET_IPv4
+      else
+#  endif
+        {
+          FAR struct ipv6_hdr_s *ipv6 = (FAR struct ipv6_hdr_s *)l3;
+
+          len             = tcphl + seglen;
+          ipv6->len[0]    = len >> 8;
+          ipv6->len[1]    = len & 0xff;
+        }
+#endif
+
+      net_incr32(tcp->seqno, offset);
+      if (offset + seglen < datalen)
+        {
+          tcp->flags &= ~(TCP_FIN | TCP_PSH);
+        }
+
+      tcp->tcpchksum = 0;
+#ifdef CONFIG_NET_TCP_CHECKSUMS
+      tcp->tcpchksum = ~HTONS(chksum_iob(netdev_upper_tcpsum(l3, iphl),
+                                         seg, iphl));
+#endif
+
+      /* Each segment is charged to the quota, the charge of the original
+       * packet is returned when it is released below.
+       */
+
+      if (offset > 0)
+        {
+          NETDEV_TXPACKETS(dev);
+        }
+
+      atomic_fetch_sub(&lower->quota[NETPKT_TX], 1);
+      ret = netdev_upper_txqueue(upper, seg);
+      if (ret != OK)
+        {
+          /* The error is counted and the segment is released already */
+
+          netpkt_free(lower, pkt, NETPKT_TX);
+          return ret;
+        }
+    }
+
+  if (ret < 0)
+    {
+      nerr("ERROR: Failed to segment TCP packet: %d\n", ret);
+      NETDEV_TXERRORS(dev);
+    }
+
+  netpkt_free(lower, pkt, NETPKT_TX);
+  return ret < 0 ? ret : OK;
+}
+#endif /* CONFIG_NETDEV_GSO */
+
+/****************************************************************************
+ * Name: netdev_upper_txpoll
+ *
+ * Description:
+ *   The transmitter is available, check if the network has any outgoing
+ *   packets ready to send.  This is a callback from devif_poll().
+ *   devif_poll() may be called:
+ *
+ *   1. When the preceding TX packet send is complete
+ *   2. When the preceding TX packet send times out and the interface is
+ *      reset
+ *   3. During normal TX polling
+ *
+ * Input Parameters:
+ *   dev - Reference to the NuttX driver state structure
+ *
+ * Returned Value:
+ *   Negated errno value - Error number that occurs.
+ *   NETDEV_TX_CONTINUE  - Driver can send more, continue the poll.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+static int netdev_upper_txpoll(FAR struct net_driver_s *dev)
+{
+  FAR struct netdev_upperhalf_s *upper = dev->d_private;
+  FAR struct netdev_lowerhalf_s *lower = upper->lower;
+  FAR netpkt_t                  *pkt;
+#ifdef CONFIG_NETDEV_GSO
+  uint16_t                       gsosize;
+#endif
+  int                            ret;
+
+  DEBUGASSERT(dev->d_len > 0);
+
+  NETDEV_TXPACKETS(dev);
+
+#ifdef CONFIG_NET_PKT
+  /* When packet sockets are enabled, feed the tx frame into it */
+
+  pkt_input(dev);
+#endif
+
+#ifdef CONFIG_NETDEV_GSO
+  /* The segment size is only valid for the packet polled just now */
+
+  gsosize = dev->d_gsosize;
+  dev->d_gsosize = 0;
+#endif
+
+  pkt = netpkt_get(dev, NETPKT_TX);
+
+  if (netpkt_getdatalen(lower, pkt) > NETDEV_PKTSIZE(dev))
+    {
+#ifdef CONFIG_NETDEV_GSO
+      uint16_t iphl;
+      uint16_t tcphl;
+
+      if (gsosize > 0 && netdev_upper_tcpinfo(pkt, &iphl, &tcphl))
+        {
+          ret = netdev_upper_gso(upper, pkt, gsosize, iphl, tcphl);
+          return ret == OK ? NETDEV_TX_CONTINUE : ret;
+        }
+#endif
+
+      nerr("ERROR: Packet too long to send!\n");
+      NETDEV_TXERRORS(dev);
+      netpkt_put(dev, pkt, NETPKT_TX);
+      return -EMSGSIZE;
+    }
+
+  /* Collect the packet into the batch if there is one, it is sent after
+   * the network is unlocked.  Stop polling on any error.
+   * REVISIT: maybe store the pkt in upper half and retry later?
+   */
+
+  ret = netdev_upper_txqueue(upper, pkt);
+  return ret == OK ? NETDEV_TX_CONTINUE : ret;
+}
+
+/****************************************************************************
+ * Name: netdev_upper_tx
+ *
+ * Description:
+ *   Do the actual transmission of packets, including pre-queued packets and
+ *   packets from the network stack.
+ *
+ * Input Parameters:
+ *   dev - Reference to the NuttX driver state structure
+ *
+ * Returned Value:
+ *   Negated errno value - Error number that occurs.
+ *   NETDEV_TX_CONTINUE  - Driver can send more, continue the poll.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+static int netdev_upper_tx(FAR struct net_driver_s *dev)
+{
+#ifdef CONFIG_NETDEV_GSO
+  int ret;
+#endif
+#if CONFIG_IOB_NCHAINS > 0
+  FAR struct netdev_upperhalf_s *upper = dev->d_private;
+
+  if (!IOB_QEMPTY(&upper->txq))
+    {
+      /* Put the packet back to the device */
+
+      netdev_iob_replace(dev, iob_remove_queue(&upper->txq));
+      return netdev_upper_txpoll(dev);
+    }
+#endif
+
+  /* No more TX packets in queue, poll the net stack to get more packets */
+
+#ifdef CONFIG_NETDEV_GSO
+  /* TCP may hand down packets larger than the MTU during this poll, they
+   * are segmented by netdev_upper_txpoll().
+   */
+
+  dev->d_gsomax = CONFIG_NETDEV_GSO_MAXSIZE;
+  ret = devif_poll(dev, netdev_upper_txpoll);
+  dev->d_gsomax = 0;
+
+  return ret;
+#else
+  return devif_poll(dev, netdev_upper_txpoll);
+#endif
+}
+
+/****************************************************************************
+ * Name: netdev_upper_txavail_work
+ *
+ * Description:
+ *   Perform an out-of-cycle tx poll on the worker thread, collecting the
+ *   outgoing packets into a batch.
+ *
+ * Input Parameters:
+ *   upper - Reference to the upper half driver structure
+ *   batch - The batch to collect the packets into
+ *
+ * Returned Value:
+ *   True if the poll stopped because the batch is full.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+static bool netdev_upper_txavail_work(FAR struct netdev_upperhalf_s *upper,
+                                      FAR struct netdev_upper_batch_s *batch)
+{
+  FAR struct net_driver_s *dev = &upper->lower->netdev;
+
+  /* Ignore the notification if the interface is not yet up */
+
+  if (IFF_IS_UP(dev->d_flags))
+    {
+      DEBUGASSERT(dev->d_buf == NULL); /* Make sure: IOB only. */
+
+      upper->txbatch = batch;
+      while (batch->npkts < CONFIG_NETDEV_PKT_BATCH &&
+             netdev_upper_can_tx(upper) &&
+             netdev_upper_tx(dev) == NETDEV_TX_CONTINUE);
+      upper->txbatch = NULL;
+    }
+
+  return batch->npkts >= CONFIG_NETDEV_PKT_BATCH;
+}
+
+/****************************************************************************
+ * Name: netdev_upper_queue_tx
+ *
+ * Description:
+ *   Queue a TX packet to the upper half for sending later.
+ *
+ * Input Parameters:
+ *   dev - Reference to the NuttX driver state structure
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_NET_LOOPBACK) || defined(CONFIG_NET_ETHERNET) || \
+    defined(CONFIG_DRIVERS_IEEE80211) || defined(CONFIG_NET_MBIM)
+static void netdev_upper_queue_tx(FAR struct net_driver_s *dev)
+{
+#if CONFIG_IOB_NCHAINS > 0
+  FAR struct netdev_upperhalf_s *upper = dev->d_private;
+  int ret;
+
+  if ((ret = iob_tryadd_queue(dev->d_iob, &upper->txq)) >= 0)
+    {
+      netdev_iob_clear(dev);
+    }
+  else
+    {
+      nwarn("WARNING: Failed to queue TX packet, dropping: %d\n", ret);
+    }
+#else
+  /* Fall back to send the packet directly if we don't have IOB queue. */
+
+  netdev_upper_txpoll(dev);
+#endif
+}
+#endif
+
+/****************************************************************************
+ * Name: eth_input
+ *
+ * Description:
+ *   Handle L2 packet input.
+ *
+ * Input Parameters:
+ *   dev - Reference to the NuttX network driver state structure
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_NET_LOOPBACK) || defined(CONFIG_NET_ETHERNET) || \
+    defined(CONFIG_DRIVERS_IEEE80211)
+static void eth_input(FAR struct net_driver_s *dev)
+{
+  FAR struct eth_hdr_s *eth_hdr = (FAR struct eth_hdr_s *)NETLLBUF;
+
+  /* Check if this is an 802.1Q VLAN tagged packet */
+
+  if (eth_hdr->type == HTONS(TPID_8021QVLAN))
+    {
+      /* Need to remove the 4 octet VLAN Tag, by moving src and dest
+       * addresses 4 octets to the right, and then read the actual
+       * ethertype. The VLAN ID and priority fields are currently
+       * ignored.
+       */
+
+      memmove((FAR uint8_t *)eth_hdr + 4, eth_hdr,
+              offsetof(struct eth_hdr_s, type));
+      dev->d_iob  = iob_trimhead(dev->d_iob, 4);
+      dev->d_len -= 4;
+
+      eth_hdr = (FAR struct eth_hdr_s *)NETLLBUF;
+    }
+
+  /* We only accept IP packets of the configured type and ARP packets */
 
 #ifdef CONFIG_NET_IPv4
   if (eth_hdr->type == HTONS(ETHTYPE_IP))
@@ -507,107 +1246,523 @@ static void eth_input(FAR struct net_driver_s *dev)
    * the field d_len will set to a value > 0.
    */
 
-  if (dev->d_len > 0)
-    {
-      /* And queue the packet for sending later.
-       * Note: RX is tried before TX, so we don't need to call txavail here.
-       */
+  if (dev->d_len > 0)
+    {
+      /* And queue the packet for sending later.
+       * Note: RX is tried before TX, so we don't need to call txavail here.
+       */
+
+      netdev_upper_queue_tx(dev);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: ip_input
+ *
+ * Description:
+ *   Handle L3 packet input.
+ *
+ * Input Parameters:
+ *   dev - Reference to the NuttX network driver state structure
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_MBIM
+static void ip_input(FAR struct net_driver_s *dev)
+{
+  /* We only accept IP packets of the configured type */
+
+#ifdef CONFIG_NET_IPv4
+  if ((IPv4BUF->vhl & IP_VERSION_MASK) == IPv4_VERSION)
+    {
+      ninfo("IPv4 frame\n");
+      NETDEV_RXIPV4(dev);
+
+      /* Receive an IPv4 packet from the network device */
+
+      ipv4_input(dev);
+    }
+  else
+#endif
+#ifdef CONFIG_NET_IPv6
+  if ((IPv6BUF->vtc & IP_VERSION_MASK) == IPv6_VERSION)
+    {
+      ninfo("IPv6 frame\n");
+      NETDEV_RXIPV6(dev);
+
+      /* Give the IPv6 packet to the network layer */
+
+      ipv6_input(dev);
+    }
+  else
+#endif
+    {
+      ninfo("INFO: Dropped, Unknown type\n");
+      NETDEV_RXDROPPED(dev);
+      dev->d_len = 0;
+    }
+
+  /* If the above function invocation resulted in data
+   * that should be sent out on the network,
+   * the field d_len will set to a value > 0.
+   */
+
+  if (dev->d_len > 0)
+    {
+      /* And queue the packet for sending later.
+       * Note: RX is tried before TX, so we don't need to call txavail here.
+       */
+
+      netdev_upper_queue_tx(dev);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: netdev_upper_gro_hdr
+ *
+ * Description:
+ *   Check if a received packet is a TCP segment that may be merged with
+ *   others: an in-order data segment with only ACK and maybe PSH set,
+ *   addressed to this device, without IP options and with a valid IP
+ *   header.
+ *
+ * Returned Value:
+ *   The IP header of the packet, or NULL if it can not be merged.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETDEV_GRO
+static FAR uint8_t *netdev_upper_gro_hdr(FAR struct net_driver_s *dev,
+                                         FAR netpkt_t *pkt,
+                                         FAR uint16_t *iphl,
+                                         FAR uint16_t *tcphl)
+{
+  FAR struct eth_hdr_s *eth;
+  FAR struct tcp_hdr_s *tcp;
+  FAR uint8_t *l3 = IOB_DATA(pkt);
+
+  if (!netdev_upper_tcpinfo(pkt, iphl, tcphl) ||
+      pkt->io_pktlen == *iphl + *tcphl)
+    {
+      return NULL;
+    }
+
+  tcp = (FAR struct tcp_hdr_s *)(l3 + *iphl);
+  if ((tcp->flags & ~TCP_PSH) != TCP_ACK)
+    {
+      return NULL;
+    }
+
+  /* The link layer header is dropped when the segments are merged, so it
+   * must be plain Ethernet of the same IP version.
+   */
+
+  eth = (FAR struct eth_hdr_s *)(l3 - ETH_HDRLEN);
+
+#ifdef CONFIG_NET_IPv4
+  if ((l3[0] & IP_VERSION_MASK) == IPv4_VERSION)
+    {
+      FAR struct ipv4_hdr_s *ipv4 = (FAR struct ipv4_hdr_s *)l3;
+
+      if (eth->type != HTONS(ETHTYPE_IP) || *iphl != IPv4_HDRLEN ||
+          !net_ipv4addr_cmp(net_ip4addr_conv32(ipv4->destipaddr),
+                            dev->d_ipaddr) ||
+          ipv4_chksum(ipv4) != 0xffff)
+        {
+          return NULL;
+        }
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  if ((l3[0] & IP_VERSION_MASK) == IPv6_VERSION)
+    {
+      FAR struct ipv6_hdr_s *ipv6 = (FAR struct ipv6_hdr_s *)l3;
+
+      if (eth->type != HTONS(ETHTYPE_IP6) ||
+          !NETDEV_IS_MY_V6ADDR(dev, ipv6->destipaddr))
+        {
+          return NULL;
+        }
+    }
+#endif
+
+  return l3;
+}
+
+/****************************************************************************
+ * Name: netdev_upper_gro_flush
+ *
+ * Description:
+ *   Finish the merged packet, fixing up the IP length and the checksums of
+ *   the headers of the first segment.
+ *
+ ****************************************************************************/
+
+static void netdev_upper_gro_flush(FAR struct netdev_upper_gro_s *gro)
+{
+  FAR uint8_t *l3 = IOB_DATA(gro->pkt);
+  FAR struct tcp_hdr_s *tcp = (FAR struct tcp_hdr_s *)(l3 + gro->iphl);
+  uint16_t len = gro->pkt->io_pktlen;
+  uint32_t sum;
+
+  if (gro->nsegs > 1)
+    {
+#ifdef CONFIG_NET_IPv4
+#  ifdef CONFIG_NET_IPv6
+      if ((l3[0] & IP_VERSION_MASK) == IPv4_VERSION)
+#  endif
+        {
+          FAR struct ipv4_hdr_s *ipv4 = (FAR struct ipv4_hdr_s *)l3;
+
+          ipv4->len[0]   = len >> 8;
+          ipv4->len[1]   = len & 0xff;
+          ipv4->ipchksum = 0;
+          ipv4->ipchksum = ~ipv4_chksum(ipv4);
+        }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+#  ifdef CONFIG_NET_IPv4
+      else
+#  endif
+        {
+          FAR struct ipv6_hdr_s *ipv6 = (FAR struct ipv6_hdr_s *)l3;
+
+          len           -= IPv6_HDRLEN;
+          ipv6->len[0]   = len >> 8;
+          ipv6->len[1]   = len & 0xff;
+        }
+#endif
+
+      /* The payload was summed up segment by segment, add the headers */
+
+      tcp->tcpchksum = 0;
+      sum = chksum(netdev_upper_tcpsum(l3, gro->iphl), (FAR uint8_t *)tcp,
+                   gro->tcphl);
+      sum += gro->sum;
+      sum  = (sum & 0xffff) + (sum >> 16);
+      tcp->tcpchksum = ~HTONS((uint16_t)sum);
+    }
+
+  gro->pkt = NULL;
+}
+
+/****************************************************************************
+ * Name: netdev_upper_gro_start
+ *
+ * Description:
+ *   Start merging into a received packet if it is a candidate.
+ *
+ ****************************************************************************/
+
+static void netdev_upper_gro_start(FAR struct net_driver_s *dev,
+                                   FAR struct netdev_upper_gro_s *gro,
+                                   FAR netpkt_t *pkt)
+{
+  FAR struct tcp_hdr_s *tcp;
+  FAR uint8_t *l3;
+  uint16_t datalen;
+
+  l3 = netdev_upper_gro_hdr(dev, pkt, &gro->iphl, &gro->tcphl);
+  if (l3 == NULL)
+    {
+      return;
+    }
+
+  /* A segment with PSH set ends the merge */
+
+  tcp = (FAR struct tcp_hdr_s *)(l3 + gro->iphl);
+  if ((tcp->flags & TCP_PSH) != 0)
+    {
+      return;
+    }
+
+  /* The sum of the payload is what is left of the TCP checksum without the
+   * headers.  A corrupted segment leaves a wrong sum, which then fails the
+   * check of the merged packet in the network.
+   */
+
+  datalen       = pkt->io_pktlen - gro->iphl - gro->tcphl;
+  gro->pkt      = pkt;
+  gro->nsegs    = 1;
+  gro->sum      = ~chksum(netdev_upper_tcpsum(l3, gro->iphl),
+                          (FAR uint8_t *)tcp, gro->tcphl);
+  gro->nextseq  = (((uint32_t)tcp->seqno[0] << 24) |
+                   ((uint32_t)tcp->seqno[1] << 16) |
+                   ((uint32_t)tcp->seqno[2] << 8) |
+                   (uint32_t)tcp->seqno[3]) + datalen;
+}
+
+/****************************************************************************
+ * Name: netdev_upper_gro_merge
+ *
+ * Description:
+ *   Try to merge a received packet into the packet being merged.  The
+ *   packet must be the next segment of the same flow with identical
+ *   headers other than the length, the sequence number and the window.
+ *
+ * Returned Value:
+ *   True if the packet was merged and released.
+ *
+ ****************************************************************************/
+
+static bool netdev_upper_gro_merge(FAR struct net_driver_s *dev,
+                                   FAR struct netdev_upper_gro_s *gro,
+                                   FAR netpkt_t *pkt)
+{
+  FAR struct tcp_hdr_s *tcp1;
+  FAR struct tcp_hdr_s *tcp2;
+  FAR uint8_t *l31 = IOB_DATA(gro->pkt);
+  FAR uint8_t *l32;
+  uint32_t seqno;
+  uint32_t sum;
+  uint16_t datalen;
+  uint16_t iphl;
+  uint16_t tcphl;
+  bool psh;
+
+  /* The payload of the merged packet must stay 16-bit aligned for the
+   * checksum, and the packet must fit into d_len.
+   */
+
+  if (((gro->pkt->io_pktlen - gro->iphl - gro->tcphl) & 1) != 0)
+    {
+      return false;
+    }
+
+  l32 = netdev_upper_gro_hdr(dev, pkt, &iphl, &tcphl);
+  if (l32 == NULL || iphl != gro->iphl || tcphl != gro->tcphl ||
+      (l31[0] & IP_VERSION_MASK) != (l32[0] & IP_VERSION_MASK))
+    {
+      return false;
+    }
+
+  datalen = pkt->io_pktlen - iphl - tcphl;
+  if (gro->pkt->io_pktlen + datalen + NET_LL_HDRLEN(dev) > UINT16_MAX)
+    {
+      return false;
+    }
+
+#ifdef CONFIG_NET_IPv4
+  if ((l31[0] & IP_VERSION_MASK) == IPv4_VERSION)
+    {
+      FAR struct ipv4_hdr_s *ipv41 = (FAR struct ipv4_hdr_s *)l31;
+      FAR struct ipv4_hdr_s *ipv42 = (FAR struct ipv4_hdr_s *)l32;
+
+      if (ipv41->tos != ipv42->tos || ipv41->ttl != ipv42->ttl ||
+          memcmp(ipv41->srcipaddr, ipv42->srcipaddr,
+                 2 * sizeof(in_addr_t)) != 0)
+        {
+          return false;
+        }
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  if ((l31[0] & IP_VERSION_MASK) == IPv6_VERSION)
+    {
+      FAR struct ipv6_hdr_s *ipv61 = (FAR struct ipv6_hdr_s *)l31;
+      FAR struct ipv6_hdr_s *ipv62 = (FAR struct ipv6_hdr_s *)l32;
+
+      /* Compare the traffic class, flow label, hop limit and addresses */
+
+      if (memcmp(ipv61, ipv62, 4) != 0 || ipv61->ttl != ipv62->ttl ||
+          memcmp(ipv61->srcipaddr, ipv62->srcipaddr,
+                 2 * sizeof(net_ipv6addr_t)) != 0)
+        {
+          return false;
+        }
+    }
+#endif
+
+  /* Same ports and acknowledgment, the next sequence number and the same
+   * TCP options.
+   */
+
+  tcp1  = (FAR struct tcp_hdr_s *)(l31 + iphl);
+  tcp2  = (FAR struct tcp_hdr_s *)(l32 + iphl);
+  seqno = ((uint32_t)tcp2->seqno[0] << 24) |
+          ((uint32_t)tcp2->seqno[1] << 16) |
+          ((uint32_t)tcp2->seqno[2] << 8) |
+          (uint32_t)tcp2->seqno[3];
+
+  if (seqno != gro->nextseq ||
+      tcp1->srcport != tcp2->srcport || tcp1->destport != tcp2->destport ||
+      memcmp(tcp1->ackno, tcp2->ackno, sizeof(tcp1->ackno)) != 0 ||
+      memcmp(tcp1->optdata, tcp2->optdata, tcphl - TCP_HDRLEN) != 0)
+    {
+      return false;
+    }
+
+  /* Add up the payload sum and take the latest window and PSH */
+
+  sum = ~chksum(netdev_upper_tcpsum(l32, iphl), (FAR uint8_t *)tcp2,
+                tcphl) & 0xffff;
+  sum += gro->sum;
+  gro->sum = (sum & 0xffff) + (sum >> 16);
 
-      netdev_upper_queue_tx(dev);
+  tcp1->wnd[0]  = tcp2->wnd[0];
+  tcp1->wnd[1]  = tcp2->wnd[1];
+  tcp1->flags  |= tcp2->flags & TCP_PSH;
+  gro->nextseq += datalen;
+  gro->nsegs++;
+
+  psh = (tcp2->flags & TCP_PSH) != 0;
+  iob_concat(gro->pkt, iob_trimhead(pkt, iphl + tcphl));
+
+  if (psh)
+    {
+      netdev_upper_gro_flush(gro);
     }
+
+  return true;
 }
-#endif
 
 /****************************************************************************
- * Name: ip_input
+ * Name: netdev_upper_gro
  *
  * Description:
- *   Handle L3 packet input.
+ *   Merge consecutive in-order TCP segments of the same flow in a batch of
+ *   received packets, so that the network processes them at once.
  *
  * Input Parameters:
- *   dev - Reference to the NuttX network driver state structure
- *
- * Assumptions:
- *   Called with the network locked.
+ *   upper - Reference to the upper half driver structure
+ *   batch - The received packets, compacted in place
  *
  ****************************************************************************/
 
-#ifdef CONFIG_NET_MBIM
-static void ip_input(FAR struct net_driver_s *dev)
+static void netdev_upper_gro(FAR struct netdev_upperhalf_s *upper,
+                             FAR struct netdev_upper_batch_s *batch)
 {
-  /* We only accept IP packets of the configured type */
+  FAR struct netdev_lowerhalf_s *lower = upper->lower;
+  FAR struct net_driver_s       *dev   = &lower->netdev;
+  struct netdev_upper_gro_s      gro;
+  FAR netpkt_t                  *pkt;
+  int                            npkts = 0;
+  int                            i;
 
-#ifdef CONFIG_NET_IPv4
-  if ((IPv4BUF->vhl & IP_VERSION_MASK) == IPv4_VERSION)
+  if (batch->npkts < 2 || (dev->d_lltype != NET_LL_ETHERNET &&
+                           dev->d_lltype != NET_LL_IEEE80211))
     {
-      ninfo("IPv4 frame\n");
-      NETDEV_RXIPV4(dev);
-
-      /* Receive an IPv4 packet from the network device */
-
-      ipv4_input(dev);
+      return;
     }
-  else
-#endif
-#ifdef CONFIG_NET_IPv6
-  if ((IPv6BUF->vtc & IP_VERSION_MASK) == IPv6_VERSION)
+
+  gro.pkt = NULL;
+  for (i = 0; i < batch->npkts; i++)
     {
-      ninfo("IPv6 frame\n");
-      NETDEV_RXIPV6(dev);
+      pkt = batch->pkts[i];
 
-      /* Give the IPv6 packet to the network layer */
+      if (gro.pkt != NULL && netdev_upper_gro_merge(dev, &gro, pkt))
+        {
+          /* The merged packet is handed back to the network as one */
 
-      ipv6_input(dev);
+          atomic_fetch_add(&lower->quota[NETPKT_RX], 1);
+          NETDEV_RXPACKETS(dev);
+          continue;
+        }
+
+      if (gro.pkt != NULL)
+        {
+          netdev_upper_gro_flush(&gro);
+        }
+
+      batch->pkts[npkts++] = pkt;
+      netdev_upper_gro_start(dev, &gro, pkt);
     }
-  else
-#endif
+
+  if (gro.pkt != NULL)
     {
-      ninfo("INFO: Dropped, Unknown type\n");
-      NETDEV_RXDROPPED(dev);
-      dev->d_len = 0;
+      netdev_upper_gro_flush(&gro);
     }
 
-  /* If the above function invocation resulted in data
-   * that should be sent out on the network,
-   * the field d_len will set to a value > 0.
-   */
+  batch->npkts = npkts;
+}
+#endif /* CONFIG_NETDEV_GRO */
 
-  if (dev->d_len > 0)
+/****************************************************************************
+ * Function: netdev_upper_rxfetch
+ *
+ * Description:
+ *   Retrieve a batch of received packets from a queue of the device.
+ *
+ * Input Parameters:
+ *   upper - Reference to the upper half driver structure
+ *   queue - The queue to receive from
+ *   batch - The batch to fill
+ *
+ * Assumptions:
+ *   Called with the queue locked.
+ *
+ ****************************************************************************/
+
+static void netdev_upper_rxfetch(FAR struct netdev_upperhalf_s *upper,
+                                 int queue,
+                                 FAR struct netdev_upper_batch_s *batch)
+{
+  FAR struct netdev_lowerhalf_s *lower = upper->lower;
+  FAR netpkt_t                  *pkt;
+
+  batch->npkts = 0;
+  while (batch->npkts < CONFIG_NETDEV_PKT_BATCH)
     {
-      /* And queue the packet for sending later.
-       * Note: RX is tried before TX, so we don't need to call txavail here.
-       */
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+      if (NETDEV_UPPER_MQ(upper))
+        {
+          pkt = lower->ops->receiveq(lower, queue);
+        }
+      else
+#endif
+        {
+          pkt = lower->ops->receive(lower);
+        }
 
-      netdev_upper_queue_tx(dev);
+      if (pkt == NULL)
+        {
+          break;
+        }
+
+      batch->pkts[batch->npkts++] = pkt;
     }
 }
-#endif
 
 /****************************************************************************
  * Function: netdev_upper_rxpoll_work
  *
  * Description:
- *   Try to receive packets from device and pass packets into IP
- *   stack and send packets which is from IP stack if necessary.
+ *   Pass a batch of received packets into IP stack and send packets which
+ *   is from IP stack if necessary.
  *
  * Input Parameters:
  *   upper - Reference to the upper half driver structure
+ *   batch - The received packets
  *
  * Assumptions:
  *   Called with the network locked.
  *
  ****************************************************************************/
 
-static void netdev_upper_rxpoll_work(FAR struct netdev_upperhalf_s *upper)
+static void netdev_upper_rxpoll_work(FAR struct netdev_upperhalf_s *upper,
+                                     FAR struct netdev_upper_batch_s *batch)
 {
   FAR struct netdev_lowerhalf_s *lower = upper->lower;
   FAR struct net_driver_s       *dev   = &lower->netdev;
   FAR netpkt_t                  *pkt;
+  int                            i;
 
-  /* Loop while receive() successfully retrieves valid Ethernet frames. */
+#ifdef CONFIG_NETDEV_GRO
+  netdev_upper_gro(upper, batch);
+#endif
 
-  while ((pkt = lower->ops->receive(lower)) != NULL)
+  for (i = 0; i < batch->npkts; i++)
     {
+      pkt = batch->pkts[i];
+
       if (!IFF_IS_UP(dev->d_flags))
         {
           /* Interface down, drop frame */
@@ -665,23 +1820,73 @@ static void netdev_upper_rxpoll_work(FAR struct netdev_upperhalf_s *upper)
  *
  * Description:
  *   Perform an out-of-cycle poll on a dedicated thread or the worker thread.
+ *   The packets are received from the given queue, the packets sent may go
+ *   to any queue.
  *
  * Input Parameters:
- *   arg - Reference to the upper half driver structure (cast to void *)
+ *   upper - Reference to the upper half driver structure
+ *   queue - The queue serviced by this thread
  *
  ****************************************************************************/
 
-static void netdev_upper_work(FAR void *arg)
+static void netdev_upper_work(FAR struct netdev_upperhalf_s *upper,
+                              int queue)
 {
-  FAR struct netdev_upperhalf_s *upper = arg;
+  struct netdev_upper_batch_s batch;
+  bool full;
+
+  /* RX may release quota and driver buffer, so do RX first.  The packets
+   * are fetched from the lower half in batches, only the protocol
+   * processing is done with the network locked.
+   */
 
-  /* RX may release quota and driver buffer, so do RX first. */
+  do
+    {
+      netdev_upper_qlock(upper, queue);
+      netdev_upper_rxfetch(upper, queue, &batch);
+      netdev_upper_qunlock(upper, queue);
+
+      if (batch.npkts > 0)
+        {
+          net_lock();
+          netdev_upper_rxpoll_work(upper, &batch);
+          net_unlock();
+        }
+    }
+  while (batch.npkts == CONFIG_NETDEV_PKT_BATCH);
+
+  /* The queues are locked before the network is unlocked, so that batches
+   * polled by different threads reach the lower half in order.
+   */
+
+  batch.npkts = 0;
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  batch.queues = 0;
+#endif
+
+  do
+    {
+      net_lock();
+      full = netdev_upper_txavail_work(upper, &batch);
+      netdev_upper_batch_lock(upper, &batch);
+      net_unlock();
+
+      if (netdev_upper_txflush(upper, &batch) != OK)
+        {
+          full = false;
+        }
+
+      netdev_upper_batch_unlock(upper, &batch);
+    }
+  while (full);
+}
 
-  net_lock();
-  netdev_upper_rxpoll_work(upper);
-  netdev_upper_txavail_work(upper);
-  net_unlock();
+#ifndef CONFIG_NETDEV_WORK_THREAD
+static void netdev_upper_worker(FAR void *arg)
+{
+  netdev_upper_work(arg, 0);
 }
+#endif
 
 /****************************************************************************
  * Name: netdev_upper_wait
@@ -704,6 +1909,50 @@ static int netdev_upper_wait(FAR sem_t *sem)
 #endif
 }
 
+/****************************************************************************
+ * Name: netdev_upper_nthreads
+ *
+ * Description:
+ *   The number of work threads of a device: one for each queue, or one for
+ *   each CPU with RSS.
+ *
+ ****************************************************************************/
+
+static int netdev_upper_nthreads(FAR struct netdev_upperhalf_s *upper)
+{
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  if (NETDEV_UPPER_MQ(upper))
+    {
+      return upper->lower->nqueues;
+    }
+#endif
+
+#ifdef CONFIG_NETDEV_RSS
+  return CONFIG_SMP_NCPUS;
+#else
+  return 1;
+#endif
+}
+
+/****************************************************************************
+ * Name: netdev_upper_post
+ *
+ * Description:
+ *   Wake up a work thread.
+ *
+ ****************************************************************************/
+
+static void netdev_upper_post(FAR struct netdev_upperhalf_s *upper, int i)
+{
+  int semcount;
+
+  if (nxsem_get_value(&upper->sem[i], &semcount) == OK &&
+      semcount <= 0)
+    {
+      nxsem_post(&upper->sem[i]);
+    }
+}
+
 /****************************************************************************
  * Name: netdev_upper_loop
  *
@@ -718,18 +1967,22 @@ static int netdev_upper_loop(int argc, FAR char *argv[])
     (FAR struct netdev_upperhalf_s *)((uintptr_t)strtoul(argv[1], NULL, 16));
   int cpu = atoi(argv[2]);
 
-#ifdef CONFIG_NETDEV_RSS
+#if defined(CONFIG_NETDEV_RSS) || defined(CONFIG_NETDEV_MULTIQUEUE)
   cpu_set_t cpuset;
 
   CPU_ZERO(&cpuset);
-  CPU_SET(cpu, &cpuset);
+  CPU_SET(cpu % CONFIG_SMP_NCPUS, &cpuset);
   sched_setaffinity(upper->tid[cpu], sizeof(cpu_set_t), &cpuset);
 #endif
 
+  /* The thread of each queue services that queue, while the threads of a
+   * single queue device all service the only one.
+   */
+
   while (netdev_upper_wait(&upper->sem[cpu]) == OK &&
          upper->tid[cpu] != INVALID_PROCESS_ID)
     {
-      netdev_upper_work(upper);
+      netdev_upper_work(upper, NETDEV_UPPER_MQ(upper) ? cpu : 0);
     }
 
   nwarn("WARNING: Netdev work thread quitting.");
@@ -754,24 +2007,17 @@ static inline void netdev_upper_queue_work(FAR struct net_driver_s *dev)
   FAR struct netdev_upperhalf_s *upper = dev->d_private;
 
 #ifdef CONFIG_NETDEV_WORK_THREAD
-#  ifdef CONFIG_NETDEV_RSS
-  int cpu = this_cpu();
+#  if defined(CONFIG_NETDEV_RSS) || defined(CONFIG_NETDEV_MULTIQUEUE)
+  netdev_upper_post(upper, this_cpu() % netdev_upper_nthreads(upper));
 #  else
-  const int cpu = 0;
+  netdev_upper_post(upper, 0);
 #  endif
-  int semcount;
-
-  if (nxsem_get_value(&upper->sem[cpu], &semcount) == OK &&
-      semcount <= 0)
-    {
-      nxsem_post(&upper->sem[cpu]);
-    }
 #else
   if (work_available(&upper->work))
     {
       /* Schedule to serialize the poll on the worker thread. */
 
-      work_queue(NETDEV_WORK, &upper->work, netdev_upper_work, upper, 0);
+      work_queue(NETDEV_WORK, &upper->work, netdev_upper_worker, upper, 0);
     }
 #endif
 }
@@ -1053,7 +2299,7 @@ static int netdev_upper_ifup(FAR struct net_driver_s *dev)
 
   /* Try to bring up a dedicated thread for work. */
 
-  for (i = 0; i < NETDEV_THREAD_COUNT; i++)
+  for (i = 0; i < netdev_upper_nthreads(upper); i++)
     {
       if (upper->tid[i] <= 0)
         {
@@ -1086,7 +2332,12 @@ static int netdev_upper_ifup(FAR struct net_driver_s *dev)
 
   if (upper->lower->ops->ifup)
     {
-      return upper->lower->ops->ifup(upper->lower);
+      int ret;
+
+      netdev_upper_lock_all(upper);
+      ret = upper->lower->ops->ifup(upper->lower);
+      netdev_upper_unlock_all(upper);
+      return ret;
     }
 
   return -ENOSYS;
@@ -1102,7 +2353,12 @@ static int netdev_upper_ifdown(FAR struct net_driver_s *dev)
 
   if (upper->lower->ops->ifdown)
     {
-      return upper->lower->ops->ifdown(upper->lower);
+      int ret;
+
+      netdev_upper_lock_all(upper);
+      ret = upper->lower->ops->ifdown(upper->lower);
+      netdev_upper_unlock_all(upper);
+      return ret;
     }
 
   return -ENOSYS;
@@ -1116,7 +2372,12 @@ static int netdev_upper_addmac(FAR struct net_driver_s *dev,
 
   if (upper->lower->ops->addmac)
     {
-      return upper->lower->ops->addmac(upper->lower, mac);
+      int ret;
+
+      netdev_upper_lock_all(upper);
+      ret = upper->lower->ops->addmac(upper->lower, mac);
+      netdev_upper_unlock_all(upper);
+      return ret;
     }
 
   return -ENOSYS;
@@ -1131,7 +2392,12 @@ static int netdev_upper_rmmac(FAR struct net_driver_s *dev,
 
   if (upper->lower->ops->rmmac)
     {
-      return upper->lower->ops->rmmac(upper->lower, mac);
+      int ret;
+
+      netdev_upper_lock_all(upper);
+      ret = upper->lower->ops->rmmac(upper->lower, mac);
+      netdev_upper_unlock_all(upper);
+      return ret;
     }
 
   return -ENOSYS;
@@ -1158,7 +2424,12 @@ static int netdev_upper_ioctl(FAR struct net_driver_s *dev, int cmd,
 
   if (lower->ops->ioctl)
     {
-      return lower->ops->ioctl(lower, cmd, arg);
+      int ret;
+
+      netdev_upper_lock_all(upper);
+      ret = lower->ops->ioctl(lower, cmd, arg);
+      netdev_upper_unlock_all(upper);
+      return ret;
     }
 
   return -ENOTTY;
@@ -1191,12 +2462,27 @@ int netdev_lower_register(FAR struct netdev_lowerhalf_s *dev,
 {
   FAR struct netdev_upperhalf_s *upper;
   int ret;
-#ifdef CONFIG_NETDEV_WORK_THREAD
+#if defined(CONFIG_NETDEV_WORK_THREAD) || defined(CONFIG_NETDEV_MULTIQUEUE)
   int i;
 #endif
 
-  if (dev == NULL || quota_is_valid(dev) == false || dev->ops == NULL ||
-      dev->ops->transmit == NULL || dev->ops->receive == NULL)
+  if (dev == NULL || quota_is_valid(dev) == false || dev->ops == NULL)
+    {
+      return -EINVAL;
+    }
+
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  if (dev->nqueues > 1)
+    {
+      if (dev->nqueues > CONFIG_NETDEV_MAX_QUEUES ||
+          dev->ops->transmitq == NULL || dev->ops->receiveq == NULL)
+        {
+          return -EINVAL;
+        }
+    }
+  else
+#endif
+  if (dev->ops->transmit == NULL || dev->ops->receive == NULL)
     {
       return -EINVAL;
     }
@@ -1221,6 +2507,16 @@ int netdev_lower_register(FAR struct netdev_lowerhalf_s *dev,
   ret = netdev_register(&dev->netdev, lltype);
   if (ret < 0)
     {
+#ifdef CONFIG_NETDEV_SPLIT_LOCK
+      nxmutex_destroy(&upper->lock);
+#endif
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+      for (i = 0; i < CONFIG_NETDEV_MAX_QUEUES; i++)
+        {
+          nxmutex_destroy(&upper->qlock[i]);
+        }
+
+#endif
       kmm_free(upper);
       dev->netdev.d_private = NULL;
     }
@@ -1255,7 +2551,7 @@ int netdev_lower_unregister(FAR struct netdev_lowerhalf_s *dev)
 {
   FAR struct netdev_upperhalf_s *upper;
   int ret;
-#ifdef CONFIG_NETDEV_WORK_THREAD
+#if defined(CONFIG_NETDEV_WORK_THREAD) || defined(CONFIG_NETDEV_MULTIQUEUE)
   int i;
 #endif
 
@@ -1292,6 +2588,16 @@ int netdev_lower_unregister(FAR struct netdev_lowerhalf_s *dev)
   iob_free_queue(&upper->txq);
 #endif
 
+#ifdef CONFIG_NETDEV_SPLIT_LOCK
+  nxmutex_destroy(&upper->lock);
+#endif
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  for (i = 0; i < CONFIG_NETDEV_MAX_QUEUES; i++)
+    {
+      nxmutex_destroy(&upper->qlock[i]);
+    }
+
+#endif
   kmm_free(upper);
   dev->netdev.d_private = NULL;
 
@@ -1369,6 +2675,149 @@ void netdev_lower_txdone(FAR struct netdev_lowerhalf_s *dev)
 #endif
 }
 
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+/****************************************************************************
+ * Name: netdev_lower_rxready_queue
+ *
+ * Description:
+ *   Notifies the networking layer about an RX packet is ready to read on a
+ *   queue, the thread of that queue is woken up.
+ *
+ * Input Parameters:
+ *   dev   - The lower half device driver structure
+ *   queue - The queue with RX packets ready
+ *
+ ****************************************************************************/
+
+void netdev_lower_rxready_queue(FAR struct netdev_lowerhalf_s *dev,
+                                int queue)
+{
+#if CONFIG_NETDEV_WORK_THREAD_POLLING_PERIOD == 0
+  FAR struct netdev_upperhalf_s *upper = dev->netdev.d_private;
+
+  DEBUGASSERT(queue == 0 || (queue > 0 && queue < dev->nqueues));
+  netdev_upper_post(upper, queue % netdev_upper_nthreads(upper));
+#endif
+}
+
+/****************************************************************************
+ * Name: netdev_lower_txdone_queue
+ *
+ * Description:
+ *   Notifies the networking layer about a TX packet is sent on a queue, the
+ *   thread of that queue is woken up.
+ *
+ * Input Parameters:
+ *   dev   - The lower half device driver structure
+ *   queue - The queue with TX packets sent
+ *
+ ****************************************************************************/
+
+void netdev_lower_txdone_queue(FAR struct netdev_lowerhalf_s *dev,
+                               int queue)
+{
+  NETDEV_TXDONE(&dev->netdev);
+  netdev_lower_rxready_queue(dev, queue);
+}
+
+/****************************************************************************
+ * Name: netdev_lower_flowqueue
+ *
+ * Description:
+ *   Select the queue of a packet by hashing its flow.  The hash of the
+ *   addresses, the protocol and the TCP or UDP ports is symmetric, so both
+ *   directions of a flow map to the same queue.  Fragments are hashed on
+ *   the addresses only, packets other than IP go to queue 0.
+ *
+ * Input Parameters:
+ *   dev - The lower half device driver structure
+ *   pkt - The packet, as given to transmitq or returned by receiveq
+ *
+ * Returned Value:
+ *   The queue of the packet, between 0 and nqueues - 1.
+ *
+ ****************************************************************************/
+
+int netdev_lower_flowqueue(FAR struct netdev_lowerhalf_s *dev,
+                           FAR netpkt_t *pkt)
+{
+  FAR const uint8_t *l3 = IOB_DATA(pkt);
+  FAR const uint8_t *addr = NULL;
+  unsigned int addrlen = 0;
+  unsigned int iphl = 0;
+  uint32_t hash = 0;
+  bool ports = false;
+  uint8_t proto = 0;
+  unsigned int i;
+
+  if (dev->nqueues <= 1 || pkt->io_len == 0)
+    {
+      return 0;
+    }
+
+#ifdef CONFIG_NET_IPv4
+  if ((l3[0] & IP_VERSION_MASK) == IPv4_VERSION &&
+      pkt->io_len >= IPv4_HDRLEN)
+    {
+      FAR const struct ipv4_hdr_s *ipv4 = (FAR const struct ipv4_hdr_s *)l3;
+
+      addr    = (FAR const uint8_t *)ipv4->srcipaddr;
+      addrlen = sizeof(in_addr_t);
+      iphl    = (ipv4->vhl & IPv4_HLMASK) << 2;
+      proto   = ipv4->proto;
+      ports   = ((((uint16_t)ipv4->ipoffset[0] << 8) | ipv4->ipoffset[1]) &
+                 ~IP_FLAG_DONTFRAG) == 0;
+    }
+  else
+#endif
+#ifdef CONFIG_NET_IPv6
+  if ((l3[0] & IP_VERSION_MASK) == IPv6_VERSION &&
+      pkt->io_len >= IPv6_HDRLEN)
+    {
+      FAR const struct ipv6_hdr_s *ipv6 = (FAR const struct ipv6_hdr_s *)l3;
+
+      /* Extension headers are not followed, those packets are hashed on
+       * the addresses and the next header.
+       */
+
+      addr    = (FAR const uint8_t *)ipv6->srcipaddr;
+      addrlen = sizeof(net_ipv6addr_t);
+      iphl    = IPv6_HDRLEN;
+      proto   = ipv6->proto;
+      ports   = true;
+    }
+  else
+#endif
+    {
+      return 0;
+    }
+
+  /* The source and the destination address follow each other, XOR is
+   * insensitive to their order.
+   */
+
+  for (i = 0; i < addrlen; i += 2)
+    {
+      hash ^= ((uint32_t)addr[i] << 8) | addr[i + 1];
+      hash ^= ((uint32_t)addr[addrlen + i] << 8) | addr[addrlen + i + 1];
+    }
+
+  if (ports && (proto == IP_PROTO_TCP || proto == IP_PROTO_UDP) &&
+      pkt->io_len >= iphl + 4)
+    {
+      hash ^= ((uint32_t)l3[iphl] << 8) | l3[iphl + 1];
+      hash ^= ((uint32_t)l3[iphl + 2] << 8) | l3[iphl + 3];
+    }
+
+  hash ^= proto;
+
+  /* Mix the bits with a multiplicative hash before the modulo */
+
+  hash *= 0x9e3779b1;
+  return (hash >> 16) % dev->nqueues;
+}
+#endif /* CONFIG_NETDEV_MULTIQUEUE */
+
 /****************************************************************************
  * Name: netpkt_alloc
  *
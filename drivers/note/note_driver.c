@@ -1587,21 +1587,28 @@ void sched_note_vprintf_ip(uint32_t tag, uintptr_t ip, FAR const char *fmt,
           if (type)
             {
               size_t count = NOTE_PRINTF_GET_COUNT(type);
+              bool truncated = false;
               size_t i;
 
-              for (i = 0; i < count; i++)
+              /* The types are known at compile time, the arguments are
+               * stored as raw words without looking at the format string.
+               * Recording stops at the first argument that does not fit.
+               */
+
+              for (i = 0; i < count && !truncated; i++)
                 {
                   var = (FAR void *)&note->npt_data[next];
                   switch (NOTE_PRINTF_GET_TYPE(type, i))
                     {
                       case NOTE_PRINTF_UINT32:
                         {
-                          var->i = va_arg(va, int);
                           if (next + sizeof(var->i) > length)
                             {
+                              truncated = true;
                               break;
                             }
 
+                          var->i = va_arg(va, int);
                           next += sizeof(var->i);
                         }
                       break;
@@ -1609,6 +1616,7 @@ void sched_note_vprintf_ip(uint32_t tag, uintptr_t ip, FAR const char *fmt,
                         {
                           if (next + sizeof(var->ll) > length)
                             {
+                              truncated = true;
                               break;
                             }
 
@@ -1618,26 +1626,35 @@ void sched_note_vprintf_ip(uint32_t tag, uintptr_t ip, FAR const char *fmt,
                       break;
                       case NOTE_PRINTF_STRING:
                         {
+                          FAR const char *str;
                           size_t len;
-                          var->s = va_arg(va, FAR const char *);
-                          len = strlen(var->s) + 1;
+
+                          if (next >= length)
+                            {
+                              truncated = true;
+                              break;
+                            }
+
+                          str = va_arg(va, FAR const char *);
+                          len = strlen(str) + 1;
                           if (next + len > length)
                             {
                               len = length - next;
                             }
 
-                          strlcpy(note->npt_data + next, var->s, len);
+                          strlcpy(note->npt_data + next, str, len);
                           next += len;
                         }
                       break;
                       case NOTE_PRINTF_DOUBLE:
                         {
-                          var->d = va_arg(va, double);
                           if (next + sizeof(var->d) > length)
                             {
+                              truncated = true;
                               break;
                             }
 
+                          var->d = va_arg(va, double);
                           next += sizeof(var->d);
                         }
                       break;
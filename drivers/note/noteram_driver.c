@@ -26,6 +26,7 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <sys/types.h>
 #include <sched.h>
 #include <fcntl.h>
@@ -76,6 +77,22 @@
  * Private Types
  ****************************************************************************/
 
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+/* The ring of one CPU.  The positions are free running and only wrap
+ * around at 2^32, the size is a power of two.
+ */
+
+struct noteram_ring_s
+{
+  FAR uint8_t *buffer;
+  uint32_t size;               /* Zero until the first note of the CPU */
+  volatile uint32_t head;      /* End of the committed notes, by the CPU */
+  volatile uint32_t tail;      /* Oldest note kept, by the CPU */
+  volatile uint32_t clear;     /* Oldest note after a clear, by the reader */
+  uint32_t read;               /* Next note to read, by the reader */
+};
+#endif
+
 struct noteram_driver_s
 {
   struct note_driver_s driver;
@@ -87,6 +104,10 @@ struct noteram_driver_s
   volatile unsigned int ni_read;
   spinlock_t lock;
   FAR struct pollfd *pfd;
+  volatile bool ni_notified;
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  struct noteram_ring_s ni_rings[NCPUS];
+#endif
 };
 
 /* The structure to hold the context data of trace dump */
@@ -203,8 +224,22 @@ struct noteram_driver_s g_noteram_driver =
 
 static void noteram_buffer_clear(FAR struct noteram_driver_s *drv)
 {
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  int cpu;
+
+  /* Only the CPU of a ring moves its tail, up to the clear position */
+
+  for (cpu = 0; cpu < NCPUS; cpu++)
+    {
+      FAR struct noteram_ring_s *ring = &drv->ni_rings[cpu];
+
+      ring->clear = ring->head;
+      ring->read  = ring->clear;
+    }
+#else
   drv->ni_tail = drv->ni_head;
   drv->ni_read = drv->ni_head;
+#endif
 
   if (drv->ni_overwrite == NOTERAM_MODE_OVERWRITE_OVERFLOW)
     {
@@ -212,6 +247,26 @@ static void noteram_buffer_clear(FAR struct noteram_driver_s *drv)
     }
 }
 
+/****************************************************************************
+ * Name: noteram_notify
+ *
+ * Description:
+ *   Wake up the poller.  The poller is woken up once per poll() instead of
+ *   for each note, it reads all available notes before polling again.
+ *
+ ****************************************************************************/
+
+static inline void noteram_notify(FAR struct noteram_driver_s *drv)
+{
+  if (drv->pfd != NULL && !drv->ni_notified)
+    {
+      drv->ni_notified = true;
+      poll_notify(&drv->pfd, 1, POLLIN);
+    }
+}
+
+#ifndef CONFIG_DRIVERS_NOTERAM_PERCPU
+
 /****************************************************************************
  * Name: noteram_next
  *
@@ -420,6 +475,327 @@ static ssize_t noteram_get(FAR struct noteram_driver_s *drv,
   return notelen;
 }
 
+#else /* CONFIG_DRIVERS_NOTERAM_PERCPU */
+
+/****************************************************************************
+ * Name: noteram_ring_init
+ *
+ * Description:
+ *   Set up the ring of a CPU on its first note.  Each CPU gets the largest
+ *   power of two that fits in its share of the buffer.
+ *
+ ****************************************************************************/
+
+static void noteram_ring_init(FAR struct noteram_driver_s *drv,
+                              FAR struct noteram_ring_s *ring, int cpu)
+{
+  uint32_t size = 1;
+
+  while (size <= drv->ni_bufsize / NCPUS / 2)
+    {
+      size <<= 1;
+    }
+
+  DEBUGASSERT(size > UINT8_MAX);
+
+  ring->buffer = drv->ni_buffer + cpu * size;
+  ring->head   = 0;
+  ring->tail   = 0;
+  ring->clear  = 0;
+  ring->read   = 0;
+
+  /* The reader skips the ring until it is complete */
+
+  UP_DMB();
+  ring->size   = size;
+}
+
+/****************************************************************************
+ * Name: noteram_ring_tail
+ *
+ * Description:
+ *   Return the oldest note of a ring, which is the later of the tail kept
+ *   by the CPU and the tail set by the last clear.
+ *
+ ****************************************************************************/
+
+static inline uint32_t noteram_ring_tail(FAR struct noteram_ring_s *ring)
+{
+  uint32_t tail  = ring->tail;
+  uint32_t clear = ring->clear;
+
+  return (int32_t)(clear - tail) > 0 ? clear : tail;
+}
+
+/****************************************************************************
+ * Name: noteram_ring_copyin/copyout
+ *
+ * Description:
+ *   Copy data into or out of a ring at a position, handling wraparound.
+ *
+ ****************************************************************************/
+
+static void noteram_ring_copyin(FAR struct noteram_ring_s *ring,
+                                uint32_t pos, FAR const void *src,
+                                size_t len)
+{
+  uint32_t offset = pos & (ring->size - 1);
+  size_t space = MIN(ring->size - offset, len);
+
+  memcpy(ring->buffer + offset, src, space);
+  memcpy(ring->buffer, (FAR const uint8_t *)src + space, len - space);
+}
+
+static void noteram_ring_copyout(FAR struct noteram_ring_s *ring,
+                                 uint32_t pos, FAR void *dest, size_t len)
+{
+  uint32_t offset = pos & (ring->size - 1);
+  size_t space = MIN(ring->size - offset, len);
+
+  memcpy(dest, ring->buffer + offset, space);
+  memcpy((FAR uint8_t *)dest + space, ring->buffer, len - space);
+}
+
+/****************************************************************************
+ * Name: noteram_ring_add
+ *
+ * Description:
+ *   Add a note to the ring of this CPU.  The local interrupts are disabled
+ *   so that the CPU is the only producer of its ring, no lock is shared
+ *   with the other CPUs.  The space is reserved by moving the tail past
+ *   the notes to overwrite, and the note is committed by moving the head.
+ *
+ * Returned Value:
+ *   True if the note was added, false if the recording stopped.
+ *
+ ****************************************************************************/
+
+static bool noteram_ring_add(FAR struct noteram_driver_s *drv,
+                             FAR const void *note, size_t notelen)
+{
+  FAR struct noteram_ring_s *ring;
+  uint32_t len = NOTE_ALIGN(notelen);
+  irqstate_t flags;
+  uint32_t head;
+  uint32_t tail;
+  bool ret = false;
+  int cpu;
+
+  flags = up_irq_save();
+
+  cpu  = this_cpu();
+  ring = &drv->ni_rings[cpu];
+  if (ring->size == 0)
+    {
+      noteram_ring_init(drv, ring, cpu);
+    }
+
+  if (drv->ni_overwrite == NOTERAM_MODE_OVERWRITE_OVERFLOW)
+    {
+      goto out;
+    }
+
+  DEBUGASSERT(note != NULL && len < ring->size);
+  head = ring->head;
+  tail = noteram_ring_tail(ring);
+
+  if (head - tail + len > ring->size)
+    {
+      if (drv->ni_overwrite == NOTERAM_MODE_OVERWRITE_DISABLE)
+        {
+          /* Stop recording if not in overwrite mode */
+
+          drv->ni_overwrite = NOTERAM_MODE_OVERWRITE_OVERFLOW;
+          goto out;
+        }
+
+      /* Drop the oldest notes until there is enough space */
+
+      do
+        {
+          tail += NOTE_ALIGN(ring->buffer[tail & (ring->size - 1)]);
+        }
+      while (head - tail + len > ring->size);
+    }
+
+  /* The new tail is visible before the old notes are overwritten, the
+   * reader checks it after copying a note out.
+   */
+
+  ring->tail = tail;
+  UP_DMB();
+
+  noteram_ring_copyin(ring, head, note, notelen);
+
+  /* Commit the note */
+
+  UP_DMB();
+  ring->head = head + len;
+  ret = true;
+
+out:
+  up_irq_restore(flags);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: noteram_ring_peek
+ *
+ * Description:
+ *   Copy the common header of the next unread note of a ring.  The read
+ *   position skips the notes overwritten since the last read.
+ *
+ * Returned Value:
+ *   True if there is an unread note, false if the ring is empty.
+ *
+ ****************************************************************************/
+
+static bool noteram_ring_peek(FAR struct noteram_ring_s *ring,
+                              FAR struct note_common_s *note)
+{
+  uint32_t head;
+  uint32_t tail;
+
+  do
+    {
+      head = ring->head;
+      UP_DMB();
+
+      tail = noteram_ring_tail(ring);
+      if ((int32_t)(tail - ring->read) > 0)
+        {
+          ring->read = tail;
+        }
+
+      if (ring->read == head)
+        {
+          return false;
+        }
+
+      noteram_ring_copyout(ring, ring->read, note, sizeof(*note));
+      UP_DMB();
+    }
+  while ((int32_t)(noteram_ring_tail(ring) - ring->read) > 0);
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: noteram_unread_length
+ *
+ * Description:
+ *   Length of unread data currently in the rings of all CPUs.
+ *
+ ****************************************************************************/
+
+static unsigned int noteram_unread_length(FAR struct noteram_driver_s *drv)
+{
+  unsigned int length = 0;
+  int cpu;
+
+  for (cpu = 0; cpu < NCPUS; cpu++)
+    {
+      FAR struct noteram_ring_s *ring = &drv->ni_rings[cpu];
+      uint32_t read = ring->read;
+      uint32_t tail;
+
+      if (ring->size == 0)
+        {
+          continue;
+        }
+
+      tail = noteram_ring_tail(ring);
+      if ((int32_t)(tail - read) > 0)
+        {
+          read = tail;
+        }
+
+      length += ring->head - read;
+    }
+
+  return length;
+}
+
+/****************************************************************************
+ * Name: noteram_get
+ *
+ * Description:
+ *   Get the oldest unread note of all CPUs, the rings are merged by the
+ *   timestamp of their next note.  A note recorded by an interrupt may be
+ *   reported just before the note it interrupted.
+ *
+ * Input Parameters:
+ *   buffer - Location to return the next note
+ *   buflen - The length of the user provided buffer.
+ *
+ * Returned Value:
+ *   On success, the positive, non-zero length of the return note is
+ *   provided.  Zero is returned only if the rings are empty.  A negated
+ *   errno value is returned in the event of any failure.
+ *
+ ****************************************************************************/
+
+static ssize_t noteram_get(FAR struct noteram_driver_s *drv,
+                           FAR uint8_t *buffer, size_t buflen)
+{
+  FAR struct noteram_ring_s *next;
+  struct note_common_s note;
+  clock_t systime = 0;
+  size_t notelen = 0;
+  int cpu;
+
+  DEBUGASSERT(buffer != NULL);
+
+  for (; ; )
+    {
+      next = NULL;
+      for (cpu = 0; cpu < NCPUS; cpu++)
+        {
+          FAR struct noteram_ring_s *ring = &drv->ni_rings[cpu];
+
+          if (ring->size == 0 || !noteram_ring_peek(ring, &note))
+            {
+              continue;
+            }
+
+          if (next == NULL || (sclock_t)(note.nc_systime - systime) < 0)
+            {
+              next    = ring;
+              systime = note.nc_systime;
+              notelen = note.nc_length;
+            }
+        }
+
+      if (next == NULL)
+        {
+          return 0;
+        }
+
+      /* Is the user buffer large enough to hold the note? */
+
+      if (buflen < notelen)
+        {
+          /* Skip the large note so that we do not get constipated. */
+
+          next->read += NOTE_ALIGN(notelen);
+          return -EFBIG;
+        }
+
+      noteram_ring_copyout(next, next->read, buffer, notelen);
+      UP_DMB();
+
+      /* Try again if the note was overwritten while it was copied */
+
+      if ((int32_t)(noteram_ring_tail(next) - next->read) <= 0)
+        {
+          next->read += NOTE_ALIGN(notelen);
+          return notelen;
+        }
+    }
+}
+
+#endif /* CONFIG_DRIVERS_NOTERAM_PERCPU */
+
 /****************************************************************************
  * Name: noteram_open
  ****************************************************************************/
@@ -429,10 +805,20 @@ static int noteram_open(FAR struct file *filep)
   FAR struct noteram_dump_context_s *ctx;
   FAR struct noteram_driver_s *drv = (FAR struct noteram_driver_s *)
                                      filep->f_inode->i_private;
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  int cpu;
+#endif
 
   /* Reset the read index of the circular buffer */
 
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  for (cpu = 0; cpu < NCPUS; cpu++)
+    {
+      drv->ni_rings[cpu].read = noteram_ring_tail(&drv->ni_rings[cpu]);
+    }
+#else
   drv->ni_read = drv->ni_tail;
+#endif
   ctx = kmm_zalloc(sizeof(*ctx));
   if (ctx == NULL)
     {
@@ -647,6 +1033,7 @@ static int noteram_poll(FAR struct file *filep, FAR struct pollfd *fds,
           goto errout;
         }
 
+      drv->ni_notified = false;
       drv->pfd = fds;
 
       /* Is there unread data in noteram? then trigger POLLIN now -
@@ -656,7 +1043,7 @@ static int noteram_poll(FAR struct file *filep, FAR struct pollfd *fds,
       if (noteram_unread_length(drv) > 0)
         {
           spin_unlock_irqrestore_notrace(&drv->lock, flags);
-          poll_notify(&drv->pfd, 1, POLLIN);
+          noteram_notify(drv);
           return ret;
         }
     }
@@ -691,8 +1078,14 @@ errout:
 static void noteram_add(FAR struct note_driver_s *driver,
                         FAR const void *note, size_t notelen)
 {
-  FAR const char *buf = note;
   FAR struct noteram_driver_s *drv = (FAR struct noteram_driver_s *)driver;
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  if (noteram_ring_add(drv, note, notelen))
+    {
+      noteram_notify(drv);
+    }
+#else
+  FAR const char *buf = note;
   unsigned int head;
   unsigned int remain;
   unsigned int space;
@@ -738,7 +1131,8 @@ static void noteram_add(FAR struct note_driver_s *driver,
   memcpy(drv->ni_buffer, buf + space, notelen - space);
   drv->ni_head = noteram_next(drv, head, NOTE_ALIGN(notelen));
   spin_unlock_irqrestore_notrace(&drv->lock, flags);
-  poll_notify(&drv->pfd, 1, POLLIN);
+  noteram_notify(drv);
+#endif
 }
 
 /****************************************************************************
@@ -1374,6 +1768,10 @@ noteram_initialize(FAR const char *devpath, size_t bufsize, bool overwrite)
   drv->ni_tail = 0;
   drv->ni_read = 0;
   drv->pfd = NULL;
+  drv->ni_notified = false;
+#ifdef CONFIG_DRIVERS_NOTERAM_PERCPU
+  memset(drv->ni_rings, 0, sizeof(drv->ni_rings));
+#endif
 
   ret = note_driver_register(&drv->driver);
   if (ret < 0)
@@ -30,6 +30,7 @@
 #include <sys/stat.h>
 #include <sys/statfs.h>
 #include <sys/mount.h>
+#include <sys/param.h>
 
 #include <stdlib.h>
 #include <unistd.h>
@@ -60,6 +61,10 @@
 #define ROUND_UP(a, b)          (((a) + (b) - 1) & ~((b) - 1))
 #define DIV_ROUND_UP(a, b)      (ROUND_UP(a, b) / (b))
 
+#if CONFIG_FAT_FILE_EXTENTS == 0
+#  define fat_extent_add(ff, index, cluster)
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -553,6 +558,209 @@ out:
   return ret;
 }
 
+/****************************************************************************
+ * Name: fat_extent_search
+ *
+ * Description:
+ *   Return the cached extent that holds the cluster with the file index
+ *   'index', or the last extent if the index lies beyond the cache.
+ *   Returns NULL if the cache is empty.
+ *
+ ****************************************************************************/
+
+#if CONFIG_FAT_FILE_EXTENTS > 0
+static FAR struct fat_extent_s *
+fat_extent_search(FAR struct fat_file_s *ff, uint32_t index)
+{
+  int low = 0;
+  int high = ff->ff_nextents - 1;
+  int mid;
+
+  if (ff->ff_nextents == 0)
+    {
+      return NULL;
+    }
+
+  /* Find the last extent that starts at or before the index */
+
+  while (low < high)
+    {
+      mid = (low + high + 1) / 2;
+      if (ff->ff_extents[mid].fe_index <= index)
+        {
+          low = mid;
+        }
+      else
+        {
+          high = mid - 1;
+        }
+    }
+
+  return &ff->ff_extents[low];
+}
+
+/****************************************************************************
+ * Name: fat_extent_find
+ *
+ * Description:
+ *   Skip ahead in the cluster chain using the extent cache.  On input,
+ *   'cluster' holds the cluster with the file index '*ntraversed - 1'.  It
+ *   is advanced towards the cluster with the file index 'index' as far as
+ *   the cache allows.
+ *
+ ****************************************************************************/
+
+static void fat_extent_find(FAR struct fat_file_s *ff, uint32_t index,
+                            FAR int *cluster, FAR int *ntraversed)
+{
+  FAR struct fat_extent_s *fe;
+
+  /* The first cluster of the file is always known */
+
+  if (ff->ff_nextents == 0)
+    {
+      fe              = &ff->ff_extents[0];
+      fe->fe_index    = 0;
+      fe->fe_cluster  = ff->ff_startcluster;
+      fe->fe_count    = 1;
+      ff->ff_nextents = 1;
+    }
+
+  fe = fat_extent_search(ff, index);
+  if (index >= fe->fe_index + fe->fe_count)
+    {
+      /* Beyond the cache, continue from its last cluster */
+
+      index = fe->fe_index + fe->fe_count - 1;
+    }
+
+  if (index + 1 > (uint32_t)*ntraversed)
+    {
+      *cluster    = fe->fe_cluster + (index - fe->fe_index);
+      *ntraversed = index + 1;
+    }
+}
+
+/****************************************************************************
+ * Name: fat_extent_add
+ *
+ * Description:
+ *   Record that the cluster with the file index 'index' is 'cluster'.
+ *   Only the cluster right after the cached part of the chain is recorded.
+ *
+ ****************************************************************************/
+
+static void fat_extent_add(FAR struct fat_file_s *ff, uint32_t index,
+                           uint32_t cluster)
+{
+  FAR struct fat_extent_s *fe = NULL;
+  uint32_t ncached = 0;
+
+  if (ff->ff_nextents > 0)
+    {
+      fe      = &ff->ff_extents[ff->ff_nextents - 1];
+      ncached = fe->fe_index + fe->fe_count;
+    }
+
+  if (index != ncached)
+    {
+      return;
+    }
+
+  if (fe != NULL && cluster == fe->fe_cluster + fe->fe_count)
+    {
+      /* Contiguous with the last run */
+
+      fe->fe_count++;
+    }
+  else if (ff->ff_nextents < CONFIG_FAT_FILE_EXTENTS)
+    {
+      fe              = &ff->ff_extents[ff->ff_nextents++];
+      fe->fe_index    = index;
+      fe->fe_cluster  = cluster;
+      fe->fe_count    = 1;
+    }
+}
+
+/****************************************************************************
+ * Name: fat_extent_fill
+ *
+ * Description:
+ *   Walk the FAT ahead of the cached part of the chain, so that the cache
+ *   tells how far the run holding the cluster with the file index 'index'
+ *   continues, looking at no more than 'nclusters' clusters from 'index'
+ *   and not past the end of the file.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_FAT_FORCE_INDIRECT
+static void fat_extent_fill(FAR struct fat_mountpt_s *fs,
+                            FAR struct fat_file_s *ff, uint32_t index,
+                            uint32_t nclusters)
+{
+  FAR struct fat_extent_s *fe;
+  uint32_t ncached;
+  uint32_t end;
+  off_t cluster;
+  bool contig;
+
+  end = DIV_ROUND_UP(ff->ff_size,
+                     fs->fs_fatsecperclus * fs->fs_hwsectorsize);
+  end = MIN(end, index + nclusters);
+
+  while (ff->ff_nextents > 0)
+    {
+      fe      = &ff->ff_extents[ff->ff_nextents - 1];
+      ncached = fe->fe_index + fe->fe_count;
+
+      /* Done if the cache reaches far enough, or if the run of 'index'
+       * has already ended.
+       */
+
+      if (ncached >= end || fe->fe_index > index)
+        {
+          break;
+        }
+
+      cluster = fat_getcluster(fs, fe->fe_cluster + fe->fe_count - 1);
+      if (cluster < 2 || cluster >= fs->fs_nclusters + 2)
+        {
+          break;
+        }
+
+      contig = cluster == fe->fe_cluster + fe->fe_count;
+      fat_extent_add(ff, ncached, cluster);
+      if (!contig)
+        {
+          break;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: fat_extent_contig
+ *
+ * Description:
+ *   Return the number of clusters known to follow the cluster with the
+ *   file index 'index' contiguously on the media.
+ *
+ ****************************************************************************/
+
+static uint32_t fat_extent_contig(FAR struct fat_file_s *ff, uint32_t index)
+{
+  FAR struct fat_extent_s *fe;
+
+  fe = fat_extent_search(ff, index);
+  if (fe == NULL || index >= fe->fe_index + fe->fe_count)
+    {
+      return 0;
+    }
+
+  return fe->fe_index + fe->fe_count - 1 - index;
+}
+#endif /* CONFIG_FAT_FORCE_INDIRECT */
+#endif
+
 /****************************************************************************
  * Name: fat_get_sectors
  *
@@ -563,6 +771,8 @@ out:
  *
  * Input Parameters:
  *   fs      - A reference to the file
+ *   buflen  - The number of bytes about to be written from ->f_pos, so that
+ *             the clusters for all of them can be allocated contiguously
  *   read    - True if get sectors for reading
  *
  * Output:
@@ -578,7 +788,8 @@ out:
  *
  ****************************************************************************/
 
-static int fat_get_sectors(FAR struct file *filep, bool read)
+static int fat_get_sectors(FAR struct file *filep, size_t buflen,
+                           bool read)
 {
   FAR struct inode *inode = filep->f_inode;
   FAR struct fat_mountpt_s *fs = inode->i_private;
@@ -586,6 +797,7 @@ static int fat_get_sectors(FAR struct file *filep, bool read)
   int i;
   int num_clu;
   int new_num_clu;
+  int end_clu;
   int num_traversed;
   int cluster;
   int ret;
@@ -595,6 +807,7 @@ static int fat_get_sectors(FAR struct file *filep, bool read)
 
   num_clu = DIV_ROUND_UP(ff->ff_size, clu_size);
   new_num_clu = DIV_ROUND_UP(filep->f_pos + 1, clu_size);
+  end_clu = MAX(DIV_ROUND_UP(filep->f_pos + buflen, clu_size), new_num_clu);
 
   if (ff->ff_startcluster == 0)
     {
@@ -620,6 +833,16 @@ static int fat_get_sectors(FAR struct file *filep, bool read)
       num_traversed = 1;
     }
 
+#if CONFIG_FAT_FILE_EXTENTS > 0
+  /* Skip the part of the chain that is in the extent cache */
+
+  if (ff->ff_startcluster != 0 && num_clu > 0)
+    {
+      fat_extent_find(ff, MIN(num_clu, new_num_clu) - 1,
+                      &cluster, &num_traversed);
+    }
+#endif
+
   /* Traverse the existing chain */
 
   for (i = num_traversed; i < num_clu && i < new_num_clu; i++)
@@ -632,6 +855,8 @@ static int fat_get_sectors(FAR struct file *filep, bool read)
         {
           return -EIO;
         }
+
+      fat_extent_add(ff, i, cluster);
     }
 
   if (read)
@@ -677,13 +902,15 @@ static int fat_get_sectors(FAR struct file *filep, bool read)
 
   for (; i < new_num_clu - 1; i++)
     {
-      cluster = fat_extendchain(fs, cluster);
+      cluster = fat_extendrun(fs, cluster, end_clu - i);
 
       if (cluster < 2 || cluster >= fs->fs_nclusters + 2)
         {
           return -EIO;
         }
 
+      fat_extent_add(ff, i, cluster);
+
       /* zero area (2) */
 
       ret = fat_zero_cluster(fs, cluster, 0, clu_size);
@@ -700,13 +927,15 @@ static int fat_get_sectors(FAR struct file *filep, bool read)
 
   if (i == new_num_clu - 1)
     {
-      cluster = fat_extendchain(fs, cluster);
+      cluster = fat_extendrun(fs, cluster, end_clu - i);
 
       if (cluster < 2 || cluster >= fs->fs_nclusters + 2)
         {
           return -EIO;
         }
 
+      fat_extent_add(ff, i, cluster);
+
       /* zero area (3) */
 
       zero_end = filep->f_pos & (clu_size -1);
@@ -764,6 +993,10 @@ static ssize_t fat_read(FAR struct file *filep, FAR char *buffer,
 #ifndef CONFIG_FAT_FORCE_INDIRECT
   unsigned int nsectors;
   bool force_indirect = false;
+#  if CONFIG_FAT_FILE_EXTENTS > 0
+  unsigned int contig;
+  uint32_t index;
+#  endif
 #endif
 
   /* Sanity checks */
@@ -845,7 +1078,7 @@ static ssize_t fat_read(FAR struct file *filep, FAR char *buffer,
     {
       bytesread  = 0;
 
-      ret = fat_get_sectors(filep, true);
+      ret = fat_get_sectors(filep, 0, true);
       if (ret < 0)
         {
           goto errout_with_lock;
@@ -874,7 +1107,27 @@ fat_read_restart:
 
           if (nsectors > ff->ff_sectorsincluster)
             {
+#if CONFIG_FAT_FILE_EXTENTS > 0
+              /* Continue into the following clusters as long as they are
+               * contiguous on the media, walking the FAT ahead if the cache
+               * does not reach that far yet.  fat_get_sectors() finds the
+               * right cluster again on the next time through the loop.
+               */
+
+              index  = SEC_NSECTORS(fs, ff->ff_pos) / fs->fs_fatsecperclus;
+              contig = DIV_ROUND_UP(nsectors - ff->ff_sectorsincluster,
+                                    fs->fs_fatsecperclus);
+              fat_extent_fill(fs, ff, index, contig + 1);
+
+              contig = ff->ff_sectorsincluster +
+                       fat_extent_contig(ff, index) * fs->fs_fatsecperclus;
+              if (nsectors > contig)
+                {
+                  nsectors = contig;
+                }
+#else
               nsectors = ff->ff_sectorsincluster;
+#endif
             }
 
           /* We are not sure of the state of the file buffer so
@@ -909,7 +1162,27 @@ fat_read_restart:
               goto errout_with_lock;
             }
 
-          ff->ff_sectorsincluster -= nsectors;
+#if CONFIG_FAT_FILE_EXTENTS > 0
+          if (nsectors > ff->ff_sectorsincluster)
+            {
+              /* Move on to the last cluster that was read */
+
+              contig = DIV_ROUND_UP(nsectors - ff->ff_sectorsincluster,
+                                    fs->fs_fatsecperclus);
+              ff->ff_currentcluster  += contig;
+              ff->ff_pos             += (off_t)contig *
+                                        fs->fs_fatsecperclus *
+                                        fs->fs_hwsectorsize;
+              ff->ff_sectorsincluster = ff->ff_sectorsincluster +
+                                        contig * fs->fs_fatsecperclus -
+                                        nsectors;
+            }
+          else
+#endif
+            {
+              ff->ff_sectorsincluster -= nsectors;
+            }
+
           ff->ff_currentsector    += nsectors;
           bytesread                = nsectors * fs->fs_hwsectorsize;
         }
@@ -1044,7 +1317,7 @@ static ssize_t fat_write(FAR struct file *filep, FAR const char *buffer,
 
   while (buflen > 0)
     {
-      ret = fat_get_sectors(filep, false);
+      ret = fat_get_sectors(filep, buflen, false);
       if (ret < 0)
         {
           goto errout_with_lock;
@@ -1599,6 +1872,11 @@ static int fat_dup(FAR const struct file *oldp, FAR struct file *newp)
   newff->ff_startcluster     = oldff->ff_startcluster;     /* Start cluster of file on media */
   newff->ff_currentsector    = oldff->ff_currentsector;    /* Current sector */
   newff->ff_cachesector      = 0;                          /* Sector in file buffer */
+#if CONFIG_FAT_FILE_EXTENTS > 0
+  newff->ff_nextents         = oldff->ff_nextents;         /* Cached cluster runs */
+  memcpy(newff->ff_extents, oldff->ff_extents,
+         oldff->ff_nextents * sizeof(struct fat_extent_s));
+#endif
 
   /* Attach the private date to the struct file instance */
 
@@ -1931,6 +2209,12 @@ static int fat_truncate(FAR struct file *filep, off_t length)
           ret = fat_dirshrink(fs, direntry, length);
         }
 
+#if CONFIG_FAT_FILE_EXTENTS > 0
+      /* The end of the cluster chain has been freed */
+
+      ff->ff_nextents = 0;
+#endif
+
       if (ret >= 0)
         {
           /* The truncation has completed without error.  Update the file
@@ -2358,6 +2642,10 @@ static int fat_unbind(FAR void *handle, FAR struct inode **blkdriver,
       fat_io_free(fs->fs_buffer, fs->fs_hwsectorsize);
     }
 
+#ifdef CONFIG_FAT_FREE_BITMAP
+  fs_heap_free(fs->fs_freemap);
+#endif
+
   nxmutex_destroy(&fs->fs_lock);
   fs_heap_free(fs);
   return OK;
@@ -272,6 +272,17 @@
 
 #define CLUS_NDXMASK(f)     ((f)->fs_fatsecperclus - 1)
 
+/* Free cluster bitmap access.  Bit n is cluster n + 2, set if in use. */
+
+#ifdef CONFIG_FAT_FREE_BITMAP
+#  define FAT_FREEMAP_SET(f,c) \
+     ((f)->fs_freemap[((c) - 2) >> 3] |= (uint8_t)(1 << (((c) - 2) & 7)))
+#  define FAT_FREEMAP_CLR(f,c) \
+     ((f)->fs_freemap[((c) - 2) >> 3] &= (uint8_t)~(1 << (((c) - 2) & 7)))
+#  define FAT_FREEMAP_ISSET(f,c) \
+     (((f)->fs_freemap[((c) - 2) >> 3] & (1 << (((c) - 2) & 7))) != 0)
+#endif
+
 /* The FAT "long" file name (LFN) directory entry */
 
 #ifdef CONFIG_FAT_LFN
@@ -891,7 +902,22 @@ struct fat_mountpt_s
   uint8_t  fs_fatsecperclus;       /* MBR: Sectors per allocation unit: 2**n, n=0..7 */
   uint8_t *fs_buffer;              /* This is an allocated buffer to hold one
                                     * sector from the device */
+#ifdef CONFIG_FAT_FREE_BITMAP
+  uint8_t *fs_freemap;             /* One bit per cluster, set if in use.
+                                    * NULL until the first allocation */
+#endif
+};
+
+/* This structure describes a run of contiguous clusters of an open file */
+
+#if CONFIG_FAT_FILE_EXTENTS > 0
+struct fat_extent_s
+{
+  uint32_t fe_index;               /* Index of the first cluster in the file */
+  uint32_t fe_cluster;             /* First cluster of the run on media */
+  uint32_t fe_count;               /* Number of clusters in the run */
 };
+#endif
 
 /* This structure represents on open file under the mountpoint.  An instance
  * of this structure is retained as struct file specific information on each
@@ -913,6 +939,16 @@ struct fat_file_s
   off_t    ff_cachesector;         /* Current sector in the file buffer */
   off_t    ff_pos;                 /* Current position in the file */
   uint8_t *ff_buffer;              /* File buffer (for partial sector accesses) */
+#if CONFIG_FAT_FILE_EXTENTS > 0
+  uint8_t  ff_nextents;            /* Number of valid entries in ff_extents */
+
+  /* The start of the cluster chain as runs of contiguous clusters.  The
+   * runs follow each other without gaps, starting with the first cluster
+   * of the file.
+   */
+
+  struct fat_extent_s ff_extents[CONFIG_FAT_FILE_EXTENTS];
+#endif
 };
 
 /* This structure holds the sequence of directory entries used by one
@@ -1050,9 +1086,10 @@ EXTERN int    fat_putcluster(FAR struct fat_mountpt_s *fs,
                              uint32_t clusterno, off_t startsector);
 EXTERN int    fat_removechain(FAR struct fat_mountpt_s *fs,
                               uint32_t cluster);
-EXTERN int32_t fat_extendchain(FAR struct fat_mountpt_s *fs,
-                               uint32_t cluster);
+EXTERN int32_t fat_extendrun(FAR struct fat_mountpt_s *fs,
+                             uint32_t cluster, uint32_t nclusters);
 
+#define fat_extendchain(fs, cluster) fat_extendrun(fs, cluster, 1)
 #define fat_createchain(fs) fat_extendchain(fs, 0)
 
 /* Help for traversing directory trees and accessing directory entries */
@@ -27,6 +27,7 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <sys/param.h>
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -48,6 +49,297 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: fat_freemap_build
+ *
+ * Description:
+ *   Build the bitmap of the clusters in use from the FAT.  The count of
+ *   free clusters is refreshed on the way.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FAT_FREE_BITMAP
+static int fat_freemap_build(struct fat_mountpt_s *fs)
+{
+  uint32_t nfreeclusters = 0;
+  uint32_t cluster;
+  off_t    next;
+
+  fs->fs_freemap = fs_heap_zalloc((fs->fs_nclusters + 7) / 8);
+  if (fs->fs_freemap == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  /* The FAT is read in order, so each FAT sector is read only once */
+
+  for (cluster = 2; cluster < fs->fs_nclusters + 2; cluster++)
+    {
+      next = fat_getcluster(fs, cluster);
+      if (next < 0)
+        {
+          fs_heap_free(fs->fs_freemap);
+          fs->fs_freemap = NULL;
+          return next;
+        }
+      else if (next == 0)
+        {
+          nfreeclusters++;
+        }
+      else
+        {
+          FAT_FREEMAP_SET(fs, cluster);
+        }
+    }
+
+  fs->fs_fsifreecount = nfreeclusters;
+  if (fs->fs_type == FSTYPE_FAT32)
+    {
+      fs->fs_fsidirty = true;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fat_freemap_find
+ *
+ * Description:
+ *   Search the bitmap for a free cluster, starting after 'startcluster' and
+ *   wrapping around at the end of the volume.  Returns zero if there is no
+ *   free cluster.
+ *
+ ****************************************************************************/
+
+static uint32_t fat_freemap_find(struct fat_mountpt_s *fs,
+                                 uint32_t startcluster)
+{
+  uint32_t cluster = startcluster;
+  uint32_t count;
+
+  for (count = 0; count < fs->fs_nclusters; )
+    {
+      cluster++;
+      count++;
+      if (cluster >= fs->fs_nclusters + 2)
+        {
+          cluster = 2;
+        }
+
+      /* Skip over whole bytes of clusters in use */
+
+      while (((cluster - 2) & 7) == 0 && count + 8 < fs->fs_nclusters &&
+             cluster + 8 <= fs->fs_nclusters + 2 &&
+             fs->fs_freemap[(cluster - 2) >> 3] == 0xff)
+        {
+          cluster += 8;
+          count   += 8;
+          if (cluster >= fs->fs_nclusters + 2)
+            {
+              cluster = 2;
+            }
+        }
+
+      if (!FAT_FREEMAP_ISSET(fs, cluster))
+        {
+          return cluster;
+        }
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: fat_freemap_run
+ *
+ * Description:
+ *   Search the clusters from 'first' up to, but not including, 'last' for
+ *   the first run of 'nclusters' free clusters.  Returns its first cluster
+ *   or zero if there is none.
+ *
+ ****************************************************************************/
+
+static uint32_t fat_freemap_run(struct fat_mountpt_s *fs, uint32_t first,
+                                uint32_t last, uint32_t nclusters)
+{
+  uint32_t cluster;
+  uint32_t run = 0;
+
+  for (cluster = first; cluster < last; cluster++)
+    {
+      /* Skip over whole bytes of clusters in use */
+
+      if (((cluster - 2) & 7) == 0 && cluster + 8 <= last &&
+          fs->fs_freemap[(cluster - 2) >> 3] == 0xff)
+        {
+          cluster += 7;
+          run      = 0;
+        }
+      else if (FAT_FREEMAP_ISSET(fs, cluster))
+        {
+          run = 0;
+        }
+      else if (++run >= nclusters)
+        {
+          return cluster + 1 - nclusters;
+        }
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: fat_freemap_findrun
+ *
+ * Description:
+ *   Search the bitmap for the first run of 'nclusters' free clusters,
+ *   starting after 'startcluster' and wrapping around at the end of the
+ *   volume.  Returns zero if there is no such run.
+ *
+ ****************************************************************************/
+
+static uint32_t fat_freemap_findrun(struct fat_mountpt_s *fs,
+                                    uint32_t startcluster,
+                                    uint32_t nclusters)
+{
+  uint32_t end = fs->fs_nclusters + 2;
+  uint32_t first = startcluster + 1;
+  uint32_t cluster;
+
+  if (first < 2 || first >= end)
+    {
+      first = 2;
+    }
+
+  cluster = fat_freemap_run(fs, first, end, nclusters);
+  if (cluster == 0 && first > 2)
+    {
+      /* A run may also start before the start cluster and reach past it */
+
+      cluster = fat_freemap_run(fs, 2, MIN(first + nclusters - 1, end),
+                                nclusters);
+    }
+
+  return cluster;
+}
+#endif
+
+/****************************************************************************
+ * Name: fat_findfreecluster
+ *
+ * Description:
+ *   Find a free cluster, searching from the one after 'startcluster'.
+ *   With the bitmap, if the cluster right after 'startcluster' is in use
+ *   and 'nclusters' are needed, the first run of that many free clusters
+ *   is preferred.
+ *
+ * Returned Value:
+ *   <0:error, 0: no free cluster, >=2: free cluster number
+ *
+ ****************************************************************************/
+
+static int32_t fat_findfreecluster(struct fat_mountpt_s *fs,
+                                   uint32_t startcluster,
+                                   uint32_t nclusters)
+{
+  off_t    startsector;
+  uint32_t newcluster;
+
+#ifdef CONFIG_FAT_FREE_BITMAP
+  /* Build the bitmap on first use.  Fall back to scanning the FAT if that
+   * fails.
+   */
+
+  if (fs->fs_freemap == NULL)
+    {
+      fat_freemap_build(fs);
+    }
+
+  if (fs->fs_freemap != NULL)
+    {
+      /* Keep the chain contiguous if the next cluster is free */
+
+      newcluster = startcluster + 1;
+      if (newcluster >= 2 && newcluster < fs->fs_nclusters + 2 &&
+          !FAT_FREEMAP_ISSET(fs, newcluster))
+        {
+          return newcluster;
+        }
+
+      if (nclusters > 1)
+        {
+          newcluster = fat_freemap_findrun(fs, startcluster, nclusters);
+          if (newcluster != 0)
+            {
+              return newcluster;
+            }
+        }
+
+      return fat_freemap_find(fs, startcluster);
+    }
+#else
+  UNUSED(nclusters);
+#endif
+
+  /* Loop until (1) we discover that there are not free clusters
+   * (return 0), an errors occurs (return -errno), or (3) we find
+   * the next cluster (return the new cluster number).
+   */
+
+  newcluster = startcluster;
+  for (; ; )
+    {
+      /* Examine the next cluster in the FAT */
+
+      newcluster++;
+      if (newcluster >= fs->fs_nclusters + 2)
+        {
+          /* If we hit the end of the available clusters, then
+           * wrap back to the beginning because we might have
+           * started at a non-optimal place.  But don't continue
+           * past the start cluster.
+           */
+
+          newcluster = 2;
+          if (newcluster > startcluster)
+            {
+              /* We are back past the starting cluster, then there
+               * is no free cluster.
+               */
+
+              return 0;
+            }
+        }
+
+      /* We have a candidate cluster.  Check if the cluster number is
+       * mapped to a group of sectors.
+       */
+
+      startsector = fat_getcluster(fs, newcluster);
+      if (startsector == 0)
+        {
+          /* Found have found a free cluster */
+
+          return newcluster;
+        }
+      else if (startsector < 0)
+        {
+          /* Some error occurred, return the error number */
+
+          return startsector;
+        }
+
+      /* We wrap all the back to the starting cluster?  If so, then
+       * there are no free clusters.
+       */
+
+      if (newcluster == startcluster)
+        {
+          return 0;
+        }
+    }
+}
+
 /****************************************************************************
  * Name: fat_checkfsinfo
  *
@@ -952,6 +1244,8 @@ off_t fat_getcluster(struct fat_mountpt_s *fs, uint32_t clusterno)
 int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
                    off_t nextcluster)
 {
+  int ret;
+
   /* Verify that the cluster number is within range.  Zero erases the
    * cluster.
    */
@@ -980,11 +1274,12 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
 
               /* Make sure that the sector at this offset is in the cache */
 
-              if (fat_fscacheread(fs, fatsector) < 0)
+              ret = fat_fscacheread(fs, fatsector);
+              if (ret < 0)
                 {
                   /* Read error */
 
-                  break;
+                  return ret;
                 }
 
               /* Get the LS byte first handling the 12-bit alignment within
@@ -1025,11 +1320,12 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
                    */
 
                   fs->fs_dirty = true;
-                  if (fat_fscacheread(fs, fatsector) < 0)
+                  ret = fat_fscacheread(fs, fatsector);
+                  if (ret < 0)
                     {
                       /* Read error */
 
-                      break;
+                      return ret;
                     }
                 }
 
@@ -1062,11 +1358,12 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
                                        SEC_NSECTORS(fs, fatoffset);
               unsigned int fatindex  = fatoffset & SEC_NDXMASK(fs);
 
-              if (fat_fscacheread(fs, fatsector) < 0)
+              ret = fat_fscacheread(fs, fatsector);
+              if (ret < 0)
                 {
                   /* Read error */
 
-                  break;
+                  return ret;
                 }
 
               FAT_PUTFAT16(fs->fs_buffer, fatindex, nextcluster & 0xffff);
@@ -1081,11 +1378,12 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
               unsigned int fatindex  = fatoffset & SEC_NDXMASK(fs);
               uint32_t     val;
 
-              if (fat_fscacheread(fs, fatsector) < 0)
+              ret = fat_fscacheread(fs, fatsector);
+              if (ret < 0)
                 {
                   /* Read error */
 
-                  break;
+                  return ret;
                 }
 
               /* Keep the top 4 bits */
@@ -1103,6 +1401,23 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
       /* Mark the modified sector as "dirty" and return success */
 
       fs->fs_dirty = true;
+
+#ifdef CONFIG_FAT_FREE_BITMAP
+      /* Keep the bitmap in step with the FAT */
+
+      if (fs->fs_freemap != NULL && clusterno >= 2)
+        {
+          if (nextcluster != 0)
+            {
+              FAT_FREEMAP_SET(fs, clusterno);
+            }
+          else
+            {
+              FAT_FREEMAP_CLR(fs, clusterno);
+            }
+        }
+#endif
+
       return OK;
     }
 
@@ -1161,18 +1476,21 @@ int fat_removechain(struct fat_mountpt_s *fs, uint32_t cluster)
 }
 
 /****************************************************************************
- * Name: fat_extendchain
+ * Name: fat_extendrun
  *
  * Description:
  *   Add a new cluster to the chain following cluster (if cluster is non-
- *   NULL).  if cluster is zero, then a new chain is created.
+ *   NULL).  if cluster is zero, then a new chain is created.  'nclusters'
+ *   is the number of clusters the caller is about to add, including this
+ *   one, so that they can be placed in one contiguous run.
  *
  * Returned Value:
  *   <0:error, 0: no free cluster, >=2: new cluster number
  *
  ****************************************************************************/
 
-int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
+int32_t fat_extendrun(struct fat_mountpt_s *fs, uint32_t cluster,
+                      uint32_t nclusters)
 {
   off_t    startsector;
   uint32_t newcluster;
@@ -1226,67 +1544,21 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
       startcluster = cluster;
     }
 
-  /* Loop until (1) we discover that there are not free clusters
-   * (return 0), an errors occurs (return -errno), or (3) we find
-   * the next cluster (return the new cluster number).
+  /* Find a free cluster, preferably the one right after the start cluster
+   * so that the chain stays contiguous.
    */
 
-  newcluster = startcluster;
-  for (; ; )
+  ret = fat_findfreecluster(fs, startcluster, nclusters);
+  if (ret <= 0)
     {
-      /* Examine the next cluster in the FAT */
+      /* An error occurred or there is no free cluster */
 
-      newcluster++;
-      if (newcluster >= fs->fs_nclusters + 2)
-        {
-          /* If we hit the end of the available clusters, then
-           * wrap back to the beginning because we might have
-           * started at a non-optimal place.  But don't continue
-           * past the start cluster.
-           */
-
-          newcluster = 2;
-          if (newcluster > startcluster)
-            {
-              /* We are back past the starting cluster, then there
-               * is no free cluster.
-               */
-
-              return 0;
-            }
-        }
-
-      /* We have a candidate cluster.  Check if the cluster number is
-       * mapped to a group of sectors.
-       */
-
-      startsector = fat_getcluster(fs, newcluster);
-      if (startsector == 0)
-        {
-          /* Found have found a free cluster break out */
-
-          break;
-        }
-      else if (startsector < 0)
-        {
-          /* Some error occurred, return the error number */
-
-          return startsector;
-        }
-
-      /* We wrap all the back to the starting cluster?  If so, then
-       * there are no free clusters.
-       */
-
-      if (newcluster == startcluster)
-        {
-          return 0;
-        }
+      return ret;
     }
 
-  /* We get here only if we break out with an available cluster
-   * number in 'newcluster'  Now mark that cluster as in-use.
-   */
+  /* Now mark that cluster as in-use. */
+
+  newcluster = ret;
 
   ret = fat_putcluster(fs, newcluster, 0x0fffffff);
   if (ret < 0)
@@ -1546,11 +1818,11 @@ int fat_dirshrink(struct fat_mountpt_s *fs, FAR uint8_t *direntry,
 
       if (remaining <= clustersize)
         {
-          /* No.. then nullify next cluster -- removing it from the
-           * chain.
+          /* No.. then terminate the chain at the last cluster --
+           * removing the next cluster from the chain.
            */
 
-          ret = fat_putcluster(fs, lastcluster, 0);
+          ret = fat_putcluster(fs, lastcluster, 0x0fffffff);
           if (ret < 0)
             {
               return ret;
@@ -1598,6 +1870,7 @@ int fat_dirextend(FAR struct fat_mountpt_s *fs, FAR struct fat_file_s *ff,
                   off_t length)
 {
   int32_t cluster;
+  off_t clustersize;
   off_t remaining;
   off_t pos;
   unsigned int zerosize;
@@ -1610,6 +1883,7 @@ int fat_dirextend(FAR struct fat_mountpt_s *fs, FAR struct fat_file_s *ff,
    */
 
   pos = ff->ff_size;
+  clustersize = fs->fs_fatsecperclus * fs->fs_hwsectorsize;
 
   /* Get the first sector to write to. */
 
@@ -1621,7 +1895,9 @@ int fat_dirextend(FAR struct fat_mountpt_s *fs, FAR struct fat_file_s *ff,
         {
           /* No.. we have to create a new cluster chain */
 
-          ff->ff_startcluster     = fat_createchain(fs);
+          ff->ff_startcluster     = fat_extendrun(fs, 0,
+                                        (length - pos + clustersize - 1) /
+                                        clustersize);
           ff->ff_currentcluster   = ff->ff_startcluster;
           ff->ff_sectorsincluster = fs->fs_fatsecperclus;
         }
@@ -1657,7 +1933,9 @@ int fat_dirextend(FAR struct fat_mountpt_s *fs, FAR struct fat_file_s *ff,
            * move the file position back from the end of the file)
            */
 
-          cluster = fat_extendchain(fs, ff->ff_currentcluster);
+          cluster = fat_extendrun(fs, ff->ff_currentcluster,
+                                  (remaining + clustersize - 1) /
+                                  clustersize);
 
           /* Verify the cluster number */
 
@@ -62,6 +62,7 @@ void inode_free(FAR struct inode *inode)
 
       /* Free all peers and children of this i_node */
 
+      inode_hash_remove(inode);
       inode_free(inode->i_peer);
       inode_free(inode->i_child);
 
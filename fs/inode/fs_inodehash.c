@@ -0,0 +1,190 @@
+/****************************************************************************
+ * fs/inode/fs_inodehash.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <nuttx/fs/fs.h>
+
+#include "inode/inode.h"
+
+#ifdef CONFIG_FS_INODE_HASH
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* All inodes except the root, chained through i_hash.  The table is
+ * protected by the inode lock like the rest of the inode tree.
+ */
+
+static FAR struct inode *g_inode_hash[CONFIG_FS_INODE_HASH_SIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_hash
+ *
+ * Description:
+ *   Return the bucket of the path segment 'name' (terminated by '/' or NUL)
+ *   below 'parent'.  This is FNV-1a seeded with the parent address.
+ *
+ ****************************************************************************/
+
+static unsigned int inode_hash(FAR struct inode *parent,
+                               FAR const char *name)
+{
+  uint32_t hash = 2166136261u;
+
+  hash = (hash ^ (uint32_t)((uintptr_t)parent >> 2)) * 16777619u;
+  while (*name != '\0' && *name != '/')
+    {
+      hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    }
+
+  return hash % CONFIG_FS_INODE_HASH_SIZE;
+}
+
+/****************************************************************************
+ * Name: inode_hash_match
+ *
+ * Description:
+ *   Return true if the path segment 'name' is the name of 'inode'.
+ *
+ ****************************************************************************/
+
+static bool inode_hash_match(FAR struct inode *inode, FAR const char *name)
+{
+  FAR const char *nname = inode->i_name;
+
+  while (*nname != '\0' && *nname == *name)
+    {
+      nname++;
+      name++;
+    }
+
+  return *nname == '\0' && (*name == '\0' || *name == '/');
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_hash_insert
+ *
+ * Description:
+ *   Add an inode to the hash table.  The inode must already be linked to
+ *   its parent.
+ *
+ * Assumptions:
+ *   The caller holds the inode lock for writing
+ *
+ ****************************************************************************/
+
+void inode_hash_insert(FAR struct inode *inode)
+{
+  unsigned int index;
+
+  DEBUGASSERT(inode->i_parent != NULL);
+
+  index               = inode_hash(inode->i_parent, inode->i_name);
+  inode->i_hash       = g_inode_hash[index];
+  g_inode_hash[index] = inode;
+}
+
+/****************************************************************************
+ * Name: inode_hash_remove
+ *
+ * Description:
+ *   Remove an inode from the hash table.  Nothing is done if the inode is
+ *   not in the table, so this may be called more than once.  The inode
+ *   must still be linked to its parent.
+ *
+ * Assumptions:
+ *   The caller holds the inode lock for writing
+ *
+ ****************************************************************************/
+
+void inode_hash_remove(FAR struct inode *inode)
+{
+  FAR struct inode **prev;
+
+  if (inode->i_parent == NULL)
+    {
+      return;
+    }
+
+  prev = &g_inode_hash[inode_hash(inode->i_parent, inode->i_name)];
+  for (; *prev != NULL; prev = &(*prev)->i_hash)
+    {
+      if (*prev == inode)
+        {
+          *prev         = inode->i_hash;
+          inode->i_hash = NULL;
+          break;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: inode_hash_find
+ *
+ * Description:
+ *   Find the child of 'parent' named by the path segment 'name'.  The
+ *   segment ends at the next '/' or at the end of the string.
+ *
+ * Returned Value:
+ *   The matching inode or NULL if 'parent' has no such child.
+ *
+ * Assumptions:
+ *   The caller holds the inode lock
+ *
+ ****************************************************************************/
+
+FAR struct inode *inode_hash_find(FAR struct inode *parent,
+                                  FAR const char *name)
+{
+  FAR struct inode *inode;
+
+  inode = g_inode_hash[inode_hash(parent, name)];
+  for (; inode != NULL; inode = inode->i_hash)
+    {
+      if (inode->i_parent == parent && inode_hash_match(inode, name))
+        {
+          break;
+        }
+    }
+
+  return inode;
+}
+
+#endif /* CONFIG_FS_INODE_HASH */
@@ -79,6 +79,24 @@ static FAR struct inode *inode_unlink(FAR const char *path)
       inode = desc.node;
       DEBUGASSERT(inode != NULL);
 
+#ifdef CONFIG_FS_INODE_HASH
+      /* The hashed search does not return the peer, look it up now */
+
+      desc.peer = NULL;
+      if (desc.parent != NULL)
+        {
+          FAR struct inode *next;
+
+          for (next = desc.parent->i_child; next != inode;
+               next = next->i_peer)
+            {
+              desc.peer = next;
+            }
+        }
+
+      inode_hash_remove(inode);
+#endif
+
       /* If peer is non-null, then remove the node from the right of
        * of that peer node.
        */
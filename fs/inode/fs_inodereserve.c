@@ -28,6 +28,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <string.h>
 
 #include <nuttx/kmalloc.h>
 #include <nuttx/fs/fs.h>
@@ -109,6 +110,22 @@ static void inode_insert(FAR struct inode *inode,
                          FAR struct inode *peer,
                          FAR struct inode *parent)
 {
+#ifdef CONFIG_FS_INODE_HASH
+  FAR struct inode *next;
+
+  /* The hashed search does not return the peer, so find the position in
+   * the ordered list of children here.
+   */
+
+  DEBUGASSERT(peer == NULL && parent != NULL);
+  for (next = parent->i_child;
+       next != NULL && strcmp(next->i_name, inode->i_name) < 0;
+       next = next->i_peer)
+    {
+      peer = next;
+    }
+#endif
+
   /* If peer is non-null, then new node simply goes to the right
    * of that peer node.
    */
@@ -129,6 +146,8 @@ static void inode_insert(FAR struct inode *inode,
       inode->i_parent = parent;
       parent->i_child = inode;
     }
+
+  inode_hash_insert(inode);
 }
 
 /****************************************************************************
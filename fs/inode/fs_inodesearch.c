@@ -386,7 +386,16 @@ static int _inode_search(FAR struct inode_search_s *desc)
 
               above = inode;
               left  = NULL;
+#ifdef CONFIG_FS_INODE_HASH
+              /* Jump straight to the child.  The peer to its left is not
+               * looked up, inode_reserve() and inode_unlink() find it
+               * themselves.
+               */
+
+              inode = inode_hash_find(above, name);
+#else
               inode = inode->i_child;
+#endif
             }
         }
     }
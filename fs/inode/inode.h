@@ -346,6 +346,28 @@ const char *inode_nextname(FAR const char *name);
 
 void inode_root_reserve(void);
 
+/****************************************************************************
+ * Name: inode_hash_insert, inode_hash_remove and inode_hash_find
+ *
+ * Description:
+ *   Maintain and search the table of inodes hashed by parent and name.
+ *   inode_hash_find() returns the child of 'parent' named by the path
+ *   segment 'name' or NULL.
+ *
+ *   NOTE: Caller must hold the inode semaphore
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_INODE_HASH
+void inode_hash_insert(FAR struct inode *inode);
+void inode_hash_remove(FAR struct inode *inode);
+FAR struct inode *inode_hash_find(FAR struct inode *parent,
+                                  FAR const char *name);
+#else
+#  define inode_hash_insert(i)
+#  define inode_hash_remove(i)
+#endif
+
 /****************************************************************************
  * Name: inode_reserve
  *
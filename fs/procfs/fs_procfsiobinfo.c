@@ -187,6 +187,9 @@ static ssize_t iobinfo_read(FAR struct file *filep, FAR char *buffer,
   size_t copysize;
   size_t totalsize;
   off_t offset;
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+  int i;
+#endif
 
   finfo("buffer=%p buflen=%d\n", buffer, (int)buflen);
 
@@ -223,6 +226,39 @@ static ssize_t iobinfo_read(FAR struct file *filep, FAR char *buffer,
                              &offset);
   totalsize += copysize;
 
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+  /* Then the per-CPU cache statistics */
+
+  buffer += copysize;
+  buflen -= copysize;
+
+  linesize   = procfs_snprintf(iobfile->line, IOBINFO_LINELEN,
+                               "%4s%10s%10s%10s%10s%10s\n",
+                               "cpu", "ncached", "nalloc", "nfree",
+                               "nrefill", "nflush");
+
+  copysize   = procfs_memcpy(iobfile->line, linesize, buffer, buflen,
+                             &offset);
+  totalsize += copysize;
+
+  for (i = 0; i < CONFIG_SMP_NCPUS; i++)
+    {
+      buffer += copysize;
+      buflen -= copysize;
+
+      linesize   = procfs_snprintf(iobfile->line, IOBINFO_LINELEN,
+                                   "%4d%10d%10lu%10lu%10lu%10lu\n",
+                                   i, stats.cpu[i].ncached,
+                                   stats.cpu[i].nalloc, stats.cpu[i].nfree,
+                                   stats.cpu[i].nrefill,
+                                   stats.cpu[i].nflush);
+
+      copysize   = procfs_memcpy(iobfile->line, linesize, buffer, buflen,
+                                 &offset);
+      totalsize += copysize;
+    }
+#endif
+
   /* Update the file offset */
 
   filep->f_pos += totalsize;
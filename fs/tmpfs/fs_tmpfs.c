@@ -26,6 +26,7 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <sys/stat.h>
 #include <sys/statfs.h>
 #include <stdint.h>
@@ -54,10 +55,6 @@
 #  warning CONFIG_FS_TMPFS_DIRECTORY_FREEGUARD needs to be > ALLOCGUARD
 #endif
 
-#if CONFIG_FS_TMPFS_FILE_FREEGUARD <= CONFIG_FS_TMPFS_FILE_ALLOCGUARD
-#  warning CONFIG_FS_TMPFS_FILE_FREEGUARD needs to be > ALLOCGUARD
-#endif
-
 #define tmpfs_lock(fs) \
            nxrmutex_lock(&fs->tfs_lock)
 #define tmpfs_lock_object(to) \
@@ -96,6 +93,9 @@ static int  tmpfs_realloc_directory(FAR struct tmpfs_directory_s *tdo,
               unsigned int nentries);
 static int  tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
               size_t newsize);
+static FAR uint8_t *tmpfs_get_page(FAR struct tmpfs_file_s *tfo,
+              size_t index);
+static void tmpfs_free_pages(FAR struct tmpfs_file_s *tfo);
 static void tmpfs_release_lockedobject(FAR struct tmpfs_object_s *to);
 static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo);
 static int  tmpfs_release_file(FAR struct tmpfs_file_s *tfo);
@@ -270,82 +270,243 @@ static int tmpfs_realloc_directory(FAR struct tmpfs_directory_s *tdo,
 
 /****************************************************************************
  * Name: tmpfs_realloc_file
+ *
+ * Description:
+ *   Change the size of a file.  Only the page table is reallocated, the
+ *   pages past the end of a growing file are holes until they are written.
+ *
  ****************************************************************************/
 
 static int tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
                               size_t newsize)
 {
-  FAR uint8_t *newdata;
-  size_t allocsize;
-  size_t delta;
+  FAR uint8_t **newpages;
+  size_t allocpages;
+  size_t npages;
+  size_t offset;
+  size_t index;
+
+  npages = TMPFS_NPAGES(newsize);
 
   /* Are we growing or shrinking the object? */
 
-  if (newsize <= tfo->tfo_alloc)
+  if (newsize <= tfo->tfo_size)
     {
-      /* Shrinking ... Shrink unconditionally if the size is shrinking to
-       * zero.
+      /* Shrinking ... Free the pages past the new end of the file.  Pages
+       * of the contiguous block and pages that may be mapped are only
+       * cleared, their memory must stay valid.
        */
 
-      if (newsize == 0)
+      for (index = npages; index < TMPFS_NPAGES(tfo->tfo_size); index++)
         {
-          /* Free the file object */
+          if (tfo->tfo_pages[index] == NULL)
+            {
+              continue;
+            }
 
-          fs_heap_free(tfo->tfo_data);
-          tfo->tfo_data = NULL;
-          tfo->tfo_alloc = 0;
-          tfo->tfo_size = 0;
-          return OK;
+          if (tfo->tfo_nmaps > 0 || index < tfo->tfo_nbase)
+            {
+              memset(tfo->tfo_pages[index], 0, TMPFS_PAGESIZE);
+            }
+          else
+            {
+              fs_heap_free(tfo->tfo_pages[index]);
+              tfo->tfo_pages[index] = NULL;
+              tfo->tfo_alloc -= TMPFS_PAGESIZE;
+            }
         }
-      else if (newsize > 0)
+
+      /* We should make sure the shrunk part of the last page is zero */
+
+      offset = TMPFS_PGOFF(newsize);
+      if (offset > 0 && tfo->tfo_pages[npages - 1] != NULL)
         {
-          /* Otherwise, don't realloc unless the object has shrunk by a
-           * lot.
-           */
+          memset(tfo->tfo_pages[npages - 1] + offset, 0,
+                 TMPFS_PAGESIZE - offset);
+        }
 
-          delta = tfo->tfo_alloc - newsize;
+      tfo->tfo_size = newsize;
 
-          /* We should make sure the shrunked memory be zero */
+      /* The page table can't shrink below pages that are still held */
 
-          memset(tfo->tfo_data + newsize, 0, delta);
-          if (delta <= CONFIG_FS_TMPFS_FILE_FREEGUARD)
-            {
-              /* Hasn't shrunk enough.. Return doing nothing for now */
+      if (tfo->tfo_nmaps > 0)
+        {
+          return OK;
+        }
 
-              tfo->tfo_size = newsize;
-              return OK;
+      /* Shrink the page table unconditionally if the size is shrinking to
+       * zero.  Otherwise, don't realloc unless it has shrunk by a lot.
+       */
+
+      if (npages == 0)
+        {
+          tmpfs_free_pages(tfo);
+        }
+      else if (MAX(npages, tfo->tfo_nbase) < tfo->tfo_npages / 2)
+        {
+          npages   = MAX(npages, tfo->tfo_nbase);
+          newpages = fs_heap_realloc(tfo->tfo_pages,
+                                     npages * sizeof(FAR uint8_t *));
+          if (newpages != NULL)
+            {
+              tfo->tfo_pages  = newpages;
+              tfo->tfo_npages = npages;
             }
         }
+
+      return OK;
     }
 
-  /* Added some additional amount to the new size to account frequent
-   * reallocations.
+  /* Growing ... Extend the page table if needed.  Add half again to account
+   * for frequent reallocations.
    */
 
-  allocsize = newsize + CONFIG_FS_TMPFS_FILE_ALLOCGUARD;
-  if (allocsize < newsize)
+  if (npages > tfo->tfo_npages)
     {
-      /* There must have been an integer overflow */
+      allocpages = npages + npages / 2;
+      if (allocpages > SIZE_MAX / sizeof(FAR uint8_t *))
+        {
+          /* There must have been an integer overflow */
 
-      return -ENOMEM;
+          return -ENOMEM;
+        }
+
+      newpages = fs_heap_realloc(tfo->tfo_pages,
+                                 allocpages * sizeof(FAR uint8_t *));
+      if (newpages == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      memset(&newpages[tfo->tfo_npages], 0,
+             (allocpages - tfo->tfo_npages) * sizeof(FAR uint8_t *));
+
+      tfo->tfo_pages  = newpages;
+      tfo->tfo_npages = allocpages;
+    }
+
+  tfo->tfo_size = newsize;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: tmpfs_get_page
+ *
+ * Description:
+ *   Return a page of a file, allocating it if it is a hole.  Returns NULL
+ *   if the page can not be allocated.
+ *
+ ****************************************************************************/
+
+static FAR uint8_t *tmpfs_get_page(FAR struct tmpfs_file_s *tfo,
+                                   size_t index)
+{
+  FAR uint8_t *page;
+
+  DEBUGASSERT(index < tfo->tfo_npages);
+
+  page = tfo->tfo_pages[index];
+  if (page == NULL)
+    {
+      page = fs_heap_zalloc(TMPFS_PAGESIZE);
+      if (page != NULL)
+        {
+          tfo->tfo_pages[index] = page;
+          tfo->tfo_alloc       += TMPFS_PAGESIZE;
+        }
+    }
+
+  return page;
+}
+
+/****************************************************************************
+ * Name: tmpfs_linearize
+ *
+ * Description:
+ *   Move all pages of a file into one contiguous block, so that the whole
+ *   file can be mapped or executed in place.  Nothing is done if the file
+ *   is already contiguous.  Mapped pages can't move, so this fails with
+ *   -EBUSY if the file is mapped and not contiguous.
+ *
+ ****************************************************************************/
+
+static int tmpfs_linearize(FAR struct tmpfs_file_s *tfo)
+{
+  FAR uint8_t *base;
+  FAR uint8_t *page;
+  size_t npages;
+  size_t index;
+
+  npages = TMPFS_NPAGES(tfo->tfo_size);
+  if (npages <= tfo->tfo_nbase)
+    {
+      return OK;
     }
 
-  /* Realloc the file object */
+  if (tfo->tfo_nmaps > 0)
+    {
+      return -EBUSY;
+    }
 
-  newdata = fs_heap_realloc(tfo->tfo_data, allocsize);
-  if (newdata == NULL)
+  if (npages > SIZE_MAX / TMPFS_PAGESIZE)
     {
       return -ENOMEM;
     }
 
-  /* Return the new address of the reallocated file object */
+  base = fs_heap_zalloc(npages * TMPFS_PAGESIZE);
+  if (base == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  /* Copy the pages and release the memory that held them */
+
+  for (index = 0; index < tfo->tfo_npages; index++)
+    {
+      page = tfo->tfo_pages[index];
+      if (page != NULL && index < npages)
+        {
+          memcpy(base + index * TMPFS_PAGESIZE, page, TMPFS_PAGESIZE);
+        }
 
-  tfo->tfo_alloc = allocsize;
-  tfo->tfo_size  = newsize;
-  tfo->tfo_data  = newdata;
+      if (page != NULL && index >= tfo->tfo_nbase)
+        {
+          fs_heap_free(page);
+        }
+
+      tfo->tfo_pages[index] = index < npages ?
+                              base + index * TMPFS_PAGESIZE : NULL;
+    }
+
+  fs_heap_free(tfo->tfo_base);
+  tfo->tfo_base  = base;
+  tfo->tfo_nbase = npages;
+  tfo->tfo_alloc = npages * TMPFS_PAGESIZE;
   return OK;
 }
 
+/****************************************************************************
+ * Name: tmpfs_free_pages
+ ****************************************************************************/
+
+static void tmpfs_free_pages(FAR struct tmpfs_file_s *tfo)
+{
+  size_t index;
+
+  for (index = tfo->tfo_nbase; index < tfo->tfo_npages; index++)
+    {
+      fs_heap_free(tfo->tfo_pages[index]);
+    }
+
+  fs_heap_free(tfo->tfo_base);
+  fs_heap_free(tfo->tfo_pages);
+  tfo->tfo_base   = NULL;
+  tfo->tfo_nbase  = 0;
+  tfo->tfo_pages  = NULL;
+  tfo->tfo_npages = 0;
+  tfo->tfo_alloc  = 0;
+}
+
 /****************************************************************************
  * Name: tmpfs_release_lockedobject
  ****************************************************************************/
@@ -383,7 +544,7 @@ static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo)
     {
       tmpfs_unlock_file(tfo);
       nxrmutex_destroy(&tfo->tfo_lock);
-      fs_heap_free(tfo->tfo_data);
+      tmpfs_free_pages(tfo);
       fs_heap_free(tfo);
     }
 
@@ -582,7 +743,11 @@ tmpfs_alloc_file(FAR struct tmpfs_directory_s *parent)
   tfo->tfo_parent = parent;
   tfo->tfo_flags  = 0;
   tfo->tfo_size   = 0;
-  tfo->tfo_data   = NULL;
+  tfo->tfo_npages = 0;
+  tfo->tfo_pages  = NULL;
+  tfo->tfo_base   = NULL;
+  tfo->tfo_nbase  = 0;
+  tfo->tfo_nmaps  = 0;
 
   nxrmutex_init(&tfo->tfo_lock);
   tmpfs_lock_file(tfo);
@@ -1188,8 +1353,16 @@ static int tmpfs_statfs_callout(FAR struct tmpfs_directory_s *tdo,
        */
 
       tmptfo             = (FAR struct tmpfs_file_s *)to;
-      tmpbuf->tsf_alloc += sizeof(struct tmpfs_file_s);
-      tmpbuf->tsf_avail += to->to_alloc - tmptfo->tfo_size;
+      tmpbuf->tsf_alloc += sizeof(struct tmpfs_file_s) +
+                           tmptfo->tfo_npages * sizeof(FAR uint8_t *);
+
+      /* The holes of a sparse file take no memory at all */
+
+      if (to->to_alloc > tmptfo->tfo_size)
+        {
+          tmpbuf->tsf_avail += to->to_alloc - tmptfo->tfo_size;
+        }
+
       tmpbuf->tsf_files++;
     }
   else /* if (to->to_type == TMPFS_DIRECTORY) */
@@ -1265,7 +1438,7 @@ static int tmpfs_free_callout(FAR struct tmpfs_directory_s *tdo,
           return TMPFS_UNLINKED;
         }
 
-      fs_heap_free(tfo->tfo_data);
+      tmpfs_free_pages(tfo);
     }
   else /* if (to->to_type == TMPFS_DIRECTORY) */
     {
@@ -1544,9 +1717,13 @@ static ssize_t tmpfs_read(FAR struct file *filep, FAR char *buffer,
                           size_t buflen)
 {
   FAR struct tmpfs_file_s *tfo;
+  FAR uint8_t *page;
   ssize_t nread;
   off_t startpos;
   off_t endpos;
+  off_t pos;
+  size_t offset;
+  size_t nbytes;
   int ret;
 
   finfo("filep: %p buffer: %p buflen: %lu\n",
@@ -1584,18 +1761,28 @@ static ssize_t tmpfs_read(FAR struct file *filep, FAR char *buffer,
       nread  = endpos - startpos;
     }
 
-  /* Copy data from the memory object to the user buffer */
+  /* Copy data from the file pages to the user buffer.  Holes read as
+   * zero.
+   */
 
-  if (tfo->tfo_data != NULL)
-    {
-      memcpy(buffer, &tfo->tfo_data[startpos], nread);
-      filep->f_pos += nread;
-    }
-  else
+  for (pos = startpos; pos < endpos; pos += nbytes, buffer += nbytes)
     {
-      DEBUGASSERT(tfo->tfo_size == 0 && nread == 0);
+      page   = tfo->tfo_pages[TMPFS_PAGE(pos)];
+      offset = TMPFS_PGOFF(pos);
+      nbytes = MIN(TMPFS_PAGESIZE - offset, endpos - pos);
+
+      if (page != NULL)
+        {
+          memcpy(buffer, page + offset, nbytes);
+        }
+      else
+        {
+          memset(buffer, 0, nbytes);
+        }
     }
 
+  filep->f_pos += nread;
+
   /* Release the lock on the file */
 
   tmpfs_unlock_file(tfo);
@@ -1610,9 +1797,14 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
                            size_t buflen)
 {
   FAR struct tmpfs_file_s *tfo;
+  FAR uint8_t *page;
   ssize_t nwritten;
+  size_t oldsize;
   off_t startpos;
   off_t endpos;
+  off_t pos;
+  size_t offset;
+  size_t nbytes;
   int ret;
 
   finfo("filep: %p buffer: %p buflen: %lu\n",
@@ -1644,6 +1836,7 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
 
   nwritten = buflen;
   endpos   = startpos + buflen;
+  oldsize  = tfo->tfo_size;
 
   if (endpos > tfo->tfo_size)
     {
@@ -1656,15 +1849,34 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
         }
     }
 
-  /* Copy data from the memory object to the user buffer */
+  /* Copy data from the user buffer to the file pages, allocating the
+   * pages that are written for the first time.
+   */
 
-  if (tfo->tfo_data != NULL)
+  for (pos = startpos; pos < endpos; pos += nbytes, buffer += nbytes)
     {
-      memcpy(&tfo->tfo_data[startpos], buffer, nwritten);
-    }
-  else
-    {
-      DEBUGASSERT(tfo->tfo_size == 0 && nwritten == 0);
+      offset = TMPFS_PGOFF(pos);
+      nbytes = MIN(TMPFS_PAGESIZE - offset, endpos - pos);
+
+      page = tmpfs_get_page(tfo, TMPFS_PAGE(pos));
+      if (page == NULL)
+        {
+          /* Out of memory.  Trim the file to the data written so far */
+
+          tmpfs_realloc_file(tfo, MAX(oldsize, (size_t)pos));
+
+          nwritten = pos - startpos;
+          if (nwritten == 0)
+            {
+              ret = -ENOMEM;
+              goto errout_with_lock;
+            }
+
+          endpos = pos;
+          break;
+        }
+
+      memcpy(page + offset, buffer, nbytes);
     }
 
   filep->f_pos = endpos;
@@ -1753,6 +1965,11 @@ static int tmpfs_unmap(FAR struct task_group_s *group,
       ret = mm_map_remove(get_group_mm(group), entry);
       if (ret >= 0)
         {
+          tmpfs_lock_file(tfo);
+          DEBUGASSERT(tfo->tfo_nmaps > 0);
+          tfo->tfo_nmaps--;
+          tmpfs_unlock_file(tfo);
+
           ret = tmpfs_release_file(tfo);
         }
     }
@@ -1775,6 +1992,9 @@ static int tmpfs_unmap(FAR struct task_group_s *group,
 static int tmpfs_mmap(FAR struct file *filep, FAR struct mm_map_entry_s *map)
 {
   FAR struct tmpfs_file_s *tfo;
+  FAR uint8_t *page;
+  size_t first;
+  size_t last;
   int ret = -EINVAL;
 
   DEBUGASSERT(filep->f_priv != NULL);
@@ -1788,15 +2008,46 @@ static int tmpfs_mmap(FAR struct file *filep, FAR struct mm_map_entry_s *map)
   if (map->offset >= 0 && map->offset < tfo->tfo_size &&
       map->length && map->offset + map->length <= tfo->tfo_size)
     {
-      map->vaddr = tfo->tfo_data + map->offset;
+      first = TMPFS_PAGE(map->offset);
+      last  = TMPFS_PAGE(map->offset + map->length - 1);
+
+      /* A range spanning several pages must be contiguous in memory.  The
+       * file is moved to one block if needed, and its pages stay pinned
+       * while the mapping exists.
+       */
+
+      tmpfs_lock_file(tfo);
+      if (last != first && last >= tfo->tfo_nbase)
+        {
+          ret = tmpfs_linearize(tfo);
+          if (ret < 0)
+            {
+              tmpfs_unlock_file(tfo);
+              return ret;
+            }
+        }
+
+      page = tmpfs_get_page(tfo, first);
+      if (page == NULL)
+        {
+          tmpfs_unlock_file(tfo);
+          return -ENOMEM;
+        }
+
+      tfo->tfo_nmaps++;
+      tfo->tfo_refs++;
+      tmpfs_unlock_file(tfo);
+
+      map->vaddr = page + TMPFS_PGOFF(map->offset);
       map->priv.p = tfo;
       map->munmap = tmpfs_unmap;
       ret = mm_map_add(get_current_mm(), map);
 
-      if (ret >= 0)
+      if (ret < 0)
         {
           tmpfs_lock_file(tfo);
-          tfo->tfo_refs++;
+          tfo->tfo_nmaps--;
+          tfo->tfo_refs--;
           tmpfs_unlock_file(tfo);
         }
     }
@@ -1841,8 +2092,30 @@ static int tmpfs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
   else if (cmd == FIOC_XIPBASE)
     {
       FAR uintptr_t *ptr = (FAR uintptr_t *)arg;
+      FAR uint8_t *page;
+
+      if (tfo->tfo_size == 0)
+        {
+          return -ENOTTY;
+        }
+
+      /* The file must be contiguous in memory to execute in place */
+
+      tmpfs_lock_file(tfo);
+      ret = tmpfs_linearize(tfo);
+      page = ret < 0 ? NULL : tmpfs_get_page(tfo, 0);
+      tmpfs_unlock_file(tfo);
 
-      *ptr = (uintptr_t)tfo->tfo_data;
+      if (ret < 0)
+        {
+          return ret;
+        }
+      else if (page == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      *ptr = (uintptr_t)page;
       return OK;
     }
 
@@ -1976,15 +2249,10 @@ static int tmpfs_truncate(FAR struct file *filep, off_t length)
           goto errout_with_lock;
         }
 
-      /* If the size has increased, then we need to zero the newly added
-       * memory.
+      /* If the size has increased, the newly added pages are holes that
+       * read as zero.
        */
 
-      if (length > oldsize)
-        {
-          memset(&tfo->tfo_data[oldsize], 0, length - oldsize);
-        }
-
       ret = OK;
     }
 
@@ -2426,7 +2694,7 @@ static int tmpfs_unlink(FAR struct inode *mountpt, FAR const char *relpath)
   else
     {
       nxrmutex_destroy(&tfo->tfo_lock);
-      fs_heap_free(tfo->tfo_data);
+      tmpfs_free_pages(tfo);
       fs_heap_free(tfo);
     }
 
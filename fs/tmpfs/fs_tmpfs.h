@@ -42,6 +42,15 @@
 
 #define TFO_FLAG_UNLINKED (1 << 0)  /* Bit 0: File is unlinked */
 
+/* Regular files are held in fixed-size pages.  A page that has never been
+ * written is not allocated and reads as zero.
+ */
+
+#define TMPFS_PAGESIZE    CONFIG_FS_TMPFS_PAGESIZE
+#define TMPFS_PAGE(o)     ((o) / TMPFS_PAGESIZE)  /* Page holding offset o */
+#define TMPFS_PGOFF(o)    ((o) % TMPFS_PAGESIZE)  /* Offset o in its page */
+#define TMPFS_NPAGES(s)   (((s) + TMPFS_PAGESIZE - 1) / TMPFS_PAGESIZE)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -119,16 +128,20 @@ struct tmpfs_file_s
 
   rmutex_t tfo_lock;
 
-  size_t   tfo_alloc;    /* Allocated size of the file object */
+  size_t   tfo_alloc;    /* Allocated size of the file pages */
   uint8_t  tfo_type;     /* See enum tmpfs_objtype_e */
   uint8_t  tfo_refs;     /* Reference count */
   FAR struct tmpfs_directory_s *tfo_parent;
 
   /* Remaining fields are unique to a directory object */
 
-  uint8_t       tfo_flags; /* See TFO_FLAG_* definitions */
-  size_t        tfo_size;  /* Valid file size */
-  FAR uint8_t  *tfo_data;  /* File data starts here */
+  uint8_t       tfo_flags;  /* See TFO_FLAG_* definitions */
+  size_t        tfo_size;   /* Valid file size */
+  size_t        tfo_npages; /* Number of entries in tfo_pages */
+  FAR uint8_t **tfo_pages;  /* File data pages, NULL for holes */
+  FAR uint8_t  *tfo_base;   /* Contiguous block holding the first pages */
+  size_t        tfo_nbase;  /* Number of pages in tfo_base */
+  uint8_t       tfo_nmaps;  /* Number of mappings pinning the pages */
 };
 
 /* This structure represents one instance of a TMPFS file system */
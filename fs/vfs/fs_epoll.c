@@ -27,6 +27,7 @@
 #include <nuttx/config.h>
 
 #include <sys/epoll.h>
+#include <sys/param.h>
 
 #include <inttypes.h>
 #include <stdint.h>
@@ -42,6 +43,7 @@
 #include <nuttx/list.h>
 #include <nuttx/mutex.h>
 #include <nuttx/signal.h>
+#include <nuttx/spinlock.h>
 
 #include "inode/inode.h"
 #include "fs_heap.h"
@@ -52,9 +54,15 @@
 
 struct epoll_node_s
 {
-  struct list_node         node;
+  struct list_node         node;    /* Entry in the setup, teardown, oneshot
+                                     * or free list.
+                                     */
+  struct list_node         ready;   /* Entry in the ready list */
   epoll_data_t             data;
-  bool                     notified;
+  bool                     armed;   /* The poll of the fd is set up */
+  pollevent_t              revents; /* The events collected since the node
+                                     * was put into the ready list.
+                                     */
   struct pollfd            pfd;
   FAR struct file         *filep;
   FAR struct epoll_head_s *eph;
@@ -68,13 +76,22 @@ struct epoll_head_s
   int                   crefs;
   mutex_t               lock;
   sem_t                 sem;
+  spinlock_t            rlock;    /* Protects the ready list and the revents
+                                   * of the epoll nodes, which are updated
+                                   * from the poll callback.
+                                   */
+  struct list_node      ready;    /* The ready list, store all the epoll node
+                                   * that have pending events, in the order
+                                   * they were notified.
+                                   */
   struct list_node      setup;    /* The setup list, store all the setuped
                                    * epoll node.
                                    */
-  struct list_node      teardown; /* The teardown list, store all the epoll
-                                   * node notified after epoll_wait finish,
-                                   * these epoll node should be setup again
-                                   * to check the pending poll notification.
+  struct list_node      teardown; /* The teardown list, store all the level
+                                   * triggered epoll node returned by the
+                                   * last epoll_wait, these epoll node should
+                                   * be setup again to check if the events
+                                   * are still pending.
                                    */
   struct list_node      oneshot;  /* The oneshot list, store all the epoll
                                    * node notified after epoll_wait and with
@@ -138,6 +155,90 @@ static struct inode g_epoll_inode =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: epoll_unready
+ *
+ * Description:
+ *   Remove the epoll node from the ready list and drop its pending events.
+ *
+ ****************************************************************************/
+
+static void epoll_unready(FAR epoll_head_t *eph, FAR epoll_node_t *epn)
+{
+  irqstate_t flags;
+
+  flags = spin_lock_irqsave(&eph->rlock);
+  if (list_in_list(&epn->ready))
+    {
+      list_delete(&epn->ready);
+    }
+
+  epn->revents = 0;
+  spin_unlock_irqrestore(&eph->rlock, flags);
+}
+
+/****************************************************************************
+ * Name: epoll_arm and epoll_disarm
+ *
+ * Description:
+ *   Setup or teardown the poll of the fd of the epoll node.  The setup
+ *   notifies the events that are already pending.
+ *
+ ****************************************************************************/
+
+static int epoll_arm(FAR epoll_node_t *epn)
+{
+  int ret;
+
+  epn->pfd.revents = 0;
+  ret = file_poll(epn->filep, &epn->pfd, true);
+  epn->armed = ret >= 0;
+  return ret;
+}
+
+static void epoll_disarm(FAR epoll_head_t *eph, FAR epoll_node_t *epn)
+{
+  if (epn->armed)
+    {
+      file_poll(epn->filep, &epn->pfd, false);
+      epn->armed = false;
+    }
+
+  epoll_unready(eph, epn);
+}
+
+/****************************************************************************
+ * Name: epoll_find
+ *
+ * Description:
+ *   Find the epoll node of the fd in the setup, teardown and oneshot lists.
+ *
+ ****************************************************************************/
+
+static FAR epoll_node_t *epoll_find(FAR epoll_head_t *eph, int fd)
+{
+  FAR struct list_node *lists[3];
+  FAR epoll_node_t *epn;
+  int i;
+
+  lists[0] = &eph->setup;
+  lists[1] = &eph->teardown;
+  lists[2] = &eph->oneshot;
+
+  for (i = 0; i < nitems(lists); i++)
+    {
+      list_for_every_entry(lists[i], epn, epoll_node_t, node)
+        {
+          if (epn->pfd.fd == fd)
+            {
+              return epn;
+            }
+        }
+    }
+
+  return NULL;
+}
+
 static FAR epoll_head_t *epoll_head_from_fd(int fd, FAR struct file **filep)
 {
   int ret;
@@ -199,7 +300,18 @@ static int epoll_do_close(FAR struct file *filep)
       nxmutex_destroy(&eph->lock);
       list_for_every_entry(&eph->setup, epn, epoll_node_t, node)
         {
-          file_poll(epn->filep, &epn->pfd, false);
+          epoll_disarm(eph, epn);
+          file_put(epn->filep);
+        }
+
+      list_for_every_entry(&eph->teardown, epn, epoll_node_t, node)
+        {
+          epoll_disarm(eph, epn);
+          file_put(epn->filep);
+        }
+
+      list_for_every_entry(&eph->oneshot, epn, epoll_node_t, node)
+        {
           file_put(epn->filep);
         }
 
@@ -244,6 +356,8 @@ static int epoll_do_create(int size, int flags)
 
   epn = (FAR epoll_node_t *)(eph + 1);
 
+  spin_lock_init(&eph->rlock);
+  list_initialize(&eph->ready);
   list_initialize(&eph->setup);
   list_initialize(&eph->teardown);
   list_initialize(&eph->oneshot);
@@ -274,7 +388,9 @@ static int epoll_do_create(int size, int flags)
  * Name: epoll_setup
  *
  * Description:
- *   Setup all the fd.
+ *   Setup again the level triggered fd returned by the last epoll_wait, to
+ *   check if their events are still pending.  All other fd stay setup and
+ *   report their events through the ready list.
  *
  * Input Parameters:
  *   eph       - The epoll head pointer
@@ -298,13 +414,13 @@ static int epoll_setup(FAR epoll_head_t *eph)
 
   list_for_every_entry_safe(&eph->teardown, epn, tepn, epoll_node_t, node)
     {
-      /* Setup again to check the notified pollfd last epoll_wait() to
-       * cover the situation several poll event pending on one fd.
+      /* Drop the events collected since the last epoll_wait() and setup
+       * again, the setup puts the node back to the ready list if one of
+       * the events is still pending.
        */
 
-      epn->notified    = false;
-      epn->pfd.revents = 0;
-      ret = file_poll(epn->filep, &epn->pfd, true);
+      epoll_disarm(eph, epn);
+      ret = epoll_arm(epn);
       if (ret < 0)
         {
           ferr("epoll setup failed, filep=%p, events=%08" PRIx32 ", "
@@ -324,8 +440,8 @@ static int epoll_setup(FAR epoll_head_t *eph)
  * Name: epoll_teardown
  *
  * Description:
- *   Teardown all the notified fd and check the notified fd's event with user
- *   expected event.
+ *   Take the notified fd from the ready list and return their events.  Only
+ *   the fd in the ready list are visited, not all the registered fd.
  *
  * Input Parameters:
  *   eph       - The epoll head pointer
@@ -341,45 +457,90 @@ static int epoll_setup(FAR epoll_head_t *eph)
 static int epoll_teardown(FAR epoll_head_t *eph, FAR struct epoll_event *evs,
                           int maxevents)
 {
-  FAR epoll_node_t *tepn;
+  FAR struct list_node *node;
   FAR epoll_node_t *epn;
+  pollevent_t revents = 0;
+  irqstate_t flags;
+  bool pending;
+  int semcount = 0;
+  int nready = 0;
   int i = 0;
 
   nxmutex_lock(&eph->lock);
 
-  list_for_every_entry_safe(&eph->setup, epn, tepn, epoll_node_t, node)
+  /* Only visit the nodes that are ready now, a node notified again while
+   * the list is being reaped is returned by the next epoll_wait().
+   */
+
+  flags = spin_lock_irqsave(&eph->rlock);
+  list_for_every(&eph->ready, node)
     {
-      /* Only check the notified fd */
+      nready++;
+    }
 
-      if (!epn->notified)
+  spin_unlock_irqrestore(&eph->rlock, flags);
+
+  while (nready-- > 0 && i < maxevents)
+    {
+      flags = spin_lock_irqsave(&eph->rlock);
+      epn = list_remove_head_type(&eph->ready, epoll_node_t, ready);
+      if (epn != NULL)
         {
-          continue;
+          revents      = epn->revents;
+          epn->revents = 0;
         }
 
-      /* Teradown all the notified fd */
+      spin_unlock_irqrestore(&eph->rlock, flags);
 
-      file_poll(epn->filep, &epn->pfd, false);
-      list_delete(&epn->node);
+      if (epn == NULL)
+        {
+          break;
+        }
+      else if (revents == 0)
+        {
+          continue;
+        }
 
-      if (epn->pfd.revents != 0 && i < maxevents)
+      evs[i].data     = epn->data;
+      evs[i++].events = revents;
+
+      if ((epn->pfd.events & EPOLLONESHOT) != 0)
         {
-          evs[i].data     = epn->data;
-          evs[i++].events = epn->pfd.revents;
-          if ((epn->pfd.events & EPOLLONESHOT) != 0)
-            {
-              list_add_tail(&eph->oneshot, &epn->node);
-            }
-          else
-            {
-              list_add_tail(&eph->teardown, &epn->node);
-            }
+          /* Disable the fd until it is rearmed by EPOLL_CTL_MOD */
+
+          epoll_disarm(eph, epn);
+          list_delete(&epn->node);
+          list_add_tail(&eph->oneshot, &epn->node);
         }
-      else
+      else if ((epn->pfd.events & EPOLLET) == 0)
         {
+          /* The level triggered fd is checked again by the next
+           * epoll_wait(), the edge triggered fd stays setup and is only
+           * reported again on the next notification.
+           */
+
+          list_delete(&epn->node);
           list_add_tail(&eph->teardown, &epn->node);
         }
     }
 
+  /* The nodes left on the ready list do not post again, so keep the
+   * semaphore posted for the next epoll_wait().
+   */
+
+  flags = spin_lock_irqsave(&eph->rlock);
+  pending = !list_is_empty(&eph->ready);
+  spin_unlock_irqrestore(&eph->rlock, flags);
+
+  if (pending)
+    {
+      nxsem_get_value(&eph->sem, &semcount);
+      if (semcount < 1)
+        {
+          nxsem_post(&eph->sem);
+        }
+    }
+
   nxmutex_unlock(&eph->lock);
   return i;
 }
@@ -389,7 +550,8 @@ static int epoll_teardown(FAR epoll_head_t *eph, FAR struct epoll_event *evs,
  *
  * Description:
  *   The default epoll callback function, this function do the final step of
- *   poll notification.
+ *   poll notification: collect the events and queue the node to the ready
+ *   list.
  *
  * Input Parameters:
  *   fds - The fds
@@ -402,15 +564,34 @@ static int epoll_teardown(FAR epoll_head_t *eph, FAR struct epoll_event *evs,
 static void epoll_default_cb(FAR struct pollfd *fds)
 {
   FAR epoll_node_t *epn = fds->arg;
+  FAR epoll_head_t *eph = epn->eph;
+  bool wakeup = false;
+  irqstate_t flags;
   int semcount = 0;
 
-  epn->notified = true;
-  if (fds->revents != 0)
+  flags = spin_lock_irqsave(&eph->rlock);
+
+  /* Move the events to the node, so that each notification is seen only
+   * once by an edge triggered fd.
+   */
+
+  epn->revents |= fds->revents;
+  fds->revents  = 0;
+
+  if (epn->revents != 0 && !list_in_list(&epn->ready))
+    {
+      list_add_tail(&eph->ready, &epn->ready);
+      wakeup = true;
+    }
+
+  spin_unlock_irqrestore(&eph->rlock, flags);
+
+  if (wakeup)
     {
-      nxsem_get_value(&epn->eph->sem, &semcount);
+      nxsem_get_value(&eph->sem, &semcount);
       if (semcount < 1)
         {
-          nxsem_post(&epn->eph->sem);
+          nxsem_post(&eph->sem);
         }
     }
 }
@@ -507,31 +688,10 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
 
         /* Check repetition */
 
-        list_for_every_entry(&eph->setup, epn, epoll_node_t, node)
+        if (epoll_find(eph, fd) != NULL)
           {
-            if (epn->pfd.fd == fd)
-              {
-                ret = -EEXIST;
-                goto err;
-              }
-          }
-
-        list_for_every_entry(&eph->teardown, epn, epoll_node_t, node)
-          {
-            if (epn->pfd.fd == fd)
-              {
-                ret = -EEXIST;
-                goto err;
-              }
-          }
-
-        list_for_every_entry(&eph->oneshot, epn, epoll_node_t, node)
-          {
-            if (epn->pfd.fd == fd)
-              {
-                ret = -EEXIST;
-                goto err;
-              }
+            ret = -EEXIST;
+            goto err;
           }
 
         if (list_is_empty(&eph->free))
@@ -561,8 +721,9 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
         epn = container_of(list_remove_head(&eph->free), epoll_node_t, node);
         epn->eph         = eph;
         epn->data        = ev->data;
-        epn->notified    = false;
-        epn->pfd.events  = ev->events | POLLALWAYS;
+        epn->armed       = false;
+        epn->revents     = 0;
+        epn->pfd.events  = ev->events;
         epn->pfd.fd      = fd;
         epn->pfd.arg     = epn;
         epn->pfd.cb      = epoll_default_cb;
@@ -575,9 +736,10 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
             goto err;
           }
 
-        ret = file_poll(epn->filep, &epn->pfd, true);
+        ret = epoll_arm(epn);
         if (ret < 0)
           {
+            epoll_unready(eph, epn);
             file_put(epn->filep);
             list_add_tail(&eph->free, &epn->node);
             goto err;
@@ -588,114 +750,46 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
 
       case EPOLL_CTL_DEL:
         finfo("%p CTL DEL: fd=%d\n", eph, fd);
-        list_for_every_entry(&eph->setup, epn, epoll_node_t, node)
+        epn = epoll_find(eph, fd);
+        if (epn != NULL)
           {
-            if (epn->pfd.fd == fd)
-              {
-                file_poll(epn->filep, &epn->pfd, false);
-                file_put(epn->filep);
-                list_delete(&epn->node);
-                list_add_tail(&eph->free, &epn->node);
-                goto out;
-              }
-          }
-
-        list_for_every_entry(&eph->teardown, epn, epoll_node_t, node)
-          {
-            if (epn->pfd.fd == fd)
-              {
-                file_put(epn->filep);
-                list_delete(&epn->node);
-                list_add_tail(&eph->free, &epn->node);
-                goto out;
-              }
-          }
-
-        list_for_every_entry(&eph->oneshot, epn, epoll_node_t, node)
-          {
-            if (epn->pfd.fd == fd)
-              {
-                file_put(epn->filep);
-                list_delete(&epn->node);
-                list_add_tail(&eph->free, &epn->node);
-                goto out;
-              }
+            epoll_disarm(eph, epn);
+            file_put(epn->filep);
+            list_delete(&epn->node);
+            list_add_tail(&eph->free, &epn->node);
           }
 
         break;
 
       case EPOLL_CTL_MOD:
         finfo("%p CTL MOD: fd=%d ev=%08" PRIx32 "\n", eph, fd, ev->events);
-        list_for_every_entry(&eph->setup, epn, epoll_node_t, node)
+        epn = epoll_find(eph, fd);
+        if (epn == NULL)
           {
-            if (epn->pfd.fd == fd)
-              {
-                if (epn->pfd.events != (ev->events | POLLALWAYS))
-                  {
-                    file_poll(epn->filep, &epn->pfd, false);
-
-                    epn->notified    = false;
-                    epn->data        = ev->data;
-                    epn->pfd.events  = ev->events | POLLALWAYS;
-                    epn->pfd.revents = 0;
-
-                    ret = file_poll(epn->filep, &epn->pfd, true);
-                    if (ret < 0)
-                      {
-                        goto err;
-                      }
-                  }
-
-                goto out;
-              }
+            break;
           }
 
-        list_for_every_entry(&eph->teardown, epn, epoll_node_t, node)
+        epn->data = ev->data;
+        if (epn->armed && epn->pfd.events == ev->events)
           {
-            if (epn->pfd.fd == fd)
-              {
-                if (epn->pfd.events != (ev->events | POLLALWAYS))
-                  {
-                    epn->notified    = false;
-                    epn->data        = ev->data;
-                    epn->pfd.events  = ev->events | POLLALWAYS;
-                    epn->pfd.revents = 0;
-
-                    ret = file_poll(epn->filep, &epn->pfd, true);
-                    if (ret < 0)
-                      {
-                        goto err;
-                      }
-
-                    list_delete(&epn->node);
-                    list_add_tail(&eph->setup, &epn->node);
-                  }
-
-                goto out;
-              }
+            break;
           }
 
-        list_for_every_entry(&eph->oneshot, epn, epoll_node_t, node)
+        /* Setup again with the new events, this also rearms a disabled
+         * EPOLLONESHOT fd.
+         */
+
+        epoll_disarm(eph, epn);
+        epn->pfd.events = ev->events;
+
+        ret = epoll_arm(epn);
+        if (ret < 0)
           {
-            if (epn->pfd.fd == fd)
-              {
-                epn->notified    = false;
-                epn->data        = ev->data;
-                epn->pfd.events  = ev->events | POLLALWAYS;
-                epn->pfd.revents = 0;
-
-                ret = file_poll(epn->filep, &epn->pfd, true);
-                if (ret < 0)
-                  {
-                    goto err;
-                  }
-
-                list_delete(&epn->node);
-                list_add_tail(&eph->setup, &epn->node);
-                break;
-              }
+            goto err;
           }
 
+        list_delete(&epn->node);
+        list_add_tail(&eph->setup, &epn->node);
         break;
 
       default:
@@ -703,7 +797,6 @@ int epoll_ctl(int epfd, int op, int fd, FAR struct epoll_event *ev)
         goto err;
     }
 
-out:
   nxmutex_unlock(&eph->lock);
   file_put(filep);
   return OK;
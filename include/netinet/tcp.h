@@ -57,5 +57,11 @@
 #define TCP_KEEPCNT   (__SO_PROTOCOL + 3) /* Number of keepalives before death
                                            * Argument: max retry count */
 #define TCP_MAXSEG    (__SO_PROTOCOL + 4) /* The maximum segment size */
+#define TCP_CONGESTION (__SO_PROTOCOL + 5) /* Congestion control algorithm
+                                            * Argument: name string */
+
+/* The maximum length of a congestion control algorithm name */
+
+#define TCP_CA_NAME_MAX 16
 
 #endif /* __INCLUDE_NETINET_TCP_H */
@@ -57,6 +57,12 @@
 #  define CONFIG_IOB_THROTTLE 0
 #endif
 
+/* The per-CPU I/O buffer caches are disabled by a size of zero */
+
+#if !defined(CONFIG_IOB_PERCPU_NBUFFERS)
+#  define CONFIG_IOB_PERCPU_NBUFFERS 0
+#endif
+
 /* Some I/O buffers should be allocated */
 
 #if !defined(CONFIG_IOB_NBUFFERS)
@@ -162,12 +168,26 @@ struct iob_queue_s
 };
 #endif /* CONFIG_IOB_NCHAINS > 0 */
 
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+struct iob_cpustats_s
+{
+  int ncached;
+  unsigned long nalloc;
+  unsigned long nfree;
+  unsigned long nrefill;
+  unsigned long nflush;
+};
+#endif
+
 struct iob_stats_s
 {
   int ntotal;
   int nfree;
   int nwait;
   int nthrottle;
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+  struct iob_cpustats_s cpu[CONFIG_SMP_NCPUS];
+#endif
 };
 
 /****************************************************************************
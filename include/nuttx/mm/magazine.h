@@ -0,0 +1,198 @@
+/****************************************************************************
+ * include/nuttx/mm/magazine.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_MM_MAGAZINE_H
+#define __INCLUDE_NUTTX_MM_MAGAZINE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdbool.h>
+
+#include <nuttx/spinlock.h>
+
+#ifdef CONFIG_MM_HEAP_MAGAZINE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The magazines are only usable where interrupts can be disabled, i.e. not
+ * from the user-space copy of the heap in the protected or kernel build.
+ * The heap layout does not depend on this, only the use of the magazines.
+ */
+
+#if defined(CONFIG_BUILD_FLAT) || defined(__KERNEL__)
+#  define MM_HAVE_MAGAZINE 1
+#endif
+
+/* Size class 'n' holds blocks with at least (n + 1) * STEP usable bytes */
+
+#define MM_MAGAZINE_STEP      CONFIG_MM_HEAP_MAGAZINE_STEP
+#define MM_MAGAZINE_NCLASSES  (CONFIG_MM_HEAP_MAGAZINE_THRESHOLD / \
+                               CONFIG_MM_HEAP_MAGAZINE_STEP)
+#define MM_MAGAZINE_MAXSIZE   (MM_MAGAZINE_NCLASSES * MM_MAGAZINE_STEP)
+
+/* A magazine holds up to ROUNDS blocks and is refilled from, or flushed
+ * to, the heap half a magazine at a time.
+ */
+
+#define MM_MAGAZINE_ROUNDS    CONFIG_MM_HEAP_MAGAZINE_ROUNDS
+#define MM_MAGAZINE_BATCH     ((MM_MAGAZINE_ROUNDS + 1) / 2)
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Take up to 'nblks' blocks of at least 'size' bytes from the heap, holding
+ * the heap lock only once.  Returns the number of blocks taken.
+ */
+
+typedef CODE size_t (*mm_magazine_alloc_t)(FAR void *arg, size_t size,
+                                           FAR void **blks, size_t nblks);
+
+/* Return 'nblks' blocks to the heap, holding the heap lock only once */
+
+typedef CODE void (*mm_magazine_free_t)(FAR void *arg, FAR void **blks,
+                                        size_t nblks);
+
+/* Return the usable size of a block allocated from the heap */
+
+typedef CODE size_t (*mm_magazine_size_t)(FAR void *arg, FAR void *blk);
+
+/* A cached block is linked through its first word */
+
+struct mm_magnode_s
+{
+  FAR struct mm_magnode_s *flink;
+};
+
+struct mm_magazine_s
+{
+  FAR struct mm_magnode_s *head;  /* The cached blocks of one size class */
+  size_t count;                   /* The number of cached blocks */
+};
+
+struct mm_magcpu_s
+{
+  /* Only the owning CPU takes this lock on the allocation paths, other CPUs
+   * only take it to drain the magazines.
+   */
+
+  spinlock_t lock;
+  struct mm_magazine_s mag[MM_MAGAZINE_NCLASSES];
+};
+
+struct mm_magcache_s
+{
+  mm_magazine_alloc_t alloc;
+  mm_magazine_free_t  free;
+  mm_magazine_size_t  size;
+  FAR void           *arg;
+  struct mm_magcpu_s  cpu[CONFIG_SMP_NCPUS];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#undef EXTERN
+#if defined(__cplusplus)
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: mm_magazine_initialize
+ *
+ * Description:
+ *   Initialize the per-CPU magazines of a heap.
+ *
+ * Input Parameters:
+ *   cache - The magazine set to initialize.
+ *   alloc - The batched allocation function of the heap.
+ *   size  - The usable size function of the heap.
+ *   free  - The batched free function of the heap.
+ *   arg   - The heap, passed to the functions above.
+ *
+ ****************************************************************************/
+
+void mm_magazine_initialize(FAR struct mm_magcache_s *cache,
+                            mm_magazine_alloc_t alloc,
+                            mm_magazine_size_t size,
+                            mm_magazine_free_t free, FAR void *arg);
+
+/****************************************************************************
+ * Name: mm_magazine_alloc
+ *
+ * Description:
+ *   Take a block of at least 'size' bytes from the magazine of this CPU,
+ *   refilling the magazine from the heap if it is empty.
+ *
+ * Returned Value:
+ *   The block, or NULL if 'size' is not cached or the heap is exhausted.
+ *
+ ****************************************************************************/
+
+FAR void *mm_magazine_alloc(FAR struct mm_magcache_s *cache, size_t size);
+
+/****************************************************************************
+ * Name: mm_magazine_free
+ *
+ * Description:
+ *   Put a block into the magazine of this CPU, flushing half of the
+ *   magazine back to the heap if it is full.
+ *
+ * Returned Value:
+ *   true if the block was taken, false if the caller has to free it.
+ *
+ ****************************************************************************/
+
+bool mm_magazine_free(FAR struct mm_magcache_s *cache, FAR void *mem);
+
+/****************************************************************************
+ * Name: mm_magazine_drain
+ *
+ * Description:
+ *   Return the blocks cached by all CPUs to the heap.
+ *
+ * Returned Value:
+ *   true if any block was returned.
+ *
+ ****************************************************************************/
+
+bool mm_magazine_drain(FAR struct mm_magcache_s *cache);
+
+#undef EXTERN
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CONFIG_MM_HEAP_MAGAZINE */
+#endif /* __INCLUDE_NUTTX_MM_MAGAZINE_H */
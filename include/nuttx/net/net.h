@@ -50,6 +50,10 @@
 
 #define SOCKCAP_NONBLOCKING (1 << 0)  /* Bit 0: Socket supports non-blocking
                                        *        operation. */
+#define SOCKCAP_ZEROCOPY    (1 << 1)  /* Bit 1: Socket supports MSG_ZEROCOPY
+                                       *        receive. */
+#define SOCKCAP_BATCHING    (1 << 2)  /* Bit 2: Socket may be batched under
+                                       *        the network lock. */
 
 /* Definitions of 8-bit socket flags */
 
@@ -928,6 +932,68 @@ ssize_t psock_sendmsg(FAR struct socket *psock, FAR struct msghdr *msg,
 ssize_t psock_recvmsg(FAR struct socket *psock, FAR struct msghdr *msg,
                       int flags);
 
+/****************************************************************************
+ * Name: psock_sendmmsg
+ *
+ * Description:
+ *   psock_sendmmsg() sends a vector of messages to a socket.  This is an
+ *   internal OS interface.  It is functionally equivalent to sendmmsg()
+ *   except that:
+ *
+ *   - It is not a cancellation point,
+ *   - It does not modify the errno variable, and
+ *   - It accepts the internal socket structure as an input rather than an
+ *     task-specific socket descriptor.
+ *
+ * Input Parameters:
+ *   psock   A pointer to a NuttX-specific, internal socket structure
+ *   msgvec  The vector of messages to send
+ *   vlen    The number of messages in the vector
+ *   flags   Send flags
+ *
+ * Returned Value:
+ *   On success, returns the number of messages sent, the number of bytes
+ *   sent of each message is returned in its msg_len.  If no message could
+ *   be sent, a negated errno value is returned (see comments with
+ *   sendmsg() for a list of appropriate errno values).
+ *
+ ****************************************************************************/
+
+int psock_sendmmsg(FAR struct socket *psock, FAR struct mmsghdr *msgvec,
+                   unsigned int vlen, int flags);
+
+/****************************************************************************
+ * Name: psock_recvmmsg
+ *
+ * Description:
+ *   psock_recvmmsg() receives a vector of messages from a socket.  This is
+ *   an internal OS interface.  It is functionally equivalent to recvmmsg()
+ *   except that:
+ *
+ *   - It is not a cancellation point,
+ *   - It does not modify the errno variable, and
+ *   - It accepts the internal socket structure as an input rather than an
+ *     task-specific socket descriptor.
+ *
+ * Input Parameters:
+ *   psock   A pointer to a NuttX-specific, internal socket structure
+ *   msgvec  The vector of messages to receive
+ *   vlen    The number of messages in the vector
+ *   flags   Receive flags
+ *   timeout Optional time after which no further message is received
+ *
+ * Returned Value:
+ *   On success, returns the number of messages received, the number of
+ *   bytes received of each message is returned in its msg_len.  If no
+ *   message was received, a negated errno value is returned (see comments
+ *   with recvmsg() for a list of appropriate errno values).
+ *
+ ****************************************************************************/
+
+int psock_recvmmsg(FAR struct socket *psock, FAR struct mmsghdr *msgvec,
+                   unsigned int vlen, int flags,
+                   FAR const struct timespec *timeout);
+
 /****************************************************************************
  * Name: psock_send
  *
@@ -474,6 +474,18 @@ struct net_driver_s
 
   uint16_t d_sndlen;
 
+#ifdef CONFIG_NETDEV_GSO
+  /* Generic segmentation offload.  While the driver polls for outgoing
+   * packets, d_gsomax is the largest TCP payload it accepts in a single
+   * packet, it is zero otherwise.  When TCP hands down a packet larger
+   * than the MTU, d_gsosize holds the payload size of the segments that
+   * the driver must split it into.  The driver clears it.
+   */
+
+  uint16_t d_gsomax;
+  uint16_t d_gsosize;
+#endif
+
   /* Multicast group support */
 
 #ifdef CONFIG_NET_IGMP
@@ -810,6 +822,29 @@ void netdev_carrier_off(FAR struct net_driver_s *dev);
 
 uint16_t chksum(uint16_t sum, FAR const uint8_t *data, uint16_t len);
 
+/****************************************************************************
+ * Name: chksum_copy
+ *
+ * Description:
+ *   Copy a memory region and calculate the raw change sum over it in the
+ *   same pass.
+ *
+ * Input Parameters:
+ *   sum  - Partial calculations carried over from a previous call to
+ *          chksum().  This should be zero on the first time that check
+ *          sum is called.
+ *   dest - Where to copy the data to.
+ *   src  - Beginning of the data to copy and include in the checksum.
+ *   len  - Length of the data.
+ *
+ * Returned Value:
+ *   The updated checksum value.
+ *
+ ****************************************************************************/
+
+uint16_t chksum_copy(uint16_t sum, FAR uint8_t *dest,
+                     FAR const uint8_t *src, uint16_t len);
+
 /****************************************************************************
  * Name: chksum_iob
  *
@@ -830,6 +865,32 @@ uint16_t chksum(uint16_t sum, FAR const uint8_t *data, uint16_t len);
 
 uint16_t chksum_iob(uint16_t sum, FAR struct iob_s *iob, uint16_t offset);
 
+/****************************************************************************
+ * Name: chksum_iob_copyin
+ *
+ * Description:
+ *   Copy a memory region into an iob chain buffer and calculate the raw
+ *   change sum over it in the same pass.  The chain must already be long
+ *   enough to hold the data.
+ *
+ * Input Parameters:
+ *   sum    - Partial calculations carried over from a previous call to
+ *            chksum().  This should be zero on the first time that check
+ *            sum is called.
+ *   iob    - The iob chain buffer to copy the data to.
+ *   offset - Specifies the byte offset in the chain to copy the data to.
+ *   src    - Beginning of the data to copy and include in the checksum.
+ *   len    - Length of the data.
+ *
+ * Returned Value:
+ *   The updated checksum value.
+ *
+ ****************************************************************************/
+
+uint16_t chksum_iob_copyin(uint16_t sum, FAR struct iob_s *iob,
+                           uint16_t offset, FAR const uint8_t *src,
+                           uint16_t len);
+
 /****************************************************************************
  * Name: net_chksum
  *
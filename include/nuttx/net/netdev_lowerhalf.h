@@ -119,6 +119,14 @@ struct netdev_lowerhalf_s
 
   atomic_t quota[NETPKT_TYPENUM];
 
+  /* Number of RX/TX queue pairs of a multi-queue driver, zero or one for a
+   * driver with a single queue.  Set before the driver is registered.
+   */
+
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  uint8_t nqueues;
+#endif
+
   /* The structure used by net stack.
    * Note: Do not change its fields unless you know what you are doing.
    *
@@ -132,6 +140,14 @@ struct netdev_lowerhalf_s
 /* This structure is a set a callback functions used to call from the upper-
  * half, generic netdev driver into lower-half, platform-specific logic that
  * supports the low-level functionality.
+ *
+ * ifup, ifdown, transmit, receive, reclaim, addmac, rmmac and ioctl are
+ * serialized by the upper half.  With CONFIG_NETDEV_SPLIT_LOCK they are
+ * called with a lock of the device instead of the network lock held.
+ *
+ * Segmentation and receive offload (CONFIG_NETDEV_GSO / CONFIG_NETDEV_GRO)
+ * are done in software by the upper half: transmit never sees a packet
+ * larger than the MTU, and receive returns packets as they are on the wire.
  */
 
 struct netdev_ops_s
@@ -172,6 +188,22 @@ struct netdev_ops_s
   /* reclaim - try to reclaim packets sent by netdev. */
 
   CODE void (*reclaim)(FAR struct netdev_lowerhalf_s *dev);
+
+  /* transmitq, receiveq, reclaimq - The same as transmit, receive and
+   * reclaim, on the RX/TX queue pair 'queue' of a driver with nqueues > 1,
+   * which does not need to provide the single queue operations.  The calls
+   * on one queue are serialized, the calls on different queues may run in
+   * parallel on different CPUs.  ifup, ifdown, addmac, rmmac and ioctl are
+   * called with all of the queues locked.
+   */
+
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+  CODE int (*transmitq)(FAR struct netdev_lowerhalf_s *dev,
+                        FAR netpkt_t *pkt, int queue);
+  CODE FAR netpkt_t *(*receiveq)(FAR struct netdev_lowerhalf_s *dev,
+                                 int queue);
+  CODE void (*reclaimq)(FAR struct netdev_lowerhalf_s *dev, int queue);
+#endif
 };
 
 /* This structure is a set of wireless handlers, leave unsupported operations
@@ -308,6 +340,45 @@ void netdev_lower_rxready(FAR struct netdev_lowerhalf_s *dev);
 
 void netdev_lower_txdone(FAR struct netdev_lowerhalf_s *dev);
 
+/****************************************************************************
+ * Name: netdev_lower_rxready_queue/txdone_queue
+ *
+ * Description:
+ *   The same as netdev_lower_rxready() and netdev_lower_txdone(), for the
+ *   queue 'queue' of a multi-queue driver.  Only the work thread of that
+ *   queue is woken up.
+ *
+ * Input Parameters:
+ *   dev   - The lower half device driver structure
+ *   queue - The queue index
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETDEV_MULTIQUEUE
+void netdev_lower_rxready_queue(FAR struct netdev_lowerhalf_s *dev,
+                                int queue);
+void netdev_lower_txdone_queue(FAR struct netdev_lowerhalf_s *dev,
+                               int queue);
+
+/****************************************************************************
+ * Name: netdev_lower_flowqueue
+ *
+ * Description:
+ *   Return the queue of the flow a packet belongs to, which is the queue the
+ *   upper half sends the packets of the flow on.  The hash of the addresses
+ *   and ports is symmetric, so a driver without hardware RSS may use this to
+ *   steer received packets to the queue of the replies.
+ *
+ * Input Parameters:
+ *   dev - The lower half device driver structure
+ *   pkt - The packet to steer
+ *
+ ****************************************************************************/
+
+int netdev_lower_flowqueue(FAR struct netdev_lowerhalf_s *dev,
+                           FAR netpkt_t *pkt);
+#endif
+
 /****************************************************************************
  * Name: netdev_lower_quota_load
  *
@@ -376,9 +376,11 @@ SYSCALL_LOOKUP(munmap,                     2)
   SYSCALL_LOOKUP(recv,                     4)
   SYSCALL_LOOKUP(recvfrom,                 6)
   SYSCALL_LOOKUP(recvmsg,                  3)
+  SYSCALL_LOOKUP(recvmmsg,                 5)
   SYSCALL_LOOKUP(send,                     4)
   SYSCALL_LOOKUP(sendto,                   6)
   SYSCALL_LOOKUP(sendmsg,                  3)
+  SYSCALL_LOOKUP(sendmmsg,                 4)
   SYSCALL_LOOKUP(setsockopt,               5)
   SYSCALL_LOOKUP(shutdown,                 2)
   SYSCALL_LOOKUP(socket,                   3)
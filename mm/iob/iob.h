@@ -98,6 +98,26 @@ extern int16_t g_qentry_wait;
 
 extern volatile spinlock_t g_iob_lock;
 
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+/* The free I/O buffers cached by each CPU.  The owning CPU accesses its
+ * cache with local interrupts disabled, the lock is only contended while
+ * another CPU drains the cache.
+ */
+
+struct iob_pcpu_s
+{
+  spinlock_t lock;
+  FAR struct iob_s *freelist;  /* Cached free I/O buffers */
+  int16_t count;               /* Number of cached I/O buffers */
+  unsigned long nalloc;        /* Allocations served by the cache */
+  unsigned long nfree;         /* Frees absorbed by the cache */
+  unsigned long nrefill;       /* Batches taken from the global list */
+  unsigned long nflush;        /* Batches returned to the global list */
+};
+
+extern struct iob_pcpu_s g_iob_pcpu[CONFIG_SMP_NCPUS];
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -137,6 +157,65 @@ FAR struct iob_qentry_s *iob_tryalloc_qentry(void);
 
 FAR struct iob_qentry_s *iob_free_qentry(FAR struct iob_qentry_s *iobq);
 
+/****************************************************************************
+ * Name: iob_free_list
+ *
+ * Description:
+ *   Return a list of I/O buffers, linked through io_flink, to the free list
+ *   or hand them to waiting allocations.  The global IOB spinlock is taken
+ *   only once.
+ *
+ ****************************************************************************/
+
+void iob_free_list(FAR struct iob_s *iob);
+
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+/****************************************************************************
+ * Name: iob_pcpu_alloc
+ *
+ * Description:
+ *   Take an I/O buffer from the cache of this CPU, refilling the cache from
+ *   the global free list if it is empty.  Returns NULL if no I/O buffer can
+ *   be taken without touching the throttle reserve.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_pcpu_alloc(bool throttled);
+
+/****************************************************************************
+ * Name: iob_pcpu_free
+ *
+ * Description:
+ *   Put an I/O buffer into the cache of this CPU.  Returns false if the
+ *   buffer must go to the global free list because an allocation is
+ *   waiting or the throttle reserve is not full.
+ *
+ ****************************************************************************/
+
+bool iob_pcpu_free(FAR struct iob_s *iob);
+
+/****************************************************************************
+ * Name: iob_pcpu_drain
+ *
+ * Description:
+ *   Return the I/O buffers cached by all CPUs to the global free list.
+ *   Returns true if any buffer was returned.
+ *
+ ****************************************************************************/
+
+bool iob_pcpu_drain(void);
+
+/****************************************************************************
+ * Name: iob_pcpu_navail
+ *
+ * Description:
+ *   Return the number of I/O buffers cached by all CPUs.
+ *
+ ****************************************************************************/
+
+int iob_pcpu_navail(void);
+#endif
+
 /****************************************************************************
  * Name: iob_notifier_signal
  *
@@ -173,6 +173,14 @@ static FAR struct iob_s *iob_allocwait(bool throttled, unsigned int timeout)
    * we are waiting for I/O buffers to become free.
    */
 
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+  iob = iob_pcpu_alloc(throttled);
+  if (iob != NULL)
+    {
+      return iob;
+    }
+#endif
+
   flags = spin_lock_irqsave(&g_iob_lock);
 
   /* Try to get an I/O buffer */
@@ -193,6 +201,15 @@ static FAR struct iob_s *iob_allocwait(bool throttled, unsigned int timeout)
 
       spin_unlock_irqrestore(&g_iob_lock, flags);
 
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+      /* Now that we are registered as a waiter, no CPU caches freed I/O
+       * buffers any more.  Return the cached ones, they are committed to
+       * the waiters.
+       */
+
+      iob_pcpu_drain();
+#endif
+
       if (timeout == UINT_MAX)
         {
           ret = nxsem_wait_uninterruptible(sem);
@@ -304,9 +321,29 @@ FAR struct iob_s *iob_tryalloc(bool throttled)
    * to protect the free list:  We disable interrupts very briefly.
    */
 
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+  iob = iob_pcpu_alloc(throttled);
+  if (iob != NULL)
+    {
+      return iob;
+    }
+#endif
+
   flags = spin_lock_irqsave(&g_iob_lock);
   iob = iob_tryalloc_internal(throttled);
   spin_unlock_irqrestore(&g_iob_lock, flags);
+
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+  /* The free I/O buffers may be cached by other CPUs */
+
+  if (iob == NULL && iob_pcpu_drain())
+    {
+      flags = spin_lock_irqsave(&g_iob_lock);
+      iob = iob_tryalloc_internal(throttled);
+      spin_unlock_irqrestore(&g_iob_lock, flags);
+    }
+#endif
+
   return iob;
 }
 
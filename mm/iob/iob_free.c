@@ -63,6 +63,80 @@
 
 #define IOB_MASK      (IOB_DIVIDER - 1)
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_free_locked
+ *
+ * Description:
+ *   Add the I/O buffer to the head of the free or the committed list.  The
+ *   caller must hold g_iob_lock and post the returned semaphore, if any,
+ *   after releasing it.
+ *
+ ****************************************************************************/
+
+static FAR sem_t *iob_free_locked(FAR struct iob_s *iob)
+{
+  /* Which list?  If there is a task waiting for an IOB, then put
+   * the IOB on either the free list or on the committed list where
+   * it is reserved for that allocation (and not available to
+   * iob_tryalloc()). This is true for both throttled and non-throttled
+   * cases.
+   */
+
+  if (g_iob_count < 0)
+    {
+      g_iob_count++;
+      iob->io_flink   = g_iob_committed;
+      g_iob_committed = iob;
+      return &g_iob_sem;
+    }
+#if CONFIG_IOB_THROTTLE > 0
+  else if (g_throttle_wait > 0 && g_iob_count >= CONFIG_IOB_THROTTLE)
+    {
+      iob->io_flink   = g_iob_committed;
+      g_iob_committed = iob;
+      g_throttle_wait--;
+      return &g_throttle_sem;
+    }
+#endif
+  else
+    {
+      g_iob_count++;
+      iob->io_flink   = g_iob_freelist;
+      g_iob_freelist  = iob;
+      return NULL;
+    }
+}
+
+#ifdef CONFIG_IOB_NOTIFIER
+/****************************************************************************
+ * Name: iob_free_notify
+ *
+ * Description:
+ *   Signal any threads that have requested a signal notification when an
+ *   IOB becomes available.
+ *
+ ****************************************************************************/
+
+static void iob_free_notify(void)
+{
+  int16_t navail;
+
+  /* Check if the IOB was claimed by a thread that is blocked waiting
+   * for an IOB.
+   */
+
+  navail = iob_navail(false);
+  if (navail > 0 && (navail & IOB_MASK) == 0)
+    {
+      iob_notifier_signal();
+    }
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -79,10 +153,8 @@
 FAR struct iob_s *iob_free(FAR struct iob_s *iob)
 {
   FAR struct iob_s *next = iob->io_flink;
+  FAR sem_t *sem;
   irqstate_t flags;
-#ifdef CONFIG_IOB_NOTIFIER
-  int16_t navail;
-#endif
 
   iobinfo("iob=%p io_pktlen=%u io_len=%u next=%p\n",
           iob, iob->io_pktlen, iob->io_len, next);
@@ -126,66 +198,92 @@ FAR struct iob_s *iob_free(FAR struct iob_s *iob)
     }
 #endif
 
-  /* Free the I/O buffer by adding it to the head of the free or the
-   * committed list. We don't know what context we are called from so
-   * we use extreme measures to protect the free list:  We disable
-   * interrupts very briefly.
+  /* Free the I/O buffer into the cache of this CPU if possible, otherwise
+   * add it to the head of the free or the committed list.  We don't know
+   * what context we are called from so we use extreme measures to protect
+   * the free list:  We disable interrupts very briefly.
    */
 
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+  if (!iob_pcpu_free(iob))
+#endif
+    {
+      flags = spin_lock_irqsave(&g_iob_lock);
+      sem = iob_free_locked(iob);
+      spin_unlock_irqrestore(&g_iob_lock, flags);
+
+      if (sem != NULL)
+        {
+          nxsem_post(sem);
+        }
+    }
+
+  DEBUGASSERT(g_iob_count <= CONFIG_IOB_NBUFFERS);
+
+#ifdef CONFIG_IOB_NOTIFIER
+  iob_free_notify();
+#endif
+
+  /* And return the I/O buffer after the one that was freed */
+
+  return next;
+}
+
+/****************************************************************************
+ * Name: iob_free_list
+ *
+ * Description:
+ *   Return a list of I/O buffers, linked through io_flink, to the free list
+ *   or hand them to waiting allocations.  The global IOB spinlock is taken
+ *   only once.
+ *
+ ****************************************************************************/
+
+void iob_free_list(FAR struct iob_s *iob)
+{
+  FAR struct iob_s *next;
+  FAR sem_t *sem;
+  irqstate_t flags;
+  int npost = 0;
+#if CONFIG_IOB_THROTTLE > 0
+  int nthrottle = 0;
+#endif
+
   flags = spin_lock_irqsave(&g_iob_lock);
 
-  /* Which list?  If there is a task waiting for an IOB, then put
-   * the IOB on either the free list or on the committed list where
-   * it is reserved for that allocation (and not available to
-   * iob_tryalloc()). This is true for both throttled and non-throttled
-   * cases.
-   */
+  for (; iob != NULL; iob = next)
+    {
+      next = iob->io_flink;
+      sem  = iob_free_locked(iob);
+      if (sem == &g_iob_sem)
+        {
+          npost++;
+        }
+#if CONFIG_IOB_THROTTLE > 0
+      else if (sem == &g_throttle_sem)
+        {
+          nthrottle++;
+        }
+#endif
+    }
 
-  if (g_iob_count < 0)
+  spin_unlock_irqrestore(&g_iob_lock, flags);
+
+  while (npost-- > 0)
     {
-      g_iob_count++;
-      iob->io_flink   = g_iob_committed;
-      g_iob_committed = iob;
-      spin_unlock_irqrestore(&g_iob_lock, flags);
       nxsem_post(&g_iob_sem);
     }
+
 #if CONFIG_IOB_THROTTLE > 0
-  else if (g_throttle_wait > 0 && g_iob_count >= CONFIG_IOB_THROTTLE)
+  while (nthrottle-- > 0)
     {
-      iob->io_flink   = g_iob_committed;
-      g_iob_committed = iob;
-      g_throttle_wait--;
-      spin_unlock_irqrestore(&g_iob_lock, flags);
       nxsem_post(&g_throttle_sem);
     }
 #endif
-  else
-    {
-      g_iob_count++;
-      iob->io_flink   = g_iob_freelist;
-      g_iob_freelist  = iob;
-      spin_unlock_irqrestore(&g_iob_lock, flags);
-    }
 
   DEBUGASSERT(g_iob_count <= CONFIG_IOB_NBUFFERS);
 
 #ifdef CONFIG_IOB_NOTIFIER
-  /* Check if the IOB was claimed by a thread that is blocked waiting
-   * for an IOB.
-   */
-
-  navail = iob_navail(false);
-  if (navail > 0 && (navail & IOB_MASK) == 0)
-    {
-      /* Signal any threads that have requested a signal notification
-       * when an IOB becomes available.
-       */
-
-      iob_notifier_signal();
-    }
+  iob_free_notify();
 #endif
-
-  /* And return the I/O buffer after the one that was freed */
-
-  return next;
 }
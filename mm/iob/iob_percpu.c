@@ -0,0 +1,321 @@
+/****************************************************************************
+ * mm/iob/iob_percpu.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <assert.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/arch.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/mm/iob.h>
+
+#include "iob.h"
+
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The number of I/O buffers moved between a cache and the global free list
+ * at once.
+ */
+
+#define IOB_PCPU_BATCH ((CONFIG_IOB_PERCPU_NBUFFERS + 1) / 2)
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+struct iob_pcpu_s g_iob_pcpu[CONFIG_SMP_NCPUS];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_pcpu_lock
+ *
+ * Description:
+ *   Disable local interrupts, so that the caller can not migrate, and lock
+ *   the cache of the current CPU.
+ *
+ ****************************************************************************/
+
+static inline_function FAR struct iob_pcpu_s *
+iob_pcpu_lock(FAR irqstate_t *flags)
+{
+  FAR struct iob_pcpu_s *pcpu;
+
+  *flags = up_irq_save();
+  pcpu = &g_iob_pcpu[this_cpu()];
+  spin_lock(&pcpu->lock);
+
+  return pcpu;
+}
+
+static inline_function void iob_pcpu_unlock(FAR struct iob_pcpu_s *pcpu,
+                                            irqstate_t flags)
+{
+  spin_unlock(&pcpu->lock);
+  up_irq_restore(flags);
+}
+
+/****************************************************************************
+ * Name: iob_pcpu_refill
+ *
+ * Description:
+ *   Move up to a batch of I/O buffers from the global free list to the
+ *   cache.  The throttle reserve always stays in the global free list.
+ *
+ ****************************************************************************/
+
+static void iob_pcpu_refill(FAR struct iob_pcpu_s *pcpu)
+{
+  FAR struct iob_s *iob;
+  int16_t navail;
+
+  spin_lock(&g_iob_lock);
+
+  navail = g_iob_count - CONFIG_IOB_THROTTLE;
+  if (navail > IOB_PCPU_BATCH)
+    {
+      navail = IOB_PCPU_BATCH;
+    }
+
+  if (navail > 0)
+    {
+      pcpu->nrefill++;
+    }
+
+  while (navail-- > 0 && (iob = g_iob_freelist) != NULL)
+    {
+      g_iob_freelist = iob->io_flink;
+      g_iob_count--;
+
+      iob->io_flink  = pcpu->freelist;
+      pcpu->freelist = iob;
+      pcpu->count++;
+    }
+
+  spin_unlock(&g_iob_lock);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iob_pcpu_alloc
+ *
+ * Description:
+ *   Take an I/O buffer from the cache of this CPU, refilling the cache from
+ *   the global free list if it is empty.  Returns NULL if no I/O buffer can
+ *   be taken without touching the throttle reserve.
+ *
+ ****************************************************************************/
+
+FAR struct iob_s *iob_pcpu_alloc(bool throttled)
+{
+  FAR struct iob_pcpu_s *pcpu;
+  FAR struct iob_s *iob;
+  irqstate_t flags;
+
+#if CONFIG_IOB_THROTTLE > 0
+  /* The cached I/O buffers are counted on top of the global free list, so
+   * a throttled allocation may use them as long as the throttle reserve in
+   * the global free list is complete.
+   */
+
+  if (throttled && g_iob_count < CONFIG_IOB_THROTTLE)
+    {
+      return NULL;
+    }
+#endif
+
+  pcpu = iob_pcpu_lock(&flags);
+
+  if (pcpu->freelist == NULL)
+    {
+      iob_pcpu_refill(pcpu);
+    }
+
+  iob = pcpu->freelist;
+  if (iob != NULL)
+    {
+      pcpu->freelist = iob->io_flink;
+      pcpu->count--;
+      pcpu->nalloc++;
+    }
+
+  iob_pcpu_unlock(pcpu, flags);
+
+  if (iob != NULL)
+    {
+      /* Put the I/O buffer in a known state */
+
+      iob->io_flink  = NULL; /* Not in a chain */
+      iob->io_len    = 0;    /* Length of the data in the entry */
+      iob->io_offset = 0;    /* Offset to the beginning of data */
+      iob->io_pktlen = 0;    /* Total length of the packet */
+    }
+
+  return iob;
+}
+
+/****************************************************************************
+ * Name: iob_pcpu_free
+ *
+ * Description:
+ *   Put an I/O buffer into the cache of this CPU.  Returns false if the
+ *   buffer must go to the global free list because an allocation is
+ *   waiting or the throttle reserve is not full.
+ *
+ ****************************************************************************/
+
+bool iob_pcpu_free(FAR struct iob_s *iob)
+{
+  FAR struct iob_pcpu_s *pcpu;
+  FAR struct iob_s *flush = NULL;
+  irqstate_t flags;
+  int i;
+
+  pcpu = iob_pcpu_lock(&flags);
+
+  /* A waiter registers itself under g_iob_lock and then drains all caches,
+   * which takes this lock.  So either the waiter is seen here or the IOB
+   * is cached before the drain.
+   */
+
+  if (g_iob_count < CONFIG_IOB_THROTTLE
+#if CONFIG_IOB_THROTTLE > 0
+      || g_throttle_wait > 0
+#endif
+     )
+    {
+      iob_pcpu_unlock(pcpu, flags);
+      return false;
+    }
+
+  /* If the cache is full, detach a batch to return to the global list */
+
+  if (pcpu->count >= CONFIG_IOB_PERCPU_NBUFFERS)
+    {
+      FAR struct iob_s *tail = pcpu->freelist;
+
+      for (i = 1; i < IOB_PCPU_BATCH; i++)
+        {
+          tail = tail->io_flink;
+        }
+
+      flush          = pcpu->freelist;
+      pcpu->freelist = tail->io_flink;
+      pcpu->count   -= IOB_PCPU_BATCH;
+      tail->io_flink = NULL;
+      pcpu->nflush++;
+    }
+
+  iob->io_flink  = pcpu->freelist;
+  pcpu->freelist = iob;
+  pcpu->count++;
+  pcpu->nfree++;
+
+  iob_pcpu_unlock(pcpu, flags);
+
+  if (flush != NULL)
+    {
+      iob_free_list(flush);
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: iob_pcpu_drain
+ *
+ * Description:
+ *   Return the I/O buffers cached by all CPUs to the global free list.
+ *   Returns true if any buffer was returned.
+ *
+ ****************************************************************************/
+
+bool iob_pcpu_drain(void)
+{
+  FAR struct iob_pcpu_s *pcpu;
+  FAR struct iob_s *iob;
+  irqstate_t flags;
+  bool ret = false;
+  int i;
+
+  for (i = 0; i < CONFIG_SMP_NCPUS; i++)
+    {
+      pcpu = &g_iob_pcpu[i];
+
+      flags = spin_lock_irqsave(&pcpu->lock);
+      iob = pcpu->freelist;
+      if (iob != NULL)
+        {
+          pcpu->freelist = NULL;
+          pcpu->count    = 0;
+          pcpu->nflush++;
+        }
+
+      spin_unlock_irqrestore(&pcpu->lock, flags);
+
+      if (iob != NULL)
+        {
+          iob_free_list(iob);
+          ret = true;
+        }
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: iob_pcpu_navail
+ *
+ * Description:
+ *   Return the number of I/O buffers cached by all CPUs.
+ *
+ ****************************************************************************/
+
+int iob_pcpu_navail(void)
+{
+  int navail = 0;
+  int i;
+
+  for (i = 0; i < CONFIG_SMP_NCPUS; i++)
+    {
+      navail += g_iob_pcpu[i].count;
+    }
+
+  return navail;
+}
+
+#endif /* CONFIG_IOB_PERCPU_NBUFFERS > 0 */
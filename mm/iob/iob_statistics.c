@@ -54,8 +54,31 @@
 
 void iob_getstats(FAR struct iob_stats_s *stats)
 {
+  int ncached = 0;
+#if CONFIG_IOB_PERCPU_NBUFFERS > 0
+  FAR struct iob_pcpu_s *pcpu;
+  int i;
+
+  for (i = 0; i < CONFIG_SMP_NCPUS; i++)
+    {
+      pcpu = &g_iob_pcpu[i];
+
+      stats->cpu[i].ncached = pcpu->count;
+      stats->cpu[i].nalloc  = pcpu->nalloc;
+      stats->cpu[i].nfree   = pcpu->nfree;
+      stats->cpu[i].nrefill = pcpu->nrefill;
+      stats->cpu[i].nflush  = pcpu->nflush;
+
+      ncached += pcpu->count;
+    }
+#endif
+
   stats->ntotal = CONFIG_IOB_NBUFFERS;
 
+  /* The I/O buffers cached by the CPUs are free, but are only cached
+   * while nobody waits and the throttle reserve is complete.
+   */
+
   stats->nfree = g_iob_count;
   if (stats->nfree < 0)
     {
@@ -64,11 +87,12 @@ void iob_getstats(FAR struct iob_stats_s *stats)
     }
   else
     {
-      stats->nwait = 0;
+      stats->nfree += ncached;
+      stats->nwait  = 0;
     }
 
 #if CONFIG_IOB_THROTTLE > 0
-  stats->nthrottle = (g_iob_count - CONFIG_IOB_THROTTLE);
+  stats->nthrottle = (g_iob_count + ncached - CONFIG_IOB_THROTTLE);
   if (stats->nthrottle < 0)
 #endif
     {
@@ -0,0 +1,324 @@
+/****************************************************************************
+ * mm/magazine/mm_magazine.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/irq.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/mm/magazine.h>
+
+#ifdef MM_HAVE_MAGAZINE
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_magazine_lock
+ *
+ * Description:
+ *   Disable local interrupts, so that the caller can not migrate, and lock
+ *   the magazines of the current CPU.
+ *
+ ****************************************************************************/
+
+static inline_function FAR struct mm_magcpu_s *
+mm_magazine_lock(FAR struct mm_magcache_s *cache, FAR irqstate_t *flags)
+{
+  FAR struct mm_magcpu_s *cpu;
+
+  *flags = up_irq_save();
+  cpu = &cache->cpu[this_cpu()];
+  spin_lock(&cpu->lock);
+
+  return cpu;
+}
+
+static inline_function void mm_magazine_unlock(FAR struct mm_magcpu_s *cpu,
+                                               irqstate_t flags)
+{
+  spin_unlock(&cpu->lock);
+  up_irq_restore(flags);
+}
+
+/****************************************************************************
+ * Name: mm_magazine_pop
+ *
+ * Description:
+ *   Move up to 'nblks' blocks from a magazine to the array 'blks'.
+ *
+ ****************************************************************************/
+
+static size_t mm_magazine_pop(FAR struct mm_magazine_s *mag,
+                              FAR void **blks, size_t nblks)
+{
+  FAR struct mm_magnode_s *node;
+  size_t i;
+
+  for (i = 0; i < nblks && (node = mag->head) != NULL; i++)
+    {
+      mag->head = node->flink;
+      mag->count--;
+      blks[i] = node;
+    }
+
+  return i;
+}
+
+/****************************************************************************
+ * Name: mm_magazine_push
+ *
+ * Description:
+ *   Move blocks from the array 'blks' to a magazine until it is full.
+ *   Returns the number of blocks that were moved.
+ *
+ ****************************************************************************/
+
+static size_t mm_magazine_push(FAR struct mm_magazine_s *mag,
+                               FAR void **blks, size_t nblks)
+{
+  FAR struct mm_magnode_s *node;
+  size_t i;
+
+  for (i = 0; i < nblks && mag->count < MM_MAGAZINE_ROUNDS; i++)
+    {
+      node        = blks[i];
+      node->flink = mag->head;
+      mag->head   = node;
+      mag->count++;
+    }
+
+  return i;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_magazine_initialize
+ *
+ * Description:
+ *   Initialize the per-CPU magazines of a heap.
+ *
+ * Input Parameters:
+ *   cache - The magazine set to initialize.
+ *   alloc - The batched allocation function of the heap.
+ *   size  - The usable size function of the heap.
+ *   free  - The batched free function of the heap.
+ *   arg   - The heap, passed to the functions above.
+ *
+ ****************************************************************************/
+
+void mm_magazine_initialize(FAR struct mm_magcache_s *cache,
+                            mm_magazine_alloc_t alloc,
+                            mm_magazine_size_t size,
+                            mm_magazine_free_t free, FAR void *arg)
+{
+  int i;
+
+  DEBUGASSERT(alloc != NULL && size != NULL && free != NULL);
+
+  memset(cache, 0, sizeof(*cache));
+
+  cache->alloc = alloc;
+  cache->size  = size;
+  cache->free  = free;
+  cache->arg   = arg;
+
+  for (i = 0; i < CONFIG_SMP_NCPUS; i++)
+    {
+      spin_lock_init(&cache->cpu[i].lock);
+    }
+}
+
+/****************************************************************************
+ * Name: mm_magazine_alloc
+ *
+ * Description:
+ *   Take a block of at least 'size' bytes from the magazine of this CPU,
+ *   refilling the magazine from the heap if it is empty.
+ *
+ * Returned Value:
+ *   The block, or NULL if 'size' is not cached or the heap is exhausted.
+ *
+ ****************************************************************************/
+
+FAR void *mm_magazine_alloc(FAR struct mm_magcache_s *cache, size_t size)
+{
+  FAR void *blks[MM_MAGAZINE_BATCH];
+  FAR struct mm_magcpu_s *cpu;
+  irqstate_t flags;
+  size_t nblks;
+  size_t npush;
+  int ndx;
+
+  if (size > MM_MAGAZINE_MAXSIZE)
+    {
+      return NULL;
+    }
+
+  ndx = size > 0 ? (size - 1) / MM_MAGAZINE_STEP : 0;
+
+  cpu = mm_magazine_lock(cache, &flags);
+  nblks = mm_magazine_pop(&cpu->mag[ndx], blks, 1);
+  mm_magazine_unlock(cpu, flags);
+
+  if (nblks > 0)
+    {
+      return blks[0];
+    }
+
+  /* The magazine is empty, refill it with a batch from the heap.  The heap
+   * lock can not be taken with the magazine locked.
+   */
+
+  nblks = cache->alloc(cache->arg, (ndx + 1) * MM_MAGAZINE_STEP,
+                       blks, MM_MAGAZINE_BATCH);
+  if (nblks == 0)
+    {
+      return NULL;
+    }
+
+  /* Keep the first block for the caller.  We may be on another CPU by now,
+   * the rest goes to whichever magazine is local.
+   */
+
+  cpu = mm_magazine_lock(cache, &flags);
+  npush = mm_magazine_push(&cpu->mag[ndx], &blks[1], nblks - 1);
+  mm_magazine_unlock(cpu, flags);
+
+  if (npush < nblks - 1)
+    {
+      cache->free(cache->arg, &blks[1 + npush], nblks - 1 - npush);
+    }
+
+  return blks[0];
+}
+
+/****************************************************************************
+ * Name: mm_magazine_free
+ *
+ * Description:
+ *   Put a block into the magazine of this CPU, flushing half of the
+ *   magazine back to the heap if it is full.
+ *
+ * Returned Value:
+ *   true if the block was taken, false if the caller has to free it.
+ *
+ ****************************************************************************/
+
+bool mm_magazine_free(FAR struct mm_magcache_s *cache, FAR void *mem)
+{
+  FAR void *blks[MM_MAGAZINE_BATCH];
+  FAR struct mm_magcpu_s *cpu;
+  FAR struct mm_magazine_s *mag;
+  irqstate_t flags;
+  size_t nblks = 0;
+  size_t size;
+
+  /* File the block by its usable size.  A block may serve any request of
+   * its class, so it goes to the largest class it fully covers.
+   */
+
+  size = cache->size(cache->arg, mem);
+  if (size < MM_MAGAZINE_STEP || size >= MM_MAGAZINE_MAXSIZE +
+                                         MM_MAGAZINE_STEP)
+    {
+      return false;
+    }
+
+  cpu = mm_magazine_lock(cache, &flags);
+  mag = &cpu->mag[size / MM_MAGAZINE_STEP - 1];
+
+  if (mag->count >= MM_MAGAZINE_ROUNDS)
+    {
+      nblks = mm_magazine_pop(mag, blks, MM_MAGAZINE_BATCH);
+    }
+
+  mm_magazine_push(mag, &mem, 1);
+  mm_magazine_unlock(cpu, flags);
+
+  if (nblks > 0)
+    {
+      cache->free(cache->arg, blks, nblks);
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: mm_magazine_drain
+ *
+ * Description:
+ *   Return the blocks cached by all CPUs to the heap.
+ *
+ * Returned Value:
+ *   true if any block was returned.
+ *
+ ****************************************************************************/
+
+bool mm_magazine_drain(FAR struct mm_magcache_s *cache)
+{
+  FAR void *blks[MM_MAGAZINE_BATCH];
+  FAR struct mm_magcpu_s *cpu;
+  irqstate_t flags;
+  bool ret = false;
+  size_t nblks;
+  int i;
+  int j;
+
+  for (i = 0; i < CONFIG_SMP_NCPUS; i++)
+    {
+      cpu = &cache->cpu[i];
+
+      for (j = 0; j < MM_MAGAZINE_NCLASSES; j++)
+        {
+          do
+            {
+              flags = spin_lock_irqsave(&cpu->lock);
+              nblks = mm_magazine_pop(&cpu->mag[j], blks,
+                                      MM_MAGAZINE_BATCH);
+              spin_unlock_irqrestore(&cpu->lock, flags);
+
+              if (nblks > 0)
+                {
+                  cache->free(cache->arg, blks, nblks);
+                  ret = true;
+                }
+            }
+          while (nblks == MM_MAGAZINE_BATCH);
+        }
+    }
+
+  return ret;
+}
+
+#endif /* MM_HAVE_MAGAZINE */
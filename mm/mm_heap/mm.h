@@ -34,6 +34,7 @@
 #include <nuttx/fs/procfs.h>
 #include <nuttx/lib/math32.h>
 #include <nuttx/mm/mempool.h>
+#include <nuttx/mm/magazine.h>
 #include <nuttx/mm/mm.h>
 
 #include <assert.h>
@@ -265,6 +266,12 @@ struct mm_heap_s
   FAR struct mempool_multiple_s *mm_mpool;
 #endif
 
+  /* The per-CPU magazines of small free blocks */
+
+#ifdef CONFIG_MM_HEAP_MAGAZINE
+  struct mm_magcache_s mm_magazine;
+#endif
+
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_MEMINFO)
   struct procfs_meminfo_entry_s mm_procfs;
 #endif
@@ -296,10 +303,22 @@ void mm_shrinkchunk(FAR struct mm_heap_s *heap,
 void mm_foreach(FAR struct mm_heap_s *heap, mm_node_handler_t handler,
                 FAR void *arg);
 
+/* Functions contained in mm_malloc.c ***************************************/
+
+#ifdef MM_HAVE_MAGAZINE
+size_t mm_malloc_batch(FAR struct mm_heap_s *heap, size_t size,
+                       FAR void **blks, size_t nblks);
+#endif
+
 /* Functions contained in mm_free.c *****************************************/
 
 void mm_delayfree(FAR struct mm_heap_s *heap, FAR void *mem, bool delay);
 
+#ifdef MM_HAVE_MAGAZINE
+void mm_free_batch(FAR struct mm_heap_s *heap, FAR void **blks,
+                   size_t nblks);
+#endif
+
 /****************************************************************************
  * Inline Functions
  ****************************************************************************/
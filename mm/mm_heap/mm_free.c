@@ -70,18 +70,15 @@ static void add_delaylist(FAR struct mm_heap_s *heap, FAR void *mem)
 }
 
 /****************************************************************************
- * Public Functions
- ****************************************************************************/
-
-/****************************************************************************
- * Name: mm_delayfree
+ * Name: free_chunk
  *
  * Description:
- *   Delay free memory if `delay` is true, otherwise free it immediately.
+ *   Return a chunk to the free lists, merging it with its free neighbours.
+ *   The caller must hold the MM mutex.
  *
  ****************************************************************************/
 
-void mm_delayfree(FAR struct mm_heap_s *heap, FAR void *mem, bool delay)
+static void free_chunk(FAR struct mm_heap_s *heap, FAR void *mem)
 {
   FAR struct mm_freenode_s *node;
   FAR struct mm_freenode_s *prev;
@@ -89,42 +86,6 @@ void mm_delayfree(FAR struct mm_heap_s *heap, FAR void *mem, bool delay)
   size_t nodesize;
   size_t prevsize;
 
-  if (mm_lock(heap) < 0)
-    {
-      /* Meet -ESRCH return, which means we are in situations
-       * during context switching(See mm_lock() & gettid()).
-       * Then add to the delay list.
-       */
-
-      add_delaylist(heap, mem);
-      return;
-    }
-
-  nodesize = mm_malloc_size(heap, mem);
-#ifdef CONFIG_MM_FILL_ALLOCATIONS
-#if CONFIG_MM_FREE_DELAYCOUNT_MAX > 0
-  /* If delay free is enabled, a memory node will be freed twice.
-   * The first time is to add the node to the delay list, and the second
-   * time is to actually free the node. Therefore, we only colorize the
-   * memory node the first time, when `delay` is set to true.
-   */
-
-  if (delay)
-#endif
-    {
-      memset(mem, MM_FREE_MAGIC, nodesize);
-    }
-#endif
-
-  kasan_poison(mem, nodesize);
-
-  if (delay)
-    {
-      mm_unlock(heap);
-      add_delaylist(heap, mem);
-      return;
-    }
-
   /* Map the memory chunk into a free node */
 
   node = (FAR struct mm_freenode_s *)
@@ -217,9 +178,99 @@ void mm_delayfree(FAR struct mm_heap_s *heap, FAR void *mem, bool delay)
   /* Add the merged node to the nodelist */
 
   mm_addfreechunk(heap, node);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_delayfree
+ *
+ * Description:
+ *   Delay free memory if `delay` is true, otherwise free it immediately.
+ *
+ ****************************************************************************/
+
+void mm_delayfree(FAR struct mm_heap_s *heap, FAR void *mem, bool delay)
+{
+  size_t nodesize;
+
+  if (mm_lock(heap) < 0)
+    {
+      /* Meet -ESRCH return, which means we are in situations
+       * during context switching(See mm_lock() & gettid()).
+       * Then add to the delay list.
+       */
+
+      add_delaylist(heap, mem);
+      return;
+    }
+
+  nodesize = mm_malloc_size(heap, mem);
+  UNUSED(nodesize);
+#ifdef CONFIG_MM_FILL_ALLOCATIONS
+#if CONFIG_MM_FREE_DELAYCOUNT_MAX > 0
+  /* If delay free is enabled, a memory node will be freed twice.
+   * The first time is to add the node to the delay list, and the second
+   * time is to actually free the node. Therefore, we only colorize the
+   * memory node the first time, when `delay` is set to true.
+   */
+
+  if (delay)
+#endif
+    {
+      memset(mem, MM_FREE_MAGIC, nodesize);
+    }
+#endif
+
+  kasan_poison(mem, nodesize);
+
+  if (delay)
+    {
+      mm_unlock(heap);
+      add_delaylist(heap, mem);
+      return;
+    }
+
+  free_chunk(heap, mem);
   mm_unlock(heap);
 }
 
+#ifdef MM_HAVE_MAGAZINE
+/****************************************************************************
+ * Name: mm_free_batch
+ *
+ * Description:
+ *   Free 'nblks' chunks while holding the MM mutex only once.  This flushes
+ *   the per-CPU magazines.
+ *
+ ****************************************************************************/
+
+void mm_free_batch(FAR struct mm_heap_s *heap, FAR void **blks,
+                   size_t nblks)
+{
+  size_t i;
+
+  if (mm_lock(heap) < 0)
+    {
+      for (i = 0; i < nblks; i++)
+        {
+          add_delaylist(heap, blks[i]);
+        }
+
+      return;
+    }
+
+  for (i = 0; i < nblks; i++)
+    {
+      free_chunk(heap, blks[i]);
+    }
+
+  mm_unlock(heap);
+}
+#endif
+
 /****************************************************************************
  * Name: mm_free
  *
@@ -252,5 +303,12 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
     }
 #endif
 
+#ifdef MM_HAVE_MAGAZINE
+  if (mm_magazine_free(&heap->mm_magazine, mem))
+    {
+      return;
+    }
+#endif
+
   mm_delayfree(heap, mem, CONFIG_MM_FREE_DELAYCOUNT_MAX > 0);
 }
@@ -271,6 +271,13 @@ FAR struct mm_heap_s *mm_initialize(FAR const char *name,
 
   nxmutex_init(&heap->mm_lock);
 
+#ifdef MM_HAVE_MAGAZINE
+  mm_magazine_initialize(&heap->mm_magazine,
+                         (mm_magazine_alloc_t)mm_malloc_batch,
+                         (mm_magazine_size_t)mm_malloc_size,
+                         (mm_magazine_free_t)mm_free_batch, heap);
+#endif
+
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_MEMINFO)
 #  if defined(CONFIG_BUILD_FLAT) || defined(__KERNEL__)
   heap->mm_procfs.name = name;
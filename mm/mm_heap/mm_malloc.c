@@ -109,91 +109,19 @@ static bool free_delaylist(FAR struct mm_heap_s *heap, bool force)
   return ret;
 }
 
-#if CONFIG_MM_BACKTRACE >= 0
-void mm_dump_handler(FAR struct tcb_s *tcb, FAR void *arg)
-{
-  struct mallinfo_task info;
-  struct malltask task;
-
-  task.pid = tcb ? tcb->pid : PID_MM_LEAK;
-  task.seqmin = 0;
-  task.seqmax = ULONG_MAX;
-  info = mm_mallinfo_task(arg, &task);
-  mwarn("pid:%5d, used:%10d, nused:%10d\n",
-        task.pid, info.uordblks, info.aordblks);
-}
-#endif
-
-#ifdef CONFIG_MM_HEAP_MEMPOOL
-void mm_mempool_dump_handle(FAR struct mempool_s *pool, FAR void *arg)
-{
-  struct mempoolinfo_s info;
-
-  mempool_info(pool, &info);
-  mwarn("%9lu%11lu%9lu%9lu%9lu%9lu\n",
-        info.sizeblks, info.arena, info.aordblks,
-        info.ordblks, info.iordblks, info.nwaiter);
-}
-#endif
-
 /****************************************************************************
- * Public Functions
- ****************************************************************************/
-
-/****************************************************************************
- * Name: mm_free_delaylist
+ * Name: alloc_size
  *
  * Description:
- *   force freeing the delaylist of this heap.
+ *  Adjust the size to account for (1) the size of the allocated node and
+ *  (2) to make sure that it is aligned with MM_ALIGN and its size is at
+ *  least MM_MIN_CHUNK.  Return zero on integer overflow.
  *
  ****************************************************************************/
 
-void mm_free_delaylist(FAR struct mm_heap_s *heap)
+static size_t alloc_size(size_t size)
 {
-  if (heap)
-    {
-       free_delaylist(heap, true);
-    }
-}
-
-/****************************************************************************
- * Name: mm_malloc
- *
- * Description:
- *  Find the smallest chunk that satisfies the request. Take the memory from
- *  that chunk, save the remaining, smaller chunk (if any).
- *
- *  8-byte alignment of the allocated data is assured.
- *
- ****************************************************************************/
-
-FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
-{
-  FAR struct mm_freenode_s *node;
   size_t alignsize;
-  size_t nodesize;
-  FAR void *ret = NULL;
-  int ndx;
-
-  /* Free the delay list first */
-
-  free_delaylist(heap, false);
-
-#ifdef CONFIG_MM_HEAP_MEMPOOL
-  if (heap->mm_mpool)
-    {
-      ret = mempool_multiple_alloc(heap->mm_mpool, size);
-      if (ret != NULL)
-        {
-          return ret;
-        }
-    }
-#endif
-
-  /* Adjust the size to account for (1) the size of the allocated node and
-   * (2) to make sure that it is aligned with MM_ALIGN and its size is at
-   * least MM_MIN_CHUNK.
-   */
 
   if (size < MM_MIN_CHUNK - MM_ALLOCNODE_OVERHEAD)
     {
@@ -205,14 +133,28 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
     {
       /* There must have been an integer overflow */
 
-      return NULL;
+      return 0;
     }
 
   DEBUGASSERT(alignsize >= MM_ALIGN);
+  return alignsize;
+}
 
-  /* We need to hold the MM mutex while we muck with the nodelist. */
+/****************************************************************************
+ * Name: alloc_chunk
+ *
+ * Description:
+ *  Take the best fitting chunk of 'alignsize' bytes from the free lists,
+ *  splitting off the remainder.  The caller must hold the MM mutex.
+ *
+ ****************************************************************************/
 
-  DEBUGVERIFY(mm_lock(heap));
+static FAR void *alloc_chunk(FAR struct mm_heap_s *heap, size_t alignsize)
+{
+  FAR struct mm_freenode_s *node;
+  size_t nodesize;
+  FAR void *ret = NULL;
+  int ndx;
 
   /* Convert the request size into a nodelist index */
 
@@ -320,20 +262,159 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
       ret = (FAR void *)((FAR char *)node + MM_SIZEOF_ALLOCNODE);
     }
 
-  DEBUGASSERT(ret == NULL || mm_heapmember(heap, ret));
-
   if (ret)
     {
       sched_note_heap(NOTE_HEAP_ALLOC, heap, ret, nodesize,
                       heap->mm_curused);
     }
 
+  return ret;
+}
+
+#if CONFIG_MM_BACKTRACE >= 0
+void mm_dump_handler(FAR struct tcb_s *tcb, FAR void *arg)
+{
+  struct mallinfo_task info;
+  struct malltask task;
+
+  task.pid = tcb ? tcb->pid : PID_MM_LEAK;
+  task.seqmin = 0;
+  task.seqmax = ULONG_MAX;
+  info = mm_mallinfo_task(arg, &task);
+  mwarn("pid:%5d, used:%10d, nused:%10d\n",
+        task.pid, info.uordblks, info.aordblks);
+}
+#endif
+
+#ifdef CONFIG_MM_HEAP_MEMPOOL
+void mm_mempool_dump_handle(FAR struct mempool_s *pool, FAR void *arg)
+{
+  struct mempoolinfo_s info;
+
+  mempool_info(pool, &info);
+  mwarn("%9lu%11lu%9lu%9lu%9lu%9lu\n",
+        info.sizeblks, info.arena, info.aordblks,
+        info.ordblks, info.iordblks, info.nwaiter);
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_free_delaylist
+ *
+ * Description:
+ *   force freeing the delaylist of this heap.
+ *
+ ****************************************************************************/
+
+void mm_free_delaylist(FAR struct mm_heap_s *heap)
+{
+  if (heap)
+    {
+#ifdef MM_HAVE_MAGAZINE
+       mm_magazine_drain(&heap->mm_magazine);
+#endif
+       free_delaylist(heap, true);
+    }
+}
+
+#ifdef MM_HAVE_MAGAZINE
+/****************************************************************************
+ * Name: mm_malloc_batch
+ *
+ * Description:
+ *  Allocate up to 'nblks' chunks of 'size' bytes while holding the MM
+ *  mutex only once.  This refills the per-CPU magazines.
+ *
+ *  Return the number of chunks allocated.
+ *
+ ****************************************************************************/
+
+size_t mm_malloc_batch(FAR struct mm_heap_s *heap, size_t size,
+                       FAR void **blks, size_t nblks)
+{
+  size_t alignsize;
+  size_t i;
+
+  alignsize = alloc_size(size);
+  if (alignsize == 0 || mm_lock(heap) < 0)
+    {
+      return 0;
+    }
+
+  for (i = 0; i < nblks; i++)
+    {
+      blks[i] = alloc_chunk(heap, alignsize);
+      if (blks[i] == NULL)
+        {
+          break;
+        }
+    }
+
+  mm_unlock(heap);
+  return i;
+}
+#endif
+
+/****************************************************************************
+ * Name: mm_malloc
+ *
+ * Description:
+ *  Find the smallest chunk that satisfies the request. Take the memory from
+ *  that chunk, save the remaining, smaller chunk (if any).
+ *
+ *  8-byte alignment of the allocated data is assured.
+ *
+ ****************************************************************************/
+
+FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
+{
+  size_t alignsize;
+  FAR void *ret = NULL;
+
+  /* Free the delay list first */
+
+  free_delaylist(heap, false);
+
+#ifdef CONFIG_MM_HEAP_MEMPOOL
+  if (heap->mm_mpool)
+    {
+      ret = mempool_multiple_alloc(heap->mm_mpool, size);
+      if (ret != NULL)
+        {
+          return ret;
+        }
+    }
+#endif
+
+#ifdef MM_HAVE_MAGAZINE
+  ret = mm_magazine_alloc(&heap->mm_magazine, size);
+  if (ret != NULL)
+    {
+      return ret;
+    }
+#endif
+
+  alignsize = alloc_size(size);
+  if (alignsize == 0)
+    {
+      return NULL;
+    }
+
+  /* We need to hold the MM mutex while we muck with the nodelist. */
+
+  DEBUGVERIFY(mm_lock(heap));
+  ret = alloc_chunk(heap, alignsize);
+  DEBUGASSERT(ret == NULL || mm_heapmember(heap, ret));
   mm_unlock(heap);
 
   if (ret)
     {
-      MM_ADD_BACKTRACE(heap, node);
-      ret = kasan_unpoison(ret, nodesize - MM_ALLOCNODE_OVERHEAD);
+      MM_ADD_BACKTRACE(heap, (FAR char *)ret - MM_SIZEOF_ALLOCNODE);
+      ret = kasan_unpoison(ret, mm_malloc_size(heap, ret));
 #ifdef CONFIG_MM_FILL_ALLOCATIONS
       memset(ret, MM_ALLOC_MAGIC, alignsize - MM_ALLOCNODE_OVERHEAD);
 #endif
@@ -351,6 +432,15 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
     }
 #endif
 
+#ifdef MM_HAVE_MAGAZINE
+  /* Try again after returning the cached blocks to the heap */
+
+  else if (mm_magazine_drain(&heap->mm_magazine))
+    {
+      return mm_malloc(heap, size);
+    }
+#endif
+
 #ifdef CONFIG_DEBUG_MM
   else if (MM_INTERNAL_HEAP(heap))
     {
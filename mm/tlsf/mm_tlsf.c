@@ -41,6 +41,7 @@
 #include <nuttx/mutex.h>
 #include <nuttx/mm/mm.h>
 #include <nuttx/mm/kasan.h>
+#include <nuttx/mm/magazine.h>
 #include <nuttx/mm/mempool.h>
 #include <nuttx/sched_note.h>
 
@@ -101,6 +102,12 @@ struct mm_heap_s
   FAR struct mempool_multiple_s *mm_mpool;
 #endif
 
+  /* The per-CPU magazines of small free blocks */
+
+#ifdef CONFIG_MM_HEAP_MAGAZINE
+  struct mm_magcache_s mm_magazine;
+#endif
+
   /* Free delay list, for some situation can't do free immediately */
 
   struct mm_delaynode_s *mm_delaylist[CONFIG_SMP_NCPUS];
@@ -664,6 +671,88 @@ static void mm_delayfree(FAR struct mm_heap_s *heap, FAR void *mem,
     }
 }
 
+#ifdef MM_HAVE_MAGAZINE
+/****************************************************************************
+ * Name: mm_malloc_batch
+ *
+ * Description:
+ *   Allocate up to 'nblks' blocks of 'size' bytes while holding the heap
+ *   lock only once.  This refills the per-CPU magazines.
+ *
+ ****************************************************************************/
+
+static size_t mm_malloc_batch(FAR struct mm_heap_s *heap, size_t size,
+                              FAR void **blks, size_t nblks)
+{
+  size_t nodesize;
+  size_t i;
+
+  if (mm_lock(heap) < 0)
+    {
+      return 0;
+    }
+
+  for (i = 0; i < nblks; i++)
+    {
+      blks[i] = tlsf_malloc(heap->mm_tlsf, size);
+      if (blks[i] == NULL)
+        {
+          break;
+        }
+
+      nodesize = tlsf_block_size(blks[i]);
+      heap->mm_curused += nodesize;
+      if (heap->mm_curused > heap->mm_maxused)
+        {
+          heap->mm_maxused = heap->mm_curused;
+        }
+
+      sched_note_heap(NOTE_HEAP_ALLOC, heap, blks[i], nodesize,
+                      heap->mm_curused);
+    }
+
+  mm_unlock(heap);
+  return i;
+}
+
+/****************************************************************************
+ * Name: mm_free_batch
+ *
+ * Description:
+ *   Free 'nblks' blocks while holding the heap lock only once.  This
+ *   flushes the per-CPU magazines.
+ *
+ ****************************************************************************/
+
+static void mm_free_batch(FAR struct mm_heap_s *heap, FAR void **blks,
+                          size_t nblks)
+{
+  size_t nodesize;
+  size_t i;
+
+  if (mm_lock(heap) < 0)
+    {
+      for (i = 0; i < nblks; i++)
+        {
+          add_delaylist(heap, blks[i]);
+        }
+
+      return;
+    }
+
+  for (i = 0; i < nblks; i++)
+    {
+      nodesize = tlsf_block_size(blks[i]);
+      heap->mm_curused -= nodesize;
+      sched_note_heap(NOTE_HEAP_FREE, heap, blks[i], nodesize,
+                      heap->mm_curused);
+      tlsf_free(heap->mm_tlsf, blks[i]);
+    }
+
+  mm_unlock(heap);
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -914,6 +1003,13 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
     }
 #endif
 
+#ifdef MM_HAVE_MAGAZINE
+  if (mm_magazine_free(&heap->mm_magazine, mem))
+    {
+      return;
+    }
+#endif
+
   mm_delayfree(heap, mem, CONFIG_MM_FREE_DELAYCOUNT_MAX > 0);
 }
 
@@ -1021,6 +1117,13 @@ FAR struct mm_heap_s *mm_initialize(FAR const char *name,
 
   nxmutex_init(&heap->mm_lock);
 
+#ifdef MM_HAVE_MAGAZINE
+  mm_magazine_initialize(&heap->mm_magazine,
+                         (mm_magazine_alloc_t)mm_malloc_batch,
+                         (mm_magazine_size_t)mm_malloc_size,
+                         (mm_magazine_free_t)mm_free_batch, heap);
+#endif
+
   /* Add the initial region of memory to the heap */
 
   mm_addregion(heap, heapstart, heapsize);
@@ -1354,6 +1457,14 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 
   free_delaylist(heap, false);
 
+#ifdef MM_HAVE_MAGAZINE
+  ret = mm_magazine_alloc(&heap->mm_magazine, size);
+  if (ret != NULL)
+    {
+      return ret;
+    }
+#endif
+
   /* Allocate from the tlsf pool */
 
   DEBUGVERIFY(mm_lock(heap));
@@ -1403,6 +1514,15 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
     }
 #endif
 
+#ifdef MM_HAVE_MAGAZINE
+  /* Try again after returning the cached blocks to the heap */
+
+  else if (mm_magazine_drain(&heap->mm_magazine))
+    {
+      return mm_malloc(heap, size);
+    }
+#endif
+
   return ret;
 }
 
@@ -1695,6 +1815,9 @@ void mm_free_delaylist(FAR struct mm_heap_s *heap)
 {
   if (heap)
     {
+#ifdef MM_HAVE_MAGAZINE
+       mm_magazine_drain(&heap->mm_magazine);
+#endif
        free_delaylist(heap, true);
     }
 }
@@ -45,6 +45,7 @@
 #include <netinet/arp.h>
 #include <netinet/in.h>
 
+#include <nuttx/hashtable.h>
 #include <nuttx/net/netdev.h>
 #include <nuttx/semaphore.h>
 
@@ -161,6 +162,8 @@ struct arp_notify_s
 
 struct arp_entry_s
 {
+  hash_node_t              at_node;     /* Entry in the ARP hash table */
+  dq_entry_t               at_lru;      /* Entry in the LRU list */
   in_addr_t                at_ipaddr;   /* IP address */
   struct ether_addr        at_ethaddr;  /* Hardware address */
   clock_t                  at_time;     /* Time of last usage */
@@ -535,6 +538,19 @@ unsigned int arp_snapshot(FAR struct arpreq *snapshot,
 #  define arp_snapshot(s,n) (0)
 #endif
 
+/****************************************************************************
+ * Name: arp_count
+ *
+ * Description:
+ *   Return the number of entries currently in the ARP table.
+ *
+ * Assumptions
+ *   The network is locked to assure exclusive access to the ARP table
+ *
+ ****************************************************************************/
+
+unsigned int arp_count(void);
+
 /****************************************************************************
  * Name: arp_dump
  *
@@ -626,6 +642,7 @@ void arp_acd_setup(FAR struct net_driver_s *dev);
 #  define arp_update(d,i,m);
 #  define arp_hdr_update(d,i,m);
 #  define arp_snapshot(s,n) (0)
+#  define arp_count() (0)
 #  define arp_dump(arp)
 
 #endif /* CONFIG_NET_ARP */
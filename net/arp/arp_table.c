@@ -63,6 +63,7 @@
 
 #include "netdev/netdev.h"
 #include "netlink/netlink.h"
+#include "utils/utils.h"
 #include "arp/arp.h"
 
 #ifdef CONFIG_NET_ARP
@@ -71,8 +72,29 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+#ifndef CONFIG_NET_ARP_ALLOC_ENTRIES
+#  define CONFIG_NET_ARP_ALLOC_ENTRIES 0
+#endif
+
+#ifndef CONFIG_NET_ARP_MAX_ENTRIES
+#  define CONFIG_NET_ARP_MAX_ENTRIES 0
+#endif
+
+#ifndef CONFIG_NET_ARP_HASH_BITS
+#  define CONFIG_NET_ARP_HASH_BITS 4
+#endif
+
 #define ARP_MAXAGE_TICK SEC2TICK(10 * CONFIG_NET_ARP_MAXAGE)
 
+/* The hash key of an IPv4 address, NTOHL keeps the host part in the
+ * lower bits.
+ */
+
+#define ARP_HASH_KEY(ipaddr) NTOHL(ipaddr)
+
+#define ARP_EXPIRED(e, now) \
+  ((clock_t)((now) - (e)->at_time) > ARP_MAXAGE_TICK)
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -87,9 +109,19 @@ struct arp_table_info_s
  * Private Data
  ****************************************************************************/
 
-/* The table of known address mappings */
+/* The pool of ARP table entries */
+
+NET_BUFPOOL_DECLARE(g_arp_entries, sizeof(struct arp_entry_s),
+                    CONFIG_NET_ARPTAB_SIZE, CONFIG_NET_ARP_ALLOC_ENTRIES,
+                    CONFIG_NET_ARP_MAX_ENTRIES);
+
+/* The known address mappings hashed by their IP address, and all of them
+ * ordered by their last usage, the most recently used first.
+ */
 
-static struct arp_entry_s g_arptable[CONFIG_NET_ARPTAB_SIZE];
+static DECLARE_HASHTABLE(g_arp_hash, CONFIG_NET_ARP_HASH_BITS);
+static dq_queue_t g_arp_lru;
+static unsigned int g_arp_count;
 
 static const struct ether_addr g_zero_ethaddr =
 {
@@ -148,40 +180,13 @@ static int arp_match(FAR struct net_driver_s *dev, FAR void *arg)
   return 1;
 }
 
-/****************************************************************************
- * Name: arp_return_old_entry
- *
- * Description:
- *   Compare and return the old ARP table entry.
- *
- ****************************************************************************/
-
-static FAR struct arp_entry_s *
-arp_return_old_entry(FAR struct arp_entry_s *e1, FAR struct arp_entry_s *e2)
-{
-  if (e1->at_ipaddr == 0)
-    {
-      return e1;
-    }
-  else if (e2->at_ipaddr == 0)
-    {
-      return e2;
-    }
-  else if ((int)(e1->at_time - e2->at_time) <= 0)
-    {
-      return e1;
-    }
-  else
-    {
-      return e2;
-    }
-}
-
 /****************************************************************************
  * Name: arp_lookup
  *
  * Description:
  *   Find the ARP entry corresponding to this IP address in the ARP table.
+ *   Expired entries are returned too, the caller must check the age of the
+ *   entry if that matters.
  *
  * Input Parameters:
  *   ipaddr - Refers to an IP address in network order
@@ -197,16 +202,13 @@ static FAR struct arp_entry_s *arp_lookup(in_addr_t ipaddr,
                                           FAR struct net_driver_s *dev)
 {
   FAR struct arp_entry_s *tabptr;
-  int i;
-
-  /* Check if the IPv4 address is already in the ARP table. */
+  FAR hash_node_t *node;
 
-  for (i = 0; i < CONFIG_NET_ARPTAB_SIZE; ++i)
+  hashtable_for_every_possible(g_arp_hash, node, ARP_HASH_KEY(ipaddr))
     {
-      tabptr = &g_arptable[i];
+      tabptr = container_of(node, struct arp_entry_s, at_node);
       if (tabptr->at_dev == dev &&
-          net_ipv4addr_cmp(ipaddr, tabptr->at_ipaddr) &&
-          clock_systime_ticks() - tabptr->at_time <= ARP_MAXAGE_TICK)
+          net_ipv4addr_cmp(ipaddr, tabptr->at_ipaddr))
         {
           return tabptr;
         }
@@ -217,6 +219,60 @@ static FAR struct arp_entry_s *arp_lookup(in_addr_t ipaddr,
   return NULL;
 }
 
+/****************************************************************************
+ * Name: arp_alloc_entry
+ *
+ * Description:
+ *   Get an unused entry for the ARP table.  An expired entry at the end of
+ *   the LRU list is reused first so that the table does not grow with stale
+ *   mappings, then a new entry is allocated from the pool.  If the pool is
+ *   exhausted, the least recently used entry is evicted.
+ *
+ * Returned Value:
+ *   The entry, still linked in the table if it was reused, or NULL if the
+ *   table has no entries at all.
+ *
+ * Assumptions:
+ *   The network is locked to assure exclusive access to the ARP table.
+ *
+ ****************************************************************************/
+
+static FAR struct arp_entry_s *arp_alloc_entry(void)
+{
+  FAR struct arp_entry_s *oldest = NULL;
+  FAR struct arp_entry_s *tabptr;
+  FAR dq_entry_t *lru;
+
+  lru = dq_tail(&g_arp_lru);
+  if (lru != NULL)
+    {
+      oldest = container_of(lru, struct arp_entry_s, at_lru);
+      if (ARP_EXPIRED(oldest, clock_systime_ticks()))
+        {
+          return oldest;
+        }
+    }
+
+  tabptr = NET_BUFPOOL_TRYALLOC(g_arp_entries);
+  return tabptr != NULL ? tabptr : oldest;
+}
+
+/****************************************************************************
+ * Name: arp_unlink_entry
+ *
+ * Description:
+ *   Remove an entry from the hash table and the LRU list.
+ *
+ ****************************************************************************/
+
+static void arp_unlink_entry(FAR struct arp_entry_s *tabptr)
+{
+  hashtable_delete(g_arp_hash, &tabptr->at_node,
+                   ARP_HASH_KEY(tabptr->at_ipaddr));
+  dq_rem(&tabptr->at_lru, &g_arp_lru);
+  g_arp_count--;
+}
+
 /****************************************************************************
  * Name: arp_get_arpreq
  *
@@ -275,42 +331,37 @@ static void arp_get_arpreq(FAR struct arpreq *output,
 int arp_update(FAR struct net_driver_s *dev, in_addr_t ipaddr,
                FAR const uint8_t *ethaddr)
 {
-  FAR struct arp_entry_s *tabptr = &g_arptable[0];
+  FAR struct arp_entry_s *tabptr;
 #ifdef CONFIG_NETLINK_ROUTE
   struct arpreq arp_notify;
-  bool found = false;
   bool new_entry;
 #endif
-  int i;
+  bool found;
 
-  /* Walk through the ARP mapping table and try to find an entry to
-   * update. If none is found, the IP -> MAC address mapping is
-   * inserted in the ARP table.
+  /* Try to find an entry to update.  If none is found, the IP -> MAC
+   * address mapping is inserted in the ARP table.
    */
 
-  for (i = 0; i < CONFIG_NET_ARPTAB_SIZE; ++i)
-    {
-      /* Check if the source IP address of the incoming packet matches
-       * the IP address in this ARP table entry.
-       */
+  tabptr = arp_lookup(ipaddr, dev);
+  found  = tabptr != NULL;
 
-      if (g_arptable[i].at_dev == dev &&
-          g_arptable[i].at_ipaddr != 0 &&
-          net_ipv4addr_cmp(ipaddr, g_arptable[i].at_ipaddr))
+  if (!found)
+    {
+      tabptr = arp_alloc_entry();
+      if (tabptr == NULL)
         {
-          /* An old entry found, break. */
+          return -ENOMEM;
+        }
 
-          tabptr = &g_arptable[i];
+      /* When overwrite old entry, notify old entry RTM_DELNEIGH */
+
+      if (tabptr->at_dev != NULL)
+        {
 #ifdef CONFIG_NETLINK_ROUTE
-          found = true;
+          arp_get_arpreq(&arp_notify, tabptr);
+          netlink_neigh_notify(&arp_notify, RTM_DELNEIGH, AF_INET);
 #endif
-          break;
-        }
-      else
-        {
-          /* Record the oldest entry. */
-
-          tabptr = arp_return_old_entry(tabptr, &g_arptable[i]);
+          arp_unlink_entry(tabptr);
         }
     }
 
@@ -319,17 +370,9 @@ int arp_update(FAR struct net_driver_s *dev, in_addr_t ipaddr,
       ethaddr = g_zero_ethaddr.ether_addr_octet;
     }
 
-  /* When overwrite old entry, notify old entry RTM_DELNEIGH */
-
-#ifdef CONFIG_NETLINK_ROUTE
-  if (!found && tabptr->at_ipaddr != 0)
-    {
-      arp_get_arpreq(&arp_notify, tabptr);
-      netlink_neigh_notify(&arp_notify, RTM_DELNEIGH, AF_INET);
-    }
-
   /* Need to notify when entry is not found or changes in table */
 
+#ifdef CONFIG_NETLINK_ROUTE
   new_entry = !found || memcmp(tabptr->at_ethaddr.ether_addr_octet,
                                ethaddr, ETHER_ADDR_LEN) != 0;
 #endif
@@ -338,9 +381,20 @@ int arp_update(FAR struct net_driver_s *dev, in_addr_t ipaddr,
    * information.
    */
 
-  tabptr->at_ipaddr = ipaddr;
+  if (found)
+    {
+      dq_rem(&tabptr->at_lru, &g_arp_lru);
+    }
+  else
+    {
+      tabptr->at_ipaddr = ipaddr;
+      tabptr->at_dev    = dev;
+      hashtable_add(g_arp_hash, &tabptr->at_node, ARP_HASH_KEY(ipaddr));
+      g_arp_count++;
+    }
+
+  dq_addfirst(&tabptr->at_lru, &g_arp_lru);
   memcpy(tabptr->at_ethaddr.ether_addr_octet, ethaddr, ETHER_ADDR_LEN);
-  tabptr->at_dev = dev;
   tabptr->at_time = clock_systime_ticks();
 
   /* Notify the new entry */
@@ -416,8 +470,13 @@ int arp_find(in_addr_t ipaddr, FAR uint8_t *ethaddr,
   /* Check if the IPv4 address is already in the ARP table. */
 
   tabptr = arp_lookup(ipaddr, dev);
-  if (tabptr != NULL)
+  if (tabptr != NULL && !ARP_EXPIRED(tabptr, clock_systime_ticks()))
     {
+      /* Keep the entry away from eviction while it is in use */
+
+      dq_rem(&tabptr->at_lru, &g_arp_lru);
+      dq_addfirst(&tabptr->at_lru, &g_arp_lru);
+
       /* Addresses that have failed to be searched will return a special
        * error code so that the upper layer can return faster.
        */
@@ -486,7 +545,7 @@ int arp_delete(in_addr_t ipaddr, FAR struct net_driver_s *dev)
   /* Check if the IPv4 address is in the ARP table. */
 
   tabptr = arp_lookup(ipaddr, dev);
-  if (tabptr != NULL)
+  if (tabptr != NULL && !ARP_EXPIRED(tabptr, clock_systime_ticks()))
     {
       /* Notify to netlink */
 
@@ -495,9 +554,10 @@ int arp_delete(in_addr_t ipaddr, FAR struct net_driver_s *dev)
       netlink_neigh_notify(&arp_notify, RTM_DELNEIGH, AF_INET);
 #endif
 
-      /* Yes.. Set the IP address to zero to "delete" it */
+      /* Yes.. Remove it from the table and return it to the pool */
 
-      tabptr->at_ipaddr = 0;
+      arp_unlink_entry(tabptr);
+      NET_BUFPOOL_FREE(g_arp_entries, tabptr);
       return OK;
     }
 
@@ -520,13 +580,17 @@ int arp_delete(in_addr_t ipaddr, FAR struct net_driver_s *dev)
 
 void arp_cleanup(FAR struct net_driver_s *dev)
 {
-  int i;
+  FAR struct arp_entry_s *tabptr;
+  FAR dq_entry_t *node;
+  FAR dq_entry_t *next;
 
-  for (i = 0; i < CONFIG_NET_ARPTAB_SIZE; ++i)
+  dq_for_every_safe(&g_arp_lru, node, next)
     {
-      if (dev == g_arptable[i].at_dev)
+      tabptr = container_of(node, struct arp_entry_s, at_lru);
+      if (dev == tabptr->at_dev)
         {
-          memset(&g_arptable[i], 0, sizeof(g_arptable[i]));
+          arp_unlink_entry(tabptr);
+          NET_BUFPOOL_FREE(g_arp_entries, tabptr);
         }
     }
 }
@@ -556,19 +620,21 @@ unsigned int arp_snapshot(FAR struct arpreq *snapshot,
                           unsigned int nentries)
 {
   FAR struct arp_entry_s *tabptr;
-  clock_t now;
-  unsigned int ncopied;
-  int i;
+  FAR dq_entry_t *node;
+  unsigned int ncopied = 0;
+  clock_t now = clock_systime_ticks();
 
-  /* Copy all non-empty, non-expired entries in the ARP table. */
+  /* Copy all non-expired entries in the ARP table. */
 
-  for (i = 0, now = clock_systime_ticks(), ncopied = 0;
-       nentries > ncopied && i < CONFIG_NET_ARPTAB_SIZE;
-       i++)
+  dq_for_every(&g_arp_lru, node)
     {
-      tabptr = &g_arptable[i];
-      if (tabptr->at_ipaddr != 0 &&
-          now - tabptr->at_time <= ARP_MAXAGE_TICK)
+      if (ncopied >= nentries)
+        {
+          break;
+        }
+
+      tabptr = container_of(node, struct arp_entry_s, at_lru);
+      if (!ARP_EXPIRED(tabptr, now))
         {
           arp_get_arpreq(&snapshot[ncopied], tabptr);
           ncopied++;
@@ -581,5 +647,21 @@ unsigned int arp_snapshot(FAR struct arpreq *snapshot,
 }
 #endif
 
+/****************************************************************************
+ * Name: arp_count
+ *
+ * Description:
+ *   Return the number of entries currently in the ARP table.
+ *
+ * Assumptions
+ *   The network is locked to assure exclusive access to the ARP table
+ *
+ ****************************************************************************/
+
+unsigned int arp_count(void)
+{
+  return g_arp_count;
+}
+
 #endif /* CONFIG_NET_ARP */
 #endif /* CONFIG_NET */
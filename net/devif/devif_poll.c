@@ -656,6 +656,14 @@ static inline int devif_poll_tcp_connections(FAR struct net_driver_s *dev,
           /* Call back into the driver */
 
           bstop = devif_poll_local_out(dev, callback);
+
+#ifdef CONFIG_NETDEV_GSO
+          /* Don't leave the segment size behind if the packet was dropped
+           * or replaced before it reached the driver.
+           */
+
+          dev->d_gsosize = 0;
+#endif
         }
     }
 
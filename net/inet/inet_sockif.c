@@ -48,6 +48,21 @@
 
 #ifdef HAVE_INET_SOCKETS
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Capabilities of TCP and UDP sockets.  They only block with the network
+ * lock broken, so sendmmsg() and recvmmsg() may hold it for a whole batch.
+ */
+
+#ifdef CONFIG_NET_RECV_ZEROCOPY
+#  define INET_SOCKCAPS \
+     (SOCKCAP_NONBLOCKING | SOCKCAP_BATCHING | SOCKCAP_ZEROCOPY)
+#else
+#  define INET_SOCKCAPS (SOCKCAP_NONBLOCKING | SOCKCAP_BATCHING)
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -349,12 +364,12 @@ static sockcaps_t inet_sockcaps(FAR struct socket *psock)
     {
 #ifdef NET_TCP_HAVE_STACK
       case SOCK_STREAM:
-        return SOCKCAP_NONBLOCKING;
+        return INET_SOCKCAPS;
 #endif
 
 #ifdef NET_UDP_HAVE_STACK
       case SOCK_DGRAM:
-        return SOCKCAP_NONBLOCKING;
+        return INET_SOCKCAPS;
 #endif
 
 #if defined(NET_TCP_HAVE_STACK) || defined(NET_UDP_HAVE_STACK)
@@ -65,15 +65,29 @@
 #define IPv6_L4HDR(ipv6, proto) \
   ((FAR void *)(net_ipv6_payload((FAR struct ipv6_hdr_s *)(ipv6), &(proto))))
 
+/* The compiled chain to match with, if any */
+
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+#  define IPFILTER_COMPILED(compiled, chain) ((compiled)[chain])
+#else
+#  define IPFILTER_COMPILED(compiled, chain) NULL
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
 #ifdef CONFIG_NET_IPv4
 static sq_queue_t g_ipv4_filters[IPFILTER_CHAIN_MAX];
+#  ifdef CONFIG_NET_IPFILTER_COMPILE
+static FAR struct ipfilter_compiled_s *g_ipv4_compiled[IPFILTER_CHAIN_MAX];
+#  endif
 #endif
 #ifdef CONFIG_NET_IPv6
 static sq_queue_t g_ipv6_filters[IPFILTER_CHAIN_MAX];
+#  ifdef CONFIG_NET_IPFILTER_COMPILE
+static FAR struct ipfilter_compiled_s *g_ipv6_compiled[IPFILTER_CHAIN_MAX];
+#  endif
 #endif
 
 /****************************************************************************
@@ -188,6 +202,67 @@ static bool ipfilter_match_proto(FAR const struct ipfilter_entry_s *entry,
     }
 }
 
+/****************************************************************************
+ * Name: ipfilter_chain_match
+ *
+ * Description:
+ *   Match the packet with the filter entries in a chain, by the compiled
+ *   chain if there is one, or by walking the chain.
+ *
+ * Input Parameters:
+ *   queue    - The chain of filter entries
+ *   compiled - The compiled chain, may be NULL
+ *   pkt      - The packet to match
+ *   match    - The function to match one entry
+ *
+ * Returned Value:
+ *   IPFILTER_TARGET_ACCEPT(0)  - The input packet is accepted
+ *   IPFILTER_TARGET_DROP(-1)   - The input packet needs to be dropped
+ *   IPFILTER_TARGET_REJECT(-2) - The input packet is rejected
+ *
+ ****************************************************************************/
+
+static int
+ipfilter_chain_match(FAR const sq_queue_t *queue,
+                     FAR const struct ipfilter_compiled_s *compiled,
+                     FAR const struct ipfilter_packet_s *pkt,
+                     CODE bool (*match)(FAR const struct ipfilter_entry_s *,
+                                        FAR const struct ipfilter_packet_s *))
+{
+  FAR const struct ipfilter_entry_s *filter = NULL;
+  FAR const sq_entry_t *entry;
+
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+  if (compiled != NULL)
+    {
+      filter = ipfilter_compiled_match(compiled, pkt);
+    }
+  else
+#endif
+    {
+      sq_for_every(queue, entry)
+        {
+          if (match((FAR const struct ipfilter_entry_s *)entry, pkt))
+            {
+              filter = (FAR const struct ipfilter_entry_s *)entry;
+              break;
+            }
+        }
+    }
+
+  /* Return the target action if matched. */
+
+  if (filter != NULL)
+    {
+      return filter->target;
+    }
+
+  /* Normally there should be a default rule in chain, won't reach here. */
+
+  ninfo("No filter matched, maybe uninitialized.\n");
+  return IPFILTER_TARGET_ACCEPT;
+}
+
 /****************************************************************************
  * Name: ipv4_filter_match / ipv6_filter_match
  *
@@ -213,12 +288,7 @@ static int ipv4_filter_match(FAR const struct net_driver_s *indev,
                              FAR const struct ipv4_hdr_s *ipv4,
                              enum ipfilter_chain_e chain)
 {
-  FAR const struct ipv4_filter_entry_s *filter;
-  FAR const sq_queue_t *queue = &g_ipv4_filters[chain];
-  FAR const sq_entry_t *entry;
-  FAR const void *l4hdr;
-  in_addr_t ipaddr;
-  bool matched;
+  struct ipfilter_packet_s pkt;
 
   /* Handle unexpected status, return ACCEPT to indicate doing nothing. */
 
@@ -227,130 +297,166 @@ static int ipv4_filter_match(FAR const struct net_driver_s *indev,
       return IPFILTER_TARGET_ACCEPT;
     }
 
-  l4hdr = IPv4_L4HDR(ipv4);
-
-  sq_for_every(queue, entry)
-    {
-      filter = (FAR struct ipv4_filter_entry_s *)entry;
+  pkt.indev  = indev;
+  pkt.outdev = outdev;
+  pkt.iphdr  = ipv4;
+  pkt.l4hdr  = IPv4_L4HDR(ipv4);
+  pkt.proto  = ipv4->proto;
 
-      /* Match device */
-
-      if (!ipfilter_match_device(&filter->common, indev, outdev))
-        {
-          continue;
-        }
+  return ipfilter_chain_match(&g_ipv4_filters[chain],
+                              IPFILTER_COMPILED(g_ipv4_compiled, chain),
+                              &pkt, ipv4_filter_entry_match);
+}
+#endif
 
-      /* Match addresses */
+#ifdef CONFIG_NET_IPv6
+static int ipv6_filter_match(FAR const struct net_driver_s *indev,
+                             FAR const struct net_driver_s *outdev,
+                             FAR const struct ipv6_hdr_s *ipv6,
+                             enum ipfilter_chain_e chain)
+{
+  struct ipfilter_packet_s pkt;
 
-      ipaddr  = net_ip4addr_conv32(ipv4->srcipaddr);
-      matched = net_ipv4addr_maskcmp(filter->sip, ipaddr, filter->smsk)
-                ^ filter->common.inv_srcip;
-      if (!matched)
-        {
-          continue;
-        }
+  /* Handle unexpected status, return ACCEPT to indicate doing nothing. */
 
-      ipaddr  = net_ip4addr_conv32(ipv4->destipaddr);
-      matched = net_ipv4addr_maskcmp(filter->dip, ipaddr, filter->dmsk)
-                ^ filter->common.inv_dstip;
-      if (!matched)
-        {
-          continue;
-        }
+  if ((indev == NULL && outdev == NULL) || ipv6 == NULL)
+    {
+      return IPFILTER_TARGET_ACCEPT;
+    }
 
-      /* Match protocol */
+  pkt.indev  = indev;
+  pkt.outdev = outdev;
+  pkt.iphdr  = ipv6;
+  pkt.l4hdr  = IPv6_L4HDR(ipv6, pkt.proto);
 
-      if (!ipfilter_match_proto(&filter->common, l4hdr, ipv4->proto))
-        {
-          continue;
-        }
+  return ipfilter_chain_match(&g_ipv6_filters[chain],
+                              IPFILTER_COMPILED(g_ipv6_compiled, chain),
+                              &pkt, ipv6_filter_entry_match);
+}
+#endif
 
-      /* Return the target action if matched. */
+/****************************************************************************
+ * Name: ipfilter_compiled_update
+ *
+ * Description:
+ *   Replace the compiled chain of a chain, NULL drops it.
+ *
+ ****************************************************************************/
 
-      return filter->common.target;
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+static void
+ipfilter_compiled_update(FAR struct ipfilter_compiled_s **compiled,
+                         FAR struct ipfilter_compiled_s *newcompiled)
+{
+  if (*compiled != NULL)
+    {
+      ipfilter_compiled_free(*compiled);
     }
 
-  /* Normally there should be a default rule in chain, won't reach here. */
-
-  ninfo("No filter matched, maybe uninitialized.\n");
-  return IPFILTER_TARGET_ACCEPT;
+  *compiled = newcompiled;
 }
 #endif
 
-#ifdef CONFIG_NET_IPv6
-static int ipv6_filter_match(FAR const struct net_driver_s *indev,
-                             FAR const struct net_driver_s *outdev,
-                             FAR const struct ipv6_hdr_s *ipv6,
-                             enum ipfilter_chain_e chain)
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ipv4_filter_entry_match / ipv6_filter_entry_match
+ *
+ * Description:
+ *   Match a packet with one filter entry.
+ *
+ * Input Parameters:
+ *   entry - The filter entry to match
+ *   pkt   - The packet to match
+ *
+ * Returned Value:
+ *   true if all the conditions of the entry are matched.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPv4
+bool ipv4_filter_entry_match(FAR const struct ipfilter_entry_s *entry,
+                             FAR const struct ipfilter_packet_s *pkt)
 {
-  FAR const struct ipv6_filter_entry_s *filter;
-  FAR const sq_queue_t *queue = &g_ipv6_filters[chain];
-  FAR const sq_entry_t *entry;
-  FAR const void *l4hdr;
-  uint8_t proto;
+  FAR const struct ipv4_filter_entry_s *filter =
+    (FAR const struct ipv4_filter_entry_s *)entry;
+  FAR const struct ipv4_hdr_s *ipv4 = pkt->iphdr;
+  in_addr_t ipaddr;
   bool matched;
 
-  /* Handle unexpected status, return ACCEPT to indicate doing nothing. */
+  /* Match device */
 
-  if ((indev == NULL && outdev == NULL) || ipv6 == NULL)
+  if (!ipfilter_match_device(entry, pkt->indev, pkt->outdev))
     {
-      return IPFILTER_TARGET_ACCEPT;
+      return false;
     }
 
-  l4hdr = IPv6_L4HDR(ipv6, proto);
+  /* Match addresses */
 
-  sq_for_every(queue, entry)
+  ipaddr  = net_ip4addr_conv32(ipv4->srcipaddr);
+  matched = net_ipv4addr_maskcmp(filter->sip, ipaddr, filter->smsk)
+            ^ entry->inv_srcip;
+  if (!matched)
     {
-      filter = (FAR struct ipv6_filter_entry_s *)entry;
+      return false;
+    }
 
-      /* Match device */
+  ipaddr  = net_ip4addr_conv32(ipv4->destipaddr);
+  matched = net_ipv4addr_maskcmp(filter->dip, ipaddr, filter->dmsk)
+            ^ entry->inv_dstip;
+  if (!matched)
+    {
+      return false;
+    }
 
-      if (!ipfilter_match_device(&filter->common, indev, outdev))
-        {
-          continue;
-        }
+  /* Match protocol */
 
-      /* Match addresses */
+  return ipfilter_match_proto(entry, pkt->l4hdr, pkt->proto);
+}
+#endif
 
-      matched = net_ipv6addr_maskcmp(filter->sip, ipv6->srcipaddr,
-                                     filter->smsk)
-                ^ filter->common.inv_srcip;
-      if (!matched)
-        {
-          continue;
-        }
+#ifdef CONFIG_NET_IPv6
+bool ipv6_filter_entry_match(FAR const struct ipfilter_entry_s *entry,
+                             FAR const struct ipfilter_packet_s *pkt)
+{
+  FAR const struct ipv6_filter_entry_s *filter =
+    (FAR const struct ipv6_filter_entry_s *)entry;
+  FAR const struct ipv6_hdr_s *ipv6 = pkt->iphdr;
+  bool matched;
 
-      matched = net_ipv6addr_maskcmp(filter->dip, ipv6->destipaddr,
-                                     filter->dmsk)
-                ^ filter->common.inv_dstip;
-      if (!matched)
-        {
-          continue;
-        }
+  /* Match device */
 
-      /* Match protocol */
+  if (!ipfilter_match_device(entry, pkt->indev, pkt->outdev))
+    {
+      return false;
+    }
 
-      if (!ipfilter_match_proto(&filter->common, l4hdr, proto))
-        {
-          continue;
-        }
+  /* Match addresses */
 
-      /* Return the target action if matched. */
+  matched = net_ipv6addr_maskcmp(filter->sip, ipv6->srcipaddr,
+                                 filter->smsk)
+            ^ entry->inv_srcip;
+  if (!matched)
+    {
+      return false;
+    }
 
-      return filter->common.target;
+  matched = net_ipv6addr_maskcmp(filter->dip, ipv6->destipaddr,
+                                 filter->dmsk)
+            ^ entry->inv_dstip;
+  if (!matched)
+    {
+      return false;
     }
 
-  /* Normally there should be a default rule in chain, won't reach here. */
+  /* Match protocol */
 
-  ninfo("No filter matched, maybe uninitialized.\n");
-  return IPFILTER_TARGET_ACCEPT;
+  return ipfilter_match_proto(entry, pkt->l4hdr, pkt->proto);
 }
 #endif
 
-/****************************************************************************
- * Public Functions
- ****************************************************************************/
-
 /****************************************************************************
  * Name: ipfilter_cfg_alloc
  *
@@ -410,6 +516,11 @@ void ipfilter_cfg_add(FAR struct ipfilter_entry_s *entry,
 #ifdef CONFIG_NET_IPv4
   if (family == PF_INET)
     {
+      /* The compiled chain is out of date until the next commit */
+
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+      ipfilter_compiled_update(&g_ipv4_compiled[chain], NULL);
+#endif
       sq_addlast((FAR sq_entry_t *)entry, &g_ipv4_filters[chain]);
     }
 #endif
@@ -417,6 +528,9 @@ void ipfilter_cfg_add(FAR struct ipfilter_entry_s *entry,
 #ifdef CONFIG_NET_IPv6
   if (family == PF_INET6)
     {
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+      ipfilter_compiled_update(&g_ipv6_compiled[chain], NULL);
+#endif
       sq_addlast((FAR sq_entry_t *)entry, &g_ipv6_filters[chain]);
     }
 #endif
@@ -444,6 +558,10 @@ void ipfilter_cfg_clear(sa_family_t family, enum ipfilter_chain_e chain)
   if (family == PF_INET)
     {
       FAR sq_queue_t *queue = &g_ipv4_filters[chain];
+
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+      ipfilter_compiled_update(&g_ipv4_compiled[chain], NULL);
+#endif
       while (!sq_empty(queue))
         {
           kmm_free(sq_remfirst(queue));
@@ -455,6 +573,10 @@ void ipfilter_cfg_clear(sa_family_t family, enum ipfilter_chain_e chain)
   if (family == PF_INET6)
     {
       FAR sq_queue_t *queue = &g_ipv6_filters[chain];
+
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+      ipfilter_compiled_update(&g_ipv6_compiled[chain], NULL);
+#endif
       while (!sq_empty(queue))
         {
           kmm_free(sq_remfirst(queue));
@@ -463,6 +585,63 @@ void ipfilter_cfg_clear(sa_family_t family, enum ipfilter_chain_e chain)
 #endif
 }
 
+/****************************************************************************
+ * Name: ipfilter_cfg_commit
+ *
+ * Description:
+ *   Compile the filter configuration entries of the specified chain, after
+ *   all of them have been added, so that packets can be matched without
+ *   walking the whole chain.  The chain is walked linearly if it can not be
+ *   compiled.
+ *
+ * Input Parameters:
+ *   family - The address family of the chain
+ *   chain  - The chain to compile
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+void ipfilter_cfg_commit(sa_family_t family, enum ipfilter_chain_e chain)
+{
+  FAR struct ipfilter_compiled_s **compiled = NULL;
+  FAR struct ipfilter_compiled_s *newcompiled;
+  FAR sq_queue_t *queue = NULL;
+
+#ifdef CONFIG_NET_IPv4
+  if (family == PF_INET)
+    {
+      compiled = &g_ipv4_compiled[chain];
+      queue    = &g_ipv4_filters[chain];
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  if (family == PF_INET6)
+    {
+      compiled = &g_ipv6_compiled[chain];
+      queue    = &g_ipv6_filters[chain];
+    }
+#endif
+
+  if (queue == NULL)
+    {
+      return;
+    }
+
+  newcompiled = ipfilter_compile(family, queue);
+  if (newcompiled == NULL)
+    {
+      nwarn("WARNING: Failed to compile chain %d, walk it instead\n",
+            chain);
+    }
+
+  ipfilter_compiled_update(compiled, newcompiled);
+}
+#endif
+
 /****************************************************************************
  * Name: ipv4_filter_in / ipv6_filter_in
  *
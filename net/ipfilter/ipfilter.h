@@ -32,6 +32,7 @@
 #include <stdint.h>
 
 #include <nuttx/compiler.h>
+#include <nuttx/queue.h>
 #include <nuttx/net/ip.h>
 
 #ifdef CONFIG_NET_IPFILTER
@@ -97,6 +98,11 @@ struct ipfilter_entry_s
   uint8_t inv_sport  : 1; /* Inverse source port */
   uint8_t inv_dport  : 1; /* Inverse destination port */
   uint8_t inv_icmp   : 1; /* Inverse ICMP type */
+
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+  sq_entry_t   node;      /* Entry in a list of the compiled chain */
+  unsigned int index;     /* Position of the entry in the chain */
+#endif
 };
 
 struct ipv4_filter_entry_s
@@ -123,6 +129,21 @@ struct ipv6_filter_entry_s
   net_ipv6addr_t dmsk;
 };
 
+/* The packet to match with the filter entries */
+
+struct ipfilter_packet_s
+{
+  FAR const struct net_driver_s *indev;  /* Device the packet comes from */
+  FAR const struct net_driver_s *outdev; /* Device the packet goes to */
+  FAR const void *iphdr;                 /* The IPv4/IPv6 header */
+  FAR const void *l4hdr;                 /* The L4 header */
+  uint8_t proto;                         /* The L4 protocol */
+};
+
+/* A chain compiled into lookup tables, see ipfilter_compile.c */
+
+struct ipfilter_compiled_s;
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -182,6 +203,105 @@ void ipfilter_cfg_add(FAR struct ipfilter_entry_s *entry,
 
 void ipfilter_cfg_clear(sa_family_t family, enum ipfilter_chain_e chain);
 
+/****************************************************************************
+ * Name: ipfilter_cfg_commit
+ *
+ * Description:
+ *   Compile the filter configuration entries of the specified chain, after
+ *   all of them have been added, so that packets can be matched without
+ *   walking the whole chain.  The chain is walked linearly if it can not be
+ *   compiled.
+ *
+ * Input Parameters:
+ *   family - The address family of the chain
+ *   chain  - The chain to compile
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+void ipfilter_cfg_commit(sa_family_t family, enum ipfilter_chain_e chain);
+#else
+#  define ipfilter_cfg_commit(f,c)
+#endif
+
+/****************************************************************************
+ * Name: ipv4_filter_entry_match / ipv6_filter_entry_match
+ *
+ * Description:
+ *   Match a packet with one filter entry.
+ *
+ * Input Parameters:
+ *   entry - The filter entry to match
+ *   pkt   - The packet to match
+ *
+ * Returned Value:
+ *   true if all the conditions of the entry are matched.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPv4
+bool ipv4_filter_entry_match(FAR const struct ipfilter_entry_s *entry,
+                             FAR const struct ipfilter_packet_s *pkt);
+#endif
+#ifdef CONFIG_NET_IPv6
+bool ipv6_filter_entry_match(FAR const struct ipfilter_entry_s *entry,
+                             FAR const struct ipfilter_packet_s *pkt);
+#endif
+
+/****************************************************************************
+ * Name: ipfilter_compile
+ *
+ * Description:
+ *   Compile a chain of filter entries into lookup tables.  The entries are
+ *   only referenced, the chain must not change while the compiled chain is
+ *   in use.
+ *
+ * Input Parameters:
+ *   family - The address family of the entries
+ *   chain  - The chain of filter entries, in the order they are matched
+ *
+ * Returned Value:
+ *   The compiled chain, or NULL if there is not enough memory.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+FAR struct ipfilter_compiled_s *ipfilter_compile(sa_family_t family,
+                                                 FAR sq_queue_t *chain);
+
+/****************************************************************************
+ * Name: ipfilter_compiled_free
+ *
+ * Description:
+ *   Free a compiled chain.  The filter entries are not freed.
+ *
+ ****************************************************************************/
+
+void ipfilter_compiled_free(FAR struct ipfilter_compiled_s *compiled);
+
+/****************************************************************************
+ * Name: ipfilter_compiled_match
+ *
+ * Description:
+ *   Find the first entry of a compiled chain that matches a packet.
+ *
+ * Input Parameters:
+ *   compiled - The compiled chain
+ *   pkt      - The packet to match
+ *
+ * Returned Value:
+ *   The first matching entry in the chain order, or NULL if none matches.
+ *
+ ****************************************************************************/
+
+FAR const struct ipfilter_entry_s *
+ipfilter_compiled_match(FAR const struct ipfilter_compiled_s *compiled,
+                        FAR const struct ipfilter_packet_s *pkt);
+#endif
+
 /****************************************************************************
  * Name: ipv4_filter_in / ipv6_filter_in
  *
@@ -0,0 +1,603 @@
+/****************************************************************************
+ * net/ipfilter/ipfilter_compile.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <debug.h>
+
+#include <nuttx/hashtable.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/lib/math32.h>
+#include <nuttx/net/udp.h>
+
+#include "ipfilter/ipfilter.h"
+
+#ifdef CONFIG_NET_IPFILTER_COMPILE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The longest prefix of an address, in bits */
+
+#define IPFILTER_MAXPLEN   128
+
+/* The keys an entry may be hashed by */
+
+#define IPFILTER_KEY_PORT  1  /* Protocol and destination port */
+#define IPFILTER_KEY_DST   2  /* Destination address prefix */
+#define IPFILTER_KEY_SRC   3  /* Source address prefix */
+
+/* Limit the hash table to 64K buckets */
+
+#define IPFILTER_MAXBITS   16
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A chain compiled into lookup tables.
+ *
+ * Each entry of the chain is put into exactly one list: a hash bucket if
+ * it can only match packets with one exact protocol and destination port,
+ * or with one prefix of the destination or the source address, or else the
+ * list of entries that match any packet.  A packet probes the bucket of
+ * its port and the buckets of its addresses for each prefix length used by
+ * the chain.  The lists keep the order of the chain, so the first matching
+ * entry of each list is a candidate and the first of the candidates is the
+ * same entry the linear walk over the chain would find.
+ */
+
+struct ipfilter_compiled_s
+{
+  sa_family_t family;     /* The address family of the chain */
+  uint8_t     nbits;      /* The hash table has (1 << nbits) buckets */
+  bool        port;       /* Entries are hashed by the port */
+  uint8_t     ndstlen;    /* The number of destination prefix lengths */
+  uint8_t     nsrclen;    /* The number of source prefix lengths */
+
+  /* The prefix lengths entries are hashed by */
+
+  uint8_t     dstlen[IPFILTER_MAXPLEN + 1];
+  uint8_t     srclen[IPFILTER_MAXPLEN + 1];
+
+  sq_queue_t  any;        /* The entries that are not hashed */
+  sq_queue_t  buckets[1]; /* The hash table, actual size (1 << nbits) */
+};
+
+/* How an entry is put into the compiled chain */
+
+struct ipfilter_class_s
+{
+  uint8_t key;            /* IPFILTER_KEY_*, or 0 if not hashed */
+  uint8_t plen;           /* The prefix length of an address key */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ipfilter_prefixlen
+ *
+ * Description:
+ *   Return the prefix length of a netmask in network byte order, or -1 if
+ *   the netmask is not contiguous.
+ *
+ ****************************************************************************/
+
+static int ipfilter_prefixlen(FAR const void *mask, int len)
+{
+  FAR const uint8_t *bytes = mask;
+  int plen = 0;
+  int i;
+
+  for (i = 0; i < len && bytes[i] == 0xff; i++)
+    {
+      plen += 8;
+    }
+
+  if (i < len)
+    {
+      uint8_t byte = bytes[i++];
+
+      while (byte & 0x80)
+        {
+          byte <<= 1;
+          plen++;
+        }
+
+      if (byte != 0)
+        {
+          return -1;
+        }
+
+      for (; i < len; i++)
+        {
+          if (bytes[i] != 0)
+            {
+              return -1;
+            }
+        }
+    }
+
+  return plen;
+}
+
+/****************************************************************************
+ * Name: ipfilter_addrkey
+ *
+ * Description:
+ *   Return the hash key of an address prefix in network byte order.
+ *
+ ****************************************************************************/
+
+static uint32_t ipfilter_addrkey(uint8_t key, FAR const void *addr,
+                                 int plen)
+{
+  FAR const uint8_t *bytes = addr;
+  uint32_t hash = ((uint32_t)key << 8) | plen;
+
+  for (; plen >= 8; plen -= 8)
+    {
+      hash = hash * 31 + *bytes++;
+    }
+
+  if (plen > 0)
+    {
+      hash = hash * 31 + (*bytes & (0xff << (8 - plen)));
+    }
+
+  return hash;
+}
+
+/****************************************************************************
+ * Name: ipfilter_portkey
+ *
+ * Description:
+ *   Return the hash key of a protocol and destination port.
+ *
+ ****************************************************************************/
+
+static inline uint32_t ipfilter_portkey(uint8_t proto, uint16_t port)
+{
+  return ((uint32_t)IPFILTER_KEY_PORT << 24) | ((uint32_t)proto << 16) |
+         port;
+}
+
+/****************************************************************************
+ * Name: ipfilter_bucket
+ *
+ * Description:
+ *   Return the hash bucket of a key.
+ *
+ ****************************************************************************/
+
+static inline FAR sq_queue_t *
+ipfilter_bucket(FAR const struct ipfilter_compiled_s *compiled,
+                uint32_t key)
+{
+  return (FAR sq_queue_t *)&compiled->buckets[HASH(key, compiled->nbits)];
+}
+
+/****************************************************************************
+ * Name: ipfilter_classify
+ *
+ * Description:
+ *   Choose the key to hash an entry by.  A full host address is preferred,
+ *   then the port, then the longer address prefix.
+ *
+ ****************************************************************************/
+
+static void ipfilter_classify(sa_family_t family,
+                              FAR const struct ipfilter_entry_s *entry,
+                              FAR struct ipfilter_class_s *cls)
+{
+  FAR const void *dmsk = NULL;
+  FAR const void *smsk = NULL;
+  int maxplen = 0;
+  int dlen = -1;
+  int slen = -1;
+
+#ifdef CONFIG_NET_IPv4
+  if (family == PF_INET)
+    {
+      FAR const struct ipv4_filter_entry_s *filter =
+        (FAR const struct ipv4_filter_entry_s *)entry;
+
+      dmsk    = &filter->dmsk;
+      smsk    = &filter->smsk;
+      maxplen = 32;
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  if (family == PF_INET6)
+    {
+      FAR const struct ipv6_filter_entry_s *filter =
+        (FAR const struct ipv6_filter_entry_s *)entry;
+
+      dmsk    = filter->dmsk;
+      smsk    = filter->smsk;
+      maxplen = 128;
+    }
+#endif
+
+  /* An inverted address matches packets outside of the prefix, so it can
+   * not be used as a key.
+   */
+
+  if (dmsk != NULL && !entry->inv_dstip)
+    {
+      dlen = ipfilter_prefixlen(dmsk, maxplen / 8);
+    }
+
+  if (smsk != NULL && !entry->inv_srcip)
+    {
+      slen = ipfilter_prefixlen(smsk, maxplen / 8);
+    }
+
+  if (dlen == maxplen)
+    {
+      cls->key  = IPFILTER_KEY_DST;
+      cls->plen = dlen;
+    }
+  else if (slen == maxplen)
+    {
+      cls->key  = IPFILTER_KEY_SRC;
+      cls->plen = slen;
+    }
+  else if ((entry->proto == IP_PROTO_TCP || entry->proto == IP_PROTO_UDP) &&
+           !entry->inv_proto && entry->match_tcpudp && !entry->inv_dport &&
+           entry->match.tcpudp.dports[0] == entry->match.tcpudp.dports[1])
+    {
+      cls->key  = IPFILTER_KEY_PORT;
+      cls->plen = 0;
+    }
+  else if (dlen > 0 && dlen >= slen)
+    {
+      cls->key  = IPFILTER_KEY_DST;
+      cls->plen = dlen;
+    }
+  else if (slen > 0)
+    {
+      cls->key  = IPFILTER_KEY_SRC;
+      cls->plen = slen;
+    }
+  else
+    {
+      cls->key  = 0;
+      cls->plen = 0;
+    }
+}
+
+/****************************************************************************
+ * Name: ipfilter_entry_key
+ *
+ * Description:
+ *   Return the hash key of an entry by its class.
+ *
+ ****************************************************************************/
+
+static uint32_t ipfilter_entry_key(sa_family_t family,
+                                   FAR const struct ipfilter_entry_s *entry,
+                                   FAR const struct ipfilter_class_s *cls)
+{
+  FAR const void *addr = NULL;
+
+  if (cls->key == IPFILTER_KEY_PORT)
+    {
+      return ipfilter_portkey(entry->proto, entry->match.tcpudp.dports[0]);
+    }
+
+#ifdef CONFIG_NET_IPv4
+  if (family == PF_INET)
+    {
+      FAR const struct ipv4_filter_entry_s *filter =
+        (FAR const struct ipv4_filter_entry_s *)entry;
+
+      addr = cls->key == IPFILTER_KEY_DST ? &filter->dip : &filter->sip;
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  if (family == PF_INET6)
+    {
+      FAR const struct ipv6_filter_entry_s *filter =
+        (FAR const struct ipv6_filter_entry_s *)entry;
+
+      addr = cls->key == IPFILTER_KEY_DST ? filter->dip : filter->sip;
+    }
+#endif
+
+  return ipfilter_addrkey(cls->key, addr, cls->plen);
+}
+
+/****************************************************************************
+ * Name: ipfilter_addplen
+ *
+ * Description:
+ *   Add a prefix length to a list of prefix lengths, if it is not there.
+ *
+ ****************************************************************************/
+
+static void ipfilter_addplen(FAR uint8_t *list, FAR uint8_t *nlist,
+                             uint8_t plen)
+{
+  int i;
+
+  for (i = 0; i < *nlist; i++)
+    {
+      if (list[i] == plen)
+        {
+          return;
+        }
+    }
+
+  list[(*nlist)++] = plen;
+}
+
+/****************************************************************************
+ * Name: ipfilter_probe
+ *
+ * Description:
+ *   Find the first entry of a list that matches the packet, if it comes
+ *   before the best entry found so far.
+ *
+ ****************************************************************************/
+
+static void
+ipfilter_probe(FAR const sq_queue_t *list,
+               FAR const struct ipfilter_packet_s *pkt,
+               CODE bool (*match)(FAR const struct ipfilter_entry_s *,
+                                  FAR const struct ipfilter_packet_s *),
+               FAR const struct ipfilter_entry_s **best)
+{
+  FAR const struct ipfilter_entry_s *entry;
+  FAR sq_entry_t *node;
+
+  sq_for_every(list, node)
+    {
+      entry = container_of(node, struct ipfilter_entry_s, node);
+      if (*best != NULL && entry->index >= (*best)->index)
+        {
+          break;
+        }
+
+      if (match(entry, pkt))
+        {
+          *best = entry;
+          break;
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ipfilter_compile
+ *
+ * Description:
+ *   Compile a chain of filter entries into lookup tables.  The entries are
+ *   only referenced, the chain must not change while the compiled chain is
+ *   in use.
+ *
+ * Input Parameters:
+ *   family - The address family of the entries
+ *   chain  - The chain of filter entries, in the order they are matched
+ *
+ * Returned Value:
+ *   The compiled chain, or NULL if there is not enough memory.
+ *
+ ****************************************************************************/
+
+FAR struct ipfilter_compiled_s *ipfilter_compile(sa_family_t family,
+                                                 FAR sq_queue_t *chain)
+{
+  FAR struct ipfilter_compiled_s *compiled;
+  FAR struct ipfilter_entry_s *entry;
+  struct ipfilter_class_s cls;
+  FAR sq_entry_t *node;
+  unsigned int nhashed = 0;
+  unsigned int index = 0;
+  uint8_t nbits;
+
+  /* Count the entries to be hashed to size the hash table */
+
+  sq_for_every(chain, node)
+    {
+      ipfilter_classify(family, (FAR struct ipfilter_entry_s *)node, &cls);
+      if (cls.key != 0)
+        {
+          nhashed++;
+        }
+    }
+
+  nbits = nhashed > 1 ? log2ceil(nhashed) : 1;
+  if (nbits > IPFILTER_MAXBITS)
+    {
+      nbits = IPFILTER_MAXBITS;
+    }
+
+  compiled = kmm_zalloc(sizeof(struct ipfilter_compiled_s) +
+                        (((size_t)1 << nbits) - 1) * sizeof(sq_queue_t));
+  if (compiled == NULL)
+    {
+      return NULL;
+    }
+
+  compiled->family = family;
+  compiled->nbits  = nbits;
+
+  /* Put each entry into its list, in the order of the chain */
+
+  sq_for_every(chain, node)
+    {
+      entry = (FAR struct ipfilter_entry_s *)node;
+      entry->index = index++;
+
+      ipfilter_classify(family, entry, &cls);
+      switch (cls.key)
+        {
+          case IPFILTER_KEY_PORT:
+            compiled->port = true;
+            break;
+
+          case IPFILTER_KEY_DST:
+            ipfilter_addplen(compiled->dstlen, &compiled->ndstlen,
+                             cls.plen);
+            break;
+
+          case IPFILTER_KEY_SRC:
+            ipfilter_addplen(compiled->srclen, &compiled->nsrclen,
+                             cls.plen);
+            break;
+
+          default:
+            sq_addlast(&entry->node, &compiled->any);
+            continue;
+        }
+
+      sq_addlast(&entry->node,
+                 ipfilter_bucket(compiled,
+                                 ipfilter_entry_key(family, entry, &cls)));
+    }
+
+  ninfo("Compiled %u entries, %u hashed, %u+%u prefix lengths\n",
+        index, nhashed, compiled->ndstlen, compiled->nsrclen);
+
+  return compiled;
+}
+
+/****************************************************************************
+ * Name: ipfilter_compiled_free
+ *
+ * Description:
+ *   Free a compiled chain.  The filter entries are not freed.
+ *
+ ****************************************************************************/
+
+void ipfilter_compiled_free(FAR struct ipfilter_compiled_s *compiled)
+{
+  kmm_free(compiled);
+}
+
+/****************************************************************************
+ * Name: ipfilter_compiled_match
+ *
+ * Description:
+ *   Find the first entry of a compiled chain that matches a packet.
+ *
+ * Input Parameters:
+ *   compiled - The compiled chain
+ *   pkt      - The packet to match
+ *
+ * Returned Value:
+ *   The first matching entry in the chain order, or NULL if none matches.
+ *
+ ****************************************************************************/
+
+FAR const struct ipfilter_entry_s *
+ipfilter_compiled_match(FAR const struct ipfilter_compiled_s *compiled,
+                        FAR const struct ipfilter_packet_s *pkt)
+{
+  CODE bool (*match)(FAR const struct ipfilter_entry_s *,
+                     FAR const struct ipfilter_packet_s *) = NULL;
+  FAR const struct ipfilter_entry_s *best = NULL;
+  FAR const void *dstaddr = NULL;
+  FAR const void *srcaddr = NULL;
+  int i;
+
+#ifdef CONFIG_NET_IPv4
+  if (compiled->family == PF_INET)
+    {
+      FAR const struct ipv4_hdr_s *ipv4 = pkt->iphdr;
+
+      match   = ipv4_filter_entry_match;
+      dstaddr = ipv4->destipaddr;
+      srcaddr = ipv4->srcipaddr;
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  if (compiled->family == PF_INET6)
+    {
+      FAR const struct ipv6_hdr_s *ipv6 = pkt->iphdr;
+
+      match   = ipv6_filter_entry_match;
+      dstaddr = ipv6->destipaddr;
+      srcaddr = ipv6->srcipaddr;
+    }
+#endif
+
+  if (match == NULL)
+    {
+      return NULL;
+    }
+
+  /* The entries that match any packet come usually last, the default of
+   * the chain at least, so probe the hashed entries first to find the best
+   * candidate as early as possible.
+   */
+
+  if (compiled->port &&
+      (pkt->proto == IP_PROTO_TCP || pkt->proto == IP_PROTO_UDP))
+    {
+      /* Ports in TCP & UDP headers have same offset. */
+
+      FAR const struct udp_hdr_s *udp = pkt->l4hdr;
+
+      ipfilter_probe(ipfilter_bucket(compiled,
+                                     ipfilter_portkey(pkt->proto,
+                                                      NTOHS(udp->destport))),
+                     pkt, match, &best);
+    }
+
+  for (i = 0; i < compiled->ndstlen; i++)
+    {
+      ipfilter_probe(ipfilter_bucket(compiled,
+                                     ipfilter_addrkey(IPFILTER_KEY_DST,
+                                                      dstaddr,
+                                                      compiled->dstlen[i])),
+                     pkt, match, &best);
+    }
+
+  for (i = 0; i < compiled->nsrclen; i++)
+    {
+      ipfilter_probe(ipfilter_bucket(compiled,
+                                     ipfilter_addrkey(IPFILTER_KEY_SRC,
+                                                      srcaddr,
+                                                      compiled->srclen[i])),
+                     pkt, match, &best);
+    }
+
+  ipfilter_probe(&compiled->any, pkt, match, &best);
+  return best;
+}
+
+#endif /* CONFIG_NET_IPFILTER_COMPILE */
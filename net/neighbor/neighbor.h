@@ -31,6 +31,8 @@
 
 #include <net/ethernet.h>
 
+#include <nuttx/clock.h>
+#include <nuttx/hashtable.h>
 #include <nuttx/net/ip.h>
 #include <nuttx/net/netdev.h>
 #include <nuttx/net/sixlowpan.h>
@@ -38,15 +40,100 @@
 
 #ifdef CONFIG_NET_IPv6
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_NET_IPv6_NCONF_ALLOC_ENTRIES
+#  define CONFIG_NET_IPv6_NCONF_ALLOC_ENTRIES 0
+#endif
+
+#ifndef CONFIG_NET_IPv6_NCONF_MAX_ENTRIES
+#  define CONFIG_NET_IPv6_NCONF_MAX_ENTRIES 0
+#endif
+
+#ifndef CONFIG_NET_IPv6_NCONF_HASH_BITS
+#  define CONFIG_NET_IPv6_NCONF_HASH_BITS 3
+#endif
+
+#ifndef CONFIG_NET_IPv6_NCONF_MAXAGE
+#  define CONFIG_NET_IPv6_NCONF_MAXAGE 0
+#endif
+
+/* Check if a Neighbor table entry is too old to be used */
+
+#if CONFIG_NET_IPv6_NCONF_MAXAGE > 0
+#  define NEIGHBOR_MAXAGE_TICK SEC2TICK(CONFIG_NET_IPv6_NCONF_MAXAGE)
+#  define NEIGHBOR_EXPIRED(e, now) \
+     ((clock_t)((now) - (e)->ne_time) > NEIGHBOR_MAXAGE_TICK)
+#else
+#  define NEIGHBOR_EXPIRED(e, now) false
+#endif
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* One node of the Neighbor table.  The entry itself is what is reported to
+ * the user, the rest is only needed to find it.
+ */
+
+struct neighbor_node_s
+{
+  hash_node_t             nn_node;   /* Entry in the Neighbor hash table */
+  dq_entry_t              nn_lru;    /* Entry in the LRU list */
+  struct neighbor_entry_s nn_entry;  /* The Neighbor table entry */
+};
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
 
-/* This is the Neighbor table.  The network should be locked when accessing
- * this table.
+/* This is the Neighbor table, hashed by the IPv6 address and with all of
+ * the entries ordered by their last usage, the most recently used first.
+ * The network should be locked when accessing this table.
  */
 
-extern struct neighbor_entry_s g_neighbors[CONFIG_NET_IPv6_NCONF_ENTRIES];
+extern DECLARE_HASHTABLE(g_neighbor_hash, CONFIG_NET_IPv6_NCONF_HASH_BITS);
+extern dq_queue_t g_neighbor_lru;
+extern unsigned int g_neighbor_count;
+
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: neighbor_hashkey
+ *
+ * Description:
+ *   Return the hash key of an IPv6 address in the Neighbor table.
+ *
+ ****************************************************************************/
+
+static inline uint32_t neighbor_hashkey(const net_ipv6addr_t ipaddr)
+{
+  /* The address may be only 16-bit aligned in a packet */
+
+  return ((uint32_t)(ipaddr[0] ^ ipaddr[2] ^ ipaddr[4] ^ ipaddr[6]) << 16) |
+         (ipaddr[1] ^ ipaddr[3] ^ ipaddr[5] ^ ipaddr[7]);
+}
+
+/****************************************************************************
+ * Name: neighbor_touch
+ *
+ * Description:
+ *   Make a Neighbor table entry the most recently used one.
+ *
+ ****************************************************************************/
+
+static inline void neighbor_touch(FAR struct neighbor_entry_s *neighbor)
+{
+  FAR struct neighbor_node_s *node =
+    container_of(neighbor, struct neighbor_node_s, nn_entry);
+
+  dq_rem(&node->nn_lru, &g_neighbor_lru);
+  dq_addfirst(&node->nn_lru, &g_neighbor_lru);
+}
 
 /****************************************************************************
  * Public Function Prototypes
@@ -188,6 +275,19 @@ unsigned int neighbor_snapshot(FAR struct neighbor_entry_s *snapshot,
                                unsigned int nentries);
 #endif
 
+/****************************************************************************
+ * Name: neighbor_count
+ *
+ * Description:
+ *   Return the number of entries currently in the Neighbor table.
+ *
+ * Assumptions
+ *   The network is locked to assure exclusive access to the Neighbor table
+ *
+ ****************************************************************************/
+
+unsigned int neighbor_count(void);
+
 /****************************************************************************
  * Name: neighbor_dumpentry
  *
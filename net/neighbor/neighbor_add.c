@@ -39,8 +39,59 @@
 
 #include "netdev/netdev.h"
 #include "netlink/netlink.h"
+#include "utils/utils.h"
 #include "neighbor/neighbor.h"
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The pool of Neighbor table entries */
+
+NET_BUFPOOL_DECLARE(g_neighbor_entries, sizeof(struct neighbor_node_s),
+                    CONFIG_NET_IPv6_NCONF_ENTRIES,
+                    CONFIG_NET_IPv6_NCONF_ALLOC_ENTRIES,
+                    CONFIG_NET_IPv6_NCONF_MAX_ENTRIES);
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: neighbor_alloc
+ *
+ * Description:
+ *   Get an unused node for the Neighbor table.  An expired node at the end
+ *   of the LRU list is reused first so that the table does not grow with
+ *   stale mappings, then a new node is allocated from the pool.  If the
+ *   pool is exhausted, the least recently used node is evicted.
+ *
+ * Returned Value:
+ *   The node, still linked in the table if it was reused, or NULL if the
+ *   table has no nodes at all.
+ *
+ ****************************************************************************/
+
+static FAR struct neighbor_node_s *neighbor_alloc(void)
+{
+  FAR struct neighbor_node_s *oldest = NULL;
+  FAR struct neighbor_node_s *node;
+  FAR dq_entry_t *lru;
+
+  lru = dq_tail(&g_neighbor_lru);
+  if (lru != NULL)
+    {
+      oldest = container_of(lru, struct neighbor_node_s, nn_lru);
+      if (NEIGHBOR_EXPIRED(&oldest->nn_entry, clock_systime_ticks()))
+        {
+          return oldest;
+        }
+    }
+
+  node = NET_BUFPOOL_TRYALLOC(g_neighbor_entries);
+  return node != NULL ? node : oldest;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -65,78 +116,92 @@
 void neighbor_add(FAR struct net_driver_s *dev, FAR net_ipv6addr_t ipaddr,
                   FAR uint8_t *addr)
 {
+  FAR struct neighbor_entry_s *neighbor;
+  FAR struct neighbor_node_s *node = NULL;
+  FAR hash_node_t *hnode;
   uint8_t lltype;
-  clock_t oldest_time;
-  int     oldest_ndx;
+  uint32_t key;
   bool    found = false;
   bool    new_entry;
-  int     i;
 
   DEBUGASSERT(dev != NULL && addr != NULL);
 
-  /* Find the matching entry, first unused entry, or the oldest used entry.
-   * The unused entry will have ne_time == 0 and should generate the oldest
-   * time.  REVISIT:  Could this fail on clock wraparound?  A more explicit
-   * check might be to compare ne_ipaddr with the IPv6 unspecified address.
-   */
+  /* Find the matching entry */
 
-  oldest_time = g_neighbors[0].ne_time;
-  oldest_ndx  = 0;
-  lltype      = dev->d_lltype;
+  lltype = dev->d_lltype;
+  key    = neighbor_hashkey(ipaddr);
 
-  for (i = 0; i < CONFIG_NET_IPv6_NCONF_ENTRIES; ++i)
+  hashtable_for_every_possible(g_neighbor_hash, hnode, key)
     {
-      if (g_neighbors[i].ne_addr.na_lltype == lltype &&
-          net_ipv6addr_cmp(g_neighbors[i].ne_ipaddr, ipaddr))
+      node = container_of(hnode, struct neighbor_node_s, nn_node);
+      if (node->nn_entry.ne_addr.na_lltype == lltype &&
+          net_ipv6addr_cmp(node->nn_entry.ne_ipaddr, ipaddr))
         {
-          oldest_ndx = i;
           found = true;
           break;
         }
+    }
+
+  /* Otherwise get a free entry, or the oldest used entry */
 
-      if ((int)(g_neighbors[i].ne_time - oldest_time) < 0)
+  if (!found)
+    {
+      node = neighbor_alloc();
+      if (node == NULL)
         {
-          oldest_ndx = i;
-          oldest_time = g_neighbors[i].ne_time;
+          nerr("ERROR: No free Neighbor table entry\n");
+          return;
         }
-    }
 
-  /* When overwrite old entry, need to notify RTM_DELNEIGH */
+      /* When overwrite old entry, need to notify RTM_DELNEIGH */
 
-  if (!found && g_neighbors[oldest_ndx].ne_time != 0)
-    {
-      netlink_neigh_notify(&g_neighbors[oldest_ndx], RTM_DELNEIGH,
-                           AF_INET6);
+      if (node->nn_entry.ne_dev != NULL)
+        {
+          netlink_neigh_notify(&node->nn_entry, RTM_DELNEIGH, AF_INET6);
+
+          hashtable_delete(g_neighbor_hash, &node->nn_node,
+                           neighbor_hashkey(node->nn_entry.ne_ipaddr));
+          dq_rem(&node->nn_lru, &g_neighbor_lru);
+          g_neighbor_count--;
+        }
     }
 
+  neighbor = &node->nn_entry;
+
   /* Need to notify when entry is not found or changes in table */
 
-  new_entry = !found || memcmp(&g_neighbors[oldest_ndx].ne_addr.u, addr,
-                             g_neighbors[oldest_ndx].ne_addr.na_llsize) != 0;
+  new_entry = !found || memcmp(&neighbor->ne_addr.u, addr,
+                               neighbor->ne_addr.na_llsize) != 0;
+
+  if (found)
+    {
+      dq_rem(&node->nn_lru, &g_neighbor_lru);
+    }
+  else
+    {
+      net_ipv6addr_copy(neighbor->ne_ipaddr, ipaddr);
+      hashtable_add(g_neighbor_hash, &node->nn_node, key);
+      g_neighbor_count++;
+    }
 
-  /* Use the oldest or first free entry (either pointed to by the
-   * "oldest_ndx" variable).
-   */
+  dq_addfirst(&node->nn_lru, &g_neighbor_lru);
 
-  g_neighbors[oldest_ndx].ne_dev  = dev;
-  g_neighbors[oldest_ndx].ne_time = clock_systime_ticks();
-  net_ipv6addr_copy(g_neighbors[oldest_ndx].ne_ipaddr, ipaddr);
+  neighbor->ne_dev  = dev;
+  neighbor->ne_time = clock_systime_ticks();
 
-  g_neighbors[oldest_ndx].ne_addr.na_lltype = lltype;
-  g_neighbors[oldest_ndx].ne_addr.na_llsize = netdev_lladdrsize(dev);
+  neighbor->ne_addr.na_lltype = lltype;
+  neighbor->ne_addr.na_llsize = netdev_lladdrsize(dev);
 
-  memcpy(&g_neighbors[oldest_ndx].ne_addr.u, addr,
-         g_neighbors[oldest_ndx].ne_addr.na_llsize);
+  memcpy(&neighbor->ne_addr.u, addr, neighbor->ne_addr.na_llsize);
 
   /* Notify the new entry */
 
   if (new_entry)
     {
-      netlink_neigh_notify(&g_neighbors[oldest_ndx], RTM_NEWNEIGH,
-                           AF_INET6);
+      netlink_neigh_notify(neighbor, RTM_NEWNEIGH, AF_INET6);
     }
 
   /* Dump the contents of the new entry */
 
-  neighbor_dumpentry("Added entry", &g_neighbors[oldest_ndx]);
+  neighbor_dumpentry("Added entry", neighbor);
 }
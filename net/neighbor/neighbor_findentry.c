@@ -53,11 +53,13 @@
 
 FAR struct neighbor_entry_s *neighbor_findentry(const net_ipv6addr_t ipaddr)
 {
-  int i;
+  FAR hash_node_t *node;
 
-  for (i = 0; i < CONFIG_NET_IPv6_NCONF_ENTRIES; ++i)
+  hashtable_for_every_possible(g_neighbor_hash, node,
+                               neighbor_hashkey(ipaddr))
     {
-      FAR struct neighbor_entry_s *neighbor = &g_neighbors[i];
+      FAR struct neighbor_entry_s *neighbor =
+        &container_of(node, struct neighbor_node_s, nn_node)->nn_entry;
 
       if (net_ipv6addr_cmp(neighbor->ne_ipaddr, ipaddr))
         {
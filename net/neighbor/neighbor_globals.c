@@ -32,12 +32,31 @@
  * Public Data
  ****************************************************************************/
 
-/* This is the Neighbor table.  The network should be locked when accessing
- * this table.
+/* This is the Neighbor table, hashed by the IPv6 address and with all of
+ * the entries ordered by their last usage, the most recently used first.
+ * The network should be locked when accessing this table.
  */
 
-struct neighbor_entry_s g_neighbors[CONFIG_NET_IPv6_NCONF_ENTRIES];
+DECLARE_HASHTABLE(g_neighbor_hash, CONFIG_NET_IPv6_NCONF_HASH_BITS);
+dq_queue_t g_neighbor_lru;
+unsigned int g_neighbor_count;
 
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
+
+/****************************************************************************
+ * Name: neighbor_count
+ *
+ * Description:
+ *   Return the number of entries currently in the Neighbor table.
+ *
+ * Assumptions
+ *   The network is locked to assure exclusive access to the Neighbor table
+ *
+ ****************************************************************************/
+
+unsigned int neighbor_count(void)
+{
+  return g_neighbor_count;
+}
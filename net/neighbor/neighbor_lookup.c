@@ -121,8 +121,12 @@ int neighbor_lookup(FAR const net_ipv6addr_t ipaddr,
   /* Check if the IPv6 address is already in the neighbor table. */
 
   neighbor = neighbor_findentry(ipaddr);
-  if (neighbor != NULL)
+  if (neighbor != NULL && !NEIGHBOR_EXPIRED(neighbor, clock_systime_ticks()))
     {
+      /* Keep the entry away from eviction while it is in use */
+
+      neighbor_touch(neighbor);
+
       /* Yes.. return the link layer address if the caller has provided a
        * non-NULL address in 'laddr'.
        */
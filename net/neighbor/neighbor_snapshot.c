@@ -31,7 +31,6 @@
 
 #include <nuttx/net/ip.h>
 
-#include "inet/inet.h"
 #include "neighbor/neighbor.h"
 
 #ifdef CONFIG_NETLINK_ROUTE
@@ -63,23 +62,22 @@
 unsigned int neighbor_snapshot(FAR struct neighbor_entry_s *snapshot,
                                unsigned int nentries)
 {
-  unsigned int ncopied;
-  int i;
+  FAR dq_entry_t *node;
+  unsigned int ncopied = 0;
 
-  /* Copy all non-empty entries in the Neighbor table. */
+  /* Copy all non-expired entries in the Neighbor table. */
 
-  for (i = 0, ncopied = 0;
-       nentries > ncopied && i < CONFIG_NET_IPv6_NCONF_ENTRIES;
-       i++)
+  dq_for_every(&g_neighbor_lru, node)
     {
-      FAR struct neighbor_entry_s *neighbor = &g_neighbors[i];
+      FAR struct neighbor_entry_s *neighbor =
+        &container_of(node, struct neighbor_node_s, nn_lru)->nn_entry;
 
-      /* An unused entry table entry will be nullified.  In particularly,
-       * the Neighbor IP address will be all zero (i.e., the unspecified
-       * IPv6 address).
-       */
+      if (ncopied >= nentries)
+        {
+          break;
+        }
 
-      if (!net_ipv6addr_cmp(neighbor->ne_ipaddr, g_ipv6_unspecaddr))
+      if (!NEIGHBOR_EXPIRED(neighbor, clock_systime_ticks()))
         {
           memcpy(&snapshot[ncopied], neighbor,
                  sizeof(struct neighbor_entry_s));
@@ -400,6 +400,10 @@ static void adjust_ipv4filter(FAR const struct ipt_replace *repl)
               nwarn("WARNING: Failed to convert entry!\n");
             }
         }
+
+      /* Compile the chain now that it is complete. */
+
+      ipfilter_cfg_commit(PF_INET, chain);
     }
 }
 #endif
@@ -441,6 +445,10 @@ static void adjust_ipv6filter(FAR const struct ip6t_replace *repl)
               nwarn("WARNING: Failed to convert entry!\n");
             }
         }
+
+      /* Compile the chain now that it is complete. */
+
+      ipfilter_cfg_commit(PF_INET6, chain);
     }
 }
 #endif
@@ -61,7 +61,7 @@
  * Private Types
  ****************************************************************************/
 
-#ifdef CONFIG_NET_IPv4
+#if defined(CONFIG_NET_IPv4) && !defined(CONFIG_ROUTE_IPv4_TRIEROUTE)
 struct route_ipv4_match_s
 {
   in_addr_t target;              /* Target IPv4 address on remote network */
@@ -81,7 +81,7 @@ struct route_ipv4_match_s
 };
 #endif
 
-#ifdef CONFIG_NET_IPv6
+#if defined(CONFIG_NET_IPv6) && !defined(CONFIG_ROUTE_IPv6_TRIEROUTE)
 struct route_ipv6_match_s
 {
   net_ipv6addr_t target;         /* Target IPv6 address on remote network */
@@ -120,7 +120,7 @@ struct route_ipv6_match_s
  *
  ****************************************************************************/
 
-#ifdef CONFIG_NET_IPv4
+#if defined(CONFIG_NET_IPv4) && !defined(CONFIG_ROUTE_IPv4_TRIEROUTE)
 static int net_ipv4_match(FAR struct net_route_ipv4_s *route, FAR void *arg)
 {
   FAR struct route_ipv4_match_s *match =
@@ -160,7 +160,7 @@ static int net_ipv4_match(FAR struct net_route_ipv4_s *route, FAR void *arg)
 
   return 0;
 }
-#endif /* CONFIG_NET_IPv4 */
+#endif /* CONFIG_NET_IPv4 && !CONFIG_ROUTE_IPv4_TRIEROUTE */
 
 /****************************************************************************
  * Name: net_ipv6_match
@@ -177,7 +177,7 @@ static int net_ipv4_match(FAR struct net_route_ipv4_s *route, FAR void *arg)
  *
  ****************************************************************************/
 
-#ifdef CONFIG_NET_IPv6
+#if defined(CONFIG_NET_IPv6) && !defined(CONFIG_ROUTE_IPv6_TRIEROUTE)
 static int net_ipv6_match(FAR struct net_route_ipv6_s *route, FAR void *arg)
 {
   FAR struct route_ipv6_match_s *match =
@@ -217,7 +217,7 @@ static int net_ipv6_match(FAR struct net_route_ipv6_s *route, FAR void *arg)
 
   return 0;
 }
-#endif /* CONFIG_NET_IPv6 */
+#endif /* CONFIG_NET_IPv6 && !CONFIG_ROUTE_IPv6_TRIEROUTE */
 
 /****************************************************************************
  * Public Functions
@@ -243,7 +243,7 @@ static int net_ipv6_match(FAR struct net_route_ipv6_s *route, FAR void *arg)
  *
  ****************************************************************************/
 
-#ifdef CONFIG_NET_IPv4
+#if defined(CONFIG_NET_IPv4) && !defined(CONFIG_ROUTE_IPv4_TRIEROUTE)
 int net_ipv4_router(in_addr_t target, FAR in_addr_t *router,
                     int8_t prefixlen)
 {
@@ -315,7 +315,7 @@ int net_ipv4_router(in_addr_t target, FAR in_addr_t *router,
   net_ipv4addr_copy(*router, match.IPv4_ROUTER);
   return OK;
 }
-#endif /* CONFIG_NET_IPv4 */
+#endif /* CONFIG_NET_IPv4 && !CONFIG_ROUTE_IPv4_TRIEROUTE */
 
 /****************************************************************************
  * Name: net_ipv6_router
@@ -337,7 +337,7 @@ int net_ipv4_router(in_addr_t target, FAR in_addr_t *router,
  *
  ****************************************************************************/
 
-#ifdef CONFIG_NET_IPv6
+#if defined(CONFIG_NET_IPv6) && !defined(CONFIG_ROUTE_IPv6_TRIEROUTE)
 int net_ipv6_router(const net_ipv6addr_t target, net_ipv6addr_t router,
                     int16_t prefixlen)
 {
@@ -409,6 +409,6 @@ int net_ipv6_router(const net_ipv6addr_t target, net_ipv6addr_t router,
   net_ipv6addr_copy(router, match.IPv6_ROUTER);
   return OK;
 }
-#endif /* CONFIG_NET_IPv6 */
+#endif /* CONFIG_NET_IPv6 && !CONFIG_ROUTE_IPv6_TRIEROUTE */
 
 #endif /* CONFIG_NET && CONFIG_NET_ROUTE */
@@ -0,0 +1,1002 @@
+/****************************************************************************
+ * net/route/net_trieroute.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <netinet/in.h>
+
+#include <nuttx/atomic.h>
+#include <nuttx/mutex.h>
+#include <nuttx/net/ip.h>
+#include <nuttx/spinlock.h>
+
+#include "netlink/netlink.h"
+#include "route/route.h"
+#include "utils/utils.h"
+
+#if defined(CONFIG_ROUTE_IPv4_TRIEROUTE) || \
+    defined(CONFIG_ROUTE_IPv6_TRIEROUTE)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Configuration ************************************************************/
+
+#ifndef CONFIG_ROUTE_MAX_IPv4_TRIENODES
+#  define CONFIG_ROUTE_MAX_IPv4_TRIENODES 8
+#endif
+
+#ifndef CONFIG_ROUTE_ALLOC_IPv4_TRIENODES
+#  define CONFIG_ROUTE_ALLOC_IPv4_TRIENODES 8
+#endif
+
+#ifndef CONFIG_ROUTE_MAX_IPv6_TRIENODES
+#  define CONFIG_ROUTE_MAX_IPv6_TRIENODES 8
+#endif
+
+#ifndef CONFIG_ROUTE_ALLOC_IPv6_TRIENODES
+#  define CONFIG_ROUTE_ALLOC_IPv6_TRIENODES 8
+#endif
+
+/* Each node is followed by a struct net_route_ipv4_s or net_route_ipv6_s.
+ * The target address comes first in both, so it doubles as the key of the
+ * node; only the first plen bits of the key are significant.
+ */
+
+#define TRIEROUTE_ENTRY(n)  ((FAR void *)((n) + 1))
+#define TRIEROUTE_KEY(n)    ((FAR uint8_t *)((n) + 1))
+#define TRIEROUTE_BIT(k, i) (((k)[(i) >> 3] >> (7 - ((i) & 7))) & 1)
+
+/* Nodes are published to and read by lock-free readers through these, so
+ * that every pointer is loaded and stored exactly once.
+ */
+
+#define TRIEROUTE_LOAD(p)   (*(FAR struct trieroute_node_s * volatile *)&(p))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One node of a path-compressed binary trie.  A node either holds a route
+ * or is a branch point where two sub-tries part; branch points always have
+ * two children.
+ */
+
+struct trieroute_node_s
+{
+  FAR struct trieroute_node_s *child[2]; /* Sub-tries, by bit plen of key */
+  FAR struct trieroute_node_s *flink;    /* Next route in insertion order */
+  FAR struct trieroute_node_s *blink;    /* Previous route, or next retired
+                                          * node once unlinked */
+  uint8_t plen;                          /* Prefix length in bits */
+  bool    route;                         /* True: The node holds a route */
+};
+
+/* A routing table.  Lookups and traversals take no lock: updates are built
+ * aside and published with a single pointer store, and unlinked nodes are
+ * only freed once every reader that might still see them has left.
+ *
+ * Readers enter in the current epoch and are counted there.  An update
+ * puts the nodes it unlinks on the retired list of the current epoch.  Once
+ * the readers of the previous epoch have drained, its retired list is freed
+ * and the epoch is flipped.  Nothing ever waits for a reader.
+ */
+
+struct trieroute_s
+{
+  FAR struct net_bufpool_s    *pool;       /* Allocator for the nodes */
+  uint8_t                      keylen;     /* Key length in bytes */
+  mutex_t                      lock;       /* Serializes updates */
+  atomic_t                     epoch;      /* Epoch of new readers */
+  atomic_t                     readers[2]; /* Readers active in each epoch */
+  FAR struct trieroute_node_s *root;       /* Root of the trie */
+  FAR struct trieroute_node_s *head;       /* Oldest route */
+  FAR struct trieroute_node_s *tail;       /* Newest route */
+  FAR struct trieroute_node_s *retired[2]; /* Unlinked in each epoch */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+NET_BUFPOOL_DECLARE(g_ipv4_trienodes, sizeof(struct trieroute_node_s) +
+                    sizeof(struct net_route_ipv4_s),
+                    CONFIG_ROUTE_MAX_IPv4_TRIENODES,
+                    CONFIG_ROUTE_ALLOC_IPv4_TRIENODES, 0);
+
+static struct trieroute_s g_ipv4_trie =
+{
+  &g_ipv4_trienodes,
+  sizeof(in_addr_t),
+  NXMUTEX_INITIALIZER
+};
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+NET_BUFPOOL_DECLARE(g_ipv6_trienodes, sizeof(struct trieroute_node_s) +
+                    sizeof(struct net_route_ipv6_s),
+                    CONFIG_ROUTE_MAX_IPv6_TRIENODES,
+                    CONFIG_ROUTE_ALLOC_IPv6_TRIENODES, 0);
+
+static struct trieroute_s g_ipv6_trie =
+{
+  &g_ipv6_trienodes,
+  sizeof(net_ipv6addr_t),
+  NXMUTEX_INITIALIZER
+};
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: trieroute_read_lock and trieroute_read_unlock
+ *
+ * Description:
+ *   Enter and leave a read-side section.  Nodes reached from the trie or
+ *   the route list stay valid until the section is left.  Neither call
+ *   ever blocks.
+ *
+ ****************************************************************************/
+
+static int trieroute_read_lock(FAR struct trieroute_s *table)
+{
+  int epoch;
+
+  for (; ; )
+    {
+      /* Count ourselves in the current epoch.  If an update flipped the
+       * epoch meanwhile, the count may have been missed, so try again.
+       */
+
+      epoch = atomic_read(&table->epoch);
+      atomic_fetch_add(&table->readers[epoch], 1);
+      if (atomic_read_acquire(&table->epoch) == epoch)
+        {
+          return epoch;
+        }
+
+      atomic_fetch_sub(&table->readers[epoch], 1);
+    }
+}
+
+static void trieroute_read_unlock(FAR struct trieroute_s *table, int epoch)
+{
+  atomic_fetch_sub_release(&table->readers[epoch], 1);
+}
+
+/****************************************************************************
+ * Name: trieroute_publish
+ *
+ * Description:
+ *   Store a node pointer that lock-free readers may follow.  The node must
+ *   be completely initialized.
+ *
+ ****************************************************************************/
+
+static void trieroute_publish(FAR struct trieroute_s *table,
+                              FAR struct trieroute_node_s **slot,
+                              FAR struct trieroute_node_s *node)
+{
+  /* Order the initialization of the node before its publication */
+
+  UP_DMB();
+  TRIEROUTE_LOAD(*slot) = node;
+}
+
+/****************************************************************************
+ * Name: trieroute_retire
+ *
+ * Description:
+ *   Queue an unlinked node to be freed after the current epoch.
+ *
+ ****************************************************************************/
+
+static void trieroute_retire(FAR struct trieroute_s *table,
+                             FAR struct trieroute_node_s *node)
+{
+  int epoch = atomic_read(&table->epoch);
+
+  node->blink            = table->retired[epoch];
+  table->retired[epoch] = node;
+}
+
+/****************************************************************************
+ * Name: trieroute_reclaim
+ *
+ * Description:
+ *   Called at the end of each update.  If no reader of the previous epoch
+ *   is left, free the nodes retired in it and start a new epoch.
+ *   Otherwise, try again on the next update.
+ *
+ ****************************************************************************/
+
+static void trieroute_reclaim(FAR struct trieroute_s *table)
+{
+  FAR struct trieroute_node_s *node;
+  int prev = !atomic_read(&table->epoch);
+
+  if (atomic_read_acquire(&table->readers[prev]) != 0)
+    {
+      return;
+    }
+
+  while ((node = table->retired[prev]) != NULL)
+    {
+      table->retired[prev] = node->blink;
+      NET_BUFPOOL_FREE(*table->pool, node);
+    }
+
+  atomic_set_release(&table->epoch, prev);
+}
+
+/****************************************************************************
+ * Name: trieroute_diffbit
+ *
+ * Description:
+ *   Return the first bit before maxbits at which the two keys differ, or
+ *   maxbits if there is none.  The bits before start are known to be equal.
+ *
+ ****************************************************************************/
+
+static unsigned int trieroute_diffbit(FAR const uint8_t *key1,
+                                      FAR const uint8_t *key2,
+                                      unsigned int start,
+                                      unsigned int maxbits)
+{
+  unsigned int bit;
+  uint8_t diff;
+
+  for (bit = start & ~7; bit < maxbits; bit += 8)
+    {
+      diff = key1[bit >> 3] ^ key2[bit >> 3];
+      if (diff != 0)
+        {
+          while ((diff & 0x80) == 0)
+            {
+              diff <<= 1;
+              bit++;
+            }
+
+          return bit < maxbits ? bit : maxbits;
+        }
+    }
+
+  return maxbits;
+}
+
+/****************************************************************************
+ * Name: trieroute_alloc
+ *
+ * Description:
+ *   Allocate a zeroed node.
+ *
+ ****************************************************************************/
+
+static FAR struct trieroute_node_s *
+trieroute_alloc(FAR struct trieroute_s *table)
+{
+  return NET_BUFPOOL_TRYALLOC(*table->pool);
+}
+
+/****************************************************************************
+ * Name: trieroute_lookup
+ *
+ * Description:
+ *   Return the route with the longest prefix matching the key, or NULL.
+ *   Must be called in a read-side section.
+ *
+ ****************************************************************************/
+
+static FAR struct trieroute_node_s *
+trieroute_lookup(FAR struct trieroute_s *table, FAR const uint8_t *key)
+{
+  FAR struct trieroute_node_s *match = NULL;
+  FAR struct trieroute_node_s *node;
+  unsigned int keybits = table->keylen << 3;
+  unsigned int bit = 0;
+
+  node = TRIEROUTE_LOAD(table->root);
+  while (node != NULL)
+    {
+      /* The bits before the parent's prefix length are already matched */
+
+      bit = trieroute_diffbit(key, TRIEROUTE_KEY(node), bit, node->plen);
+      if (bit < node->plen)
+        {
+          break;
+        }
+
+      /* Routes deeper in the trie have longer prefixes */
+
+      if (node->route)
+        {
+          match = node;
+        }
+
+      if (node->plen >= keybits)
+        {
+          break;
+        }
+
+      node = TRIEROUTE_LOAD(node->child[TRIEROUTE_BIT(key, node->plen)]);
+    }
+
+  return match;
+}
+
+/****************************************************************************
+ * Name: trieroute_insert
+ *
+ * Description:
+ *   Insert a route node prepared by the caller.  Must be called with the
+ *   table locked.
+ *
+ * Returned Value:
+ *   OK on success; -EEXIST if the prefix already has a route, -ENOMEM if
+ *   no node is available for a branch point.  The caller still owns the
+ *   node on failure.
+ *
+ ****************************************************************************/
+
+static int trieroute_insert(FAR struct trieroute_s *table,
+                            FAR struct trieroute_node_s *route)
+{
+  FAR struct trieroute_node_s **slot = &table->root;
+  FAR struct trieroute_node_s *node;
+  FAR struct trieroute_node_s *branch;
+  FAR const uint8_t *key = TRIEROUTE_KEY(route);
+  unsigned int plen = route->plen;
+  unsigned int bit = 0;
+
+  while ((node = *slot) != NULL)
+    {
+      bit = trieroute_diffbit(key, TRIEROUTE_KEY(node), bit,
+                              MIN(plen, node->plen));
+      if (bit < node->plen)
+        {
+          if (bit == plen)
+            {
+              /* The new prefix covers the node: it goes above it */
+
+              route->child[TRIEROUTE_BIT(TRIEROUTE_KEY(node), plen)] = node;
+              trieroute_publish(table, slot, route);
+            }
+          else
+            {
+              /* The keys part before the end of either prefix: add a branch
+               * point there with both below it.
+               */
+
+              branch = trieroute_alloc(table);
+              if (branch == NULL)
+                {
+                  return -ENOMEM;
+                }
+
+              memcpy(TRIEROUTE_KEY(branch), key, table->keylen);
+              branch->plen = bit;
+              branch->child[TRIEROUTE_BIT(key, bit)] = route;
+              branch->child[TRIEROUTE_BIT(key, bit) ^ 1] = node;
+              trieroute_publish(table, slot, branch);
+            }
+
+          break;
+        }
+
+      if (node->plen == plen)
+        {
+          if (node->route)
+            {
+              return -EEXIST;
+            }
+
+          /* Replace the branch point with the route.  Readers may still be
+           * on the old node, so it is retired rather than modified.
+           */
+
+          route->child[0] = node->child[0];
+          route->child[1] = node->child[1];
+          trieroute_publish(table, slot, route);
+          trieroute_retire(table, node);
+          break;
+        }
+
+      slot = &node->child[TRIEROUTE_BIT(key, node->plen)];
+    }
+
+  if (node == NULL)
+    {
+      trieroute_publish(table, slot, route);
+    }
+
+  /* Append the route to the list for traversals */
+
+  route->blink = table->tail;
+  if (table->tail != NULL)
+    {
+      trieroute_publish(table, &table->tail->flink, route);
+    }
+  else
+    {
+      trieroute_publish(table, &table->head, route);
+    }
+
+  table->tail = route;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: trieroute_remove
+ *
+ * Description:
+ *   Unlink and retire the route for a prefix.  Must be called with the
+ *   table locked.  The node is not freed before the table is unlocked.
+ *
+ * Returned Value:
+ *   OK on success; -ENOENT if there is no such route, -ENOMEM if no node
+ *   is available to keep a branch point.
+ *
+ ****************************************************************************/
+
+static int trieroute_remove(FAR struct trieroute_s *table,
+                            FAR const uint8_t *key, unsigned int plen,
+                            FAR struct trieroute_node_s **removed)
+{
+  FAR struct trieroute_node_s **pslot = NULL;
+  FAR struct trieroute_node_s **slot = &table->root;
+  FAR struct trieroute_node_s *parent = NULL;
+  FAR struct trieroute_node_s *branch;
+  FAR struct trieroute_node_s *node;
+  unsigned int bit = 0;
+
+  /* Find the node of the prefix and the two slots above it */
+
+  while ((node = *slot) != NULL && node->plen <= plen)
+    {
+      bit = trieroute_diffbit(key, TRIEROUTE_KEY(node), bit, node->plen);
+      if (bit < node->plen)
+        {
+          return -ENOENT;
+        }
+
+      if (node->plen == plen)
+        {
+          break;
+        }
+
+      pslot  = slot;
+      parent = node;
+      slot   = &node->child[TRIEROUTE_BIT(key, node->plen)];
+    }
+
+  if (node == NULL || node->plen != plen || !node->route)
+    {
+      return -ENOENT;
+    }
+
+  if (node->child[0] != NULL && node->child[1] != NULL)
+    {
+      /* The node is still needed as a branch point */
+
+      branch = trieroute_alloc(table);
+      if (branch == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      memcpy(TRIEROUTE_KEY(branch), TRIEROUTE_KEY(node), table->keylen);
+      branch->plen     = node->plen;
+      branch->child[0] = node->child[0];
+      branch->child[1] = node->child[1];
+      trieroute_publish(table, slot, branch);
+    }
+  else if (node->child[0] != NULL || node->child[1] != NULL)
+    {
+      trieroute_publish(table, slot,
+                        node->child[node->child[0] == NULL]);
+    }
+  else if (parent != NULL && !parent->route)
+    {
+      /* A branch point with one child left is not needed any more: the
+       * sibling takes its place.
+       */
+
+      trieroute_publish(table, pslot,
+                        parent->child[parent->child[0] == node]);
+      trieroute_retire(table, parent);
+    }
+  else
+    {
+      trieroute_publish(table, slot, NULL);
+    }
+
+  /* Unlink the route from the list.  Its forward link is left alone, so
+   * that a traversal standing on it can go on.
+   */
+
+  if (node->blink != NULL)
+    {
+      trieroute_publish(table, &node->blink->flink, node->flink);
+    }
+  else
+    {
+      trieroute_publish(table, &table->head, node->flink);
+    }
+
+  if (node->flink != NULL)
+    {
+      node->flink->blink = node->blink;
+    }
+  else
+    {
+      table->tail = node->blink;
+    }
+
+  trieroute_retire(table, node);
+  *removed = node;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: trieroute_add
+ *
+ * Description:
+ *   Add a route whose entry has been copied into the node.
+ *
+ ****************************************************************************/
+
+static int trieroute_add(FAR struct trieroute_s *table,
+                         FAR struct trieroute_node_s *route)
+{
+  int ret;
+
+  ret = nxmutex_lock(&table->lock);
+  if (ret < 0)
+    {
+      NET_BUFPOOL_FREE(*table->pool, route);
+      return ret;
+    }
+
+  ret = trieroute_insert(table, route);
+  if (ret < 0)
+    {
+      NET_BUFPOOL_FREE(*table->pool, route);
+    }
+
+  trieroute_reclaim(table);
+  nxmutex_unlock(&table->lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: trieroute_del
+ *
+ * Description:
+ *   Delete the route of a prefix, copying its entry to the caller.
+ *
+ ****************************************************************************/
+
+static int trieroute_del(FAR struct trieroute_s *table,
+                         FAR const uint8_t *key, unsigned int plen,
+                         FAR void *entry, size_t entrysize)
+{
+  FAR struct trieroute_node_s *node;
+  int ret;
+
+  ret = nxmutex_lock(&table->lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = trieroute_remove(table, key, plen, &node);
+  if (ret >= 0)
+    {
+      memcpy(entry, TRIEROUTE_ENTRY(node), entrysize);
+    }
+
+  trieroute_reclaim(table);
+  nxmutex_unlock(&table->lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: trieroute_ipv4_prefix and trieroute_ipv6_prefix
+ *
+ * Description:
+ *   Return the prefix length of a netmask, or -EINVAL if the netmask is not
+ *   contiguous and so can not be held by the trie.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+static int trieroute_ipv4_prefix(in_addr_t netmask)
+{
+  uint8_t plen = net_ipv4_mask2pref(netmask);
+
+  if (netmask != HTONL(plen > 0 ? UINT32_MAX << (32 - plen) : 0))
+    {
+      return -EINVAL;
+    }
+
+  return plen;
+}
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+static int trieroute_ipv6_prefix(FAR const uint16_t *netmask)
+{
+  uint8_t plen = net_ipv6_mask2pref(netmask);
+  net_ipv6addr_t mask;
+
+  net_ipv6_pref2mask(mask, plen);
+  if (!net_ipv6addr_cmp(mask, netmask))
+    {
+      return -EINVAL;
+    }
+
+  return plen;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: net_addroute_ipv4 and net_addroute_ipv6
+ *
+ * Description:
+ *   Add a new route to the routing table
+ *
+ * Input Parameters:
+ *
+ * Returned Value:
+ *   OK on success; Negated errno on failure.  The netmask must be
+ *   contiguous.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+int net_addroute_ipv4(in_addr_t target, in_addr_t netmask, in_addr_t router)
+{
+  FAR struct trieroute_node_s *node;
+  FAR struct net_route_ipv4_s *route;
+  struct net_route_ipv4_s entry;
+  int plen;
+  int ret;
+
+  plen = trieroute_ipv4_prefix(netmask);
+  if (plen < 0)
+    {
+      nerr("ERROR:  Non-contiguous netmask\n");
+      return plen;
+    }
+
+  /* Allocate a route entry */
+
+  node = trieroute_alloc(&g_ipv4_trie);
+  if (node == NULL)
+    {
+      nerr("ERROR:  Failed to allocate a route\n");
+      return -ENOMEM;
+    }
+
+  /* Format the new routing table entry */
+
+  route = TRIEROUTE_ENTRY(node);
+  net_ipv4addr_copy(route->target, target);
+  net_ipv4addr_copy(route->netmask, netmask);
+  net_ipv4addr_copy(route->router, router);
+  net_ipv4_dumproute("New route", route);
+
+  node->plen  = plen;
+  node->route = true;
+  memcpy(&entry, route, sizeof(entry));
+
+  /* Then add the new entry to the table */
+
+  ret = trieroute_add(&g_ipv4_trie, node);
+  if (ret >= 0)
+    {
+      netlink_route_notify(&entry, RTM_NEWROUTE, AF_INET);
+    }
+
+  return ret;
+}
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+int net_addroute_ipv6(net_ipv6addr_t target, net_ipv6addr_t netmask,
+                      net_ipv6addr_t router)
+{
+  FAR struct trieroute_node_s *node;
+  FAR struct net_route_ipv6_s *route;
+  struct net_route_ipv6_s entry;
+  int plen;
+  int ret;
+
+  plen = trieroute_ipv6_prefix(netmask);
+  if (plen < 0)
+    {
+      nerr("ERROR:  Non-contiguous netmask\n");
+      return plen;
+    }
+
+  /* Allocate a route entry */
+
+  node = trieroute_alloc(&g_ipv6_trie);
+  if (node == NULL)
+    {
+      nerr("ERROR:  Failed to allocate a route\n");
+      return -ENOMEM;
+    }
+
+  /* Format the new routing table entry */
+
+  route = TRIEROUTE_ENTRY(node);
+  net_ipv6addr_copy(route->target, target);
+  net_ipv6addr_copy(route->netmask, netmask);
+  net_ipv6addr_copy(route->router, router);
+  net_ipv6_dumproute("New route", route);
+
+  node->plen  = plen;
+  node->route = true;
+  memcpy(&entry, route, sizeof(entry));
+
+  /* Then add the new entry to the table */
+
+  ret = trieroute_add(&g_ipv6_trie, node);
+  if (ret >= 0)
+    {
+      netlink_route_notify(&entry, RTM_NEWROUTE, AF_INET6);
+    }
+
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: net_delroute_ipv4 and net_delroute_ipv6
+ *
+ * Description:
+ *   Remove an existing route from the routing table
+ *
+ * Input Parameters:
+ *
+ * Returned Value:
+ *   OK on success; Negated errno on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+int net_delroute_ipv4(in_addr_t target, in_addr_t netmask)
+{
+  struct net_route_ipv4_s entry;
+  int plen;
+  int ret;
+
+  /* A non-contiguous netmask can not have been added */
+
+  plen = trieroute_ipv4_prefix(netmask);
+  if (plen < 0)
+    {
+      return -ENOENT;
+    }
+
+  ret = trieroute_del(&g_ipv4_trie, (FAR const uint8_t *)&target, plen,
+                      &entry, sizeof(entry));
+  if (ret >= 0)
+    {
+      netlink_route_notify(&entry, RTM_DELROUTE, AF_INET);
+    }
+
+  return ret;
+}
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+int net_delroute_ipv6(net_ipv6addr_t target, net_ipv6addr_t netmask)
+{
+  struct net_route_ipv6_s entry;
+  int plen;
+  int ret;
+
+  /* A non-contiguous netmask can not have been added */
+
+  plen = trieroute_ipv6_prefix(netmask);
+  if (plen < 0)
+    {
+      return -ENOENT;
+    }
+
+  ret = trieroute_del(&g_ipv6_trie, (FAR const uint8_t *)target, plen,
+                      &entry, sizeof(entry));
+  if (ret >= 0)
+    {
+      netlink_route_notify(&entry, RTM_DELROUTE, AF_INET6);
+    }
+
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: net_foreachroute_ipv4 and net_foreachroute_ipv6
+ *
+ * Description:
+ *   Traverse the routing table.  Updates are not locked out, a route added
+ *   or deleted meanwhile may or may not be visited.
+ *
+ * Input Parameters:
+ *   handler - Will be called for each route in the routing table.
+ *   arg     - An arbitrary value that will be passed to the handler.
+ *
+ * Returned Value:
+ *   Zero (OK) returned if the entire table was searched.  Handlers may
+ *   terminate the search early with any non-zero value.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+int net_foreachroute_ipv4(route_handler_ipv4_t handler, FAR void *arg)
+{
+  FAR struct trieroute_node_s *node;
+  int epoch;
+  int ret = 0;
+
+  epoch = trieroute_read_lock(&g_ipv4_trie);
+
+  /* Visit each entry in the routing table */
+
+  for (node = TRIEROUTE_LOAD(g_ipv4_trie.head); ret == 0 && node != NULL;
+       node = TRIEROUTE_LOAD(node->flink))
+    {
+      ret = handler(TRIEROUTE_ENTRY(node), arg);
+    }
+
+  trieroute_read_unlock(&g_ipv4_trie, epoch);
+  return ret;
+}
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+int net_foreachroute_ipv6(route_handler_ipv6_t handler, FAR void *arg)
+{
+  FAR struct trieroute_node_s *node;
+  int epoch;
+  int ret = 0;
+
+  epoch = trieroute_read_lock(&g_ipv6_trie);
+
+  /* Visit each entry in the routing table */
+
+  for (node = TRIEROUTE_LOAD(g_ipv6_trie.head); ret == 0 && node != NULL;
+       node = TRIEROUTE_LOAD(node->flink))
+    {
+      ret = handler(TRIEROUTE_ENTRY(node), arg);
+    }
+
+  trieroute_read_unlock(&g_ipv6_trie, epoch);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: net_ipv4_router and net_ipv6_router
+ *
+ * Description:
+ *   Given an IP address on a external network, return the address of the
+ *   router on a local network that can forward to the external network.
+ *   The trie yields the longest matching prefix directly and the lookup
+ *   never blocks, not even while the table is being updated.
+ *
+ * Input Parameters:
+ *   target    - An IP address on a remote network to use in the lookup.
+ *   router    - The address of router on a local network that can forward
+ *               our packets to the target.
+ *   prefixlen - The prefix length of previously matched routes (maybe on
+ *               device), will only match prefix longer than prefixlen.
+ *
+ * Returned Value:
+ *   OK on success; Negated errno on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ROUTE_IPv4_TRIEROUTE
+int net_ipv4_router(in_addr_t target, FAR in_addr_t *router,
+                    int8_t prefixlen)
+{
+  FAR struct trieroute_node_s *node;
+  int epoch;
+  int ret = -ENOENT;
+
+  /* Do not route the special broadcast IP address */
+
+  if (prefixlen >= 32 || net_ipv4addr_cmp(target, INADDR_BROADCAST))
+    {
+      return -ENOENT;
+    }
+
+  epoch = trieroute_read_lock(&g_ipv4_trie);
+
+  node = trieroute_lookup(&g_ipv4_trie, (FAR const uint8_t *)&target);
+  if (node != NULL && node->plen > prefixlen)
+    {
+      FAR struct net_route_ipv4_s *route = TRIEROUTE_ENTRY(node);
+
+      net_ipv4addr_copy(*router, route->router);
+      ret = OK;
+    }
+
+  trieroute_read_unlock(&g_ipv4_trie, epoch);
+  return ret;
+}
+#endif
+
+#ifdef CONFIG_ROUTE_IPv6_TRIEROUTE
+int net_ipv6_router(const net_ipv6addr_t target, net_ipv6addr_t router,
+                    int16_t prefixlen)
+{
+  FAR struct trieroute_node_s *node;
+  int epoch;
+  int ret = -ENOENT;
+
+  /* Do not route to any the special IPv6 multicast addresses */
+
+  if (prefixlen >= 128 || target[0] == HTONS(0xff02))
+    {
+      return -ENOENT;
+    }
+
+  epoch = trieroute_read_lock(&g_ipv6_trie);
+
+  node = trieroute_lookup(&g_ipv6_trie, (FAR const uint8_t *)target);
+  if (node != NULL && node->plen > prefixlen)
+    {
+      FAR struct net_route_ipv6_s *route = TRIEROUTE_ENTRY(node);
+
+      net_ipv6addr_copy(router, route->router);
+      ret = OK;
+    }
+
+  trieroute_read_unlock(&g_ipv6_trie, epoch);
+  return ret;
+}
+#endif
+
+#endif /* CONFIG_ROUTE_IPv4_TRIEROUTE || CONFIG_ROUTE_IPv6_TRIEROUTE */
@@ -0,0 +1,213 @@
+/****************************************************************************
+ * net/socket/recvmmsg.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <errno.h>
+
+#include <nuttx/cancelpt.h>
+#include <nuttx/clock.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/net/net.h>
+
+#include "socket/socket.h"
+
+#ifdef CONFIG_NET
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: psock_recvmmsg
+ *
+ * Description:
+ *   psock_recvmmsg() receives a vector of messages from a socket.  This is
+ *   an internal OS interface.  It is functionally equivalent to recvmmsg()
+ *   except that:
+ *
+ *   - It is not a cancellation point,
+ *   - It does not modify the errno variable, and
+ *   - It accepts the internal socket structure as an input rather than an
+ *     task-specific socket descriptor.
+ *
+ *   If the socket allows it, the network stays locked for the whole
+ *   vector, so the messages already queued are taken in one go.
+ *
+ * Input Parameters:
+ *   psock   A pointer to a NuttX-specific, internal socket structure
+ *   msgvec  The vector of messages to receive
+ *   vlen    The number of messages in the vector
+ *   flags   Receive flags
+ *   timeout Optional time after which no further message is received
+ *
+ * Returned Value:
+ *   On success, returns the number of messages received, the number of
+ *   bytes received of each message is returned in its msg_len.  If no
+ *   message was received, a negated errno value is returned (see comments
+ *   with recvmsg() for a list of appropriate errno values).
+ *
+ ****************************************************************************/
+
+int psock_recvmmsg(FAR struct socket *psock, FAR struct mmsghdr *msgvec,
+                   unsigned int vlen, int flags,
+                   FAR const struct timespec *timeout)
+{
+  unsigned int nrecv = 0;
+  clock_t start = 0;
+  clock_t ticks = 0;
+  ssize_t ret = 0;
+  bool batch;
+
+  /* Verify that non-NULL pointers were passed */
+
+  if (msgvec == NULL && vlen > 0)
+    {
+      return -EINVAL;
+    }
+
+  /* Verify that the sockfd corresponds to valid, allocated socket */
+
+  if (psock == NULL || psock->s_conn == NULL)
+    {
+      return -EBADF;
+    }
+
+  if (timeout != NULL)
+    {
+      if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 ||
+          timeout->tv_nsec >= NSEC_PER_SEC)
+        {
+          return -EINVAL;
+        }
+
+      ticks = clock_time2ticks(timeout);
+      start = clock_systime_ticks();
+    }
+
+  /* Batch the vector under one network lock if the socket only ever
+   * blocks with the network lock broken.
+   */
+
+  DEBUGASSERT(psock->s_sockif != NULL);
+  batch = psock->s_sockif->si_sockcaps != NULL &&
+          (psock->s_sockif->si_sockcaps(psock) & SOCKCAP_BATCHING) != 0;
+  if (batch)
+    {
+      net_lock();
+    }
+
+  while (nrecv < vlen)
+    {
+      ret = psock_recvmsg(psock, &msgvec[nrecv].msg_hdr,
+                          flags & ~MSG_WAITFORONE);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      msgvec[nrecv++].msg_len = ret;
+
+      /* With MSG_WAITFORONE, only wait for the first message */
+
+      if ((flags & MSG_WAITFORONE) != 0)
+        {
+          flags |= MSG_DONTWAIT;
+        }
+
+      /* As with Linux, the timeout is only checked after each message */
+
+      if (timeout != NULL && clock_systime_ticks() - start >= ticks)
+        {
+          break;
+        }
+    }
+
+  if (batch)
+    {
+      net_unlock();
+    }
+
+  return nrecv > 0 ? nrecv : ret;
+}
+
+/****************************************************************************
+ * Function: recvmmsg
+ *
+ * Description:
+ *   The recvmmsg() call receives a vector of messages with one call, each
+ *   as if by recvmsg().
+ *
+ * Parameters:
+ *   sockfd   Socket descriptor of socket
+ *   msgvec   The vector of messages to receive
+ *   vlen     The number of messages in the vector
+ *   flags    Receive flags, MSG_WAITFORONE sets MSG_DONTWAIT after the
+ *            first message
+ *   timeout  Optional time after which no further message is received
+ *
+ * Returned Value:
+ *   On success, returns the number of messages received in msgvec.  If no
+ *   message was received, -1 is returned, and errno is set as with
+ *   recvmsg().
+ *
+ ****************************************************************************/
+
+int recvmmsg(int sockfd, FAR struct mmsghdr *msgvec, unsigned int vlen,
+             int flags, FAR struct timespec *timeout)
+{
+  FAR struct socket *psock;
+  FAR struct file *filep;
+  int ret;
+
+  /* recvmmsg() is a cancellation point */
+
+  enter_cancellation_point();
+
+  /* Get the underlying socket structure */
+
+  ret = sockfd_socket(sockfd, &filep, &psock);
+
+  /* Let psock_recvmmsg() do all of the work */
+
+  if (ret == OK)
+    {
+      ret = psock_recvmmsg(psock, msgvec, vlen, flags, timeout);
+      file_put(filep);
+    }
+
+  if (ret < 0)
+    {
+      set_errno(-ret);
+      ret = ERROR;
+    }
+
+  leave_cancellation_point();
+  return ret;
+}
+
+#endif /* CONFIG_NET */
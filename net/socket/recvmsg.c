@@ -102,6 +102,30 @@ ssize_t psock_recvmsg(FAR struct socket *psock, FAR struct msghdr *msg,
   DEBUGASSERT(psock->s_sockif != NULL &&
               psock->s_sockif->si_recvmsg != NULL);
 
+  if ((flags & MSG_ZEROCOPY) != 0)
+    {
+#ifdef CONFIG_NET_RECV_ZEROCOPY
+      /* The single I/O vector receives the pointer to the loaned I/O
+       * buffer chain instead of the data.
+       */
+
+      if (psock->s_sockif->si_sockcaps == NULL ||
+          (psock->s_sockif->si_sockcaps(psock) & SOCKCAP_ZEROCOPY) == 0)
+        {
+          return -EOPNOTSUPP;
+        }
+
+      if (msg->msg_iovlen != 1 ||
+          msg->msg_iov->iov_len < sizeof(FAR struct iob_s *) ||
+          (flags & MSG_PEEK) != 0)
+        {
+          return -EINVAL;
+        }
+#else
+      return -EOPNOTSUPP;
+#endif
+    }
+
   /* Save the original cmsg information */
 
   msg_control         = msg->msg_control;
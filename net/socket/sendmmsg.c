@@ -0,0 +1,182 @@
+/****************************************************************************
+ * net/socket/sendmmsg.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <errno.h>
+
+#include <nuttx/cancelpt.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/net/net.h>
+
+#include "socket/socket.h"
+
+#ifdef CONFIG_NET
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: psock_sendmmsg
+ *
+ * Description:
+ *   psock_sendmmsg() sends a vector of messages to a socket.  This is an
+ *   internal OS interface.  It is functionally equivalent to sendmmsg()
+ *   except that:
+ *
+ *   - It is not a cancellation point,
+ *   - It does not modify the errno variable, and
+ *   - It accepts the internal socket structure as an input rather than an
+ *     task-specific socket descriptor.
+ *
+ *   If the socket allows it, the network stays locked for the whole
+ *   vector, so the driver picks up all of the queued messages once the
+ *   vector is done.
+ *
+ * Input Parameters:
+ *   psock   A pointer to a NuttX-specific, internal socket structure
+ *   msgvec  The vector of messages to send
+ *   vlen    The number of messages in the vector
+ *   flags   Send flags
+ *
+ * Returned Value:
+ *   On success, returns the number of messages sent, the number of bytes
+ *   sent of each message is returned in its msg_len.  If no message could
+ *   be sent, a negated errno value is returned (see comments with
+ *   sendmsg() for a list of appropriate errno values).
+ *
+ ****************************************************************************/
+
+int psock_sendmmsg(FAR struct socket *psock, FAR struct mmsghdr *msgvec,
+                   unsigned int vlen, int flags)
+{
+  unsigned int nsent = 0;
+  ssize_t ret = 0;
+  bool batch;
+
+  /* Verify that non-NULL pointers were passed */
+
+  if (msgvec == NULL && vlen > 0)
+    {
+      return -EINVAL;
+    }
+
+  /* Verify that the sockfd corresponds to valid, allocated socket */
+
+  if (psock == NULL || psock->s_conn == NULL)
+    {
+      return -EBADF;
+    }
+
+  /* Batch the vector under one network lock if the socket only ever
+   * blocks with the network lock broken.
+   */
+
+  DEBUGASSERT(psock->s_sockif != NULL);
+  batch = psock->s_sockif->si_sockcaps != NULL &&
+          (psock->s_sockif->si_sockcaps(psock) & SOCKCAP_BATCHING) != 0;
+  if (batch)
+    {
+      net_lock();
+    }
+
+  while (nsent < vlen)
+    {
+      ret = psock_sendmsg(psock, &msgvec[nsent].msg_hdr, flags);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      msgvec[nsent++].msg_len = ret;
+    }
+
+  if (batch)
+    {
+      net_unlock();
+    }
+
+  /* Report an error only if nothing was sent, as Linux does */
+
+  return nsent > 0 ? nsent : ret;
+}
+
+/****************************************************************************
+ * Function: sendmmsg
+ *
+ * Description:
+ *   The sendmmsg() call sends a vector of messages with one call, each as
+ *   if by sendmsg().
+ *
+ * Parameters:
+ *   sockfd   Socket descriptor of socket
+ *   msgvec   The vector of messages to send
+ *   vlen     The number of messages in the vector
+ *   flags    Send flags
+ *
+ * Returned Value:
+ *   On success, returns the number of messages sent from msgvec.  If no
+ *   message could be sent, -1 is returned, and errno is set as with
+ *   sendmsg().
+ *
+ ****************************************************************************/
+
+int sendmmsg(int sockfd, FAR struct mmsghdr *msgvec, unsigned int vlen,
+             int flags)
+{
+  FAR struct socket *psock;
+  FAR struct file *filep;
+  int ret;
+
+  /* sendmmsg() is a cancellation point */
+
+  enter_cancellation_point();
+
+  /* Get the underlying socket structure */
+
+  ret = sockfd_socket(sockfd, &filep, &psock);
+
+  /* Let psock_sendmmsg() do all of the work */
+
+  if (ret == OK)
+    {
+      ret = psock_sendmmsg(psock, msgvec, vlen, flags);
+      file_put(filep);
+    }
+
+  if (ret < 0)
+    {
+      set_errno(-ret);
+      ret = ERROR;
+    }
+
+  leave_cancellation_point();
+  return ret;
+}
+
+#endif /* CONFIG_NET */
@@ -37,6 +37,7 @@
 #include <nuttx/mm/iob.h>
 #include <nuttx/net/ip.h>
 #include <nuttx/net/net.h>
+#include <nuttx/hashtable.h>
 #include <nuttx/net/tcp.h>
 #include <nuttx/wqueue.h>
 
@@ -127,6 +128,16 @@
 #define TCP_RTO_MAX 240 /* 120s,The unit is half a second */
 #define TCP_RTO_MIN 1   /* 0.5s */
 
+/* The size of the private state of the congestion control algorithms, in
+ * 32-bit words.
+ */
+
+#if defined(CONFIG_NET_TCP_CC_BBR)
+#  define TCP_CC_PRIV_WORDS 12
+#elif defined(CONFIG_NET_TCP_CC_CUBIC)
+#  define TCP_CC_PRIV_WORDS 8
+#endif
+
 /****************************************************************************
  * Public Type Definitions
  ****************************************************************************/
@@ -149,6 +160,7 @@ struct net_driver_s;      /* Forward reference */
 struct devif_callback_s;  /* Forward reference */
 struct tcp_backlog_s;     /* Forward reference */
 struct tcp_hdr_s;         /* Forward reference */
+struct tcp_cc_ops_s;      /* Forward reference */
 
 /* This is a container that holds the poll-related information */
 
@@ -208,6 +220,10 @@ struct tcp_conn_s
 
   /* TCP-specific content follows */
 
+  hash_node_t hnode;      /* Active connections hashed by 4-tuple */
+  hash_node_t pnode;      /* Active connections hashed by local port */
+  hash_node_t lnode;      /* Listeners hashed by local port */
+
   union ip_binding_u u;   /* IP address binding */
   uint8_t  rcvseq[4];     /* The sequence number that we expect to
                            * receive next */
@@ -252,6 +268,13 @@ struct tcp_conn_s
   uint32_t cwnd;          /* The Congestion window */
   uint32_t max_cwnd;      /* The Congestion window maximum value */
   uint32_t ssthresh;      /* The Slow start threshold */
+
+  /* The congestion control algorithm, NULL until selected */
+
+  FAR const struct tcp_cc_ops_s *cc_ops;
+#ifdef TCP_CC_PRIV_WORDS
+  uint32_t cc_priv[TCP_CC_PRIV_WORDS]; /* Private state of cc_ops */
+#endif
 #endif
 #ifdef CONFIG_NET_TCP_WINDOW_SCALE
   uint32_t snd_wnd;       /* Sequence and acknowledgement numbers of last
@@ -446,6 +469,42 @@ struct tcp_callback_s
   FAR sem_t *tc_sem;
 };
 
+#ifdef CONFIG_NET_TCP_CC_NEWRENO
+/* This structure describes a congestion control algorithm.  The loss
+ * detection and the fast recovery of RFC 6582 are common to all of them,
+ * the algorithm decides how the congestion window grows and how far it
+ * backs off.
+ */
+
+struct tcp_cc_ops_s
+{
+  FAR const char *name;
+
+  /* Initialize the private state in cc_priv when the algorithm is attached
+   * to a connection.  Optional.
+   */
+
+  CODE void (*init)(FAR struct tcp_conn_s *conn);
+
+  /* Grow cwnd when 'acked' bytes of new data are acknowledged outside of
+   * fast recovery.
+   */
+
+  CODE void (*cong_avoid)(FAR struct tcp_conn_s *conn, uint32_t acked);
+
+  /* Return the new slow start threshold after a loss was detected */
+
+  CODE uint32_t (*ssthresh)(FAR struct tcp_conn_s *conn);
+
+  /* Pacing, return how many bytes may be sent now and account for them
+   * once they are sent.  Optional.
+   */
+
+  CODE uint32_t (*allowance)(FAR struct tcp_conn_s *conn);
+  CODE void (*sent)(FAR struct tcp_conn_s *conn, uint32_t len);
+};
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -455,6 +514,14 @@ extern "C"
 {
 #endif
 
+#ifdef CONFIG_NET_TCP_CC_CUBIC
+extern const struct tcp_cc_ops_s g_tcp_cc_cubic;
+#endif
+
+#ifdef CONFIG_NET_TCP_CC_BBR
+extern const struct tcp_cc_ops_s g_tcp_cc_bbr;
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -2308,6 +2375,87 @@ void tcp_cc_update(FAR struct tcp_conn_s *conn, FAR struct tcp_hdr_s *tcp);
  ****************************************************************************/
 
 void tcp_cc_recv_ack(FAR struct tcp_conn_s *conn, FAR struct tcp_hdr_s *tcp);
+
+/****************************************************************************
+ * Name: tcp_cc_timeout
+ *
+ * Description:
+ *   Update the congestion control variables after a retransmission
+ *   time-out.
+ *
+ * Input Parameters:
+ *   conn   - The TCP connection of interest
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+void tcp_cc_timeout(FAR struct tcp_conn_s *conn);
+
+/****************************************************************************
+ * Name: tcp_cc_slow_start
+ *
+ * Description:
+ *   Grow cwnd exponentially for 'acked' bytes of new data (RFC 5681), for
+ *   the use of the congestion control algorithms.
+ *
+ * Input Parameters:
+ *   conn   - The TCP connection of interest
+ *   acked  - The number of bytes acknowledged
+ *
+ ****************************************************************************/
+
+void tcp_cc_slow_start(FAR struct tcp_conn_s *conn, uint32_t acked);
+
+/****************************************************************************
+ * Name: tcp_cc_allowance / tcp_cc_sent
+ *
+ * Description:
+ *   Ask the congestion control algorithm how many bytes may be sent now,
+ *   UINT32_MAX if the connection is not paced, and tell it once they are
+ *   sent.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+uint32_t tcp_cc_allowance(FAR struct tcp_conn_s *conn);
+void tcp_cc_sent(FAR struct tcp_conn_s *conn, uint32_t len);
+
+/****************************************************************************
+ * Name: tcp_cc_select
+ *
+ * Description:
+ *   Select the congestion control algorithm of a connection by name
+ *   (TCP_CONGESTION socket option).
+ *
+ * Input Parameters:
+ *   conn   - The TCP connection of interest
+ *   name   - The name of the algorithm, not necessarily NUL terminated
+ *   len    - The length of name
+ *
+ * Returned Value:
+ *   OK on success, -ENOENT if there is no such algorithm.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+int tcp_cc_select(FAR struct tcp_conn_s *conn, FAR const char *name,
+                  size_t len);
+
+/****************************************************************************
+ * Name: tcp_cc_name
+ *
+ * Description:
+ *   Return the name of the congestion control algorithm of a connection.
+ *
+ ****************************************************************************/
+
+FAR const char *tcp_cc_name(FAR struct tcp_conn_s *conn);
 #endif
 
 #ifdef __cplusplus
@@ -24,7 +24,10 @@
  * Included Files
  ****************************************************************************/
 
+#include <sys/param.h>
 #include <debug.h>
+#include <errno.h>
+#include <string.h>
 
 #include "tcp/tcp.h"
 
@@ -74,10 +77,102 @@
     } \
  } while(0)
 
+/* The algorithm of new connections */
+
+#if defined(CONFIG_NET_TCP_CC_DEFAULT_CUBIC)
+#  define TCP_CC_DEFAULT (&g_tcp_cc_cubic)
+#elif defined(CONFIG_NET_TCP_CC_DEFAULT_BBR)
+#  define TCP_CC_DEFAULT (&g_tcp_cc_bbr)
+#else
+#  define TCP_CC_DEFAULT (&g_tcp_cc_newreno)
+#endif
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void tcp_newreno_cong_avoid(FAR struct tcp_conn_s *conn,
+                                   uint32_t acked);
+static uint32_t tcp_newreno_ssthresh(FAR struct tcp_conn_s *conn);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct tcp_cc_ops_s g_tcp_cc_newreno =
+{
+  "newreno",                /* name */
+  NULL,                     /* init */
+  tcp_newreno_cong_avoid,   /* cong_avoid */
+  tcp_newreno_ssthresh,     /* ssthresh */
+  NULL,                     /* allowance */
+  NULL                      /* sent */
+};
+
+/* All available congestion control algorithms */
+
+static FAR const struct tcp_cc_ops_s * const g_tcp_cc[] =
+{
+  &g_tcp_cc_newreno,
+#ifdef CONFIG_NET_TCP_CC_CUBIC
+  &g_tcp_cc_cubic,
+#endif
+#ifdef CONFIG_NET_TCP_CC_BBR
+  &g_tcp_cc_bbr,
+#endif
+};
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: tcp_newreno_cong_avoid
+ *
+ * Description:
+ *   Grow cwnd exponentially below ssthresh and linearly above it.
+ *
+ ****************************************************************************/
+
+static void tcp_newreno_cong_avoid(FAR struct tcp_conn_s *conn,
+                                   uint32_t acked)
+{
+  uint32_t increase;
+
+  if (conn->cwnd < conn->ssthresh)
+    {
+      tcp_cc_slow_start(conn, acked);
+    }
+  else
+    {
+      /* cong avoid (RFC 5681):
+       * Grow cwnd linearly by approximately maxseg per RTT using
+       * maxseg^2 / cwnd per ACK as the increment.
+       * If cwnd > maxseg^2, fix the cwnd increment at 1 byte to
+       * avoid capping cwnd.
+       */
+
+      increase = MAX((conn->mss * conn->mss / conn->cwnd), 1);
+
+      CC_CWND_INC(conn->cwnd, increase);
+      conn->cwnd = MIN(conn->cwnd, conn->max_cwnd);
+      ninfo("update congestion avoidance cwnd to %u\n", conn->cwnd);
+    }
+}
+
+/****************************************************************************
+ * Name: tcp_newreno_ssthresh
+ *
+ * Description:
+ *   ssthresh = max (FlightSize / 2, 2*SMSS) referring to rfc5681
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_newreno_ssthresh(FAR struct tcp_conn_s *conn)
+{
+  return MAX(conn->tx_unacked / 2, 2 * conn->mss);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -117,6 +212,20 @@ void tcp_cc_init(FAR struct tcp_conn_s *conn)
 
   conn->ssthresh = 2 * TCP_IPV4_DEFAULT_MSS;
   conn->dupacks = 0;
+
+  /* Keep the algorithm selected by setsockopt() or inherited from the
+   * listener.
+   */
+
+  if (conn->cc_ops == NULL)
+    {
+      conn->cc_ops = TCP_CC_DEFAULT;
+    }
+
+  if (conn->cc_ops->init != NULL)
+    {
+      conn->cc_ops->init(conn);
+    }
 }
 
 /****************************************************************************
@@ -140,15 +249,14 @@ void tcp_cc_init(FAR struct tcp_conn_s *conn)
 
 void tcp_cc_update(FAR struct tcp_conn_s *conn, FAR struct tcp_hdr_s *tcp)
 {
-  /* After Fast retransmitted, set ssthresh to the maximum of
-   * the unacked and the 2*SMSS, and enter to Fast Recovery.
-   * ssthresh = max (FlightSize / 2, 2*SMSS) referring to rfc5681
+  /* After Fast retransmitted, let the algorithm reduce ssthresh and enter
+   * to Fast Recovery.
    * cwnd=ssthresh + 3*SMSS  referring to rfc5681
    */
 
   if (conn->flags & TCP_INFT)
     {
-      conn->ssthresh = MAX(conn->tx_unacked / 2, 2 * conn->mss);
+      conn->ssthresh = conn->cc_ops->ssthresh(conn);
       conn->cwnd = conn->ssthresh + 3 * conn->mss;
 
       conn->flags &= ~TCP_INFT;
@@ -269,34 +377,166 @@ void tcp_cc_recv_ack(FAR struct tcp_conn_s *conn, FAR struct tcp_hdr_s *tcp)
 
       if (conn->tcpstateflags >= TCP_ESTABLISHED)
         {
-          uint32_t increase;
+          conn->cc_ops->cong_avoid(conn, acked);
+        }
+    }
+}
 
-          if (conn->cwnd < conn->ssthresh)
-            {
-              /* slow start (RFC 5681):
-               * Grow cwnd exponentially by maxseg(smss) per ACK.
-               */
+/****************************************************************************
+ * Name: tcp_cc_timeout
+ *
+ * Description:
+ *   Update the congestion control variables after a retransmission
+ *   time-out.
+ *
+ * Input Parameters:
+ *   conn   - The TCP connection of interest
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+void tcp_cc_timeout(FAR struct tcp_conn_s *conn)
+{
+  /* If conn is TCP_INFR, it should enter to slow start */
 
-              increase = acked > 0 ? MIN(acked, conn->mss) : conn->mss;
+  conn->flags &= ~TCP_INFR;
 
-              CC_CWND_INC(conn->cwnd, increase);
-              ninfo("update slow start cwnd to %u\n", conn->cwnd);
-            }
-          else
-            {
-              /* cong avoid (RFC 5681):
-               * Grow cwnd linearly by approximately maxseg per RTT using
-               * maxseg^2 / cwnd per ACK as the increment.
-               * If cwnd > maxseg^2, fix the cwnd increment at 1 byte to
-               * avoid capping cwnd.
-               */
+  /* update the max_cwnd */
 
-              increase = MAX((conn->mss * conn->mss / conn->cwnd), 1);
+  conn->max_cwnd = (conn->max_cwnd + 7 * conn->cwnd) >> 3;
 
-              CC_CWND_INC(conn->cwnd, increase);
-              conn->cwnd = MIN(conn->cwnd, conn->max_cwnd);
-              ninfo("update congestion avoidance cwnd to %u\n", conn->cwnd);
-            }
+  /* reset cwnd and ssthresh, refers to RFC5861. */
+
+  conn->ssthresh = conn->cc_ops->ssthresh(conn);
+  conn->cwnd = conn->mss;
+}
+
+/****************************************************************************
+ * Name: tcp_cc_slow_start
+ *
+ * Description:
+ *   Grow cwnd exponentially for 'acked' bytes of new data (RFC 5681), for
+ *   the use of the congestion control algorithms.
+ *
+ * Input Parameters:
+ *   conn   - The TCP connection of interest
+ *   acked  - The number of bytes acknowledged
+ *
+ ****************************************************************************/
+
+void tcp_cc_slow_start(FAR struct tcp_conn_s *conn, uint32_t acked)
+{
+  /* slow start (RFC 5681):
+   * Grow cwnd exponentially by maxseg(smss) per ACK.
+   */
+
+  uint32_t increase = acked > 0 ? MIN(acked, conn->mss) : conn->mss;
+
+  CC_CWND_INC(conn->cwnd, increase);
+  ninfo("update slow start cwnd to %u\n", conn->cwnd);
+}
+
+/****************************************************************************
+ * Name: tcp_cc_allowance / tcp_cc_sent
+ *
+ * Description:
+ *   Ask the congestion control algorithm how many bytes may be sent now,
+ *   UINT32_MAX if the connection is not paced, and tell it once they are
+ *   sent.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+uint32_t tcp_cc_allowance(FAR struct tcp_conn_s *conn)
+{
+  if (conn->cc_ops == NULL || conn->cc_ops->allowance == NULL)
+    {
+      return UINT32_MAX;
+    }
+
+  return conn->cc_ops->allowance(conn);
+}
+
+void tcp_cc_sent(FAR struct tcp_conn_s *conn, uint32_t len)
+{
+  if (conn->cc_ops != NULL && conn->cc_ops->sent != NULL)
+    {
+      conn->cc_ops->sent(conn, len);
+    }
+}
+
+/****************************************************************************
+ * Name: tcp_cc_select
+ *
+ * Description:
+ *   Select the congestion control algorithm of a connection by name
+ *   (TCP_CONGESTION socket option).
+ *
+ * Input Parameters:
+ *   conn   - The TCP connection of interest
+ *   name   - The name of the algorithm, not necessarily NUL terminated
+ *   len    - The length of name
+ *
+ * Returned Value:
+ *   OK on success, -ENOENT if there is no such algorithm.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+int tcp_cc_select(FAR struct tcp_conn_s *conn, FAR const char *name,
+                  size_t len)
+{
+  int i;
+
+  len = strnlen(name, len);
+
+  for (i = 0; i < nitems(g_tcp_cc); i++)
+    {
+      if (strlen(g_tcp_cc[i]->name) == len &&
+          strncmp(g_tcp_cc[i]->name, name, len) == 0)
+        {
+          break;
         }
     }
+
+  if (i >= nitems(g_tcp_cc))
+    {
+      return -ENOENT;
+    }
+
+  /* cwnd and ssthresh are carried over, only the private state of the new
+   * algorithm is set up.  Connections that are not started yet do this in
+   * tcp_cc_init().
+   */
+
+  if (conn->cc_ops != g_tcp_cc[i])
+    {
+      conn->cc_ops = g_tcp_cc[i];
+      if (conn->tcpstateflags != TCP_ALLOCATED &&
+          conn->cc_ops->init != NULL)
+        {
+          conn->cc_ops->init(conn);
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: tcp_cc_name
+ *
+ * Description:
+ *   Return the name of the congestion control algorithm of a connection.
+ *
+ ****************************************************************************/
+
+FAR const char *tcp_cc_name(FAR struct tcp_conn_s *conn)
+{
+  return conn->cc_ops != NULL ? conn->cc_ops->name : TCP_CC_DEFAULT->name;
 }
@@ -0,0 +1,382 @@
+/****************************************************************************
+ * net/tcp/tcp_cc_bbr.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <assert.h>
+#include <debug.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <nuttx/clock.h>
+
+#include "tcp/tcp.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Gains are scaled by 256 */
+
+#define BBR_UNIT            256
+#define BBR_HIGH_GAIN       739  /* 2/ln(2), doubles the rate per round */
+#define BBR_DRAIN_GAIN      88   /* 1/BBR_HIGH_GAIN */
+#define BBR_CWND_GAIN       512
+
+/* Startup ends when the bandwidth grew by less than 25% for 3 rounds */
+
+#define BBR_FULL_BW_THRESH  320
+#define BBR_FULL_BW_ROUNDS  3
+
+/* The bandwidth estimate is the maximum of the last 10 rounds, the minimum
+ * round trip time expires after 10 seconds.
+ */
+
+#define BBR_BW_ROUNDS       10
+#define BBR_MINRTT_EXPIRE   10000
+
+/* The pacing budget may burst up to two clock ticks worth of data */
+
+#define BBR_BURST_USEC      (2 * CONFIG_USEC_PER_TICK)
+
+#define BBR_MIN_CWND(conn)  (4 * (uint32_t)(conn)->mss)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum tcp_bbr_mode_e
+{
+  BBR_STARTUP = 0,    /* Ramp up to fill the pipe */
+  BBR_DRAIN,          /* Drain the queue built during startup */
+  BBR_PROBE_BW        /* Cycle around the estimated bandwidth */
+};
+
+/* The BBR state, kept in cc_priv of the connection */
+
+struct tcp_bbr_s
+{
+  uint32_t btlbw;         /* Bottleneck bandwidth estimate, bytes/s */
+  uint32_t btlbw_round;   /* The round btlbw was sampled in */
+  uint32_t minrtt;        /* Minimum round trip time, ms, 0 if unknown */
+  uint32_t minrtt_stamp;  /* When minrtt was sampled, ms */
+  uint32_t round;         /* Round trip counter */
+  uint32_t round_end;     /* The ACK number that ends the round */
+  uint32_t round_start;   /* When the round started, ms, 0 if idle */
+  uint32_t delivered;     /* Bytes acknowledged in this round */
+  uint32_t full_bw;       /* Bandwidth at the last startup growth */
+  uint32_t budget;        /* Pacing budget, bytes */
+  uint32_t budget_stamp;  /* When the budget was last refilled, ms */
+  uint8_t  mode;          /* See enum tcp_bbr_mode_e */
+  uint8_t  full_cnt;      /* Rounds without startup growth */
+  uint8_t  cycle;         /* Index into g_bbr_pacing_gain */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void tcp_bbr_init(FAR struct tcp_conn_s *conn);
+static void tcp_bbr_cong_avoid(FAR struct tcp_conn_s *conn,
+                               uint32_t acked);
+static uint32_t tcp_bbr_ssthresh(FAR struct tcp_conn_s *conn);
+static uint32_t tcp_bbr_allowance(FAR struct tcp_conn_s *conn);
+static void tcp_bbr_sent(FAR struct tcp_conn_s *conn, uint32_t len);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The pacing gain cycle of PROBE_BW, one entry per round */
+
+static const uint16_t g_bbr_pacing_gain[] =
+{
+  320, 192, 256, 256, 256, 256, 256, 256
+};
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+const struct tcp_cc_ops_s g_tcp_cc_bbr =
+{
+  "bbr",                    /* name */
+  tcp_bbr_init,             /* init */
+  tcp_bbr_cong_avoid,       /* cong_avoid */
+  tcp_bbr_ssthresh,         /* ssthresh */
+  tcp_bbr_allowance,        /* allowance */
+  tcp_bbr_sent              /* sent */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_bbr_now
+ ****************************************************************************/
+
+static uint32_t tcp_bbr_now(void)
+{
+  return TICK2MSEC(clock_systime_ticks());
+}
+
+/****************************************************************************
+ * Name: tcp_bbr_bdp
+ *
+ * Description:
+ *   Return the estimated bandwidth-delay product scaled by gain, or 0 if
+ *   there is no estimate yet.
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_bbr_bdp(FAR struct tcp_bbr_s *bbr, uint32_t gain)
+{
+  uint64_t bdp = (uint64_t)bbr->btlbw * bbr->minrtt / 1000;
+
+  return (uint32_t)MIN(bdp * gain / BBR_UNIT, UINT32_MAX);
+}
+
+/****************************************************************************
+ * Name: tcp_bbr_rate
+ *
+ * Description:
+ *   Return the pacing rate in bytes per second, 0 if not pacing.
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_bbr_rate(FAR struct tcp_bbr_s *bbr)
+{
+  uint32_t gain;
+
+  switch (bbr->mode)
+    {
+      case BBR_STARTUP:
+        gain = BBR_HIGH_GAIN;
+        break;
+
+      case BBR_DRAIN:
+        gain = BBR_DRAIN_GAIN;
+        break;
+
+      default:
+        gain = g_bbr_pacing_gain[bbr->cycle];
+        break;
+    }
+
+  return (uint32_t)MIN((uint64_t)bbr->btlbw * gain / BBR_UNIT, UINT32_MAX);
+}
+
+/****************************************************************************
+ * Name: tcp_bbr_round
+ *
+ * Description:
+ *   Take the bandwidth and round trip time samples of a finished round
+ *   and advance the state machine.
+ *
+ ****************************************************************************/
+
+static void tcp_bbr_round(FAR struct tcp_conn_s *conn,
+                          FAR struct tcp_bbr_s *bbr, uint32_t now)
+{
+  uint32_t elapsed;
+  uint32_t bw;
+
+  /* A round that started with nothing in flight is application limited
+   * and says nothing about the path.
+   */
+
+  if (bbr->round_start != 0)
+    {
+      elapsed = MAX(now - bbr->round_start, 1);
+      bw      = (uint32_t)MIN((uint64_t)bbr->delivered * 1000 / elapsed,
+                              UINT32_MAX);
+
+      if (bw >= bbr->btlbw ||
+          bbr->round - bbr->btlbw_round > BBR_BW_ROUNDS)
+        {
+          bbr->btlbw       = bw;
+          bbr->btlbw_round = bbr->round;
+        }
+
+      if (bbr->minrtt == 0 || elapsed <= bbr->minrtt ||
+          now - bbr->minrtt_stamp > BBR_MINRTT_EXPIRE)
+        {
+          bbr->minrtt       = elapsed;
+          bbr->minrtt_stamp = now;
+        }
+    }
+
+  switch (bbr->mode)
+    {
+      case BBR_STARTUP:
+        if ((uint64_t)bbr->btlbw * BBR_UNIT >=
+            (uint64_t)bbr->full_bw * BBR_FULL_BW_THRESH)
+          {
+            bbr->full_bw  = bbr->btlbw;
+            bbr->full_cnt = 0;
+          }
+        else if (++bbr->full_cnt >= BBR_FULL_BW_ROUNDS)
+          {
+            bbr->mode = BBR_DRAIN;
+          }
+        break;
+
+      case BBR_DRAIN:
+        if (conn->tx_unacked <= tcp_bbr_bdp(bbr, BBR_UNIT))
+          {
+            bbr->mode  = BBR_PROBE_BW;
+            bbr->cycle = 0;
+          }
+        break;
+
+      default:
+        bbr->cycle = (bbr->cycle + 1) % nitems(g_bbr_pacing_gain);
+        break;
+    }
+
+  /* Start the next round, it ends when everything in flight now is
+   * acknowledged.
+   */
+
+  bbr->round++;
+  bbr->round_end   = conn->last_ackno + conn->tx_unacked;
+  bbr->round_start = conn->tx_unacked > 0 && now != 0 ? now : 0;
+  bbr->delivered   = 0;
+}
+
+/****************************************************************************
+ * Name: tcp_bbr_init
+ ****************************************************************************/
+
+static void tcp_bbr_init(FAR struct tcp_conn_s *conn)
+{
+  FAR struct tcp_bbr_s *bbr = (FAR struct tcp_bbr_s *)conn->cc_priv;
+
+  DEBUGASSERT(sizeof(struct tcp_bbr_s) <= sizeof(conn->cc_priv));
+  memset(bbr, 0, sizeof(struct tcp_bbr_s));
+  bbr->round_end = conn->last_ackno;
+}
+
+/****************************************************************************
+ * Name: tcp_bbr_cong_avoid
+ *
+ * Description:
+ *   Update the path model and set cwnd to twice the estimated
+ *   bandwidth-delay product.  Until there is an estimate, the window grows
+ *   as in slow start.
+ *
+ ****************************************************************************/
+
+static void tcp_bbr_cong_avoid(FAR struct tcp_conn_s *conn,
+                               uint32_t acked)
+{
+  FAR struct tcp_bbr_s *bbr = (FAR struct tcp_bbr_s *)conn->cc_priv;
+  uint32_t now = tcp_bbr_now();
+  uint32_t target;
+
+  bbr->delivered += acked;
+  if (TCP_SEQ_GTE(conn->last_ackno, bbr->round_end))
+    {
+      tcp_bbr_round(conn, bbr, now);
+    }
+
+  target = tcp_bbr_bdp(bbr, bbr->mode == BBR_STARTUP ?
+                            BBR_HIGH_GAIN : BBR_CWND_GAIN);
+  if (target == 0)
+    {
+      tcp_cc_slow_start(conn, acked);
+      return;
+    }
+
+  target     = MAX(target, BBR_MIN_CWND(conn));
+  conn->cwnd = MIN(conn->cwnd + MIN(acked, target), target);
+  ninfo("update bbr cwnd to %" PRIu32 " btlbw %" PRIu32
+        " minrtt %" PRIu32 "\n", conn->cwnd, bbr->btlbw, bbr->minrtt);
+}
+
+/****************************************************************************
+ * Name: tcp_bbr_ssthresh
+ *
+ * Description:
+ *   BBR does not back off on losses, the window stays at the model.
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_bbr_ssthresh(FAR struct tcp_conn_s *conn)
+{
+  return MAX(conn->cwnd, 2 * (uint32_t)conn->mss);
+}
+
+/****************************************************************************
+ * Name: tcp_bbr_allowance
+ *
+ * Description:
+ *   Refill the pacing budget at the pacing rate and return it.  A
+ *   connection with nothing in flight may always send a full burst, there
+ *   would be no ACK to clock the next attempt.
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_bbr_allowance(FAR struct tcp_conn_s *conn)
+{
+  FAR struct tcp_bbr_s *bbr = (FAR struct tcp_bbr_s *)conn->cc_priv;
+  uint32_t rate = tcp_bbr_rate(bbr);
+  uint32_t now;
+  uint64_t budget;
+  uint64_t burst;
+
+  if (rate == 0)
+    {
+      return UINT32_MAX;
+    }
+
+  now    = tcp_bbr_now();
+  burst  = MAX((uint64_t)rate * BBR_BURST_USEC / 1000000,
+               2 * (uint64_t)conn->mss);
+  budget = bbr->budget + (uint64_t)rate * (now - bbr->budget_stamp) / 1000;
+  if (conn->tx_unacked == 0)
+    {
+      budget = burst;
+    }
+
+  bbr->budget       = (uint32_t)MIN(budget, burst);
+  bbr->budget_stamp = now;
+
+  return bbr->budget;
+}
+
+/****************************************************************************
+ * Name: tcp_bbr_sent
+ ****************************************************************************/
+
+static void tcp_bbr_sent(FAR struct tcp_conn_s *conn, uint32_t len)
+{
+  FAR struct tcp_bbr_s *bbr = (FAR struct tcp_bbr_s *)conn->cc_priv;
+
+  bbr->budget -= MIN(bbr->budget, len);
+}
@@ -0,0 +1,267 @@
+/****************************************************************************
+ * net/tcp/tcp_cc_cubic.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <assert.h>
+#include <debug.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <nuttx/clock.h>
+
+#include "tcp/tcp.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The multiplicative decrease factor beta = 0.7, scaled by 1024 */
+
+#define CUBIC_BETA          717
+#define CUBIC_BETA_SCALE    1024
+
+/* W(t) = C * (t - K)^3 + Wmax with C = 0.4 and t in seconds.  With t in
+ * milliseconds and W in segments this is (t - K)^3 / CUBIC_C_DIV.
+ */
+
+#define CUBIC_C_DIV         2500000000ll
+
+/* Clamp t - K so that its cube fits into 64 bits */
+
+#define CUBIC_MAX_DELTA     (1 << 19)
+
+/* The Reno-friendly window grows by one segment every
+ * cwnd * (2 - beta) / (3 * beta) acknowledged bytes, which is about
+ * cwnd * 15 / 8 for beta = 0.7.
+ */
+
+#define CUBIC_RENO_NUM      15
+#define CUBIC_RENO_DEN      8
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The CUBIC state, kept in cc_priv of the connection */
+
+struct tcp_cubic_s
+{
+  uint32_t epoch;    /* Start of the epoch in ms, 0 if not started */
+  uint32_t wmax;     /* Window before the last reduction, in segments */
+  uint32_t origin;   /* Origin point of the cubic function, in segments */
+  uint32_t k;        /* Time to reach the origin point, in ms */
+  uint32_t west;     /* Reno-friendly window estimate, in segments */
+  uint32_t acked;    /* Bytes acknowledged towards the next west segment */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void tcp_cubic_init(FAR struct tcp_conn_s *conn);
+static void tcp_cubic_cong_avoid(FAR struct tcp_conn_s *conn,
+                                 uint32_t acked);
+static uint32_t tcp_cubic_ssthresh(FAR struct tcp_conn_s *conn);
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+const struct tcp_cc_ops_s g_tcp_cc_cubic =
+{
+  "cubic",                  /* name */
+  tcp_cubic_init,           /* init */
+  tcp_cubic_cong_avoid,     /* cong_avoid */
+  tcp_cubic_ssthresh,       /* ssthresh */
+  NULL,                     /* allowance */
+  NULL                      /* sent */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_cubic_root
+ *
+ * Description:
+ *   Integer cube root, rounded down.
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_cubic_root(uint64_t x)
+{
+  uint64_t y = 0;
+  uint64_t b;
+  int s;
+
+  for (s = 63; s >= 0; s -= 3)
+    {
+      y <<= 1;
+      b = 3 * y * (y + 1) + 1;
+      if ((x >> s) >= b)
+        {
+          x -= b << s;
+          y++;
+        }
+    }
+
+  return (uint32_t)y;
+}
+
+/****************************************************************************
+ * Name: tcp_cubic_init
+ ****************************************************************************/
+
+static void tcp_cubic_init(FAR struct tcp_conn_s *conn)
+{
+  DEBUGASSERT(sizeof(struct tcp_cubic_s) <= sizeof(conn->cc_priv));
+  memset(conn->cc_priv, 0, sizeof(struct tcp_cubic_s));
+}
+
+/****************************************************************************
+ * Name: tcp_cubic_cong_avoid
+ *
+ * Description:
+ *   Grow cwnd towards the larger of the cubic function and the
+ *   Reno-friendly estimate at the current time (RFC 8312, section 4).
+ *
+ ****************************************************************************/
+
+static void tcp_cubic_cong_avoid(FAR struct tcp_conn_s *conn,
+                                 uint32_t acked)
+{
+  FAR struct tcp_cubic_s *ca = (FAR struct tcp_cubic_s *)conn->cc_priv;
+  uint32_t now;
+  uint32_t segs;
+  uint32_t target;
+  uint64_t increase;
+  uint64_t reno;
+  int64_t delta;
+
+  if (conn->cwnd < conn->ssthresh)
+    {
+      tcp_cc_slow_start(conn, acked);
+      return;
+    }
+
+  now  = TICK2MSEC(clock_systime_ticks());
+  segs = MAX(conn->cwnd / conn->mss, 1);
+
+  /* Start a new epoch on the first ACK after a reduction */
+
+  if (ca->epoch == 0)
+    {
+      ca->epoch = now != 0 ? now : 1;
+      ca->west  = segs;
+      ca->acked = 0;
+
+      if (segs < ca->wmax)
+        {
+          ca->k      = tcp_cubic_root((uint64_t)(ca->wmax - segs) *
+                                      CUBIC_C_DIV);
+          ca->origin = ca->wmax;
+        }
+      else
+        {
+          ca->k      = 0;
+          ca->origin = segs;
+        }
+    }
+
+  /* The cubic function at the current time */
+
+  delta = (int64_t)(now - ca->epoch) - ca->k;
+  delta = MIN(MAX(delta, -CUBIC_MAX_DELTA), CUBIC_MAX_DELTA);
+  delta = (int64_t)ca->origin + delta * delta * delta / CUBIC_C_DIV;
+  target = delta > 0 ? (uint32_t)MIN(delta, UINT32_MAX) : 0;
+
+  /* Do not grow faster than 1.5 times per round trip */
+
+  target = MIN(target, segs + segs / 2);
+
+  /* The window standard TCP would have reached in the same time */
+
+  reno = (uint64_t)segs * conn->mss * CUBIC_RENO_NUM / CUBIC_RENO_DEN;
+  ca->acked += acked;
+  while (ca->acked >= reno)
+    {
+      ca->acked -= reno;
+      ca->west++;
+    }
+
+  target = MAX(target, ca->west);
+
+  /* Spread the growth to the target over one window of ACKs, or creep
+   * very slowly if the window is at or above the target.
+   */
+
+  if (target > segs)
+    {
+      increase = (uint64_t)conn->mss * (target - segs) * acked / conn->cwnd;
+    }
+  else
+    {
+      increase = (uint64_t)conn->mss * acked / (100 * conn->cwnd);
+    }
+
+  increase = MAX(increase, 1);
+  conn->cwnd = (uint32_t)MIN((uint64_t)conn->cwnd + increase, UINT32_MAX);
+  ninfo("update cubic cwnd to %" PRIu32 "\n", conn->cwnd);
+}
+
+/****************************************************************************
+ * Name: tcp_cubic_ssthresh
+ *
+ * Description:
+ *   Remember the window at the loss and reduce it by beta.  With fast
+ *   convergence, a flow that lost before reaching the previous Wmax
+ *   releases some bandwidth to newer flows.
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_cubic_ssthresh(FAR struct tcp_conn_s *conn)
+{
+  FAR struct tcp_cubic_s *ca = (FAR struct tcp_cubic_s *)conn->cc_priv;
+  uint32_t segs = conn->cwnd / conn->mss;
+
+  ca->epoch = 0;
+
+  if (segs < ca->wmax)
+    {
+      ca->wmax = segs * (CUBIC_BETA_SCALE + CUBIC_BETA) /
+                 (2 * CUBIC_BETA_SCALE);
+    }
+  else
+    {
+      ca->wmax = segs;
+    }
+
+  return MAX((uint32_t)((uint64_t)conn->cwnd * CUBIC_BETA /
+                        CUBIC_BETA_SCALE), 2 * conn->mss);
+}
@@ -57,6 +57,7 @@
 #include <arch/irq.h>
 
 #include <nuttx/clock.h>
+#include <nuttx/hashtable.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/net/netconfig.h>
 #include <nuttx/net/net.h>
@@ -95,10 +96,119 @@ NET_BUFPOOL_DECLARE(g_tcp_connections, sizeof(struct tcp_conn_s),
 
 static dq_queue_t g_active_tcp_connections;
 
+/* The connected TCP connections hashed by their 4-tuple, for the input
+ * demultiplexing, and by their local port, for the port selection.
+ */
+
+static DECLARE_HASHTABLE(g_tcp_conn_hash, CONFIG_NET_TCP_HASH_BITS);
+static DECLARE_HASHTABLE(g_tcp_port_hash, CONFIG_NET_TCP_HASH_BITS);
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: tcp_ipv4_hashkey and tcp_ipv6_hashkey
+ *
+ * Description:
+ *   Create the 4-tuple hash key of a connection from its remote address and
+ *   its local and remote ports.  The local address is not part of the key,
+ *   a connection bound to the unspecified address must still be found.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPv4
+static inline uint32_t tcp_ipv4_hashkey(in_addr_t raddr, uint16_t lport,
+                                        uint16_t rport)
+{
+  return NTOHL(raddr) ^ ((uint32_t)rport << 16) ^ lport;
+}
+#endif
+
+#ifdef CONFIG_NET_IPv6
+static inline uint32_t tcp_ipv6_hashkey(FAR const uint16_t *raddr,
+                                        uint16_t lport, uint16_t rport)
+{
+  uint32_t key = ((uint32_t)rport << 16) ^ lport;
+  int i;
+
+  for (i = 0; i < 8; i += 2)
+    {
+      key ^= ((uint32_t)raddr[i] << 16) | raddr[i + 1];
+    }
+
+  return key;
+}
+#endif
+
+/****************************************************************************
+ * Name: tcp_conn_hashkey
+ *
+ * Description:
+ *   Create the 4-tuple hash key of a connection.
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_conn_hashkey(FAR struct tcp_conn_s *conn)
+{
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  if (conn->domain == PF_INET)
+#endif
+    {
+      return tcp_ipv4_hashkey(conn->u.ipv4.raddr, conn->lport, conn->rport);
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  else
+#endif
+    {
+      return tcp_ipv6_hashkey(conn->u.ipv6.raddr, conn->lport, conn->rport);
+    }
+#endif /* CONFIG_NET_IPv6 */
+}
+
+/****************************************************************************
+ * Name: tcp_addactive
+ *
+ * Description:
+ *   Put a connection into the list and the hash tables of the active
+ *   connections.  Its addresses and ports must not change until it is
+ *   removed again by tcp_remactive().
+ *
+ * Assumptions:
+ *   This function is called with the network locked.
+ *
+ ****************************************************************************/
+
+static void tcp_addactive(FAR struct tcp_conn_s *conn)
+{
+  dq_addlast(&conn->sconn.node, &g_active_tcp_connections);
+  hashtable_add(g_tcp_conn_hash, &conn->hnode, tcp_conn_hashkey(conn));
+  hashtable_add(g_tcp_port_hash, &conn->pnode, conn->lport);
+}
+
+/****************************************************************************
+ * Name: tcp_remactive
+ *
+ * Description:
+ *   Remove a connection from the list and the hash tables of the active
+ *   connections.
+ *
+ * Assumptions:
+ *   This function is called with the network locked.
+ *
+ ****************************************************************************/
+
+static void tcp_remactive(FAR struct tcp_conn_s *conn)
+{
+  dq_rem(&conn->sconn.node, &g_active_tcp_connections);
+  hashtable_delete(g_tcp_conn_hash, &conn->hnode, tcp_conn_hashkey(conn));
+  hashtable_delete(g_tcp_port_hash, &conn->pnode, conn->lport);
+}
+
 /****************************************************************************
  * Name: tcp_listener
  *
@@ -115,16 +225,18 @@ static FAR struct tcp_conn_s *
   tcp_listener(uint8_t domain, FAR const union ip_addr_u *ipaddr,
                uint16_t portno)
 {
-  FAR struct tcp_conn_s *conn = NULL;
+  FAR struct tcp_conn_s *conn;
+  FAR hash_node_t *p;
 
   /* Check if this port number is in use by any active UIP TCP connection */
 
-  while ((conn = tcp_nextconn(conn)) != NULL)
+  hashtable_for_every_possible(g_tcp_port_hash, p, portno)
     {
       /* Check if this connection is open and the local port assignment
        * matches the requested port number.
        */
 
+      conn = container_of(p, struct tcp_conn_s, pnode);
       if (conn->tcpstateflags != TCP_CLOSED && conn->lport == portno
 #if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
           && domain == conn->domain
@@ -192,14 +304,16 @@ static inline FAR struct tcp_conn_s *
 {
   FAR struct ipv4_hdr_s *ip = IPv4BUF;
   FAR struct tcp_conn_s *conn;
+  FAR hash_node_t *p;
   in_addr_t srcipaddr;
   in_addr_t destipaddr;
 
-  conn       = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
   srcipaddr  = net_ip4addr_conv32(ip->srcipaddr);
   destipaddr = net_ip4addr_conv32(ip->destipaddr);
 
-  while (conn)
+  hashtable_for_every_possible(g_tcp_conn_hash, p,
+                               tcp_ipv4_hashkey(srcipaddr, tcp->destport,
+                                                tcp->srcport))
     {
       /* Find an open connection matching the TCP input. The following
        * checks are performed:
@@ -218,6 +332,7 @@ static inline FAR struct tcp_conn_s *
        * is destined for this TCP connection.
        */
 
+      conn = container_of(p, struct tcp_conn_s, hnode);
       if (conn->tcpstateflags != TCP_CLOSED &&
           tcp->destport == conn->lport &&
           tcp->srcport  == conn->rport &&
@@ -225,19 +340,13 @@ static inline FAR struct tcp_conn_s *
            net_ipv4addr_cmp(destipaddr, conn->u.ipv4.laddr)) &&
           net_ipv4addr_cmp(srcipaddr, conn->u.ipv4.raddr))
         {
-          /* Matching connection found.. break out of the loop and return a
-           * reference to it.
-           */
+          /* Matching connection found.. return a reference to it. */
 
-          break;
+          return conn;
         }
-
-      /* Look at the next active connection */
-
-      conn = (FAR struct tcp_conn_s *)conn->sconn.node.flink;
     }
 
-  return conn;
+  return NULL;
 }
 #endif /* CONFIG_NET_IPv4 */
 
@@ -259,14 +368,16 @@ static inline FAR struct tcp_conn_s *
 {
   FAR struct ipv6_hdr_s *ip = IPv6BUF;
   FAR struct tcp_conn_s *conn;
+  FAR hash_node_t *p;
   net_ipv6addr_t *srcipaddr;
   net_ipv6addr_t *destipaddr;
 
-  conn       = (FAR struct tcp_conn_s *)g_active_tcp_connections.head;
   srcipaddr  = (net_ipv6addr_t *)ip->srcipaddr;
   destipaddr = (net_ipv6addr_t *)ip->destipaddr;
 
-  while (conn)
+  hashtable_for_every_possible(g_tcp_conn_hash, p,
+                               tcp_ipv6_hashkey(*srcipaddr, tcp->destport,
+                                                tcp->srcport))
     {
       /* Find an open connection matching the TCP input. The following
        * checks are performed:
@@ -285,6 +396,7 @@ static inline FAR struct tcp_conn_s *
        * is destined for this TCP connection.
        */
 
+      conn = container_of(p, struct tcp_conn_s, hnode);
       if (conn->tcpstateflags != TCP_CLOSED &&
           tcp->destport == conn->lport &&
           tcp->srcport  == conn->rport &&
@@ -292,19 +404,13 @@ static inline FAR struct tcp_conn_s *
            net_ipv6addr_cmp(*destipaddr, conn->u.ipv6.laddr)) &&
           net_ipv6addr_cmp(*srcipaddr, conn->u.ipv6.raddr))
         {
-          /* Matching connection found.. break out of the loop and return a
-           * reference to it.
-           */
+          /* Matching connection found.. return a reference to it. */
 
-          break;
+          return conn;
         }
-
-      /* Look at the next active connection */
-
-      conn = (FAR struct tcp_conn_s *)conn->sconn.node.flink;
     }
 
-  return conn;
+  return NULL;
 }
 #endif /* CONFIG_NET_IPv6 */
 
@@ -859,7 +965,7 @@ void tcp_free(FAR struct tcp_conn_s *conn)
     {
       /* Remove the connection from the active list */
 
-      dq_rem(&conn->sconn.node, &g_active_tcp_connections);
+      tcp_remactive(conn);
     }
 
   tcp_free_rx_buffers(conn);
@@ -1106,6 +1212,9 @@ FAR struct tcp_conn_s *tcp_alloc_accept(FAR struct net_driver_s *dev,
       conn->snd_bufs         = listener->snd_bufs;
 #endif
       conn->mss              = listener->mss;
+#ifdef CONFIG_NET_TCP_CC_NEWRENO
+      conn->cc_ops           = listener->cc_ops;
+#endif
 
       /* Fill in the necessary fields for the new connection. */
 
@@ -1156,7 +1265,7 @@ FAR struct tcp_conn_s *tcp_alloc_accept(FAR struct net_driver_s *dev,
        * Interrupts should already be disabled in this context.
        */
 
-      dq_addlast(&conn->sconn.node, &g_active_tcp_connections);
+      tcp_addactive(conn);
       tcp_update_retrantimer(conn, TCP_RTO);
     }
 
@@ -1467,7 +1576,7 @@ int tcp_connect(FAR struct tcp_conn_s *conn, FAR const struct sockaddr *addr)
 
   /* And, finally, put the connection structure into the active list. */
 
-  dq_addlast(&conn->sconn.node, &g_active_tcp_connections);
+  tcp_addactive(conn);
   ret = OK;
 
 errout_with_lock:
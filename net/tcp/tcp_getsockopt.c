@@ -26,11 +26,13 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <sys/time.h>
 #include <stdint.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
+#include <string.h>
 
 #include <netinet/tcp.h>
 
@@ -239,6 +241,19 @@ int tcp_getsockopt(FAR struct socket *psock, int option,
           }
         break;
 
+#ifdef CONFIG_NET_TCP_CC_NEWRENO
+      case TCP_CONGESTION: /* Congestion control algorithm */
+        {
+          FAR const char *name = tcp_cc_name(conn);
+          size_t len           = MIN(*value_len, strlen(name) + 1);
+
+          memcpy(value, name, len);
+          *value_len           = len;
+          ret                  = OK;
+        }
+        break;
+#endif
+
       default:
         nerr("ERROR: Unrecognized TCP option: %d\n", option);
         ret = -ENOPROTOOPT;
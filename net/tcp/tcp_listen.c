@@ -50,6 +50,7 @@
 #include <stdbool.h>
 #include <debug.h>
 
+#include <nuttx/hashtable.h>
 #include <nuttx/net/netconfig.h>
 #include <nuttx/net/net.h>
 
@@ -61,9 +62,12 @@
  * Private Data
  ****************************************************************************/
 
-/* The tcp_listenports list all currently listening ports. */
+/* The tcp_listenports hash all currently listening connections by their
+ * local port.
+ */
 
-static FAR struct tcp_conn_s *tcp_listenports[CONFIG_NET_MAX_LISTENPORTS];
+static DECLARE_HASHTABLE(tcp_listenports, CONFIG_NET_TCP_HASH_BITS);
+static int tcp_nlistenports;
 
 /****************************************************************************
  * Private Functions
@@ -89,21 +93,20 @@ FAR struct tcp_conn_s *tcp_findlistener(FAR union ip_binding_u *uaddr,
                                         uint16_t portno)
 #endif
 {
-  int ndx;
+  FAR struct tcp_conn_s *conn;
+  FAR hash_node_t *p;
 
-  /* Examine each connection structure in each slot of the listener list */
+  /* Examine each listener that may have the same local port number */
 
-  for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
+  hashtable_for_every_possible(tcp_listenports, p, portno)
     {
-      /* Is this slot assigned?  If so, does the connection have the same
-       * local port number?
-       */
+      /* Does the connection have the same local port number? */
 
-      FAR struct tcp_conn_s *conn = tcp_listenports[ndx];
+      conn = container_of(p, struct tcp_conn_s, lnode);
 #if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
-      if (conn && conn->lport == portno && conn->domain == domain)
+      if (conn->lport == portno && conn->domain == domain)
 #else
-      if (conn && conn->lport == portno)
+      if (conn->lport == portno)
 #endif
         {
 #ifdef CONFIG_NET_IPv6
@@ -160,15 +163,16 @@ FAR struct tcp_conn_s *tcp_findlistener(FAR union ip_binding_u *uaddr,
 
 int tcp_unlisten(FAR struct tcp_conn_s *conn)
 {
-  int ndx;
+  FAR hash_node_t *p;
   int ret = -EINVAL;
 
   net_lock();
-  for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
+  hashtable_for_every_possible(tcp_listenports, p, conn->lport)
     {
-      if (tcp_listenports[ndx] == conn)
+      if (p == &conn->lnode)
         {
-          tcp_listenports[ndx] = NULL;
+          hashtable_delete(tcp_listenports, p, conn->lport);
+          tcp_nlistenports--;
           ret = OK;
           break;
         }
@@ -191,7 +195,6 @@ int tcp_unlisten(FAR struct tcp_conn_s *conn)
 
 int tcp_listen(FAR struct tcp_conn_s *conn)
 {
-  int ndx;
   int ret;
 
   /* This must be done with network locked because the listener table
@@ -212,29 +215,21 @@ int tcp_listen(FAR struct tcp_conn_s *conn)
 
       ret = -EADDRINUSE;
     }
+  else if (tcp_nlistenports >= CONFIG_NET_MAX_LISTENPORTS)
+    {
+      /* No, but there are already too many listeners */
+
+      ret = -ENOBUFS;
+    }
   else
     {
       /* Otherwise, save a reference to the connection structure in the
-       * "listener" list.
+       * "listener" table.
        */
 
-      ret = -ENOBUFS; /* Assume failure */
-
-      /* Search all slots until an available slot is found */
-
-      for (ndx = 0; ndx < CONFIG_NET_MAX_LISTENPORTS; ndx++)
-        {
-          /* Is the next slot available? */
-
-          if (!tcp_listenports[ndx])
-            {
-              /* Yes.. we found it */
-
-              tcp_listenports[ndx] = conn;
-              ret = OK;
-              break;
-            }
-        }
+      hashtable_add(tcp_listenports, &conn->lnode, conn->lport);
+      tcp_nlistenports++;
+      ret = OK;
     }
 
   net_unlock();
@@ -409,6 +409,26 @@ static uint16_t tcp_recvhandler(FAR struct net_driver_s *dev,
 
           tcp_sender(dev, pstate);
 
+#ifdef CONFIG_NET_RECV_ZEROCOPY
+          if ((pstate->ir_flags & MSG_ZEROCOPY) != 0)
+            {
+              /* Leave the data to be queued in the read-ahead buffer
+               * without a copy, the waiting thread loans it from there.
+               */
+
+              if (dev->d_len > 0)
+                {
+                  pstate->ir_cb->flags   = 0;
+                  pstate->ir_cb->priv    = NULL;
+                  pstate->ir_cb->event   = NULL;
+
+                  nxsem_post(&pstate->ir_sem);
+                }
+
+              return flags;
+            }
+#endif
+
           if ((flags & TCP_ACKDATA) != 0)
             {
               iob = iob_tryalloc(false);
@@ -847,6 +867,124 @@ static ssize_t tcp_recvfrom_one(FAR struct tcp_conn_s *conn, FAR void *buf,
   return ret;
 }
 
+/****************************************************************************
+ * Name: tcp_recvfrom_zerocopy
+ *
+ * Description:
+ *   Receive for MSG_ZEROCOPY.  Instead of copying the data, the whole
+ *   read-ahead I/O buffer chain is detached from the connection and loaned
+ *   to the caller, waiting for new data first if the read-ahead buffer is
+ *   empty.  The caller releases the chain with iob_free_chain().
+ *
+ * Input Parameters:
+ *   conn    - The TCP connection from which data is to be received.
+ *   iobp    - The location to return the I/O buffer chain.
+ *   from    - Socket address structure to store the source address
+ *             (if provided).
+ *   fromlen - Length of the address structure.
+ *   flags   - Flags indicating specific receive options.
+ *
+ * Returned Value:
+ *   Returns the number of bytes in the loaned chain, zero if the peer
+ *   closed the connection, or a negative error code in case of failure.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_RECV_ZEROCOPY
+static ssize_t tcp_recvfrom_zerocopy(FAR struct tcp_conn_s *conn,
+                                     FAR struct iob_s **iobp,
+                                     FAR struct sockaddr *from,
+                                     FAR socklen_t *fromlen, int flags)
+{
+  struct tcp_recvfrom_s state;
+  struct tcp_callback_s info;
+  ssize_t ret;
+
+  for (; ; )
+    {
+      /* Loan the data already buffered in the read-ahead buffer.  There may
+       * be read-ahead data even after the socket has been disconnected.
+       */
+
+      if (conn->readahead != NULL)
+        {
+          *iobp           = conn->readahead;
+          conn->readahead = NULL;
+          ret             = (*iobp)->io_pktlen;
+          break;
+        }
+
+      if (!_SS_ISCONNECTED(conn->sconn.s_flags))
+        {
+          ret = _SS_ISCLOSED(conn->sconn.s_flags) ? 0 : -ENOTCONN;
+          break;
+        }
+
+      if (_SS_ISNONBLOCK(conn->sconn.s_flags) ||
+          (flags & MSG_DONTWAIT) != 0)
+        {
+          ret = -EAGAIN;
+          break;
+        }
+
+      /* Chains loaned before may have been released in the meantime, so
+       * the receive window may have opened.
+       */
+
+      if (tcp_should_send_recvwindow(conn))
+        {
+          netdev_txnotify_dev(conn->dev);
+        }
+
+      /* Wait for new data to be queued in the read-ahead buffer */
+
+      tcp_recvfrom_initialize(conn, NULL, 0, from, fromlen, &state, flags);
+
+      state.ir_cb = tcp_callback_alloc(conn);
+      if (state.ir_cb == NULL)
+        {
+          tcp_recvfrom_uninitialize(&state);
+          ret = -EBUSY;
+          break;
+        }
+
+      state.ir_cb->flags   = (TCP_NEWDATA | TCP_DISCONN_EVENTS);
+      state.ir_cb->priv    = (FAR void *)&state;
+      state.ir_cb->event   = tcp_recvhandler;
+
+      info.tc_conn = conn;
+      info.tc_cb   = state.ir_cb;
+      info.tc_sem  = &state.ir_sem;
+      tls_cleanup_push(tls_get_info(), tcp_callback_cleanup, &info);
+
+      ret = net_sem_timedwait(&state.ir_sem,
+                              _SO_TIMEOUT(conn->sconn.s_rcvtimeo));
+      tls_cleanup_pop(tls_get_info(), 0);
+
+      tcp_callback_free(conn, state.ir_cb);
+      tcp_recvfrom_uninitialize(&state);
+
+      if (ret < 0)
+        {
+          if (ret == -ETIMEDOUT)
+            {
+              ret = -EAGAIN;
+            }
+
+          break;
+        }
+
+      /* New data or a loss of connection, check again */
+    }
+
+  tcp_notify_recvcpu(conn);
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -883,6 +1021,19 @@ ssize_t psock_tcp_recvfrom(FAR struct socket *psock, FAR struct msghdr *msg,
   net_lock();
 
   conn = psock->s_conn;
+
+#ifdef CONFIG_NET_RECV_ZEROCOPY
+  if ((flags & MSG_ZEROCOPY) != 0)
+    {
+      /* The single I/O vector receives the loaned I/O buffer chain */
+
+      ret = tcp_recvfrom_zerocopy(conn, msg->msg_iov->iov_base,
+                                  from, fromlen, flags);
+      net_unlock();
+      return ret;
+    }
+#endif
+
   for (i = 0; i < msg->msg_iovlen; i++)
     {
       FAR void *buf = msg->msg_iov[i].iov_base;
@@ -607,7 +607,9 @@ static uint16_t psock_send_eventhandler(FAR struct net_driver_s *dev,
                        * driver to send the message and marked as rexmit
                        */
 
+#ifndef CONFIG_NET_TCP_CC_NEWRENO
                       TCP_WBNACK(wrb) = 0;
+#endif
                       conn->timeout = true;
                       netdev_txnotify_dev(conn->dev);
                       return flags;
@@ -1037,12 +1039,25 @@ static uint16_t psock_send_eventhandler(FAR struct net_driver_s *dev,
       if (TCP_SEQ_LT(seq, snd_wnd_edge))
         {
           uint32_t remaining_snd_wnd;
+#ifdef CONFIG_NET_TCP_CC_NEWRENO
+          uint32_t allowance;
+#endif
+          size_t maxlen = conn->mss;
           int ret;
 
+#ifdef CONFIG_NETDEV_GSO
+          /* Hand several segments at once to a driver which splits them */
+
+          if (dev->d_gsomax > conn->mss)
+            {
+              maxlen = dev->d_gsomax - dev->d_gsomax % conn->mss;
+            }
+#endif
+
           sndlen = TCP_WBPKTLEN(wrb) - TCP_WBSENT(wrb);
-          if (sndlen > conn->mss)
+          if (sndlen > maxlen)
             {
-              sndlen = conn->mss;
+              sndlen = maxlen;
             }
 
           remaining_snd_wnd = TCP_SEQ_SUB(snd_wnd_edge, seq);
@@ -1067,6 +1082,23 @@ static uint16_t psock_send_eventhandler(FAR struct net_driver_s *dev,
               sndlen = CONFIG_IOB_BUFSIZE;
             }
 
+#ifdef CONFIG_NET_TCP_CC_NEWRENO
+          /* If the congestion control algorithm paces the connection, only
+           * send as many whole segments as it allows now.  Hold the data
+           * back if not even one fits, it will be sent on a later poll.
+           */
+
+          allowance = tcp_cc_allowance(conn);
+          if (sndlen > allowance)
+            {
+              sndlen = allowance - allowance % conn->mss;
+              if (sndlen == 0)
+                {
+                  return flags;
+                }
+            }
+#endif
+
           ninfo("SEND: wrb=%p seq=%" PRIu32 " pktlen=%u sent=%u sndlen=%zu "
                 "mss=%u snd_wnd=%" PRIu32 " seq=%" PRIu32
                 " remaining_snd_wnd=%" PRIu32 "\n",
@@ -1106,10 +1138,17 @@ static uint16_t psock_send_eventhandler(FAR struct net_driver_s *dev,
             }
 #endif
 
+#ifdef CONFIG_NETDEV_GSO
+          dev->d_gsosize = sndlen > conn->mss ? conn->mss : 0;
+#endif
+
           ret = devif_iob_send(dev, TCP_WBIOB(wrb), sndlen,
                                TCP_WBSENT(wrb), tcpip_hdrsize(conn));
           if (ret <= 0)
             {
+#ifdef CONFIG_NETDEV_GSO
+              dev->d_gsosize = 0;
+#endif
               return flags;
             }
 
@@ -1121,6 +1160,9 @@ static uint16_t psock_send_eventhandler(FAR struct net_driver_s *dev,
 
           conn->tx_unacked += sndlen;
           conn->sent       += sndlen;
+#ifdef CONFIG_NET_TCP_CC_NEWRENO
+          tcp_cc_sent(conn, sndlen);
+#endif
 
           /* Below prediction will become true,
            * unless retransmission occurrence
@@ -1201,6 +1243,15 @@ static uint32_t tcp_max_wrb_size(FAR struct tcp_conn_s *conn)
 
   size = 4 * mss;
 
+#ifdef CONFIG_NETDEV_GSO
+  /* enough to fill a packet for segmentation offload */
+
+  if (size < CONFIG_NETDEV_GSO_MAXSIZE)
+    {
+      size = CONFIG_NETDEV_GSO_MAXSIZE;
+    }
+#endif
+
   /* but it should not hog too many IOB buffers */
 
   if (size > CONFIG_IOB_NBUFFERS * CONFIG_IOB_BUFSIZE / 2)
@@ -1546,7 +1597,40 @@ ssize_t psock_tcp_send(FAR struct socket *psock, FAR const void *buf,
            * remaining data.
            */
 
-          chunk_result = TCP_WBTRYCOPYIN(wrb, cp, chunk_len, off);
+          if (off == 0)
+            {
+              unsigned int count;
+              int blresult;
+
+              /* A new write buffer is not on the write queue yet, so
+               * nothing else can reach it.  Copy the user data without the
+               * network lock so that the copy does not stall the stack.
+               * Data coalesced into the last write buffer is copied with
+               * the network locked, as that buffer was already queued.
+               */
+
+              blresult = net_breaklock(&count);
+              chunk_result = TCP_WBTRYCOPYIN(wrb, cp, chunk_len, off);
+              if (blresult >= 0)
+                {
+                  net_restorelock(count);
+                }
+
+              /* The connection may have been lost in the meantime */
+
+              if (!_SS_ISCONNECTED(conn->sconn.s_flags))
+                {
+                  nerr("ERROR: No longer connected\n");
+                  tcp_wrbuffer_release(wrb);
+                  ret = -ENOTCONN;
+                  goto errout_with_lock;
+                }
+            }
+          else
+            {
+              chunk_result = TCP_WBTRYCOPYIN(wrb, cp, chunk_len, off);
+            }
+
           if (chunk_result == -ENOMEM)
             {
               if (TCP_WBPKTLEN(wrb) > 0)
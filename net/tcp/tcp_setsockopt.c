@@ -26,6 +26,7 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <sys/time.h>
 #include <stdint.h>
 #include <errno.h>
@@ -260,6 +261,17 @@ int tcp_setsockopt(FAR struct socket *psock, int option,
           }
         break;
 
+#ifdef CONFIG_NET_TCP_CC_NEWRENO
+      case TCP_CONGESTION: /* Congestion control algorithm */
+        ret = tcp_cc_select(conn, value,
+                            MIN(value_len, TCP_CA_NAME_MAX));
+        if (ret < 0)
+          {
+            nerr("ERROR: Unknown congestion control algorithm\n");
+          }
+        break;
+#endif
+
       default:
         nerr("ERROR: Unrecognized TCP option: %d\n", option);
         ret = -ENOPROTOOPT;
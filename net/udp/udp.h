@@ -32,6 +32,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 
+#include <nuttx/hashtable.h>
 #include <nuttx/queue.h>
 #include <nuttx/semaphore.h>
 #include <nuttx/net/ip.h>
@@ -70,9 +71,19 @@
 /* Definitions for the UDP connection struct flag field */
 
 #define _UDP_FLAG_CONNECTMODE (1 << 0) /* Bit 0:  UDP connection-mode */
+#define _UDP_FLAG_SNDCHKSUM   (1 << 1) /* Bit 1:  Payload sum in sndchksum */
 
 #define _UDP_ISCONNECTMODE(f) (((f) & _UDP_FLAG_CONNECTMODE) != 0)
 
+/* The payload of buffered UDP packets is summed while it is copied into
+ * the write buffer, so the checksum only needs the headers at send time.
+ */
+
+#if defined(CONFIG_NET_UDP_WRITE_BUFFERS) && \
+    defined(CONFIG_NET_UDP_CHECKSUMS) && !defined(CONFIG_NET_ARCH_CHKSUM)
+#  define UDP_WRB_CHKSUM 1
+#endif
+
 /* This is a helper pointer for accessing the contents of the udp header */
 
 #define UDPIPv4BUF ((FAR struct udp_hdr_s *)IPBUF(IPv4_HDRLEN))
@@ -110,6 +121,7 @@ struct udp_conn_s
 
   /* UDP-specific content follows */
 
+  hash_node_t pnode;      /* Bound connections hashed by local port */
   union ip_binding_u u;   /* IP address binding */
   uint16_t lport;         /* Bound local port number (network byte order) */
   uint16_t rport;         /* Remote port number (network byte order) */
@@ -149,6 +161,10 @@ struct udp_conn_s
   FAR struct devif_callback_s *sndcb;
 #endif
 
+#ifdef UDP_WRB_CHKSUM
+  uint16_t sndchksum;             /* Payload sum of the packet being sent */
+#endif
+
 #if defined(CONFIG_NET_IGMP) || defined(CONFIG_NET_MLD)
   struct ip_mreqn mreq;
 #endif
@@ -174,6 +190,9 @@ struct udp_wrbuffer_s
   sq_entry_t wb_node;              /* Supports a singly linked list */
   struct sockaddr_storage wb_dest; /* Destination address */
   FAR struct iob_s *wb_iob;        /* Head of the I/O buffer chain */
+#ifdef UDP_WRB_CHKSUM
+  uint16_t wb_chksum;              /* Raw sum of the payload */
+#endif
 };
 #endif
 
@@ -263,6 +282,24 @@ FAR struct udp_conn_s *udp_active(FAR struct net_driver_s *dev,
 
 FAR struct udp_conn_s *udp_nextconn(FAR struct udp_conn_s *conn);
 
+/****************************************************************************
+ * Name: udp_setport
+ *
+ * Description:
+ *   Set the local port of a UDP connection and move the connection to the
+ *   matching hash bucket.  A port number of zero unbinds the connection.
+ *
+ * Input Parameters:
+ *   conn   - A reference to UDP connection structure.
+ *   portno - The local port number in network byte order.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+void udp_setport(FAR struct udp_conn_s *conn, uint16_t portno);
+
 /****************************************************************************
  * Name: udp_select_port
  *
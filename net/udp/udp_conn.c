@@ -57,6 +57,7 @@
 #include <arch/irq.h>
 
 #include <nuttx/clock.h>
+#include <nuttx/hashtable.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/mutex.h>
 #include <nuttx/net/netconfig.h>
@@ -97,10 +98,44 @@ static mutex_t g_free_lock = NXMUTEX_INITIALIZER;
 
 static dq_queue_t g_active_udp_connections;
 
+/* The UDP connections bound to a local port, hashed by that port.  The
+ * local address is not part of the key, a connection bound to the
+ * unspecified address must be found for any destination address.
+ */
+
+static DECLARE_HASHTABLE(g_udp_port_hash, CONFIG_NET_UDP_HASH_BITS);
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: udp_nextport
+ *
+ * Description:
+ *   Return the hash node after 'conn' among the connections that may be
+ *   bound to the local port 'portno', or the first one if 'conn' is NULL.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+static inline FAR hash_node_t *udp_nextport(FAR struct udp_conn_s *conn,
+                                            uint16_t portno)
+{
+  if (conn == NULL)
+    {
+      return g_udp_port_hash[HASH(portno,
+                                  hashtable_bits(g_udp_port_hash))].head;
+    }
+  else
+    {
+      DEBUGASSERT(conn->lport == portno);
+      return conn->pnode.flink;
+    }
+}
+
 /****************************************************************************
  * Name: udp_find_conn()
  *
@@ -123,15 +158,18 @@ static FAR struct udp_conn_s *udp_find_conn(uint8_t domain,
                                             FAR union ip_binding_u *ipaddr,
                                             uint16_t portno, sockopt_t opt)
 {
-  FAR struct udp_conn_s *conn = NULL;
+  FAR struct udp_conn_s *conn;
+  FAR hash_node_t *p;
 #ifdef CONFIG_NET_SOCKOPTS
   bool skip_reusable = _SO_GETOPT(opt, SO_REUSEADDR);
 #endif
 
-  /* Now search each connection structure. */
+  /* Now search each connection structure bound to this port. */
 
-  while ((conn = udp_nextconn(conn)) != NULL)
+  hashtable_for_every_possible(g_udp_port_hash, p, portno)
     {
+      conn = container_of(p, struct udp_conn_s, pnode);
+
       /* With SO_REUSEADDR set for both sockets, we do not need to check its
        * address and port.
        */
@@ -202,11 +240,12 @@ udp_ipv4_active(FAR struct net_driver_s *dev, FAR struct udp_conn_s *conn,
   static const in_addr_t bcast = INADDR_BROADCAST;
 #endif
   FAR struct ipv4_hdr_s *ip = IPv4BUF;
+  FAR hash_node_t *p;
 
-  conn = udp_nextconn(conn);
-
-  while (conn)
+  for (p = udp_nextport(conn, udp->destport); p != NULL; p = p->flink)
     {
+      conn = container_of(p, struct udp_conn_s, pnode);
+
       /* If the local UDP port is non-zero, the connection is considered
        * to be used. If so, then the following checks are performed:
        *
@@ -296,31 +335,27 @@ udp_ipv4_active(FAR struct net_driver_s *dev, FAR struct udp_conn_s *conn,
 #endif
                    net_ipv4addr_hdrcmp(ip->srcipaddr, &conn->u.ipv4.raddr)))
                 {
-                  /* Matching connection found.. Break out of the loop and
-                   * return this reference to it.
+                  /* Matching connection found.. Return this reference to
+                   * it.
                    */
 
-                  break;
+                  return conn;
                 }
             }
           else
             {
               /* This UDP socket is not connected.  We need to match only
                * the destination address with the bound socket address.
-               * Break out out of the loop and return this reference to
-               * the matching connection structure.
+               * Return this reference to the matching connection
+               * structure.
                */
 
-              break;
+              return conn;
             }
         }
-
-      /* Look at the next active connection */
-
-      conn = (FAR struct udp_conn_s *)conn->sconn.node.flink;
     }
 
-  return conn;
+  return NULL;
 }
 #endif /* CONFIG_NET_IPv4 */
 
@@ -342,11 +377,12 @@ udp_ipv6_active(FAR struct net_driver_s *dev, FAR struct udp_conn_s *conn,
                 FAR struct udp_hdr_s *udp)
 {
   FAR struct ipv6_hdr_s *ip = IPv6BUF;
+  FAR hash_node_t *p;
 
-  conn = udp_nextconn(conn);
-
-  while (conn != NULL)
+  for (p = udp_nextport(conn, udp->destport); p != NULL; p = p->flink)
     {
+      conn = container_of(p, struct udp_conn_s, pnode);
+
       /* If the local UDP port is non-zero, the connection is considered
        * to be used. If so, then the following checks are performed:
        *
@@ -436,31 +472,27 @@ udp_ipv6_active(FAR struct net_driver_s *dev, FAR struct udp_conn_s *conn,
 #endif
                    net_ipv6addr_hdrcmp(ip->srcipaddr, conn->u.ipv6.raddr)))
                 {
-                  /* Matching connection found.. Break out of the loop and
-                   * return this reference to it.
+                  /* Matching connection found.. Return this reference to
+                   * it.
                    */
 
-                  break;
+                  return conn;
                 }
             }
           else
             {
               /* This UDP socket is not connected.  We need to match only
                * the destination address with the bound socket address.
-               * Break out out of the loop and return this reference to
-               * the matching connection structure.
+               * Return this reference to the matching connection
+               * structure.
                */
 
-              break;
+              return conn;
             }
         }
-
-      /* Look at the next active connection */
-
-      conn = (FAR struct udp_conn_s *)conn->sconn.node.flink;
     }
 
-  return conn;
+  return NULL;
 }
 #endif /* CONFIG_NET_IPv6 */
 
@@ -622,8 +654,9 @@ void udp_free(FAR struct udp_conn_s *conn)
 
   DEBUGASSERT(conn->crefs == 0);
 
+  udp_setport(conn, 0);
+
   nxmutex_lock(&g_free_lock);
-  conn->lport = 0;
 
   /* Remove the connection from the active list */
 
@@ -715,6 +748,37 @@ FAR struct udp_conn_s *udp_nextconn(FAR struct udp_conn_s *conn)
     }
 }
 
+/****************************************************************************
+ * Name: udp_setport
+ *
+ * Description:
+ *   Set the local port of a UDP connection and move the connection to the
+ *   matching hash bucket.  A port number of zero unbinds the connection.
+ *
+ * Input Parameters:
+ *   conn   - A reference to UDP connection structure.
+ *   portno - The local port number in network byte order.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+void udp_setport(FAR struct udp_conn_s *conn, uint16_t portno)
+{
+  if (conn->lport != 0)
+    {
+      hashtable_delete(g_udp_port_hash, &conn->pnode, conn->lport);
+    }
+
+  conn->lport = portno;
+
+  if (portno != 0)
+    {
+      hashtable_add(g_udp_port_hash, &conn->pnode, portno);
+    }
+}
+
 /****************************************************************************
  * Name: udp_bind
  *
@@ -852,7 +916,7 @@ int udp_bind(FAR struct udp_conn_s *conn, FAR const struct sockaddr *addr)
         }
       else
         {
-          conn->lport = portno;
+          udp_setport(conn, portno);
           ret         = OK;
         }
     }
@@ -877,7 +941,7 @@ int udp_bind(FAR struct udp_conn_s *conn, FAR const struct sockaddr *addr)
         {
           /* No.. then bind the socket to the port */
 
-          conn->lport = portno;
+          udp_setport(conn, portno);
           ret         = OK;
         }
       else
@@ -929,7 +993,10 @@ int udp_connect(FAR struct udp_conn_s *conn, FAR const struct sockaddr *addr)
        * connection structure.
        */
 
-      conn->lport = HTONS(udp_select_port(conn->domain, &conn->u));
+      net_lock();
+      udp_setport(conn, HTONS(udp_select_port(conn->domain, &conn->u)));
+      net_unlock();
+
       if (!conn->lport)
         {
           nerr("ERROR: Failed to get a local port!\n");
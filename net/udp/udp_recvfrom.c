@@ -170,6 +170,119 @@ static inline size_t udp_recvfrom_newdata(FAR struct net_driver_s *dev,
   return recvlen;
 }
 
+/****************************************************************************
+ * Name: udp_recvfrom_loan
+ *
+ * Description:
+ *   Loan the I/O buffer chain of the packet for MSG_ZEROCOPY, trimmed to
+ *   the UDP payload.
+ *
+ * Input Parameters:
+ *   dev      The structure of the network driver that generated the event
+ *   pstate   recvfrom state structure
+ *
+ * Returned Value:
+ *   None.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_RECV_ZEROCOPY
+static inline void udp_recvfrom_loan(FAR struct net_driver_s *dev,
+                                     FAR struct udp_recvfrom_s *pstate)
+{
+  FAR struct iob_s *iob;
+  uint16_t recvlen = dev->d_len;
+
+  iob = iob_trimhead(dev->d_iob, dev->d_appdata - dev->d_iob->io_data -
+                                 dev->d_iob->io_offset);
+  if (iob->io_pktlen > recvlen)
+    {
+      /* Drop any padding behind the payload.  iob_trimtail() would free
+       * the whole chain of an empty datagram.
+       */
+
+      iob = recvlen > 0 ? iob_trimtail(iob, iob->io_pktlen - recvlen) :
+                          iob_trimhead(iob, iob->io_pktlen);
+    }
+
+  *(FAR struct iob_s **)pstate->ir_msg->msg_iov->iov_base = iob;
+  pstate->ir_recvlen = recvlen;
+
+  /* The I/O buffer chain now belongs to the caller */
+
+  netdev_iob_clear(dev);
+}
+
+/****************************************************************************
+ * Name: udp_readahead_split
+ *
+ * Description:
+ *   Split the I/O buffer chain after the first 'len' bytes and return the
+ *   rest.  If the split point falls inside an I/O buffer, the bytes behind
+ *   it (padding, or the next datagram when the chain is packed) are moved
+ *   to a new I/O buffer, so the payload itself is never copied.
+ *
+ * Returned Value:
+ *   The rest of the chain; NULL if there is none.  -ENOMEM is returned
+ *   through 'errcode' if no I/O buffer is available for the split.
+ *
+ ****************************************************************************/
+
+static FAR struct iob_s *udp_readahead_split(FAR struct iob_s *iob,
+                                             unsigned int len,
+                                             FAR int *errcode)
+{
+  FAR struct iob_s *last = iob;
+  FAR struct iob_s *rest;
+  unsigned int pktlen = iob->io_pktlen;
+  unsigned int tail;
+
+  *errcode = OK;
+  if (len >= pktlen)
+    {
+      return NULL;
+    }
+
+  /* Find the I/O buffer holding the last byte of the first 'len' bytes */
+
+  tail = iob->io_len;
+  while (tail < len)
+    {
+      last = last->io_flink;
+      tail += last->io_len;
+    }
+
+  tail -= len;
+  if (tail == 0)
+    {
+      rest = last->io_flink;
+    }
+  else
+    {
+      rest = iob_tryalloc(false);
+      if (rest == NULL)
+        {
+          *errcode = -ENOMEM;
+          return NULL;
+        }
+
+      memcpy(rest->io_data, &last->io_data[last->io_offset +
+                                           last->io_len - tail], tail);
+      rest->io_len   = tail;
+      rest->io_flink = last->io_flink;
+      last->io_len  -= tail;
+    }
+
+  last->io_flink  = NULL;
+  iob->io_pktlen  = len;
+  rest->io_pktlen = pktlen - len;
+  return rest;
+}
+#endif
+
 static inline void udp_readahead(struct udp_recvfrom_s *pstate)
 {
   FAR struct udp_conn_s *conn = pstate->ir_conn;
@@ -235,18 +348,44 @@ static inline void udp_readahead(struct udp_recvfrom_s *pstate)
       offset += sizeof(struct timespec);
 #endif
 
-      /* Copy to user */
+#ifdef CONFIG_NET_RECV_ZEROCOPY
+      if ((pstate->ir_flags & MSG_ZEROCOPY) != 0)
+        {
+          FAR struct iob_s *rest;
+          int ret;
+
+          /* Loan the datagram, detaching it from the datagrams behind */
 
-      recvlen = iob_copyout(pstate->ir_msg->msg_iov->iov_base, iob,
-                            MIN(pstate->ir_msg->msg_iov->iov_len, datalen),
-                            offset);
+          rest = udp_readahead_split(iob, offset + datalen, &ret);
+          if (ret < 0)
+            {
+              pstate->ir_result = ret;
+              return;
+            }
+
+          conn->readahead = rest;
+          *(FAR struct iob_s **)pstate->ir_msg->msg_iov->iov_base =
+            iob_trimhead(iob, offset);
+          recvlen = datalen;
+        }
+      else
+#endif
+        {
+          /* Copy to user */
+
+          recvlen = iob_copyout(pstate->ir_msg->msg_iov->iov_base, iob,
+                                MIN(pstate->ir_msg->msg_iov->iov_len,
+                                    datalen),
+                                offset);
+        }
 
       /* Update the accumulated size of the data read */
 
       pstate->ir_recvlen = recvlen;
 
-      ninfo("Received %d bytes (of %d, total %d)\n",
-            recvlen, datalen, iob->io_pktlen);
+      /* The I/O buffer chain may have been loaned and freed by now */
+
+      ninfo("Received %d bytes (of %d)\n", recvlen, datalen);
 
       if (pstate->ir_msg->msg_name)
         {
@@ -262,7 +401,7 @@ static inline void udp_readahead(struct udp_recvfrom_s *pstate)
 
       /* Remove the packet from the head of the I/O buffer chain. */
 
-      if (!(pstate->ir_flags & MSG_PEEK))
+      if (!(pstate->ir_flags & (MSG_PEEK | MSG_ZEROCOPY)))
         {
           if (offset + datalen >= iob->io_pktlen)
             {
@@ -480,9 +619,18 @@ static uint16_t udp_eventhandler(FAR struct net_driver_s *dev,
 
           udp_sender(dev, pstate);
 
-          /* Copy the data from the packet */
+          /* Copy the data from the packet, or loan the packet itself */
 
-          udp_recvfrom_newdata(dev, pstate);
+#ifdef CONFIG_NET_RECV_ZEROCOPY
+          if ((pstate->ir_flags & MSG_ZEROCOPY) != 0)
+            {
+              udp_recvfrom_loan(dev, pstate);
+            }
+          else
+#endif
+            {
+              udp_recvfrom_newdata(dev, pstate);
+            }
 
           /* We are finished. */
 
@@ -709,9 +857,16 @@ ssize_t psock_udp_recvfrom(FAR struct socket *psock, FAR struct msghdr *msg,
 
   ret = state.ir_recvlen;
 
+  /* The read-ahead data could not be loaned */
+
+  if (state.ir_result < 0)
+    {
+      ret = state.ir_result;
+    }
+
   /* Handle non-blocking UDP sockets */
 
-  if (_SS_ISNONBLOCK(conn->sconn.s_flags) || (flags & MSG_DONTWAIT) != 0)
+  else if (_SS_ISNONBLOCK(conn->sconn.s_flags) || (flags & MSG_DONTWAIT) != 0)
     {
       /* Return the number of bytes read from the read-ahead buffer if
        * something was received (already in 'ret'); EAGAIN if not.
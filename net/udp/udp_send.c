@@ -121,6 +121,62 @@ static void udp_send_loopback(FAR struct net_driver_s *dev)
 }
 #endif
 
+/****************************************************************************
+ * Name: udp_sndchksum
+ *
+ * Description:
+ *   Calculate the UDP checksum of a packet whose payload was already summed
+ *   when it was copied into the write buffer.  Only the pseudo-header and
+ *   the UDP header are summed here.
+ *
+ * Input Parameters:
+ *   dev  - The device driver structure to use in the send operation
+ *   conn - The UDP "connection" structure holding the payload sum
+ *   udp  - The UDP header of the packet
+ *
+ * Returned Value:
+ *   The calculated checksum, as returned by udp_ipv4_chksum()
+ *
+ ****************************************************************************/
+
+#ifdef UDP_WRB_CHKSUM
+static uint16_t udp_sndchksum(FAR struct net_driver_s *dev,
+                              FAR struct udp_conn_s *conn,
+                              FAR struct udp_hdr_s *udp)
+{
+  uint16_t payload;
+  uint16_t sum;
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  if (IFF_IS_IPv4(dev->d_flags))
+#endif
+    {
+      sum = ipv4_upperlayer_header_chksum(dev, IP_PROTO_UDP);
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  else
+#endif
+    {
+      sum = ipv6_upperlayer_header_chksum(dev, IP_PROTO_UDP, IPv6_HDRLEN);
+    }
+#endif /* CONFIG_NET_IPv6 */
+
+  /* The UDP header has an even length, so the payload sum can be added as
+   * one more 16-bit word.
+   */
+
+  sum     = chksum(sum, (FAR const uint8_t *)udp, UDP_HDRLEN);
+  payload = HTONS(conn->sndchksum);
+  sum     = chksum(sum, (FAR const uint8_t *)&payload, sizeof(payload));
+
+  return (sum == 0) ? 0xffff : HTONS(sum);
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -250,6 +306,14 @@ void udp_send(FAR struct net_driver_s *dev, FAR struct udp_conn_s *conn)
 #ifdef CONFIG_NET_UDP_CHECKSUMS
       /* Calculate UDP checksum. */
 
+#ifdef UDP_WRB_CHKSUM
+      if ((conn->flags & _UDP_FLAG_SNDCHKSUM) != 0)
+        {
+          conn->flags   &= ~_UDP_FLAG_SNDCHKSUM;
+          udp->udpchksum = ~udp_sndchksum(dev, conn, udp);
+        }
+      else
+#endif
 #ifdef CONFIG_NET_IPv4
 #ifdef CONFIG_NET_IPv6
       if (IFF_IS_IPv4(dev->d_flags))
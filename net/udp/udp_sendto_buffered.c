@@ -258,7 +258,7 @@ static int sendto_next_transfer(FAR struct udp_conn_s *conn)
        * connection structure.
        */
 
-      conn->lport = HTONS(udp_select_port(conn->domain, &conn->u));
+      udp_setport(conn, HTONS(udp_select_port(conn->domain, &conn->u)));
       if (!conn->lport)
         {
           nerr("ERROR: Failed to get a local port!\n");
@@ -457,6 +457,16 @@ static uint16_t sendto_eventhandler(FAR struct net_driver_s *dev,
 
       wrb->wb_iob = NULL;
 
+#ifdef UDP_WRB_CHKSUM
+      /* The payload was summed when it was copied in */
+
+      if (dev->d_sndlen > 0)
+        {
+          conn->sndchksum = wrb->wb_chksum;
+          conn->flags    |= _UDP_FLAG_SNDCHKSUM;
+        }
+#endif
+
 #ifdef NEED_IPDOMAIN_SUPPORT
       /* If both IPv4 and IPv6 support are enabled, then we will need to
        * select which one to use when generating the outgoing packet.
@@ -513,6 +523,58 @@ static unsigned int udp_send_gettimeout(clock_t start, unsigned int timeout)
   return timeout;
 }
 
+/****************************************************************************
+ * Name: sendto_copyin
+ *
+ * Description:
+ *   Copy the user data into the write buffer and sum it on the way, so
+ *   that the UDP checksum only has to add the headers when the packet is
+ *   sent.  The I/O buffer chain is grown to its final size first.
+ *
+ *   This is called without the network lock, so it may wait for I/O
+ *   buffers to be freed by the network driver.
+ *
+ * Input Parameters:
+ *   wrb      - The write buffer to copy the data into
+ *   buf      - Data to send
+ *   len      - Length of data to send
+ *   udpiplen - The size of the UDP/IP headers in front of the data
+ *   nonblock - True if we may not wait for I/O buffers
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+#ifdef UDP_WRB_CHKSUM
+static int sendto_copyin(FAR struct udp_wrbuffer_s *wrb,
+                         FAR const uint8_t *buf, size_t len,
+                         uint16_t udpiplen, bool nonblock)
+{
+  FAR struct iob_s *iob;
+  unsigned int pktlen = udpiplen + len;
+
+  while (iob_update_pktlen(wrb->wb_iob, pktlen, false) < (int)pktlen)
+    {
+      if (nonblock)
+        {
+          return -ENOMEM;
+        }
+
+      iob = iob_alloc(false);
+      if (iob == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      iob_concat(wrb->wb_iob, iob);
+    }
+
+  wrb->wb_chksum = chksum_iob_copyin(0, wrb->wb_iob, udpiplen, buf, len);
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -549,8 +611,10 @@ ssize_t psock_udp_sendto(FAR struct socket *psock, FAR const void *buf,
   FAR struct udp_wrbuffer_s *wrb;
   FAR struct udp_conn_s *conn;
   unsigned int timeout;
+  unsigned int count;
   uint16_t udpiplen;
   bool nonblock;
+  int blresult;
   bool empty;
   int ret = OK;
   clock_t start;
@@ -813,10 +877,17 @@ ssize_t psock_udp_sendto(FAR struct socket *psock, FAR const void *buf,
       iob_reserve(wrb->wb_iob, CONFIG_NET_LL_GUARDSIZE);
       iob_update_pktlen(wrb->wb_iob, udpiplen, false);
 
-      /* Copy the user data into the write buffer.  We cannot wait for
+      /* Copy the user data into the write buffer.  The write buffer is not
+       * queued yet, so nothing else can reach it and the copy is done
+       * without the network lock.  That also lets iob_copyin() wait for
+       * buffers to be freed by the network driver.  We cannot wait for
        * buffer space if the socket was opened non-blocking.
        */
 
+      blresult = net_breaklock(&count);
+#ifdef UDP_WRB_CHKSUM
+      ret = sendto_copyin(wrb, buf, len, udpiplen, nonblock);
+#else
       if (nonblock)
         {
           ret = iob_trycopyin(wrb->wb_iob, (FAR uint8_t *)buf,
@@ -824,21 +895,14 @@ ssize_t psock_udp_sendto(FAR struct socket *psock, FAR const void *buf,
         }
       else
         {
-          unsigned int count;
-          int blresult;
-
-          /* iob_copyin might wait for buffers to be freed, but if
-           * network is locked this might never happen, since network
-           * driver is also locked, therefore we need to break the lock
-           */
-
-          blresult = net_breaklock(&count);
           ret = iob_copyin(wrb->wb_iob, (FAR uint8_t *)buf,
                            len, udpiplen, false);
-          if (blresult >= 0)
-            {
-              net_restorelock(count);
-            }
+        }
+#endif
+
+      if (blresult >= 0)
+        {
+          net_restorelock(count);
         }
 
       if (ret < 0)
@@ -27,86 +27,216 @@
 #include <nuttx/config.h>
 #ifdef CONFIG_NET
 
+#include <assert.h>
+#include <string.h>
+
 #include "utils/utils.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* A byte at an even or odd address in the native 16-bit word containing it */
+
+#ifdef CONFIG_ENDIAN_BIG
+#  define CHKSUM_EVEN(b) ((uint32_t)(b) << 8)
+#  define CHKSUM_ODD(b)  ((uint32_t)(b))
+#else
+#  define CHKSUM_EVEN(b) ((uint32_t)(b))
+#  define CHKSUM_ODD(b)  ((uint32_t)(b) << 8)
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
 /****************************************************************************
- * Name: checksum
+ * Name: chksum_partial
  *
  * Description:
- *   Calculate the raw change sum over the memory region described by
- *   data and len.
- *
- * Input Parameters:
- *   sum  - Partial calculations carried over from a previous call to
- *          chksum().  This should be zero on the first time that check
- *          sum is called.
- *   data - Beginning of the data to include in the checksum.
- *   len  - Length of the data to include in the checksum.
- *   odd  - the flag of the Calculated data sum
+ *   Sum the memory region described by src and len as native 16-bit words
+ *   aligned to even addresses, copying it to dest on the way if dest is
+ *   not NULL.  The words are loaded 32 bits at a time into a 64-bit
+ *   accumulator which is folded to 16 bits at the end.
  *
  * Returned Value:
- *   The updated checksum value.
+ *   The one's complement sum in native byte order, as if the region was
+ *   padded with zeros to even addresses on both ends.
  *
  ****************************************************************************/
 
 #ifndef CONFIG_NET_ARCH_CHKSUM
-uint16_t checksum(uint16_t sum, FAR const uint8_t *data,
-                    uint16_t len, bool *odd)
+static inline_function uint16_t chksum_partial(FAR uint8_t *dest,
+                                               FAR const uint8_t *src,
+                                               size_t len)
 {
-  FAR const uint8_t *dataptr;
-  FAR const uint8_t *last_byte;
-  uint16_t t;
+  uint64_t acc = 0;
+  uint32_t w[4];
 
-  dataptr = data;
-  last_byte = data + len - 1;
+  if (len > 0 && ((uintptr_t)src & 1) != 0)
+    {
+      if (dest != NULL)
+        {
+          *dest++ = *src;
+        }
 
-  if (*odd == true)
+      acc = CHKSUM_ODD(*src++);
+      len--;
+    }
+
+  if (len >= 2 && ((uintptr_t)src & 2) != 0)
     {
-      t = dataptr[0];
-      sum += t;
-      if (sum < t)
+      if (dest != NULL)
         {
-          sum++; /* carry */
+          memcpy(dest, src, 2);
+          dest += 2;
         }
 
-      dataptr += 1;
+      acc += *(FAR const uint16_t *)src;
+      src += 2;
+      len -= 2;
     }
 
-  while (dataptr < last_byte)
+  /* The source is 32-bit aligned now.  The accumulator can take 2^32 of
+   * these loads before it could overflow.
+   */
+
+  while (len >= 16)
     {
-      /* At least two more bytes */
+      w[0] = ((FAR const uint32_t *)src)[0];
+      w[1] = ((FAR const uint32_t *)src)[1];
+      w[2] = ((FAR const uint32_t *)src)[2];
+      w[3] = ((FAR const uint32_t *)src)[3];
 
-      t = ((uint16_t)dataptr[0] << 8) + dataptr[1];
-      sum += t;
-      if (sum < t)
+      if (dest != NULL)
         {
-          sum++; /* carry */
+          memcpy(dest, w, 16);
+          dest += 16;
         }
 
-      dataptr += 2;
+      acc += (uint64_t)w[0] + w[1] + w[2] + w[3];
+      src += 16;
+      len -= 16;
     }
 
-  *odd = false;
+  while (len >= 4)
+    {
+      w[0] = *(FAR const uint32_t *)src;
+
+      if (dest != NULL)
+        {
+          memcpy(dest, w, 4);
+          dest += 4;
+        }
+
+      acc += w[0];
+      src += 4;
+      len -= 4;
+    }
 
-  if (dataptr == last_byte)
+  if (len >= 2)
     {
-      t = (dataptr[0] << 8) + 0;
-      sum += t;
-      if (sum < t)
+      if (dest != NULL)
         {
-          sum++; /* carry */
+          memcpy(dest, src, 2);
+          dest += 2;
         }
 
-      *odd = true;
+      acc += *(FAR const uint16_t *)src;
+      src += 2;
+      len -= 2;
     }
 
-  /* Return sum in host byte order. */
+  if (len > 0)
+    {
+      if (dest != NULL)
+        {
+          *dest = *src;
+        }
 
-  return sum;
+      acc += CHKSUM_EVEN(*src);
+    }
+
+  /* Fold the accumulator down to 16 bits with end-around carries */
+
+  acc = (acc >> 32) + (acc & 0xffffffff);
+  acc = (acc >> 32) + (acc & 0xffffffff);
+  acc = (acc >> 16) + (acc & 0xffff);
+  acc = (acc >> 16) + (acc & 0xffff);
+  acc = (acc >> 16) + (acc & 0xffff);
+
+  return (uint16_t)acc;
+}
+
+/****************************************************************************
+ * Name: chksum_update
+ *
+ * Description:
+ *   Add the memory region described by src and len to a checksum in host
+ *   byte order, copying it to dest on the way if dest is not NULL.
+ *
+ *   The one's complement sum does not depend on the byte order, so the
+ *   native sum only has to be swapped if the region starts at an odd byte
+ *   of the checksummed data but at an even address, or the other way
+ *   around, and once more on little endian machines.
+ *
+ ****************************************************************************/
+
+static inline_function uint16_t chksum_update(uint16_t sum,
+                                              FAR uint8_t *dest,
+                                              FAR const uint8_t *src,
+                                              size_t len, FAR bool *odd)
+{
+  uint32_t tmp;
+  bool swap;
+
+  if (len == 0)
+    {
+      return sum;
+    }
+
+  tmp  = chksum_partial(dest, src, len);
+  swap = (((uintptr_t)src & 1) != 0) != *odd;
+#ifndef CONFIG_ENDIAN_BIG
+  swap = !swap;
+#endif
+
+  if (swap)
+    {
+      tmp = ((tmp & 0xff) << 8) | (tmp >> 8);
+    }
+
+  tmp += sum;
+  tmp  = (tmp >> 16) + (tmp & 0xffff);
+
+  *odd ^= (len & 1) != 0;
+  return (uint16_t)tmp;
+}
+
+/****************************************************************************
+ * Name: checksum
+ *
+ * Description:
+ *   Calculate the raw change sum over the memory region described by
+ *   data and len.
+ *
+ * Input Parameters:
+ *   sum  - Partial calculations carried over from a previous call to
+ *          chksum().  This should be zero on the first time that check
+ *          sum is called.
+ *   data - Beginning of the data to include in the checksum.
+ *   len  - Length of the data to include in the checksum.
+ *   odd  - the flag of the Calculated data sum
+ *
+ * Returned Value:
+ *   The updated checksum value.
+ *
+ ****************************************************************************/
+
+uint16_t checksum(uint16_t sum, FAR const uint8_t *data,
+                    uint16_t len, bool *odd)
+{
+  return chksum_update(sum, NULL, data, len, odd);
 }
 
 /****************************************************************************
@@ -139,6 +269,34 @@ uint16_t chksum(uint16_t sum, FAR const uint8_t *data, uint16_t len)
   return checksum(sum, data, len, &odd);
 }
 
+/****************************************************************************
+ * Name: chksum_copy
+ *
+ * Description:
+ *   Copy a memory region and calculate the raw change sum over it in the
+ *   same pass.
+ *
+ * Input Parameters:
+ *   sum  - Partial calculations carried over from a previous call to
+ *          chksum().  This should be zero on the first time that check
+ *          sum is called.
+ *   dest - Where to copy the data to.
+ *   src  - Beginning of the data to copy and include in the checksum.
+ *   len  - Length of the data.
+ *
+ * Returned Value:
+ *   The updated checksum value.
+ *
+ ****************************************************************************/
+
+uint16_t chksum_copy(uint16_t sum, FAR uint8_t *dest,
+                     FAR const uint8_t *src, uint16_t len)
+{
+  bool odd = false;
+
+  return chksum_update(sum, dest, src, len, &odd);
+}
+
 #endif /* CONFIG_NET_ARCH_CHKSUM */
 
 /****************************************************************************
@@ -188,6 +346,79 @@ uint16_t chksum_iob(uint16_t sum, FAR struct iob_s *iob, uint16_t offset)
 }
 #endif /* CONFIG_MM_IOB */
 
+/****************************************************************************
+ * Name: chksum_iob_copyin
+ *
+ * Description:
+ *   Copy a memory region into an iob chain buffer and calculate the raw
+ *   change sum over it in the same pass.  The chain must already be long
+ *   enough to hold the data.
+ *
+ * Input Parameters:
+ *   sum    - Partial calculations carried over from a previous call to
+ *            chksum().  This should be zero on the first time that check
+ *            sum is called.
+ *   iob    - The iob chain buffer to copy the data to.
+ *   offset - Specifies the byte offset in the chain to copy the data to.
+ *   src    - Beginning of the data to copy and include in the checksum.
+ *   len    - Length of the data.
+ *
+ * Returned Value:
+ *   The updated checksum value.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_IOB
+uint16_t chksum_iob_copyin(uint16_t sum, FAR struct iob_s *iob,
+                           uint16_t offset, FAR const uint8_t *src,
+                           uint16_t len)
+{
+  bool odd = false;
+  uint32_t tmp;
+  uint16_t ncopy;
+
+  /* Skip to the I/O buffer containing the data offset */
+
+  while (iob != NULL && offset > iob->io_len)
+    {
+      offset -= iob->io_len;
+      iob     = iob->io_flink;
+    }
+
+  while (iob != NULL && len > 0)
+    {
+      ncopy = iob->io_len - offset;
+      if (ncopy > len)
+        {
+          ncopy = len;
+        }
+
+      /* A segment that starts at an odd byte of the data adds its bytes
+       * to the other halves of the 16-bit words.
+       */
+
+      tmp = chksum_copy(0, iob->io_data + iob->io_offset + offset,
+                        src, ncopy);
+      if (odd)
+        {
+          tmp = ((tmp & 0xff) << 8) | (tmp >> 8);
+        }
+
+      tmp += sum;
+      sum  = (uint16_t)((tmp >> 16) + (tmp & 0xffff));
+      odd ^= (ncopy & 1) != 0;
+
+      src   += ncopy;
+      len   -= ncopy;
+      iob    = iob->io_flink;
+      offset = 0;
+    }
+
+  DEBUGASSERT(len == 0);
+  return sum;
+}
+#endif /* CONFIG_MM_IOB */
+
 /****************************************************************************
  * Name: net_chksum
  *
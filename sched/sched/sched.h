@@ -315,6 +315,13 @@ void nxsched_merge_prioritized(FAR dq_queue_t *list1, FAR dq_queue_t *list2,
 bool nxsched_merge_pending(void);
 void nxsched_add_blocked(FAR struct tcb_s *btcb, tstate_t task_state);
 void nxsched_remove_blocked(FAR struct tcb_s *btcb);
+
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+bool nxsched_add_rtrbitmap(FAR struct tcb_s *tcb);
+void nxsched_remove_rtrbitmap(FAR struct tcb_s *tcb);
+void nxsched_reset_rtrbitmap(void);
+#endif
+
 int  nxsched_set_priority(FAR struct tcb_s *tcb, int sched_priority);
 bool nxsched_reprioritize_rtr(FAR struct tcb_s *tcb, int priority);
 
@@ -450,6 +457,15 @@ static inline_function bool nxsched_add_prioritized(FAR struct tcb_s *tcb,
 
   DEBUGASSERT(sched_priority >= SCHED_PRIORITY_MIN);
 
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+  /* The ready-to-run list has a priority index, use it */
+
+  if (list == list_readytorun())
+    {
+      return nxsched_add_rtrbitmap(tcb);
+    }
+#endif
+
   /* Search the list to find the location to insert the new Tcb.
    * Each is list is maintained in descending sched_priority order.
    */
@@ -517,6 +533,24 @@ static inline_function bool nxsched_add_prioritized(FAR struct tcb_s *tcb,
   return ret;
 }
 
+/* Remove a TCB from a prioritized list.  The counterpart of
+ * nxsched_add_prioritized() that keeps any list index up to date.
+ */
+
+static inline_function void nxsched_remove_prioritized(FAR struct tcb_s *tcb,
+                                                       DSEG dq_queue_t *list)
+{
+#ifdef CONFIG_SCHED_READYTORUN_BITMAP
+  if (list == list_readytorun())
+    {
+      nxsched_remove_rtrbitmap(tcb);
+      return;
+    }
+#endif
+
+  dq_rem((FAR dq_entry_t *)tcb, list);
+}
+
 #  ifdef CONFIG_SMP
 static inline_function int nxsched_select_cpu(cpu_set_t affinity)
 {
@@ -0,0 +1,292 @@
+/****************************************************************************
+ * sched/sched/sched_rtrbitmap.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <strings.h>
+#include <string.h>
+#include <assert.h>
+
+#include <nuttx/queue.h>
+
+#include "sched/queue.h"
+#include "sched/sched.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define RTR_NPRIORITIES  (SCHED_PRIORITY_MAX + 1)
+#define RTR_NWORDS       ((RTR_NPRIORITIES + 31) / 32)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The g_readytorun list is still an ordinary prioritized dq_queue_t.  In
+ * addition, every TCB except the list head is filed in a priority bucket:
+ *
+ *   g_rtrbitmap  - Bit 'n' is set if bucket 'n' holds at least one TCB.
+ *   g_rtrsummary - Bit 'n' is set if g_rtrbitmap[n] is non-zero.
+ *   g_rtrtail    - The last TCB of each priority in the list.
+ *
+ * The head is deliberately kept out of the buckets.  In the non-SMP case
+ * it is the running task whose priority may be modified in place (e.g. by
+ * nxsem_protect_wait()), so its position is always re-evaluated from its
+ * live priority instead.
+ */
+
+static uint32_t g_rtrbitmap[RTR_NWORDS];
+static uint32_t g_rtrsummary;
+static FAR struct tcb_s *g_rtrtail[RTR_NPRIORITIES];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static inline_function void nxsched_rtr_setbit(int prio)
+{
+  g_rtrbitmap[prio >> 5] |= (uint32_t)1 << (prio & 31);
+  g_rtrsummary           |= (uint32_t)1 << (prio >> 5);
+}
+
+static inline_function void nxsched_rtr_clrbit(int prio)
+{
+  int word = prio >> 5;
+
+  g_rtrbitmap[word] &= ~((uint32_t)1 << (prio & 31));
+  if (g_rtrbitmap[word] == 0)
+    {
+      g_rtrsummary &= ~((uint32_t)1 << word);
+    }
+}
+
+/****************************************************************************
+ * Name: nxsched_rtr_findge
+ *
+ * Description:
+ *   Return the lowest occupied priority bucket that is greater than or
+ *   equal to 'prio', or -1 if there is none.
+ *
+ ****************************************************************************/
+
+static inline_function int nxsched_rtr_findge(int prio)
+{
+  int word = prio >> 5;
+  uint32_t bits;
+
+  bits = g_rtrbitmap[word] & (UINT32_MAX << (prio & 31));
+  if (bits == 0)
+    {
+      uint32_t words = g_rtrsummary & ~(((uint32_t)2 << word) - 1);
+
+      if (words == 0)
+        {
+          return -1;
+        }
+
+      word = ffs(words) - 1;
+      bits = g_rtrbitmap[word];
+    }
+
+  return (word << 5) + ffs(bits) - 1;
+}
+
+/****************************************************************************
+ * Name: nxsched_rtr_unfile
+ *
+ * Description:
+ *   Remove 'tcb' from its priority bucket.  'prev' is the TCB in front of
+ *   it and is NULL if 'tcb' is the first TCB that is indexed.
+ *
+ ****************************************************************************/
+
+static inline_function void nxsched_rtr_unfile(FAR struct tcb_s *tcb,
+                                               FAR struct tcb_s *prev)
+{
+  int prio = tcb->sched_priority;
+
+  DEBUGASSERT(g_rtrtail[prio] != NULL);
+
+  if (g_rtrtail[prio] == tcb)
+    {
+      if (prev != NULL && prev->sched_priority == prio)
+        {
+          g_rtrtail[prio] = prev;
+        }
+      else
+        {
+          g_rtrtail[prio] = NULL;
+          nxsched_rtr_clrbit(prio);
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxsched_add_rtrbitmap
+ *
+ * Description:
+ *   Insert a TCB into the g_readytorun list after all TCBs of greater or
+ *   equal priority.  This is the same ordering as nxsched_add_prioritized()
+ *   but the insertion point is found in constant time.
+ *
+ * Input Parameters:
+ *   tcb - Points to the TCB to be added.
+ *
+ * Returned Value:
+ *   true if the TCB was added at the head of the list.
+ *
+ * Assumptions:
+ *   The caller has established a critical section.
+ *
+ ****************************************************************************/
+
+bool nxsched_add_rtrbitmap(FAR struct tcb_s *tcb)
+{
+  FAR dq_queue_t *list = list_readytorun();
+  FAR struct tcb_s *head = (FAR struct tcb_s *)list->head;
+  FAR struct tcb_s *prev;
+  FAR struct tcb_s *next;
+  int prio = tcb->sched_priority;
+  int found;
+
+  DEBUGASSERT(prio >= SCHED_PRIORITY_MIN);
+
+  if (head == NULL)
+    {
+      /* Special case:  The list is empty */
+
+      tcb->flink = NULL;
+      tcb->blink = NULL;
+      list->head = (FAR dq_entry_t *)tcb;
+      list->tail = (FAR dq_entry_t *)tcb;
+      return true;
+    }
+
+  if (prio > head->sched_priority)
+    {
+      /* The TCB becomes the new head.  The old head now joins the buckets
+       * and, having the highest priority, is the first TCB in its bucket.
+       */
+
+      if (g_rtrtail[head->sched_priority] == NULL)
+        {
+          g_rtrtail[head->sched_priority] = head;
+          nxsched_rtr_setbit(head->sched_priority);
+        }
+
+      dq_addfirst_nonempty((FAR dq_entry_t *)tcb, list);
+      return true;
+    }
+
+  /* Insert after the last TCB of the closest priority that is greater than
+   * or equal to ours, or right after the head if there is none.
+   */
+
+  found = nxsched_rtr_findge(prio);
+  prev  = found < 0 ? head : g_rtrtail[found];
+  next  = prev->flink;
+
+  tcb->flink  = next;
+  tcb->blink  = prev;
+  prev->flink = tcb;
+
+  if (next != NULL)
+    {
+      next->blink = tcb;
+    }
+  else
+    {
+      list->tail = (FAR dq_entry_t *)tcb;
+    }
+
+  g_rtrtail[prio] = tcb;
+  nxsched_rtr_setbit(prio);
+  return false;
+}
+
+/****************************************************************************
+ * Name: nxsched_remove_rtrbitmap
+ *
+ * Description:
+ *   Remove a TCB from the g_readytorun list and from its priority bucket.
+ *
+ * Input Parameters:
+ *   tcb - Points to the TCB to be removed.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   The caller has established a critical section.
+ *
+ ****************************************************************************/
+
+void nxsched_remove_rtrbitmap(FAR struct tcb_s *tcb)
+{
+  FAR dq_queue_t *list = list_readytorun();
+  FAR struct tcb_s *head = (FAR struct tcb_s *)list->head;
+
+  if (tcb == head)
+    {
+      /* The next TCB becomes the new head and leaves its bucket.  It is
+       * the first TCB in that bucket.
+       */
+
+      if (tcb->flink != NULL)
+        {
+          nxsched_rtr_unfile(tcb->flink, NULL);
+        }
+    }
+  else
+    {
+      nxsched_rtr_unfile(tcb, tcb->blink != head ? tcb->blink : NULL);
+    }
+
+  dq_rem((FAR dq_entry_t *)tcb, list);
+}
+
+/****************************************************************************
+ * Name: nxsched_reset_rtrbitmap
+ *
+ * Description:
+ *   Forget all priority buckets.  This must be called whenever the content
+ *   of g_readytorun is moved out of the list as a whole.
+ *
+ ****************************************************************************/
+
+void nxsched_reset_rtrbitmap(void)
+{
+  memset(g_rtrbitmap, 0, sizeof(g_rtrbitmap));
+  memset(g_rtrtail, 0, sizeof(g_rtrtail));
+  g_rtrsummary = 0;
+}
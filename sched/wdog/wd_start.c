@@ -133,6 +133,10 @@ static inline_function void wd_expiration(clock_t ticks)
    * other watchdogs that became ready to run at this time
    */
 
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+  while ((wdog = wd_wheel_expire(ticks)) != NULL)
+    {
+#else
   while (!list_is_empty(&g_wdactivelist))
     {
       wdog = list_first_entry(&g_wdactivelist, struct wdog_s, node);
@@ -147,6 +151,7 @@ static inline_function void wd_expiration(clock_t ticks)
       /* Remove the watchdog from the head of the list */
 
       list_delete(&wdog->node);
+#endif
 
       /* Indicate that the watchdog is no longer active. */
 
@@ -194,6 +199,21 @@ static inline_function void wd_expiration(clock_t ticks)
  *
  ****************************************************************************/
 
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+static inline_function
+bool wd_insert(FAR struct wdog_s *wdog, clock_t expired,
+               wdentry_t wdentry, wdparm_t arg)
+{
+  wdog->func = wdentry;
+  up_getpicbase(&wdog->picbase);
+  wdog->arg = arg;
+  wdog->expired = expired;
+
+  /* Return whether the next event of the timer wheel has changed. */
+
+  return wd_wheel_add(wdog);
+}
+#else
 static inline_function
 bool wd_insert(FAR struct wdog_s *wdog, clock_t expired,
                wdentry_t wdentry, wdparm_t arg)
@@ -233,6 +253,7 @@ bool wd_insert(FAR struct wdog_s *wdog, clock_t expired,
 
   return head == curr;
 }
+#endif
 
 /****************************************************************************
  * Public Functions
@@ -298,8 +319,12 @@ int wd_start_abstick(FAR struct wdog_s *wdog, clock_t ticks,
 
   if (WDOG_ISACTIVE(wdog))
     {
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+      reassess |= wd_wheel_delete(wdog);
+#else
       reassess |= list_is_head(&g_wdactivelist, &wdog->node);
       list_delete(&wdog->node);
+#endif
       wdog->func = NULL;
     }
 
@@ -326,7 +351,11 @@ int wd_start_abstick(FAR struct wdog_s *wdog, clock_t ticks,
 
   if (WDOG_ISACTIVE(wdog))
     {
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+      wd_wheel_delete(wdog);
+#else
       list_delete(&wdog->node);
+#endif
       wdog->func = NULL;
     }
 
@@ -416,7 +445,11 @@ int wd_start(FAR struct wdog_s *wdog, clock_t delay,
 #ifdef CONFIG_SCHED_TICKLESS
 clock_t wd_timer(clock_t ticks, bool noswitches)
 {
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+  clock_t next;
+#else
   FAR struct wdog_s *wdog;
+#endif
   irqstate_t flags;
   sclock_t ret;
 
@@ -431,7 +464,15 @@ clock_t wd_timer(clock_t ticks, bool noswitches)
 
   /* Return the delay for the next watchdog to expire */
 
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+  /* The next wheel event may also be a cascade of a coarser slot, which
+   * only costs an early wakeup.
+   */
+
+  if (!wd_wheel_next(&next))
+#else
   if (list_is_empty(&g_wdactivelist))
+#endif
     {
       spin_unlock_irqrestore(&g_wdspinlock, flags);
       return 0;
@@ -441,8 +482,12 @@ clock_t wd_timer(clock_t ticks, bool noswitches)
    * may get negative value.
    */
 
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+  ret = next - ticks;
+#else
   wdog = list_first_entry(&g_wdactivelist, struct wdog_s, node);
   ret = wdog->expired - ticks;
+#endif
 
   spin_unlock_irqrestore(&g_wdspinlock, flags);
 
@@ -0,0 +1,464 @@
+/****************************************************************************
+ * sched/wdog/wd_wheel.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <strings.h>
+#include <assert.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/wdog.h>
+
+#include "wdog/wdog.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Each level of the wheel has 64 slots so that the occupied slots of a
+ * level fit in one 64-bit word.  Level 'n' slots are (1 << (6 * n)) ticks
+ * wide.  The list head of a slot is only valid while its occupied bit is
+ * set, so the wheel needs no initialization.
+ */
+
+#define WHEEL_BITS        6
+#define WHEEL_SLOTS       (1 << WHEEL_BITS)
+#define WHEEL_MASK        (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS      CONFIG_WDOG_WHEEL_LEVELS
+
+#define WHEEL_SHIFT(l)    ((l) * WHEEL_BITS)
+#define WHEEL_INDEX(t, l) ((unsigned int)((t) >> WHEEL_SHIFT(l)) & WHEEL_MASK)
+
+/* The longest delay the wheel can hold directly.  Later watchdogs are
+ * parked in the last slot that can be reached and re-filed by the cascade.
+ */
+
+#define WHEEL_MAXDELAY    (((clock_t)1 << WHEEL_SHIFT(WHEEL_LEVELS)) - 1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct wd_wheel_s
+{
+  clock_t          base;                       /* Last tick processed */
+  uint64_t         occupied[WHEEL_LEVELS];     /* Non-empty slots per level */
+  struct list_node slot[WHEEL_LEVELS][WHEEL_SLOTS];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct wd_wheel_s g_wdwheel;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_wheel_ffs
+ *
+ * Description:
+ *   Return the offset (1 .. 64) of the first occupied slot in 'bits'
+ *   following slot 'index' and wrapping around, or 0 if 'bits' is empty.
+ *   'first' selects whether the slot at 'index' itself counts as offset 0.
+ *
+ ****************************************************************************/
+
+static inline_function unsigned int wd_wheel_ffs(uint64_t bits,
+                                                 unsigned int index,
+                                                 bool first)
+{
+  unsigned int start = first ? index : (index + 1) & WHEEL_MASK;
+
+  if (bits == 0)
+    {
+      return 0;
+    }
+
+  if (start != 0)
+    {
+      bits = (bits >> start) | (bits << (WHEEL_SLOTS - start));
+    }
+
+  return ffsll(bits) - (first ? 1 : 0);
+}
+
+/****************************************************************************
+ * Name: wd_wheel_file
+ *
+ * Description:
+ *   Put the watchdog into the slot that matches its expiration time
+ *   relative to the current wheel base.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_file(FAR struct wdog_s *wdog)
+{
+  FAR struct wd_wheel_s *wheel = &g_wdwheel;
+  sclock_t delay = (sclock_t)(wdog->expired - wheel->base);
+  clock_t key = wdog->expired;
+  unsigned int level;
+  unsigned int index;
+
+  if (delay < 0)
+    {
+      /* Already expired, run it on the next tick processed */
+
+      key   = wheel->base;
+      delay = 0;
+    }
+  else if ((clock_t)delay > WHEEL_MAXDELAY)
+    {
+      key   = wheel->base + WHEEL_MAXDELAY;
+      delay = WHEEL_MAXDELAY;
+    }
+
+  for (level = 0; level < WHEEL_LEVELS - 1; level++)
+    {
+      if ((clock_t)delay < ((clock_t)1 << WHEEL_SHIFT(level + 1)))
+        {
+          break;
+        }
+    }
+
+  /* The list head of an unoccupied slot is not valid, so initialize it
+   * when the slot gets its first watchdog.
+   */
+
+  index = WHEEL_INDEX(key, level);
+  if ((wheel->occupied[level] & ((uint64_t)1 << index)) == 0)
+    {
+      list_initialize(&wheel->slot[level][index]);
+      wheel->occupied[level] |= (uint64_t)1 << index;
+    }
+
+  list_add_tail(&wheel->slot[level][index], &wdog->node);
+}
+
+/****************************************************************************
+ * Name: wd_wheel_unfile
+ *
+ * Description:
+ *   Remove the watchdog from its slot.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_unfile(FAR struct wdog_s *wdog)
+{
+  FAR struct wd_wheel_s *wheel = &g_wdwheel;
+  FAR struct list_node *next = wdog->node.next;
+
+  list_delete(&wdog->node);
+
+  /* If the slot became empty, the next node is the slot head */
+
+  if (list_is_empty(next))
+    {
+      uintptr_t offset = (uintptr_t)next - (uintptr_t)&wheel->slot[0][0];
+      unsigned int slot;
+
+      if (offset < sizeof(wheel->slot))
+        {
+          slot = offset / sizeof(struct list_node);
+          wheel->occupied[slot / WHEEL_SLOTS] &=
+            ~((uint64_t)1 << (slot % WHEEL_SLOTS));
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: wd_wheel_cascade
+ *
+ * Description:
+ *   The wheel base has reached the start of a level 0 rotation.  Re-file
+ *   the watchdogs of every higher level slot whose period starts now.
+ *
+ ****************************************************************************/
+
+static void wd_wheel_cascade(void)
+{
+  FAR struct wd_wheel_s *wheel = &g_wdwheel;
+  FAR struct wdog_s *wdog;
+  FAR struct wdog_s *tmp;
+  struct list_node pending;
+  unsigned int level;
+  unsigned int index;
+
+  for (level = 1; level < WHEEL_LEVELS; level++)
+    {
+      index = WHEEL_INDEX(wheel->base, level);
+      if ((wheel->occupied[level] & ((uint64_t)1 << index)) != 0)
+        {
+          /* Detach the slot first, some watchdogs may land in it again */
+
+          pending.next = wheel->slot[level][index].next;
+          pending.prev = wheel->slot[level][index].prev;
+          pending.next->prev = &pending;
+          pending.prev->next = &pending;
+          wheel->occupied[level] &= ~((uint64_t)1 << index);
+
+          list_for_every_entry_safe(&pending, wdog, tmp,
+                                    struct wdog_s, node)
+            {
+              list_delete(&wdog->node);
+              wd_wheel_file(wdog);
+            }
+        }
+
+      if (index != 0)
+        {
+          break;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: wd_wheel_setbase
+ *
+ * Description:
+ *   Move the wheel base forward, cascading if it lands on the start of a
+ *   level 0 rotation.
+ *
+ ****************************************************************************/
+
+static inline_function void wd_wheel_setbase(clock_t base)
+{
+  g_wdwheel.base = base;
+  if ((base & WHEEL_MASK) == 0)
+    {
+      wd_wheel_cascade();
+    }
+}
+
+/****************************************************************************
+ * Name: wd_wheel_event
+ *
+ * Description:
+ *   Return the number of ticks from the wheel base to the next tick at
+ *   which a level 0 slot expires or a higher level slot is cascaded.
+ *
+ ****************************************************************************/
+
+static bool wd_wheel_event(FAR clock_t *delay)
+{
+  FAR struct wd_wheel_s *wheel = &g_wdwheel;
+  clock_t best = 0;
+  bool found = false;
+  unsigned int level;
+  unsigned int index;
+  unsigned int offset;
+
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    {
+      clock_t event;
+
+      index  = WHEEL_INDEX(wheel->base, level);
+      offset = wd_wheel_ffs(wheel->occupied[level], index, level == 0);
+      if (level == 0 && wheel->occupied[0] != 0)
+        {
+          event = offset;
+        }
+      else if (offset != 0)
+        {
+          /* The slot is cascaded when the base reaches its start */
+
+          event = ((((wheel->base >> WHEEL_SHIFT(level)) + offset)) <<
+                   WHEEL_SHIFT(level)) - wheel->base;
+        }
+      else
+        {
+          continue;
+        }
+
+      if (!found || event < best)
+        {
+          best  = event;
+          found = true;
+        }
+    }
+
+  *delay = best;
+  return found;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wd_wheel_add
+ *
+ * Description:
+ *   Add an active watchdog to the timer wheel.  wdog->expired must be set.
+ *
+ * Returned Value:
+ *   true if the next wheel event (see wd_wheel_next()) has changed.
+ *
+ * Assumptions:
+ *   The caller holds g_wdspinlock.
+ *
+ ****************************************************************************/
+
+bool wd_wheel_add(FAR struct wdog_s *wdog)
+{
+  FAR struct wd_wheel_s *wheel = &g_wdwheel;
+  clock_t before;
+  clock_t after;
+
+  if (!wd_wheel_event(&before))
+    {
+      /* An empty wheel has no history to preserve, so catch the base up
+       * with the current time.  This keeps a long idle period from being
+       * walked through later.
+       */
+
+      wheel->base = clock_systime_ticks();
+      wd_wheel_file(wdog);
+      return true;
+    }
+
+  wd_wheel_file(wdog);
+  wd_wheel_event(&after);
+  return after != before;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_delete
+ *
+ * Description:
+ *   Remove an active watchdog from the timer wheel.
+ *
+ * Returned Value:
+ *   true if the next wheel event (see wd_wheel_next()) has changed.
+ *
+ * Assumptions:
+ *   The caller holds g_wdspinlock.
+ *
+ ****************************************************************************/
+
+bool wd_wheel_delete(FAR struct wdog_s *wdog)
+{
+  clock_t before;
+  clock_t after;
+
+  wd_wheel_event(&before);
+  wd_wheel_unfile(wdog);
+  return !wd_wheel_event(&after) || after != before;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_next
+ *
+ * Description:
+ *   Return the absolute tick of the next wheel event: either the expiration
+ *   of a watchdog or the cascade of a higher level slot.  This is never
+ *   later than the earliest watchdog expiration.
+ *
+ * Returned Value:
+ *   false if the wheel holds no watchdogs.
+ *
+ * Assumptions:
+ *   The caller holds g_wdspinlock.
+ *
+ ****************************************************************************/
+
+bool wd_wheel_next(FAR clock_t *next)
+{
+  clock_t delay;
+
+  if (!wd_wheel_event(&delay))
+    {
+      return false;
+    }
+
+  *next = g_wdwheel.base + delay;
+  return true;
+}
+
+/****************************************************************************
+ * Name: wd_wheel_expire
+ *
+ * Description:
+ *   Advance the wheel up to 'ticks' and remove the next watchdog that has
+ *   expired.  Slot boundaries with nothing to do are skipped over, so the
+ *   cost does not depend on the number of ticks elapsed.
+ *
+ * Input Parameters:
+ *   ticks - current time in ticks
+ *
+ * Returned Value:
+ *   The expired watchdog, or NULL if there are no more.
+ *
+ * Assumptions:
+ *   The caller holds g_wdspinlock.
+ *
+ ****************************************************************************/
+
+FAR struct wdog_s *wd_wheel_expire(clock_t ticks)
+{
+  FAR struct wd_wheel_s *wheel = &g_wdwheel;
+  FAR struct wdog_s *wdog;
+  unsigned int index;
+  clock_t delay;
+
+  while (clock_compare(wheel->base, ticks))
+    {
+      index = WHEEL_INDEX(wheel->base, 0);
+      if ((wheel->occupied[0] & ((uint64_t)1 << index)) != 0)
+        {
+          wdog = list_first_entry(&wheel->slot[0][index],
+                                  struct wdog_s, node);
+          wd_wheel_unfile(wdog);
+          return wdog;
+        }
+
+      /* Skip ahead to the next slot that needs attention.  The base stops
+       * at 'ticks' so that watchdogs started with an expiration time of
+       * 'ticks' or earlier still run on the next call.
+       */
+
+      if (wheel->base == ticks)
+        {
+          break;
+        }
+
+      if (!wd_wheel_event(&delay) || delay == 0 ||
+          clock_compare(ticks, wheel->base + delay))
+        {
+          wd_wheel_setbase(ticks);
+        }
+      else
+        {
+          wd_wheel_setbase(wheel->base + delay);
+        }
+    }
+
+  return NULL;
+}
@@ -64,7 +64,9 @@ extern "C"
  * this linked list are removed and the function is called.
  */
 
+#ifndef CONFIG_WDOG_TIMER_WHEEL
 extern struct list_node g_wdactivelist;
+#endif
 extern spinlock_t g_wdspinlock;
 
 /****************************************************************************
@@ -125,6 +127,28 @@ void wd_timer(clock_t ticks);
 struct tcb_s;
 void wd_recover(FAR struct tcb_s *tcb);
 
+/****************************************************************************
+ * Timer wheel backend (see wd_wheel.c)
+ *
+ *   wd_wheel_add    - File an active watchdog by wdog->expired.
+ *   wd_wheel_delete - Remove an active watchdog.
+ *   wd_wheel_next   - Absolute tick of the next wheel event.  This is never
+ *                     later than the earliest expiration.
+ *   wd_wheel_expire - Advance the wheel to 'ticks' and return the next
+ *                     expired watchdog, or NULL.
+ *
+ *   wd_wheel_add() and wd_wheel_delete() return true if the next wheel
+ *   event has changed.  All must be called with g_wdspinlock held.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WDOG_TIMER_WHEEL
+bool wd_wheel_add(FAR struct wdog_s *wdog);
+bool wd_wheel_delete(FAR struct wdog_s *wdog);
+bool wd_wheel_next(FAR clock_t *next);
+FAR struct wdog_s *wd_wheel_expire(clock_t ticks);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -148,24 +148,52 @@ class SymbolTables(object):
                         return size
         raise ValueError("not found type")
 
+    def get_enumvalue(self, enum_name):
+        if not self.elffile.has_dwarf_info():
+            raise ValueError("not found dwarf info!")
+
+        dwarfinfo = self.elffile.get_dwarf_info()
+        for CU in dwarfinfo.iter_CUs():
+            for DIE in CU.iter_DIEs():
+                if DIE.tag == "DW_TAG_enumerator":
+                    name = DIE.attributes["DW_AT_name"].value.decode("utf-8")
+                    if name == enum_name:
+                        return DIE.attributes["DW_AT_const_value"].value
+        raise ValueError("not found enumerator")
+
     def readstring(self, addr):
         data = b""
         while True:
-            data += self.read(addr, 256)
-            data = data.split(b"\x00")[0]
-            if len(data) < 256:
+            chunk = self.read(addr + len(data), 256)
+            if not chunk:
+                break
+            data += chunk
+            if b"\x00" in chunk:
                 break
-        return data.decode("utf-8")
+        return data.split(b"\x00")[0].decode("utf-8", errors="replace")
 
     def read(self, addr, size):
+        # The format strings of sched_note_printf may be in a section that
+        # is not loaded (.printf_format), so look at the sections too.
+
         for segment in self.elffile.iter_segments():
             seg_addr = segment["p_paddr"]
             seg_size = min(segment["p_memsz"], segment["p_filesz"])
-            if addr >= seg_addr and addr + size <= seg_addr + seg_size:
+            if addr >= seg_addr and addr < seg_addr + seg_size:
                 data = segment.data()
                 start = addr - seg_addr
                 return data[start : start + size]
 
+        for section in self.elffile.iter_sections():
+            sec_addr = section["sh_addr"]
+            if section["sh_type"] == "SHT_NOBITS" or sec_addr == 0:
+                continue
+            if addr >= sec_addr and addr < sec_addr + section["sh_size"]:
+                start = addr - sec_addr
+                return section.data()[start : start + size]
+
+        return b""
+
     def addr2symbol(self, addr: int):
         index = bisect.bisect(self.addr_list, addr)
         if index != -1:
@@ -399,24 +427,41 @@ class ParseBinaryLogTool:
 
 
 class TraceDecoder(SymbolTables):
-    def __init__(self, elffile):
+    # Argument types recorded by sched_note_printf with
+    # CONFIG_DRIVERS_NOTE_STRIP_FORMAT, see NOTE_PRINTF_* in sched_note.h
+
+    NOTE_PRINTF_UINT32 = 0
+    NOTE_PRINTF_UINT64 = 1
+    NOTE_PRINTF_DOUBLE = 2
+    NOTE_PRINTF_STRING = 3
+
+    # NOTE_DUMP_PRINTF of enum note_type_e, read from the ELF if possible
+
+    NOTE_DUMP_PRINTF = 30
+
+    def __init__(self, elffile, perf_freq=None):
         super().__init__(elffile)
         self.data = b""
-        self.typeinfo["time_t"] = "int%d" % (self.get_typesize("time_t") * 8)
+        self.perf_freq = perf_freq
+        self.clocksize = self.get_typesize("clock_t")
+        self.typeinfo["clock_t"] = "uint%d" % (self.clocksize * 8)
+        try:
+            self.NOTE_DUMP_PRINTF = self.get_enumvalue("NOTE_DUMP_PRINTF")
+        except ValueError:
+            pass
 
     def note_common_define(self):
-        note_common = pycstruct.StructDef(alignment=4)
+        note_common = pycstruct.StructDef(alignment=max(4, self.clocksize))
         note_common.add("uint8", "nc_length")
         note_common.add("uint8", "nc_type")
         note_common.add("uint8", "nc_priority")
         note_common.add("uint8", "nc_cpu")
         note_common.add(self.typeinfo["pid_t"], "nc_pid")
-        note_common.add(self.typeinfo["time_t"], "nc_systime_sec")
-        note_common.add(self.typeinfo["long"], "nc_systime_nsec")
+        note_common.add(self.typeinfo["clock_t"], "nc_systime")
         return note_common
 
     def note_printf_define(self, length):
-        struct_def = pycstruct.StructDef(alignment=4)
+        struct_def = pycstruct.StructDef(alignment=max(4, self.clocksize))
         struct_def.add(self.note_common_define(), "npt_cmn")
         struct_def.add(self.typeinfo["size_t"], "npt_ip")
         struct_def.add(self.typeinfo["size_t"], "npt_fmt")
@@ -561,20 +606,114 @@ class TraceDecoder(SymbolTables):
         except Exception as e:
             logger.error(f"format failed: {e}")
 
+    def typed_args(self, type, data):
+        # Split the raw argument words of a note by their recorded types
+
+        args = []
+        byteorder = self.elfinfo["byteorder"]
+        count = (type >> 28) & 0x0F
+        for i in range(count):
+            argtype = (type >> (i * 2)) & 0x03
+            if argtype == self.NOTE_PRINTF_STRING:
+                if len(data) == 0:
+                    break
+                string = data.split(b"\x00")[0]
+                args.append(string.decode("utf-8", errors="replace"))
+                data = data[len(string) + 1 :]
+                continue
+
+            size = 4 if argtype == self.NOTE_PRINTF_UINT32 else 8
+            if len(data) < size:
+                break
+
+            if argtype == self.NOTE_PRINTF_DOUBLE:
+                endian = "<" if byteorder == "little" else ">"
+                args.append(struct.unpack(endian + "d", data[:size])[0])
+            else:
+                value = int.from_bytes(data[:size], byteorder=byteorder)
+                args.append((value, size))
+            data = data[size:]
+        return args
+
+    def typed_printf(self, format, args):
+        # Format the arguments split by typed_args(), the length modifiers
+        # are not needed since the size of each argument is recorded.
+
+        out = []
+        parts = re.split(
+            r"(%[-+#0\s]*(?:\d+|\*)?(?:\.(?:\d+|\*))?(?:hh|h|ll|l|j|z|t|L)?"
+            r"[diufFeEgGxXoscpaAn%])",
+            format,
+        )
+        for index, part in enumerate(parts):
+            if index % 2 == 0:
+                out.append(part)
+                continue
+
+            if part == "%%":
+                out.append("%")
+                continue
+
+            conv = re.sub(r"(hh|h|ll|l|j|z|t|L)(?=[a-zA-Z]$)", "", part)
+            while "*" in conv:
+                width = args.pop(0) if args else (0, 4)
+                value = width[0] if isinstance(width, tuple) else int(width)
+                conv = conv.replace("*", str(value), 1)
+
+            spec = conv[-1]
+            if spec == "n":
+                continue
+
+            if not args:
+                out.append("<?>")
+                continue
+
+            arg = args.pop(0)
+            if isinstance(arg, tuple):
+                value, size = arg
+                if spec in "di" and value >= 1 << (size * 8 - 1):
+                    value -= 1 << (size * 8)
+            else:
+                value = arg
+
+            try:
+                if spec == "s":
+                    if not isinstance(value, str):
+                        value = "<0x%x>" % value
+                    out.append(conv % value)
+                elif spec == "p":
+                    out.append("0x%x" % value)
+                elif spec == "c":
+                    out.append(chr(value & 0xFF))
+                elif spec in "aA":
+                    out.append(float(value).hex())
+                else:
+                    out.append(conv % value)
+            except (TypeError, ValueError):
+                out.append(str(value))
+
+        return "".join(out)
+
     def print_format(self, note):
         payload = dict()
-        payload["time"] = (
-            note["npt_cmn"]["nc_systime_sec"]
-            + note["npt_cmn"]["nc_systime_nsec"] / 1000000000
-        )
+        systime = note["npt_cmn"]["nc_systime"]
+        payload["time"] = systime / self.perf_freq if self.perf_freq else systime
         payload["pid"] = note["npt_cmn"]["nc_pid"]
         payload["cpu"] = (
             0 if "nc_cpu" not in note["npt_cmn"] else note["npt_cmn"]["nc_cpu"]
         )
         payload["format"] = self.readstring(note["npt_fmt"])
-        prefix = "[{time:.9f}] [{pid}] [CPU{cpu}]: ".format(**payload)
-        string = self.printf(payload["format"], note["npt_data"]).rstrip("\n")
-        logger.info(prefix + string)
+        if self.perf_freq:
+            prefix = "[{time:.9f}] [{pid}] [CPU{cpu}]: ".format(**payload)
+        else:
+            prefix = "[{time}] [{pid}] [CPU{cpu}]: ".format(**payload)
+
+        if note["npt_type"] != 0:
+            args = self.typed_args(note["npt_type"], note["npt_data"])
+            string = self.typed_printf(payload["format"], args)
+        else:
+            string = self.printf(payload["format"], note["npt_data"])
+        logger.info(prefix + (string or "").rstrip("\n"))
 
     def parse_note(self, rawdata=None):
         while len(self.data) > 0:
@@ -588,7 +727,7 @@ class TraceDecoder(SymbolTables):
                 if nc_length < common_struct.size():
                     raise ValueError("Invalid note length")
 
-                if common_note["nc_type"] == 24:
+                if common_note["nc_type"] == self.NOTE_DUMP_PRINTF:
                     note_struct = self.note_printf_define(0)
                     length = nc_length - note_struct.size()
                     note = note_struct.deserialize(data)
@@ -597,7 +736,7 @@ class TraceDecoder(SymbolTables):
                     ]
                     self.print_format(note)
                 else:
-                    raise ValueError("Invalid note type")
+                    logger.debug(f"skip note type {common_note['nc_type']}")
             except Exception as e:
                 logger.debug(f"skip one byte, data: {hex(self.data[0])} {e}")
                 self.data = data[1:]
@@ -605,6 +744,13 @@ class TraceDecoder(SymbolTables):
 
             self.data = data[nc_length:]
 
+    def file_received(self, path):
+        # Decode the notes read from /dev/note/ram in binary mode
+
+        with open(path, "rb") as f:
+            self.data = f.read()
+        self.parse_note()
+
     def tty_received(self):
         while True:
             data = ser.read(16384)
@@ -623,6 +769,15 @@ def parse_arguments():
     parser.add_argument(
         "-b", "--baudrate", help="Physical serial device baud rate", default=115200
     )
+    parser.add_argument(
+        "-n", "--note", help="binary notes read from /dev/note/ram in binary mode"
+    )
+    parser.add_argument(
+        "-f",
+        "--perf-freq",
+        help="frequency of the perf counter, to print the note time in seconds",
+        type=int,
+    )
     parser.add_argument("-v", "--verbose", help="verbose output", action="store_true")
     parser.add_argument(
         "-o",
@@ -638,13 +793,22 @@ if __name__ == "__main__":
     out_path = args.output if args.output else "trace.systrace"
     logger.setLevel(logging.DEBUG if args.verbose else logging.INFO)
 
-    if args.trace is None and args.device is None:
-        print("error, please add trace file path or device name")
+    if args.trace is None and args.device is None and args.note is None:
+        print("error, please add trace file path, note file path or device name")
         print(
-            "usage: parsetrace.py [-h] [-t TRACE] [-e ELF] [-d DEVICE] [-b BAUDRATE] [-v] [-o OUTPUT]"
+            "usage: parsetrace.py [-h] [-t TRACE] [-e ELF] [-d DEVICE] [-b BAUDRATE] "
+            "[-n NOTE] [-f PERF_FREQ] [-v] [-o OUTPUT]"
         )
         exit(1)
 
+    if args.note:
+        if args.elf is None:
+            print("error, please add elf file path")
+            exit(1)
+
+        decode = TraceDecoder(args.elf, args.perf_freq)
+        decode.file_received(args.note)
+
     if args.trace:
         file_type = subprocess.check_output(f"file -b {args.trace}", shell=True)
         file_type = str(file_type, "utf-8").lower()
@@ -687,7 +851,7 @@ if __name__ == "__main__":
             print("error, please add elf file path")
             exit(1)
 
-        decode = TraceDecoder(args.elf)
+        decode = TraceDecoder(args.elf, args.perf_freq)
         with serial.Serial(args.device, baudrate=args.baudrate) as ser:
             ser.timeout = 0
             decode.tty_received()